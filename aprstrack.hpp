@@ -46,12 +46,64 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <tuple>
+#include <vector>
 #include <chrono>
 #include <iterator>
 #include <ranges>
 #include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <bit>
+#include <mutex>
+
+#ifdef APRS_TRACK_PMR
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#else
+#error "APRS_TRACK_PMR requires <memory_resource>"
+#endif
+#else
+#include <memory_resource>
+#endif
+#endif
+
+#if !defined(APRS_TRACK_NO_MMAP) && defined(__has_include)
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#define APRS_TRACK_HAS_MMAP
+#endif
+#endif
+
+#ifdef APRS_TRACK_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if !defined(APRS_TRACK_NO_THREADS) && defined(__has_include)
+#if __has_include(<thread>)
+#include <thread>
+#define APRS_TRACK_HAS_THREADS
+#endif
+#endif
+
+#if defined(__has_include)
+#if __has_include(<shared_mutex>) && __has_include(<mutex>)
+#include <shared_mutex> // __cpp_lib_shared_mutex is only defined on platforms with threads
+#endif
+#endif
 
 #ifndef APRS_TRACK_NAMESPACE
 #define APRS_TRACK_NAMESPACE aprs::track
@@ -92,12 +144,103 @@
 #ifndef APRS_TRACK_SMART_BEACONING_DEBUG
 #define APRS_TRACK_SMART_BEACONING_DEBUG(...)
 #endif
+#ifdef APRS_TRACK_HEAP_FREE
+// Intentionally left empty
+// The tracker keeps all of its storage inline, in buffers sized at compile time
+// Combine with APRS_TRACK_DEFINE_CUSTOM_TYPES and a fixed capacity string_t
+#endif
+#ifdef APRS_TRACK_PMR
+// Intentionally left empty
+// string_t and the tracker storage allocate from a std::pmr::memory_resource
+#endif
+#ifndef APRS_TRACK_MESSAGE_CAPACITY
+#define APRS_TRACK_MESSAGE_CAPACITY 256 // bytes, messages are truncated to this size with APRS_TRACK_HEAP_FREE
+#endif
+#ifndef APRS_TRACK_HISTORY_CAPACITY
+#define APRS_TRACK_HISTORY_CAPACITY 16 // fixes, the largest history capacity with APRS_TRACK_HEAP_FREE
+#endif
+#ifndef APRS_TRACK_STATION_CAPACITY
+#define APRS_TRACK_STATION_CAPACITY 256 // stations, the station_table capacity with APRS_TRACK_HEAP_FREE
+#endif
+#ifndef APRS_TRACK_DUPLICATE_CAPACITY
+#define APRS_TRACK_DUPLICATE_CAPACITY 1024 // packets, the duplicate_filter capacity with APRS_TRACK_HEAP_FREE
+#endif
+#ifdef APRS_TRACK_NO_MMAP
+// Intentionally left empty
+// mapped_file is not defined, track logs can still be read from memory
+#endif
 
 APRS_TRACK_NAMESPACE_BEGIN
 
+#ifdef APRS_TRACK_PMR
+
+struct memory_resource_scope
+{
+    // Sets the memory resource used by the encoders on the current thread,
+    // the previous resource is restored when the scope ends
+    //
+    // Strings default constructed or copied while the scope is active keep
+    // allocating from its resource for their whole lifetime, they must not
+    // outlive the resource, or a monotonic_buffer_resource release()
+    //
+    // A default constructed tracker does not use the resource in scope,
+    // it allocates from std::pmr::get_default_resource()
+
+    explicit memory_resource_scope(std::pmr::memory_resource* resource);
+    ~memory_resource_scope();
+
+    memory_resource_scope(const memory_resource_scope&) = delete;
+    memory_resource_scope& operator=(const memory_resource_scope&) = delete;
+
+private:
+    std::pmr::memory_resource* previous_;
+};
+
+std::pmr::memory_resource* current_memory_resource();
+
+template <typename T>
+struct resource_allocator
+{
+    // Like std::pmr::polymorphic_allocator, but a default constructed
+    // allocator uses the resource of the innermost memory_resource_scope
+    //
+    // Strings default constructed inside of the encoders, and copies of
+    // strings, allocate from the resource in scope
+
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    resource_allocator();
+    resource_allocator(std::pmr::memory_resource* resource);
+
+    template <typename U>
+    resource_allocator(const resource_allocator<U>& other);
+
+    T* allocate(size_t n);
+    void deallocate(T* p, size_t n);
+
+    resource_allocator select_on_container_copy_construction() const;
+
+    std::pmr::memory_resource* resource() const;
+
+private:
+    std::pmr::memory_resource* resource_;
+};
+
+template <typename T, typename U>
+bool operator==(const resource_allocator<T>& lhs, const resource_allocator<U>& rhs);
+
+#endif // APRS_TRACK_PMR
+
 #ifndef APRS_TRACK_DEFINE_CUSTOM_TYPES
 
+#ifdef APRS_TRACK_PMR
+using string_t = std::basic_string<char, std::char_traits<char>, resource_allocator<char>>;
+#else
 using string_t = std::basic_string<char>;
+#endif
 
 #endif // APRS_TRACK_DEFINE_CUSTOM_TYPES
 
@@ -114,7 +257,11 @@ APRS_TRACK_NAMESPACE_END
 APRS_TRACK_NAMESPACE_BEGIN
 
 struct tracker; // forward declaration
-enum class mic_e_status; // forward declaration
+struct tracker_profile; // forward declaration
+struct packet_airtime; // forward declaration
+enum class mic_e_status : uint8_t; // forward declaration
+enum class packet_type; // forward declaration
+struct track_log_entry; // forward declaration
 
 APRS_TRACK_DETAIL_NAMESPACE_BEGIN
 
@@ -159,8 +306,585 @@ struct data
     int hour = 0; // 24 hour format, 0-23
     int minute = 0;
     int second = 0;
+    bool has_time = false; // set when the time fields were supplied
+};
+
+struct packed_data
+{
+    // A fix in fixed point, as stored by the history, the station table
+    // and the track log
+    //
+    // Latitude and longitude are in 1e-7 degrees, speed in 1e-2 knots,
+    // track in 1e-2 degrees and altitude in 1e-2 feet
+    //
+    // The speed has 32 bits, 16 bits would stop at 655.35 knots, below
+    // the 999 knots of the uncompressed format, 16 bits hold any course
+
+    int32_t lat = 0;
+    int32_t lon = 0;
+    int32_t alt = 0;
+    uint32_t speed = 0;
+    uint16_t track = 0;
+    uint8_t day = 0;
+    uint8_t hour = 0;
+    uint8_t minute = 0;
+    uint8_t second = 0;
+    uint8_t has_speed : 1 = 0;
+    uint8_t has_track : 1 = 0;
+    uint8_t has_alt : 1 = 0;
+    uint8_t has_time : 1 = 0;
+};
+
+static_assert(sizeof(packed_data) <= 32, "a fix must fit in half of a cache line");
+
+struct fix_data
+{
+    // The fix as stored by the tracker, as given to the setters, in the
+    // units of the encoders
+    //
+    // The values are not quantized, the encoders round them to the
+    // resolution of each format, rounding them before would change the
+    // packets near the rounding boundaries
+
+    double lat = 0.0;
+    double lon = 0.0;
+    double speed_knots = 0.0;
+    double track_degrees = 0.0;
+    double alt_feet = 0.0;
+    uint8_t day = 0;
+    uint8_t hour = 0;
+    uint8_t minute = 0;
+    uint8_t second = 0;
+    uint8_t has_speed : 1 = 0;
+    uint8_t has_track : 1 = 0;
+    uint8_t has_alt : 1 = 0;
+    uint8_t has_time : 1 = 0;
+};
+
+struct history_entry
+{
+    // A fix in the position history, with its contribution to the
+    // aggregates, relative to the previous fix
+
+    packed_data fix;
+    int32_t distance_cm = 0;
+    int32_t heading_change = 0; // absolute, in 1e-2 degrees
+};
+
+int32_t pack_degrees(double degrees);
+uint32_t pack_speed(double speed_knots);
+uint16_t pack_track(double track_degrees);
+int32_t pack_alt(double alt_feet);
+packed_data pack_data(const data& d);
+data unpack_data(const packed_data& p);
+fix_data make_fix_data(const data& d);
+data make_data(const fix_data& f);
+
+template <typename T, size_t N>
+struct fixed_vector
+{
+    // Inline storage with a compile time capacity, used in place of std::vector
+    // with APRS_TRACK_HEAP_FREE, elements past the capacity are dropped
+
+    template <typename InputIterator>
+    void assign(InputIterator begin, InputIterator end);
+    void resize(size_t size);
+    void clear();
+
+    size_t size() const;
+    static constexpr size_t capacity() { return N; }
+
+    T* data();
+    const T* data() const;
+    T* begin();
+    T* end();
+    const T* begin() const;
+    const T* end() const;
+
+    T& operator[](size_t index);
+    const T& operator[](size_t index) const;
+
+    T elements_[N] = {};
+    size_t size_ = 0;
+};
+
+struct packet_cache_key
+{
+    // The fix quantized the same way as the encoder of a packet type,
+    // fixes with equal keys encode to the same bytes
+
+    int64_t lat = 0;
+    int64_t lon = 0;
+    int course = 0;
+    int speed = 0;
+    int alt = 0;
+    int day = 0;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    unsigned int flags = 0;
+
+    bool operator==(const packet_cache_key&) const = default;
+};
+
+enum packet_field : unsigned int
+{
+    packet_field_lat = 1,
+    packet_field_lon = 2,
+    packet_field_course_speed = 4,
+    packet_field_alt = 8,
+    packet_field_time = 16,
+    packet_field_all = 31,
+};
+
+struct packet_field_span
+{
+    size_t offset = 0;
+    size_t size = 0; // 0 if the field is not in the packet
+};
+
+struct packet_layout
+{
+    // Offsets of the fields in a packet of a fixed length format
+
+    bool valid = false;
+    packet_field_span destination; // Mic-E only, the latitude is encoded in the destination address
+    packet_field_span lat;
+    packet_field_span lon;
+    packet_field_span course_speed;
+    packet_field_span alt;
+    packet_field_span time;
+};
+
+struct packet_cache_entry
+{
+    bool valid = false;
+    uint64_t revision = 0;
+    unsigned int dirty = 0; // packet_field bits set since the packet was rendered
+    packet_cache_key key;
+    packet_layout layout;
+    string_t packet;
+};
+
+constexpr size_t packet_type_count = 9; // packet types excluding smallest, checked after packet_type
+
+struct duplicate_entry
+{
+    uint64_t fingerprint = 0; // 0 if the entry is empty
+    int64_t time = 0; // milliseconds, when the packet was first seen
+};
+
+struct station_entry
+{
+    uint64_t key = 0; // callsign_key value, 0 if the entry is empty
+    packed_data fix;
+};
+
+static_assert(sizeof(station_entry) <= 32, "a station must fit in half of a cache line");
+
+constexpr uint32_t grid_npos = 0xFFFFFFFF;
+
+enum packet_kind : uint16_t
+{
+    // The packet types of the APRS-IS t/ filter
+
+    position_packet = 1 << 0, // p
+    object_packet = 1 << 1, // o
+    item_packet = 1 << 2, // i
+    message_packet = 1 << 3, // m
+    query_packet = 1 << 4, // q
+    status_packet = 1 << 5, // s
+    telemetry_packet = 1 << 6, // t
+    user_defined_packet = 1 << 7, // u
+    nws_packet = 1 << 8, // n
+    weather_packet = 1 << 9, // w
+};
+
+constexpr size_t packet_kind_count = 10;
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+struct filter_region
+{
+    // An r/ range or a/ area of a client filter
+
+    uint32_t client = grid_npos; // grid_npos if the region is free
+    bool circle = false;
+    double x = 0.0; // ranges, the unit vector of the center, and the squared chord of the range
+    double y = 0.0;
+    double z = 0.0;
+    double threshold = 0.0;
+    int32_t north = 0; // areas, in 1e-7 degrees
+    int32_t west = 0;
+    int32_t south = 0;
+    int32_t east = 0;
+    int row_begin = 0; // the 1 degree cells overlapped, columns wrap around
+    int row_end = -1;
+    int col_begin = 0;
+    int col_end = -1;
+};
+
+struct filter_trie_node
+{
+    uint32_t children[38] = {}; // A-Z, 0-9, -, and any other character, 0 if none
+    std::vector<uint32_t> clients;
+    uint32_t parent = 0; // grid_npos if the node is free
+    uint8_t child = 0; // the index of the node in the children of its parent
+    uint8_t child_count = 0;
+};
+
+struct filter_client_terms
+{
+    // What a client added to an index, removed without scanning the index
+
+    std::vector<uint32_t> nodes; // trie nodes
+    std::vector<uint64_t> callsigns; // callsign hashes
+    std::vector<uint32_t> regions;
+    uint32_t kinds = 0; // a bit per packet kind
+};
+
+struct filter_index
+{
+    std::vector<filter_trie_node> trie = std::vector<filter_trie_node>(1);
+    std::vector<uint32_t> free_nodes; // pruned trie nodes, reused
+    std::vector<filter_client_terms> clients; // by client id, grown as the clients add terms
+    std::unordered_map<uint64_t, std::vector<uint32_t>> callsigns;
+    std::vector<uint32_t> kinds[packet_kind_count];
+    std::vector<filter_region> regions;
+    std::vector<uint32_t> free_regions;
+    std::vector<std::vector<uint32_t>> cells; // regions by 1 degree cell, allocated with the first region
+};
+
+struct filter_position
+{
+    // The position of a packet, prepared once for the region tests
+
+    bool valid = false;
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+    int32_t lat = 0;
+    int32_t lon = 0;
+    size_t cell = 0;
+};
+
+size_t filter_trie_child(char c);
+void prune_filter_trie(filter_index& index, uint32_t node);
+filter_client_terms& filter_terms(filter_index& index, uint32_t client);
+uint64_t filter_callsign_hash(std::string_view callsign);
+void region_cells(filter_region& r, double north, double west, double south, double east);
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
+
+template <typename T>
+struct spsc_queue
+{
+    // Bounded lock free queue of one producer thread and one consumer thread,
+    // the capacity is rounded up to a power of two
+    //
+    // The producer fills the slot returned by reserve() and commits it, the
+    // consumer reads front() and pops it, slots are reused, so the buffers
+    // of their strings are allocated once
+
+    explicit spsc_queue(size_t capacity);
+
+    T* reserve();
+    void commit();
+    T* front();
+    void pop();
+
+    size_t size() const;
+    size_t capacity() const;
+
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_ = 0; // written by the consumer
+    size_t cached_tail_ = 0; // the last tail_ seen by the consumer
+    alignas(64) std::atomic<size_t> tail_ = 0; // written by the producer
+    size_t cached_head_ = 0; // the last head_ seen by the producer
+};
+
+struct feed_line
+{
+    std::string text;
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::time_point pushed;
+};
+
+struct feed_worker;
+
+void run_feed_worker(feed_worker& w);
+void feed_backoff(size_t& idle);
+
+#endif
+
+struct grid_node
+{
+    // A station in the grid, linked with the other stations of its cell
+    // The position is kept as a unit vector too, for the distance tests
+
+    uint64_t key = 0; // callsign_key value, 0 if the node is free
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+    int32_t lat = 0; // 1e-7 degrees
+    int32_t lon = 0;
+    uint32_t cell = grid_npos;
+    uint32_t next = grid_npos;
+    uint32_t prev = grid_npos;
+};
+
+#if defined(APRS_TRACK_HEAP_FREE)
+using message_data_t = fixed_vector<unsigned char, APRS_TRACK_MESSAGE_CAPACITY>;
+using packet_cache_t = fixed_vector<packet_cache_entry, packet_type_count>;
+using history_t = fixed_vector<history_entry, APRS_TRACK_HISTORY_CAPACITY>;
+using duplicate_table_t = fixed_vector<duplicate_entry, APRS_TRACK_DUPLICATE_CAPACITY>;
+using station_table_t = fixed_vector<station_entry, APRS_TRACK_STATION_CAPACITY>;
+#elif defined(APRS_TRACK_PMR)
+using message_data_t = std::vector<unsigned char, resource_allocator<unsigned char>>;
+using packet_cache_t = std::vector<packet_cache_entry, resource_allocator<packet_cache_entry>>;
+using history_t = std::vector<history_entry, resource_allocator<history_entry>>;
+using duplicate_table_t = std::vector<duplicate_entry, resource_allocator<duplicate_entry>>;
+using station_table_t = std::vector<station_entry, resource_allocator<station_entry>>;
+#else
+using message_data_t = std::vector<unsigned char>;
+using packet_cache_t = std::vector<packet_cache_entry>;
+using history_t = std::vector<history_entry>;
+using duplicate_table_t = std::vector<duplicate_entry>;
+using station_table_t = std::vector<station_entry>;
+#endif
+
+uint64_t mix64(uint64_t value);
+uint64_t hash_bytes(const unsigned char* data, size_t size, uint64_t seed);
+uint64_t packet_fingerprint(std::string_view packet);
+uint64_t frame_fingerprint(const unsigned char* frame, size_t size);
+
+size_t encode_ax25_address(std::string_view address, bool destination, bool last, unsigned char* output);
+uint16_t fcs_register(uint16_t crc, const unsigned char* data, size_t size);
+uint16_t fcs_shift(uint16_t crc, size_t size);
+bool ax25_address_equal(const unsigned char* a, const unsigned char* b);
+bool ax25_wide_hops(const unsigned char* address, int& n, int& remaining);
+
+bool decode_position(std::string_view s, data& d, char& symbol_table, char& symbol_code);
+bool decode_mic_e_position(std::string_view to, std::string_view info, data& d, char& symbol_table, char& symbol_code);
+void decode_altitude(std::string_view comment, data& d);
+
+double distance_meters(double lat1, double lon1, double lat2, double lon2);
+history_entry make_history_entry(const packed_data& previous, const packed_data& fix);
+
+struct track_log_state
+{
+    // The previous fix of a track log block, the fixes are encoded
+    // relative to it, the state is reset at the start of every block
+
+    int64_t time = 0;
+    int64_t time_delta = 0;
+    int64_t lat_delta = 0;
+    int64_t lon_delta = 0;
+    int32_t lat = 0;
+    int32_t lon = 0;
+    int32_t alt = 0;
+    uint32_t speed = 0;
+    uint16_t track = 0;
+    uint8_t flags = 0;
+    bool started = false;
+};
+
+struct track_log_block
+{
+    int64_t first_time = 0;
+    int64_t last_time = 0;
+    uint64_t offset = 0; // of the first fix, from the start of the log
+    uint32_t count = 0;
+};
+
+enum track_log_flag : uint8_t
+{
+    track_log_has_speed = 1,
+    track_log_has_track = 2,
+    track_log_has_alt = 4,
+    track_log_has_time = 8,
+};
+
+enum track_log_field : uint8_t
+{
+    // bits of the byte starting every fix, set for the values which follow it
+
+    track_log_time = 1,
+    track_log_lat = 2,
+    track_log_lon = 4,
+    track_log_alt = 8,
+    track_log_speed = 16,
+    track_log_track = 32,
+    track_log_flags = 64,
+};
+
+inline constexpr size_t track_log_header_size = 8;
+inline constexpr size_t track_log_block_size = 32; // of a block index entry
+inline constexpr size_t track_log_footer_size = 24;
+
+uint64_t zigzag_encode(int64_t value);
+int64_t zigzag_decode(uint64_t value);
+void write_varint(std::vector<unsigned char>& out, uint64_t value);
+bool read_varint(const unsigned char*& p, const unsigned char* end, uint64_t& value);
+void write_le(std::vector<unsigned char>& out, uint64_t value, size_t bytes);
+uint64_t read_le(const unsigned char* p, size_t bytes);
+void encode_track_log_fix(std::vector<unsigned char>& out, track_log_state& s, int64_t time, const packed_data& fix);
+bool decode_track_log_fix(const unsigned char*& p, const unsigned char* end, track_log_state& s);
+void write_track_log_block(std::vector<unsigned char>& out, const track_log_block& block);
+track_log_block read_track_log_block(const unsigned char* p);
+void make_track_log_entry(const track_log_state& s, track_log_entry& entry);
+void utc_day_hour_minute_second(int64_t time, packed_data& fix);
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+enum position_column : size_t
+{
+    position_column_time,
+    position_column_lat,
+    position_column_lon,
+    position_column_alt,
+    position_column_speed,
+    position_column_track,
+    position_column_flags, // track_log_flag
+    position_column_count,
+};
+
+struct bit_column
+{
+    // Bits appended from the least significant bit of the first word
+
+    std::vector<uint64_t> words;
+    size_t bits = 0;
+};
+
+struct position_chunk
+{
+    // Up to a chunk size of fixes of one station, a compressed column per field
+    //
+    // The time, latitude and longitude are stored as the change of their
+    // delta from the previous fix, the other fields as their delta, like a
+    // track log block, in 1 bit if the value is 0, else in 9, 15, 24 or 68
+    // bits. The first fix is absolute, the second a plain delta
+    //
+    // The time range and the bounds of the positions are kept to skip the
+    // chunk in queries
+
+    bit_column columns[position_column_count];
+    int64_t first_time = 0;
+    int64_t last_time = 0;
+    int32_t north = INT32_MIN;
+    int32_t south = INT32_MAX;
+    int32_t west = INT32_MAX;
+    int32_t east = INT32_MIN;
+    uint32_t count = 0;
+};
+
+struct position_series
+{
+    uint64_t key = 0; // callsign_key value
+    std::vector<position_chunk> chunks;
+    int64_t last[position_column_count] = {}; // of the last chunk, the values are encoded relative to
+    int64_t last_delta[position_column_count] = {};
+};
+
+struct position_query
+{
+    // A query of a position_store, and the arrays its chunks are decoded to
+
+    int64_t begin = 0;
+    int64_t end = 0;
+    bool box = false;
+    int32_t north = 0;
+    int32_t west = 0;
+    int32_t south = 0;
+    int32_t east = 0;
+    std::vector<int64_t> values; // a chunk size of values per column
+    std::vector<uint8_t> matches;
+};
+
+void write_bits(bit_column& c, uint64_t value, size_t count);
+uint64_t read_bits(const bit_column& c, size_t& position, size_t count);
+void write_position_value(bit_column& c, int64_t value);
+int64_t read_position_value(const bit_column& c, size_t& position);
+void append_position_chunk(position_series& series, int64_t time, const packed_data& fix);
+void decode_position_column(const position_chunk& chunk, size_t column, size_t count, int64_t* out);
+bool position_chunk_overlaps(const position_chunk& chunk, const position_query& q);
+
+#endif // APRS_TRACK_HEAP_FREE
+
+inline constexpr uint8_t tracker_snapshot_version = 4; // 4: message bytes and length; 3: fix in float64, 32 bit rates; 2: 32 bit speed, phase; 1 to 3 are still read
+
+struct snapshot_reader
+{
+    // Bounds checked reads of a snapshot record, ok is cleared by
+    // the first read past the end
+
+    uint64_t le(size_t bytes);
+    double float64();
+    std::string_view string();
+
+    const unsigned char* p = nullptr;
+    const unsigned char* end = nullptr;
+    bool ok = true;
+};
+
+void write_float64(std::vector<unsigned char>& out, double value);
+void write_snapshot_string(std::vector<unsigned char>& out, std::string_view s);
+
+std::chrono::milliseconds callsign_phase(std::string_view callsign);
+int64_t beacon_slot(std::chrono::milliseconds time, std::chrono::milliseconds phase, std::chrono::milliseconds period);
+
+enum class profile_field : uint32_t
+{
+    // The settings of a tracker which can come from a tracker_profile,
+    // as bits of a uint32_t mask
+
+    none = 0,
+    to = 1,
+    path = 2,
+    symbol_code = 4,
+    symbol_table = 8,
+    ambiguity = 16,
+    messaging = 32,
+    mic_e_status = 64,
+    algorithm = 128,
+    interval = 256,
+    low_speed = 512,
+    high_speed = 1024,
+    slow_rate = 2048,
+    fast_rate = 4096,
+    turn_time = 8192,
+    turn_angle = 16384,
+    turn_slope = 32768,
+    baud_rate = 65536,
+};
+
+void copy_profile_fields(const tracker_profile& from, tracker_profile& to, uint32_t fields);
+
+#ifndef APRS_TRACK_HEAP_FREE
+const std::shared_ptr<const tracker_profile>& default_tracker_profile();
+#endif
+
+struct shared_message
+{
+    // An immutable message, referenced by any number of trackers
+
+    std::vector<unsigned char> bytes;
+    size_t length = 0; // in characters
 };
 
+#ifdef APRS_TRACK_PMR
+
+std::pmr::memory_resource*& memory_resource_slot();
+
+template <typename T>
+T make_with_resource(std::pmr::memory_resource* resource);
+
+#endif // APRS_TRACK_PMR
+
 string_t encode_position_packet_no_timestamp_no_message(const tracker& t, const data& d);
 string_t encode_position_packet_no_timestamp(const tracker& t, const data& d);
 string_t encode_position_packet_with_timestamp_dhm_no_message(const tracker& t, const data& d);
@@ -171,9 +895,23 @@ string_t encode_position_packet_with_utc_timestamp_dhm_no_message(const tracker&
 string_t encode_position_packet_with_utc_timestamp_dhm(const tracker& t, const data& d);
 string_t encode_position_packet_compressed_no_timestamp_no_message(const tracker& t, const data& d);
 string_t encode_position_packet_compressed_no_timestamp(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_hms_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_hms(const tracker& t, const data& d);
+size_t encode_position_packet_compressed_with_timestamp_no_message(const tracker& t, const data& d, char timestamp_format, char* out, size_t out_size);
 string_t encode_mic_e_packet_no_message(const tracker& t, const data& d);
 string_t encode_mic_e_packet(const tracker& t, const data& d);
 
+packet_airtime estimate_airtime(std::string_view packet, int baud_rate);
+
+bool make_packet_cache_key(packet_type p, const data& d, packet_cache_key& key);
+unsigned int changed_packet_fields(const packet_cache_key& previous, const packet_cache_key& current);
+packet_layout make_packet_layout(packet_type p, const tracker& t, const data& d, size_t packet_size);
+bool render_packet_fields(packet_type p, const tracker& t, const data& d, const packet_layout& layout, unsigned int fields, string_t& packet);
+
 bool smart_beaconing_test(int speed, int prev_course, int course, int low_speed, int high_speed, int slow_interval_seconds, int fast_interval_seconds, int min_turn_degrees, int turn_interval_seconds, int turn_slope, int last_update_seconds);
 
 double meters_to_feet(double meters);
@@ -212,9 +950,12 @@ enum class packet_type
     position_compressed_with_timestamp,
     position_compressed_with_timestamp_utc,
     position_compressed_with_timestamp_utc_hms,
+    smallest, // the encoding with the least airtime that carries all of the fix data
 };
 
-enum class mic_e_status
+static_assert(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_type_count == static_cast<size_t>(packet_type::smallest));
+
+enum class mic_e_status : uint8_t
 {
     off_duty,   // 1 1 1
     en_route,   // 1 1 0
@@ -327,15 +1068,108 @@ enum class device_id
     ftm_400dr,
 };
 
-enum class algorithm
+using message_handle = std::shared_ptr<const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE shared_message>;
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+struct message_pool
+{
+    // Interns messages, trackers using the same message share one buffer
+    //
+    // Not thread safe, the pool has no lock: callers synchronize all of the
+    // calls on a pool, including size(), bytes() and collect(), if it is
+    // used from several threads. The handles can be used from any thread
+
+    message_handle intern(std::string_view message);
+
+    size_t size() const;
+    size_t bytes() const;
+
+    size_t collect();
+
+private:
+    std::unordered_map<std::string_view, message_handle> messages_; // the keys view the bytes of the values
+};
+
+#endif // APRS_TRACK_HEAP_FREE
+
+enum class algorithm : uint8_t
 {
     smart_beaconing,
     periodic,
     none,
 };
 
+struct packet_airtime
+{
+    size_t packet_bytes = 0; // TNC2 packet length
+    size_t frame_bytes = 0; // AX.25 frame length: addresses, control, PID, information field and FCS
+    size_t frame_bits = 0; // bits on air: HDLC flags, frame and bit stuffing
+    double seconds = 0.0; // frame_bits at the baud rate
+};
+
+struct tracker_profile
+{
+    // Configuration shared by many trackers
+
+    string_t to;
+    string_t path;
+    char symbol_code = '>';
+    char symbol_table = '/';
+    int ambiguity = 0;
+    bool messaging = false;
+    enum mic_e_status mic_e_status = mic_e_status::in_service;
+    enum algorithm algorithm = algorithm::none;
+    unsigned int interval_seconds = 30;
+    double low_speed_knots = 4.0;
+    double high_speed_knots = 52.0;
+    int slow_rate = 60;
+    int fast_rate = 30;
+    int turn_time = 15;
+    int turn_angle = 15;
+    int turn_slope = 255;
+    int baud_rate = 1200;
+};
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+struct shared_profile
+{
+    // A tracker_profile which can be replaced while trackers use it
+    //
+    // store() swaps the profile atomically, the trackers referencing the
+    // shared profile apply it on their next update()
+
+    shared_profile() = default;
+    explicit shared_profile(const tracker_profile& p);
+
+    void store(const tracker_profile& p);
+    std::shared_ptr<const tracker_profile> load() const;
+    uint64_t version() const;
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const tracker_profile>> profile_ = std::make_shared<const tracker_profile>();
+#else
+    std::shared_ptr<const tracker_profile> profile_ = std::make_shared<const tracker_profile>();
+    mutable std::mutex mutex_; // guards profile_, std::atomic_load on a std::shared_ptr is deprecated
+#endif
+    std::atomic<uint64_t> version_ = 1;
+};
+
+#endif // APRS_TRACK_HEAP_FREE
+
 struct tracker
 {
+#ifdef APRS_TRACK_PMR
+    tracker();
+    explicit tracker(std::pmr::memory_resource* resource);
+
+    tracker(const tracker& other);
+    tracker(tracker&& other) = default;
+    tracker& operator=(const tracker& other);
+#endif
+
     void algorithm(enum algorithm a);
     enum algorithm algorithm() const;
 
@@ -393,8 +1227,13 @@ struct tracker
     template <std::output_iterator<unsigned char> OutputIterator>
     void message(OutputIterator output);
 
+#ifndef APRS_TRACK_HEAP_FREE
+    void message(const message_handle& m);
+#endif
+
     string_t message() const;
     std::u8string u8message() const;
+    std::string_view message_view() const;
 
     template <class Rep, class Period>
     void interval(std::chrono::duration<Rep, Period> interval);
@@ -418,12 +1257,22 @@ struct tracker
     void track(double track_degrees);
 
     void update();
+    void update(std::chrono::milliseconds now);
     bool updated() const;
 
+    void phase(std::chrono::milliseconds offset);
+    void phase_from_callsign();
+    std::chrono::milliseconds phase() const;
+
     string_t packet_string_no_message(packet_type p) const;
 
     string_t packet_string(packet_type p) const;
 
+#ifdef APRS_TRACK_PMR
+    string_t packet_string_no_message(packet_type p, std::pmr::memory_resource* resource) const;
+    string_t packet_string(packet_type p, std::pmr::memory_resource* resource) const;
+#endif
+
     std::u8string u8packet_string(packet_type p) const;
 
     template <std::output_iterator<unsigned char> OutputIterator>
@@ -434,2637 +1283,11177 @@ struct tracker
 
     bool smart_beaconing_test();
 
-private:
-    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data data_;
-    std::vector<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> data_list_;
-    string_t from_;
-    string_t to_;
-    string_t path_;
-    enum algorithm algorithm_ = algorithm::none;
-    std::vector<unsigned char> message_data_;
-    size_t message_data_length_ = 0;
-    char symbol_code_ = '>';
-    char symbol_table_ = '/';
-    unsigned int interval_seconds_ = 30;
-    unsigned int last_update_seconds = 0;
-    std::optional<double> previous_track_degrees_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_time;
-    double low_speed_knots_ = 4.0;  // 5 mph -> 4 knots
-    double high_speed_knots_ = 52.0; // 60 mph -> 52 knots
-    int slow_rate_ = 60; // 60 seconds (1 minute)
-    int fast_rate_ = 30; // 30 seconds
-    int turn_time_ = 15; // 15 seconds
-    int turn_angle_ = 15; // 15 degrees
-    int turn_slope_ = 255; // 255 (no slope)
-    int ambiguity_ = 0;
-    bool aprs_messaging_ = false;
-    bool updated_ = false;
-    enum mic_e_status mic_e_status_ = mic_e_status::in_service;
-};
+    void baud_rate(int baud);
+    int baud_rate() const;
 
-string_t to_string(mic_e_status status);
+    packet_type smallest_packet_type() const;
 
-string_t to_string(packet_type type);
+    packet_airtime airtime(packet_type p) const;
 
-APRS_TRACK_NAMESPACE_END
+    void account(const packet_airtime& a);
+    size_t total_packets() const;
+    size_t total_bytes() const;
+    double total_airtime_seconds() const;
 
-// **************************************************************** //
-//                                                                  //
-//                                                                  //
-// public definitions                                               //
-//                                                                  //
-//                                                                  //
-// **************************************************************** //
+    void packet_cache(bool enabled);
+    bool packet_cache() const;
 
-APRS_TRACK_NAMESPACE_BEGIN
+#ifndef APRS_TRACK_HEAP_FREE
+    void profile(std::shared_ptr<shared_profile> p);
+    const std::shared_ptr<shared_profile>& profile() const;
+#endif
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    void history_capacity(size_t capacity);
+    size_t history_capacity() const;
+    size_t history_size() const;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data history(size_t index) const;
 
-APRS_TRACK_INLINE string_t to_string(mic_e_status status)
-{
-    switch (status)
-    {
-        case mic_e_status::off_duty: return "off_duty";
-        case mic_e_status::en_route: return "en_route";
-        case mic_e_status::in_service: return "in_service";
-        case mic_e_status::returning: return "returning";
-        case mic_e_status::commited: return "commited";
-        case mic_e_status::special: return "special";
-        case mic_e_status::priority: return "priority";
-        case mic_e_status::emergency: return "emergency";
-        case mic_e_status::custom0: return "custom0";
-        case mic_e_status::custom1: return "custom1";
-        case mic_e_status::custom2: return "custom2";
-        case mic_e_status::custom3: return "custom3";
-        case mic_e_status::custom4: return "custom4";
-        case mic_e_status::custom5: return "custom5";
-        case mic_e_status::custom6: return "custom6";
-        default:
-            break;
-    }
-    return "unknown";
-}
+    template <std::output_iterator<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> OutputIterator>
+    void history(OutputIterator output) const;
 
-APRS_TRACK_INLINE string_t to_string(packet_type type)
-{
-    switch (type)
-    {
-        case packet_type::mic_e: return "mic_e";
-        case packet_type::position: return "position";
-        case packet_type::position_compressed: return "position_compressed";
-        case packet_type::position_with_timestamp: return "position_with_timestamp";
-        case packet_type::position_with_timestamp_utc: return "position_with_timestamp_utc";
-        case packet_type::position_with_timestamp_utc_hms: return "position_with_timestamp_utc_hms";
-        case packet_type::position_compressed_with_timestamp: return "position_compressed_with_timestamp";
-        case packet_type::position_compressed_with_timestamp_utc: return "position_compressed_with_timestamp_utc";
-        case packet_type::position_compressed_with_timestamp_utc_hms: return "position_compressed_with_timestamp_utc_hms";
-        default:
-            break;
-    }
-    return "";
-}
+    double history_distance() const;
+    double history_heading_change() const;
+    double history_average_speed() const;
 
-APRS_TRACK_INLINE void tracker::algorithm(enum algorithm a)
-{
-    algorithm_ = a;
-}
+#ifndef APRS_TRACK_HEAP_FREE
+    void snapshot(std::vector<unsigned char>& out) const;
+#endif
+    size_t restore(std::span<const unsigned char> bytes);
 
-APRS_TRACK_INLINE enum algorithm tracker::algorithm() const
-{
-    return algorithm_;
-}
+private:
+    string_t encode_packet_no_message(packet_type p) const;
+    void invalidate_packet_cache();
+    void mark_dirty(unsigned int fields);
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data fix() const;
+    std::span<const unsigned char> message_bytes() const;
+    void record_history();
+    const tracker_profile& settings() const;
+    tracker_profile& modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field field);
+#ifndef APRS_TRACK_HEAP_FREE
+    std::shared_ptr<tracker_profile> copy_settings(const tracker_profile& p) const;
+    void apply_profile();
+#endif
 
-APRS_TRACK_INLINE void tracker::symbol_code(char c)
-{
-    symbol_code_ = c;
-}
+    // Ordered by alignment to avoid padding
+    //
+    // With APRS_TRACK_PMR, the copy assignment lists the members
 
-APRS_TRACK_INLINE char tracker::symbol_code() const
-{
-    return symbol_code_;
-}
+    string_t from_;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE message_data_t message_data_;
+#ifdef APRS_TRACK_HEAP_FREE
+    tracker_profile settings_;
+#else
+    message_handle shared_message_; // used instead of message_data_ if set
+    std::shared_ptr<shared_profile> profile_;
+    std::shared_ptr<const tracker_profile> settings_ = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE default_tracker_profile(); // shared with the profile, owned if overrides_ is not 0
+#endif
+    mutable APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_cache_t packet_cache_; // indexed by packet_type, grown on first use
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE history_t history_; // ring buffer, sized once by history_capacity()
+    int64_t history_distance_cm_ = 0; // sums over the history, except the contribution of the oldest fix
+    int64_t history_heading_change_ = 0;
+    int64_t history_speed_sum_ = 0; // sum of the speeds of the fixes with a speed
+    std::chrono::milliseconds last_time = std::chrono::milliseconds(0); // of the last beacon, since the epoch, 0 if none
+    std::chrono::milliseconds phase_ = std::chrono::milliseconds(-1); // of the beacon slots, none if negative
+    size_t total_packets_ = 0;
+    size_t total_bytes_ = 0;
+    double total_airtime_seconds_ = 0.0;
+    uint64_t revision_ = 0; // bumped by the setters which affect the packet bytes, besides the fix
+#ifdef APRS_TRACK_PMR
+    std::pmr::memory_resource* resource_ = nullptr; // storage of the tracker
+#endif
+    uint64_t profile_version_ = 0; // version of the applied profile
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE fix_data data_;
+    unsigned int last_update_seconds = 0;
+    uint32_t message_data_length_ = 0;
+    uint32_t history_head_ = 0; // where the next fix is written
+    uint32_t history_count_ = 0;
+    uint32_t history_speed_count_ = 0;
+    uint32_t overrides_ = 0; // profile_field bits of the settings set on the tracker, which the profile does not change
+    int32_t previous_track_degrees_ = 0;
+    bool updated_ = false;
+    bool packet_cache_enabled_ = false;
+};
 
-APRS_TRACK_INLINE void tracker::symbol_table(char t)
+struct transmit_arbiter
 {
-    symbol_table_ = t;
-}
+    void baud_rate(int baud);
+    int baud_rate() const;
 
-APRS_TRACK_INLINE char tracker::symbol_table() const
-{
-    return symbol_table_;
-}
+    void txdelay(std::chrono::milliseconds delay);
+    std::chrono::milliseconds txdelay() const;
 
-APRS_TRACK_INLINE void tracker::from(std::string_view f)
-{
-    from_ = f.data();
-}
+    void budget(double channel_fraction);
+    double budget() const;
 
-APRS_TRACK_INLINE const string_t& tracker::from() const
-{
-    return from_;
-}
+    void burst(std::chrono::milliseconds airtime);
+    std::chrono::milliseconds burst() const;
 
-APRS_TRACK_INLINE void tracker::to(std::string_view t)
-{
-    to_ = t.data();
-}
+    void jitter(std::chrono::milliseconds max_jitter);
+    std::chrono::milliseconds jitter() const;
 
-APRS_TRACK_INLINE const string_t& tracker::to() const
-{
-    return to_;
-}
+    void seed(uint32_t seed);
 
-APRS_TRACK_INLINE void tracker::path(std::string_view p)
-{
-    path_ = p.data();
-}
+    std::chrono::microseconds airtime(std::string_view packet) const;
 
-APRS_TRACK_INLINE const string_t& tracker::path() const
-{
-    return path_;
-}
+    bool request(std::string_view packet, bool emergency, std::chrono::milliseconds now);
+    bool request(const tracker& t, packet_type p, std::chrono::milliseconds now);
 
-APRS_TRACK_INLINE void tracker::ambiguity(int a)
-{
-    ambiguity_ = a;
-}
+    std::chrono::milliseconds next_time() const;
 
-APRS_TRACK_INLINE int tracker::ambiguity() const
-{
-    return ambiguity_;
-}
+    size_t granted() const;
+    size_t deferred() const;
+    std::chrono::microseconds total_airtime() const;
 
-APRS_TRACK_INLINE void tracker::messaging(bool m)
-{
-    aprs_messaging_ = m;
-}
+private:
+    void refill(std::chrono::milliseconds now);
+    uint32_t next_random();
+
+    int baud_rate_ = 1200;
+    std::chrono::milliseconds txdelay_ = std::chrono::milliseconds(300);
+    double budget_ = 0.1; // 10% of the channel time
+    std::chrono::microseconds burst_ = std::chrono::seconds(3);
+    std::chrono::milliseconds jitter_ = std::chrono::milliseconds(500);
+    std::chrono::microseconds tokens_ = std::chrono::seconds(3);
+    std::chrono::milliseconds last_refill_ = std::chrono::milliseconds(0);
+    std::chrono::milliseconds next_time_ = std::chrono::milliseconds(0);
+    bool started_ = false;
+    uint32_t random_state_ = 0x9E3779B9;
+    size_t granted_ = 0;
+    size_t deferred_ = 0;
+    std::chrono::microseconds total_airtime_ = std::chrono::microseconds(0);
+};
 
-APRS_TRACK_INLINE bool tracker::messaging() const
+struct duplicate_filter
 {
-    return aprs_messaging_;
-}
+    // Remembers the packets seen in a time window, for duplicate suppression
+    // in digipeaters and igates
+    //
+    // Packets are identified by a 64 bit fingerprint of their source,
+    // destination and information field, the path is ignored, TNC2 packets
+    // and AX.25 frames of the same packet have the same fingerprint
+    //
+    // The fingerprints are kept in a table allocated once, in buckets of
+    // 8 entries, expired entries are reused, and when a bucket is full
+    // its oldest entry is evicted
 
-APRS_TRACK_INLINE void tracker::mic_e_status(enum mic_e_status s)
-{
-    mic_e_status_ = s;
-}
+    duplicate_filter();
+    explicit duplicate_filter(size_t capacity, std::chrono::milliseconds window = std::chrono::seconds(30));
 
-APRS_TRACK_INLINE enum mic_e_status tracker::mic_e_status() const
-{
-    return mic_e_status_;
-}
+    void window(std::chrono::milliseconds window);
+    std::chrono::milliseconds window() const;
+    size_t capacity() const;
 
-APRS_TRACK_INLINE void tracker::low_speed(double speed_mps)
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    bool check(std::string_view packet, std::chrono::milliseconds now);
+    bool check(const unsigned char* frame, size_t size, std::chrono::milliseconds now);
+    bool check(uint64_t fingerprint, std::chrono::milliseconds now);
 
-    low_speed_knots_ = mps_to_knots(speed_mps);
-}
+    void clear();
 
-APRS_TRACK_INLINE double tracker::low_speed() const
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    size_t duplicates() const;
+    size_t evictions() const;
 
-    return knots_to_mps(low_speed_knots_);
-}
+private:
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE duplicate_table_t table_;
+    std::chrono::milliseconds window_ = std::chrono::seconds(30);
+    size_t duplicates_ = 0;
+    size_t evictions_ = 0; // live entries evicted from full buckets, the table might be too small
+};
 
-APRS_TRACK_INLINE void tracker::high_speed(double speed_mps)
+struct digipeater
 {
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    // Repeats AX.25 UI frames addressed to it, in place
+    //
+    // The next unused digipeater address of a frame is repeated if it is:
+    //
+    //   - the digipeater callsign, marked as repeated
+    //   - an alias like WIDE1-1 or RELAY, replaced with the callsign
+    //   - WIDEn-N with n up to max_hops, the callsign is inserted and N decremented
+    //
+    //   N0CALL>APRS,WIDE1-1,WIDE2-2 -> N0CALL>APRS,DIGI*,WIDE2-2
+    //   N0CALL>APRS,DIGI1*,WIDE2-2  -> N0CALL>APRS,DIGI1*,DIGI*,WIDE2-1
+    //   N0CALL>APRS,DIGI1*,WIDE2-1  -> N0CALL>APRS,DIGI1*,DIGI*,WIDE2*
+    //
+    // With preemptive digipeating, the callsign or an alias further down
+    // the path is repeated, and the unused addresses before it are marked used
+    //
+    // Frames are passed without the HDLC flags and with the FCS, the FCS is
+    // updated from the changed addresses only, frames with a bad FCS stay bad
+    // Use a duplicate_filter to avoid repeating the same packet twice
 
-    high_speed_knots_ = mps_to_knots(speed_mps);
-}
+    void callsign(std::string_view callsign);
+    string_t callsign() const;
 
-APRS_TRACK_INLINE double tracker::high_speed() const
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    void aliases(std::string_view aliases);
+    string_t aliases() const;
 
-    return knots_to_mps(high_speed_knots_);
-}
+    void max_hops(int n);
+    int max_hops() const;
 
-APRS_TRACK_INLINE void tracker::slow_rate(int seconds)
-{
-    slow_rate_ = seconds;
-}
+    void preemptive(bool enable);
+    bool preemptive() const;
 
-APRS_TRACK_INLINE int tracker::slow_rate() const
-{
-    return slow_rate_;
-}
+    size_t digipeat(unsigned char* frame, size_t size, size_t capacity);
 
-APRS_TRACK_INLINE void tracker::fast_rate(int seconds)
-{
-    fast_rate_ = seconds;
-}
+    size_t repeated() const;
 
-APRS_TRACK_INLINE int tracker::fast_rate() const
-{
-    return fast_rate_;
-}
+private:
+    string_t callsign_;
+    string_t aliases_;
+    unsigned char callsign_address_[7] = {};
+    unsigned char alias_addresses_[8][7] = {};
+    size_t alias_count_ = 0;
+    bool has_callsign_ = false;
+    int max_hops_ = 2; // WIDE2-2 at most
+    bool preemptive_ = false;
+    size_t repeated_ = 0;
+};
 
-APRS_TRACK_INLINE void tracker::turn_time(int seconds)
+struct callsign_key
 {
-    turn_time_ = seconds;
-}
+    // A callsign and SSID packed in 64 bits, one character per byte
+    // from the most significant byte, then the SSID in the lowest byte
+    //
+    //   N0CALL-9 -> 'N' '0' 'C' 'A' 'L' 'L' 0 9
+    //
+    // Keys compare in the same order as the callsigns, 0 is not a valid key
 
-APRS_TRACK_INLINE int tracker::turn_time() const
-{
-    return turn_time_;
-}
+    uint64_t value = 0;
 
-APRS_TRACK_INLINE void tracker::turn_angle(int degrees)
-{
-    turn_angle_ = degrees;
-}
+    bool valid() const;
+    uint8_t ssid() const;
 
-APRS_TRACK_INLINE int tracker::turn_angle() const
-{
-    return turn_angle_;
-}
+    auto operator<=>(const callsign_key&) const = default;
+};
 
-APRS_TRACK_INLINE void tracker::turn_slope(int value)
+struct station_table
 {
-    turn_slope_ = value;
-}
+    // The last known position of each station, by callsign
+    //
+    // Open addressing with linear probing, in a power of 2 table of
+    // 32 byte entries, kept at most 3/4 full
+    // With APRS_TRACK_HEAP_FREE the table is inline, APRS_TRACK_STATION_CAPACITY
+    // entries rounded down to a power of 2, and does not grow
 
-APRS_TRACK_INLINE int tracker::turn_slope() const
-{
-    return turn_slope_;
-}
+    station_table();
+    explicit station_table(size_t capacity);
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    bool update(callsign_key key, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d);
+    bool update(std::string_view callsign, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d);
 
-template <typename CharType, typename Traits>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const std::basic_string_view<CharType, Traits>& m)
-{
-    message_data_length_ = m.size();
+    std::optional<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> find(callsign_key key) const;
+    std::optional<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> find(std::string_view callsign) const;
+    bool contains(callsign_key key) const;
 
-    const unsigned char* data = reinterpret_cast<const unsigned char*>(m.data());
-    size_t size = m.size() * sizeof(CharType);
-    message_data_.assign(data, data + size);
-}
+    bool erase(callsign_key key);
+    void clear();
 
-template <typename CharType>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const CharType* m)
-{
-    message(std::basic_string_view<CharType>(m));
-}
+    void reserve(size_t count);
+    size_t size() const;
+    size_t capacity() const;
 
-template <typename CharType>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const CharType* m, size_t count)
-{
-    message(std::basic_string_view<CharType>(m, count));
-}
+    template <typename F>
+    void for_each(F&& f) const;
 
-template <std::ranges::input_range InputRange>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(InputRange&& input_range)
-{
-    message(std::ranges::begin(input_range), std::ranges::end(input_range));
-}
+private:
+    size_t slot(callsign_key key) const;
+    bool rehash(size_t capacity);
 
-template <std::input_iterator InputIterator>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(InputIterator begin, InputIterator end)
-{
-    message_data_length_ = std::distance(begin, end);
-    message_data_.assign(begin, end);
-}
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE station_table_t table_;
+    size_t size_ = 0;
+};
 
-template <std::output_iterator<unsigned char> OutputIterator>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::message(OutputIterator output)
+#ifndef APRS_TRACK_HEAP_FREE
+
+struct station_grid
 {
-    std::copy(message_data_.begin(), message_data_.end(), output);
-}
+    // The positions of stations in a uniform grid of lat/lon cells, for
+    // radius and box queries, like the r/ and a/ APRS-IS filters
+    //
+    // Each cell links its stations, moving a station to another cell
+    // is O(1), queries visit the cells overlapping the area and test
+    // the stations of the cells in batches
+    //
+    // Queries can run concurrently with each other, updates are exclusive,
+    // on platforms without threads the grid is not synchronized
+    // The query callbacks must not update the grid
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    station_grid();
+    explicit station_grid(double cell_degrees);
 
-APRS_TRACK_INLINE string_t tracker::message() const
-{
-    const char* data = reinterpret_cast<const char*>(message_data_.data());
-    return string_t(data, message_data_length_);
-}
+    void update(callsign_key key, double lat, double lon);
+    bool erase(callsign_key key);
+    bool contains(callsign_key key) const;
+    void clear();
 
-APRS_TRACK_INLINE std::u8string tracker::u8message() const
-{
-    const char8_t* data = reinterpret_cast<const char8_t*>(message_data_.data());
-    return std::u8string(data, message_data_length_);
-}
+    size_t size() const;
+    double cell_degrees() const;
 
+    template <typename F>
+    size_t query_radius(double lat, double lon, double radius_meters, F&& f) const;
+
+    template <typename F>
+    size_t query_box(double north, double west, double south, double east, F&& f) const;
+
+private:
+    uint32_t cell(double lat, double lon) const;
+    uint32_t find_node(uint64_t key) const;
+    void link(uint32_t node, uint32_t cell);
+    void unlink(uint32_t node);
+    void index_insert(uint64_t key, uint32_t node);
+    void index_erase(uint64_t key);
+
+    template <typename F>
+    void visit_cells(int row_begin, int row_end, int col_begin, int col_end, F&& f) const;
+
+    double cell_degrees_ = 1.0;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<uint32_t> cells_; // first node of each cell
+    std::vector<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE grid_node> nodes_;
+    std::vector<uint32_t> index_; // nodes by key, open addressing
+    uint32_t free_ = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE grid_npos; // free nodes, linked with next
+    size_t size_ = 0;
+#if defined(__cpp_lib_shared_mutex)
+    mutable std::shared_mutex mutex_;
 #endif
+};
 
-template <class Rep, class Period>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::interval(std::chrono::duration<Rep, Period> interval)
+#endif // APRS_TRACK_HEAP_FREE
+
+struct decoded_packet
 {
-    interval_seconds_ = static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(interval).count());
-}
+    // The fields of a TNC2 packet, and its position if it has one
+    //
+    // The string views point into the decoded packet
+
+    std::string_view from;
+    std::string_view to;
+    std::string_view path;
+    std::string_view info;
+    uint16_t kinds = 0; // detail::packet_kind flags
+    bool has_position = false;
+    char symbol_table = 0;
+    char symbol_code = 0;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data fix; // lat and lon, and the speed, track and altitude if present
+};
 
-template <Position T>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::position(const T& p)
+#ifndef APRS_TRACK_HEAP_FREE
+
+struct filter_engine
 {
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    // Evaluates APRS-IS server side filters of many clients at once
+    //
+    // The filters are parsed once, into indexes shared by all clients:
+    //
+    //   p/ prefixes and b/ wildcards   - a trie of callsign prefixes
+    //   b/ callsigns                   - a hash map of callsigns
+    //   t/ packet types                - a list of clients per type
+    //   r/ ranges and a/ areas         - the regions overlapping each 1 degree cell
+    //
+    // match() visits the trie along the source callsign, the lists of the
+    // packet types and the regions of the cell of the packet position,
+    // the time depends on the matching filters rather than on the clients
+    // Filters starting with - exclude the packets they match
+    //
+    // Not synchronized, filters are changed and matched from one thread
 
-    data_.lat = p.lat;
-    data_.lon = p.lon;
+    uint32_t add_client();
+    void remove_client(uint32_t client);
+    size_t client_count() const;
 
-    if constexpr (has_speed<T>)
-    {
-        data_.speed_knots = mps_to_knots(p.speed);
-    }
+    bool filter(uint32_t client, std::string_view filter);
 
-    if constexpr (has_track<T>)
-    {
-        data_.track_degrees = p.track;
-    }
+    size_t trie_size() const;
 
-    if constexpr (has_day_hour_minute_seconds<T>)
-    {
-        data_.day = p.day;
-        data_.hour = p.hour;
-        data_.minute = p.minute;
-        data_.second = p.second;
-    }
+    template <typename F>
+    size_t match(std::string_view packet, F&& f);
 
-    if constexpr (has_altitude<T>)
-    {
-        data_.alt_feet = meters_to_feet(p.alt);
-    }
-}
+    template <typename F>
+    size_t match(const decoded_packet& p, F&& f);
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+private:
+    void add_prefix(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, std::string_view prefix, uint32_t client);
+    void add_callsign(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, std::string_view callsign, uint32_t client);
+    void add_region(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_region& r);
+    void remove(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, uint32_t client);
+
+    template <typename F>
+    void collect(const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, const decoded_packet& p, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_position& position, F&& f) const;
+
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index include_;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index exclude_;
+    std::vector<uint32_t> stamps_; // the generation of the last packet which matched each client
+    std::vector<bool> active_;
+    std::vector<uint32_t> free_clients_;
+    uint32_t generation_ = 0;
+    size_t client_count_ = 0;
+};
 
-APRS_TRACK_INLINE void tracker::interval_seconds(int interval_seconds)
-{
-    interval_seconds_ = interval_seconds;
-}
+#endif // APRS_TRACK_HEAP_FREE
 
-APRS_TRACK_INLINE void tracker::position(double lat, double lon)
-{
-    data_.lat = lat;
-    data_.lon = lon;
-}
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
 
-APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees)
+struct feed_record
 {
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    // A line of a feed, decoded by a feed_decoder
 
-    data_.lat = lat;
-    data_.lon = lon;
-    data_.speed_knots = mps_to_knots(speed_mps);
-    data_.track_degrees = track_degrees;
-}
+    uint64_t sequence = 0; // the order in which the line was pushed
+    callsign_key station; // the source callsign, invalid if it does not fit a key
+    uint16_t kinds = 0; // detail::packet_kind flags
+    bool has_position = false;
+    char symbol_table = 0;
+    char symbol_code = 0;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data fix;
+    std::chrono::steady_clock::time_point pushed;
+};
 
-APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees, double alt_meters)
+struct feed_stage_stats
 {
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    // The state of one worker of a feed_decoder
 
-    data_.lat = lat;
-    data_.lon = lon;
-    data_.speed_knots = mps_to_knots(speed_mps);
-    data_.track_degrees = track_degrees;
-    data_.alt_feet = meters_to_feet(alt_meters);
-}
+    size_t lines = 0; // decoded
+    size_t queue_depth = 0; // lines waiting to be decoded
+    size_t max_queue_depth = 0;
+    size_t output_depth = 0; // records waiting to be polled
+    size_t max_output_depth = 0;
+    double decode_latency_ns = 0.0; // average time from push to decoded
+    double max_decode_latency_ns = 0.0;
+    double poll_latency_ns = 0.0; // average time from push to polled
+};
 
-APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees, double alt_meters, int day, int hour, int minute, int second)
+struct feed_decoder
 {
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    // Decodes a feed of TNC2 lines on worker threads
+    //
+    // Lines are sharded by a hash of their source callsign, each worker
+    // takes its lines from one lock free queue and puts the records in
+    // another, so the records of a station are polled in the order its
+    // lines were pushed, the records of different stations can interleave
+    //
+    // push() is called from one thread and poll() from one thread, which
+    // can be the same thread
 
-    data_.lat = lat;
-    data_.lon = lon;
-    data_.speed_knots = mps_to_knots(speed_mps);
-    data_.track_degrees = track_degrees;
-    data_.alt_feet = meters_to_feet(alt_meters);
-    data_.day = day;
-    data_.hour = hour;
-    data_.minute = minute;
-    data_.second = second;
-}
+    explicit feed_decoder(size_t workers = std::thread::hardware_concurrency(), size_t queue_capacity = 4096);
+    ~feed_decoder();
 
-APRS_TRACK_INLINE void tracker::time(int day, int hour, int minute, int second)
-{
-    data_.day = day;
-    data_.hour = hour;
-    data_.minute = minute;
-    data_.second = second;
-}
+    feed_decoder(const feed_decoder&) = delete;
+    feed_decoder& operator=(const feed_decoder&) = delete;
 
-APRS_TRACK_INLINE void tracker::time(int hour, int minute, int second)
-{
-    data_.hour = hour;
-    data_.minute = minute;
-    data_.second = second;
-}
+    bool try_push(std::string_view line);
 
-APRS_TRACK_INLINE void tracker::time(int minute, int second)
-{
-    data_.minute = minute;
-    data_.second = second;
-}
+    template <typename F>
+    void push(std::string_view line, F&& f);
 
-APRS_TRACK_INLINE void tracker::speed(double speed_mps)
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    template <typename F>
+    size_t poll(F&& f);
 
-    data_.speed_knots = mps_to_knots(speed_mps);
-}
+    template <typename F>
+    void finish(F&& f);
 
-APRS_TRACK_INLINE void tracker::alt(double alt_meters)
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    size_t workers() const;
+    std::vector<feed_stage_stats> stats() const;
 
-    data_.alt_feet = meters_to_feet(alt_meters);
-}
+private:
+    std::vector<std::unique_ptr<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE feed_worker>> workers_;
+    uint64_t pushed_ = 0;
+    uint64_t polled_ = 0;
+};
 
-APRS_TRACK_INLINE void tracker::track(double track_degrees)
-{
-    data_.track_degrees = track_degrees;
-}
+#endif
 
-APRS_TRACK_INLINE void tracker::update()
+struct track_log_entry
 {
-    auto current_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(current_time - last_time).count();
-    
-    last_update_seconds = static_cast<unsigned int>(elapsed_time);
-
-    if (algorithm_ == algorithm::smart_beaconing)
-    {
-        if (smart_beaconing_test())
-        {
-            last_time = std::chrono::high_resolution_clock::now();
-            previous_track_degrees_ = data_.track_degrees;
-            updated_ = true;
-            return;
-        }
-    }
-    else if (algorithm_ == algorithm::periodic)
-    {
-        if (last_update_seconds >= interval_seconds_)
-        {
-            last_time = std::chrono::high_resolution_clock::now();
-            updated_ = true;
-            return;
-        }
-    }
+    int64_t time = 0; // seconds since the epoch, UTC
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packed_data fix;
+};
 
-    updated_ = false;
-}
+#ifndef APRS_TRACK_HEAP_FREE
 
-APRS_TRACK_INLINE bool tracker::updated() const
+struct track_log_writer
 {
-    return updated_;
-}
+    // Writes a track log: a header, blocks of delta encoded fixes, and
+    // an index of the blocks by time, at the end
+    //
+    // In a block, the time, latitude and longitude are encoded as the
+    // zigzag varint of the change of their delta from the previous fix,
+    // the altitude, speed and track as the zigzag varint of their delta,
+    // and each fix starts with a byte flagging which of them are not 0.
+    // A vehicle moving at a steady speed takes 3 bytes per fix
+    //
+    // The day, hour, minute and second of the fixes are not stored, they
+    // are derived from the time when the logged fix has a time
 
-APRS_TRACK_INLINE string_t tracker::packet_string_no_message(packet_type p) const
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+    track_log_writer();
+    explicit track_log_writer(size_t block_size);
 
-    string_t packet;
+    void append(int64_t time, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d);
+    void append(const track_log_entry& entry);
 
-    switch (p)
-    {
-        case aprs::track::packet_type::mic_e:
-            packet = encode_mic_e_packet_no_message(*this, data_);
-            break;
-        case aprs::track::packet_type::position:
-            packet = encode_position_packet_no_timestamp_no_message(*this, data_);
-            break;
-        case aprs::track::packet_type::position_compressed:
-            packet = encode_position_packet_compressed_no_timestamp_no_message(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp:
-            packet = encode_position_packet_with_timestamp_dhm_no_message(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp_utc:
-            packet = encode_position_packet_with_utc_timestamp_dhm_no_message(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp_utc_hms:
-            packet = encode_position_packet_with_utc_timestamp_hms_no_message(*this, data_);
-            break;
-        default:
-            break;
-    }
+    size_t size() const;
 
-    return packet;
-}
+    std::vector<unsigned char> finish() const;
 
-APRS_TRACK_INLINE string_t tracker::packet_string(packet_type p) const
-{
-APRS_TRACK_DETAIL_NAMESPACE_USE
+private:
+    std::vector<unsigned char> bytes_; // the header and the blocks
+    std::vector<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_block> index_;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_state state_;
+    size_t block_size_ = 1024;
+    size_t size_ = 0;
+};
 
-    string_t packet;
+#endif // APRS_TRACK_HEAP_FREE
 
-    switch (p)
+struct track_log_reader
+{
+    // Reads a track log in place, from memory or from a mapped_file
+    //
+    // The fixes are decoded as they are iterated, nothing is allocated
+
+    struct iterator
     {
-        case aprs::track::packet_type::mic_e:
-            packet = encode_mic_e_packet(*this, data_);
-            break;
-        case aprs::track::packet_type::position:
-            packet = encode_position_packet_no_timestamp(*this, data_);
-            break;
-        case aprs::track::packet_type::position_compressed:
-            packet = encode_position_packet_compressed_no_timestamp(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp:
-            packet = encode_position_packet_with_timestamp_dhm(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp_utc:
-            packet = encode_position_packet_with_utc_timestamp_dhm(*this, data_);
-            break;
-        case aprs::track::packet_type::position_with_timestamp_utc_hms:
-            packet = encode_position_packet_with_utc_timestamp_hms(*this, data_);
-            break;
-        default:
-            break;
-    }
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = track_log_entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const track_log_entry*;
+        using reference = const track_log_entry&;
 
-    return packet;
-}
+        iterator() = default;
 
-APRS_TRACK_INLINE std::u8string tracker::u8packet_string(packet_type p) const
-{
-    string_t packet = packet_string(p);
-    std::u8string u8packet(packet.begin(), packet.end());
-    return u8packet;
-}
+        reference operator*() const;
+        pointer operator->() const;
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+        iterator& operator++();
+        iterator operator++(int);
 
-template <std::output_iterator<unsigned char> OutputIterator>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::packet(packet_type p, OutputIterator output) const
-{
-    string_t packet = packet_string_no_message(p);
+        bool operator==(const iterator& other) const;
 
-    OutputIterator current = std::copy(reinterpret_cast<const unsigned char*>(packet.data()), reinterpret_cast<const unsigned char*>(packet.data() + packet.size()), output);
+    private:
+        friend struct track_log_reader;
 
-    std::copy(message_data_.begin(), message_data_.end(), current);
-}
+        void load_block(size_t block);
+        void decode();
 
-template <std::ranges::output_range<unsigned char> OutputRange>
-APRS_TRACK_INLINE_NO_DISABLE void tracker::packet(packet_type p, OutputRange&& output_range) const
-{
-    packet(p, std::ranges::begin(output_range));
-}
+        const track_log_reader* reader_ = nullptr;
+        const unsigned char* p_ = nullptr;
+        const unsigned char* end_ = nullptr;
+        size_t block_ = 0;
+        size_t remaining_ = 0; // fixes left in the block, including the current fix
+        APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_state state_;
+        track_log_entry entry_;
+    };
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    track_log_reader() = default;
+    explicit track_log_reader(std::span<const unsigned char> bytes);
 
-APRS_TRACK_INLINE bool tracker::smart_beaconing_test()
-{
-    int speed_knots = static_cast<int>(data_.speed_knots.value_or(0.0));
-    int course_degrees = static_cast<int>(data_.track_degrees.value_or(0));
-    int prev_course_degrees = static_cast<int>(previous_track_degrees_.value_or(0));
-    int low_speed_knots_int = static_cast<int>(std::round(low_speed_knots_));
-    int high_speed_knots_int = static_cast<int>(std::round(high_speed_knots_));
+    bool valid() const;
+    size_t size() const;
+    size_t block_count() const;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_block block(size_t index) const;
 
-    bool result = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE smart_beaconing_test(speed_knots, prev_course_degrees, course_degrees, low_speed_knots_int, high_speed_knots_int, slow_rate_,
-        fast_rate_, turn_time_, turn_angle_, turn_slope_, last_update_seconds);
+    iterator begin() const;
+    iterator end() const;
+    iterator seek(int64_t time) const;
 
-    return result;
-}
+    template <class F>
+    void for_each(F&& f) const;
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+private:
+    std::span<const unsigned char> block_bytes(size_t index) const;
 
-APRS_TRACK_NAMESPACE_END
+    std::span<const unsigned char> bytes_;
+    size_t size_ = 0;
+    size_t block_count_ = 0;
+    size_t index_offset_ = 0;
+};
 
-// **************************************************************** //
-//                                                                  //
-//                                                                  //
-// private definitions                                              //
-//                                                                  //
-//                                                                  //
-// **************************************************************** //
+#ifndef APRS_TRACK_HEAP_FREE
 
-APRS_TRACK_NAMESPACE_BEGIN
+struct position_store
+{
+    // The positions of many stations over time, stored by column
+    //
+    // The fixes of each station are appended to chunks, each field in its
+    // own compressed column, see detail::position_chunk. A vehicle moving
+    // at a steady speed takes about 1 byte per fix
+    //
+    // Queries skip the chunks outside of the time range or the area, and
+    // decode the time and position columns of the others into arrays,
+    // which are tested in a loop the compiler vectorizes. The other
+    // columns are decoded only for the chunks with a match
+    //
+    // The fixes of a station are appended in time order
 
-APRS_TRACK_DETAIL_NAMESPACE_BEGIN
+    position_store();
+    explicit position_store(size_t chunk_size);
 
-string_t encode_position_packet_no_timestamp_no_message(const tracker& t, const data& d);
-string_t encode_position_packet_no_timestamp(const tracker& t, const data& d);
-string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
+    bool append(callsign_key station, int64_t time, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d);
+    bool append(callsign_key station, const track_log_entry& entry);
 
-string_t encode_position_packet_with_timestamp_dhm_no_message(const tracker& t, const data& d);
-string_t encode_position_packet_with_timestamp_dhm(const tracker& t, const data& d);
-string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
-char packet_type_with_timestamp(bool m);
+    template <typename F>
+    size_t query_time(int64_t begin, int64_t end, F&& f) const;
 
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(const tracker& t, const data& d);
-string_t encode_position_packet_with_utc_timestamp_hms(const tracker& t, const data& d);
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
+    template <typename F>
+    size_t query_box(int64_t begin, int64_t end, double north, double west, double south, double east, F&& f) const;
 
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d);
-string_t encode_position_packet_with_utc_timestamp_dhm(const tracker& t, const data& d);
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
+    template <typename F>
+    size_t history(callsign_key station, int64_t begin, int64_t end, F&& f) const;
 
-string_t encode_position_packet_compressed_no_timestamp_no_message(const tracker& t, const data& d);
-string_t encode_position_packet_compressed_no_timestamp(const tracker& t, const data& d);
-string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
-string_t encode_compressed_course_speed(double course_degrees, double speed_knots);
-string_t encode_compressed_altitude(double altitude_feet);
+    size_t size() const;
+    size_t station_count() const;
+    size_t memory_bytes() const;
+    void clear();
 
-string_t encode_mic_e_packet_no_message(const tracker& t, const data& d);
-string_t encode_mic_e_packet(const tracker& t, const data& d);
-string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_mic_e_alt_feet(double alt_feet);
+private:
+    template <typename F>
+    size_t scan(const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE position_series& series, APRS_TRACK_DETAIL_NAMESPACE_REFERENCE position_query& q, F&& f) const;
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    std::vector<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE position_series> series_;
+    std::unordered_map<uint64_t, uint32_t> index_;
+    size_t chunk_size_ = 256;
+    size_t size_ = 0;
+};
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(const tracker& t, const data& d)
+#endif // APRS_TRACK_HEAP_FREE
+
+#ifdef APRS_TRACK_HAS_MMAP
+
+struct mapped_file
 {
-    string_t packet;
+    // A read only memory mapping of a file
 
-    packet.append(encode_position_packet_no_timestamp_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+    mapped_file() = default;
+    explicit mapped_file(const char* path);
+    ~mapped_file();
 
-    if (d.speed_knots.has_value() && d.track_degrees.has_value())
-    {
-        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
-    }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
 
-    if (d.alt_feet.has_value())
-    {
-        packet.append(encode_altitude(d.alt_feet.value()));
-    }
+    bool open(const char* path);
+    void close();
+    bool is_open() const;
 
-    return packet;
-}
+    std::span<const unsigned char> bytes() const;
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp(const tracker& t, const data& d)
-{
-    string_t packet;
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
 
-    packet.append(encode_position_packet_no_timestamp_no_message(t, d));
+#endif // APRS_TRACK_HAS_MMAP
 
-    packet.append(t.message());
+struct geojson_position
+{
+    // A position of a GeoJSON geometry, stored as [lon, lat] or [lon, lat, alt]
+    // Can be passed to tracker::position
 
-    return packet;
-}
+    double lat = 0.0;
+    double lon = 0.0;
+    std::optional<double> alt_meters;
+};
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(const tracker& t, const data& d)
+struct geojson_reader
 {
-    string_t packet;
+    // Streams the positions of the LineString geometries of a GeoJSON
+    // document, like the FeatureCollection of scripts/generate_route.py
+    //
+    //   { "type": "Feature", "geometry": { "type": "LineString", "coordinates": [ [ -122.346, 47.628 ], ... ] } }
+    //
+    // The document can be fed in chunks of any size, nothing is allocated
+    // and the state is the same size for any document
+    //
+    // LineStrings are told apart by the nesting of their coordinates, so the
+    // type of a geometry can come before or after them, the coordinates of
+    // Point, Polygon and Multi geometries are skipped, except MultiPoint,
+    // which nests the same way as a LineString
 
-    packet.append(encode_position_packet_with_timestamp_dhm_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), packet_type_with_timestamp(t.messaging()), d.day, d.hour, d.minute, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+    template <class F>
+    bool feed(std::string_view chunk, F&& f);
 
-    if (d.speed_knots.has_value() && d.track_degrees.has_value())
-    {
-        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
-    }
+    bool finish();
+    void reset();
 
-    if (d.alt_feet.has_value())
-    {
-        packet.append(encode_altitude(d.alt_feet.value()));
-    }
+    bool valid() const;
+    size_t size() const;
 
-    return packet;
-}
+private:
+    size_t scan(std::string_view chunk);
+    void end_token();
+
+    uint64_t objects_ = 0; // a bit for each open container, set for objects
+    uint32_t depth_ = 0;
+    uint32_t coordinates_depth_ = 0; // of the coordinates array, 0 outside of coordinates
+    size_t size_ = 0;
+    geojson_position position_;
+    double values_[3] = {};
+    uint8_t value_count_ = 0;
+    char token_[48] = {};
+    uint8_t token_size_ = 0;
+    uint8_t key_size_ = 0;
+    bool token_overflow_ = false;
+    bool in_string_ = false;
+    bool escape_ = false;
+    bool in_key_ = false;
+    bool expect_key_ = false;
+    bool key_coordinates_ = false; // the last key was "coordinates"
+    bool pending_coordinates_ = false; // its value is next
+    bool ready_ = false;
+    bool started_ = false;
+    bool error_ = false;
+};
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm(const tracker& t, const data& d)
-{
-    string_t packet;
+#ifndef APRS_TRACK_HEAP_FREE
 
-    packet.append(encode_position_packet_with_timestamp_dhm_no_message(t, d));
+template <class F>
+bool read_geojson(const char* path, F&& f);
 
-    packet.append(t.message());
+#endif // APRS_TRACK_HEAP_FREE
 
-    return packet;
-}
+string_t to_string(mic_e_status status);
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(const tracker& t, const data& d)
-{
-    string_t packet;
+string_t to_string(packet_type type);
 
-    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.hour, d.minute, d.second, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+callsign_key make_callsign_key(std::string_view callsign);
+callsign_key make_callsign_key(const unsigned char* address);
+string_t to_string(callsign_key key);
 
-    if (d.speed_knots.has_value() && d.track_degrees.has_value())
-    {
-        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
-    }
+bool decode_packet(std::string_view packet, decoded_packet& p);
 
-    if (d.alt_feet.has_value())
+APRS_TRACK_NAMESPACE_END
+
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
+
+APRS_TRACK_NAMESPACE_BEGIN
+
+APRS_TRACK_DETAIL_NAMESPACE_BEGIN
+
+struct feed_worker
+{
+    // The queues and the thread of a feed_decoder worker, defined after
+    // feed_record, which its output queue holds
+
+    explicit feed_worker(size_t capacity) : input(capacity), output(capacity)
     {
-        packet.append(encode_altitude(d.alt_feet.value()));
     }
 
-    return packet;
-}
+    spsc_queue<feed_line> input;
+    spsc_queue<feed_record> output;
+    std::atomic<bool> stop = false;
+    std::thread thread;
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms(const tracker& t, const data& d)
-{
-    string_t packet;
+    // written by the worker
+    std::atomic<size_t> lines = 0;
+    std::atomic<size_t> max_output_depth = 0;
+    std::atomic<int64_t> decode_latency_ns = 0;
+    std::atomic<int64_t> max_decode_latency_ns = 0;
 
-    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(t, d));
+    // written by the producer
+    size_t max_queue_depth = 0;
 
-    packet.append(t.message());
+    // written by the consumer
+    size_t polled = 0;
+    int64_t poll_latency_ns = 0;
+};
 
-    return packet;
+APRS_TRACK_DETAIL_NAMESPACE_END
+
+APRS_TRACK_NAMESPACE_END
+
+#endif
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// public definitions                                               //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+APRS_TRACK_NAMESPACE_BEGIN
+
+#ifdef APRS_TRACK_PMR
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE memory_resource_scope::memory_resource_scope(std::pmr::memory_resource* resource) : previous_(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE memory_resource_slot())
+{
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE memory_resource_slot() = resource;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d)
+APRS_TRACK_INLINE memory_resource_scope::~memory_resource_scope()
 {
-    string_t packet;
+    APRS_TRACK_DETAIL_NAMESPACE_REFERENCE memory_resource_slot() = previous_;
+}
 
-    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.day, d.hour, d.minute, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+APRS_TRACK_INLINE std::pmr::memory_resource* current_memory_resource()
+{
+    std::pmr::memory_resource* resource = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE memory_resource_slot();
+    return resource != nullptr ? resource : std::pmr::get_default_resource();
+}
 
-    if (d.speed_knots.has_value() && d.track_degrees.has_value())
-    {
-        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
-    }
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    if (d.alt_feet.has_value())
-    {
-        packet.append(encode_altitude(d.alt_feet.value()));
-    }
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE resource_allocator<T>::resource_allocator() : resource_(current_memory_resource())
+{
+}
 
-    return packet;
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE resource_allocator<T>::resource_allocator(std::pmr::memory_resource* resource) : resource_(resource != nullptr ? resource : std::pmr::get_default_resource())
+{
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm(const tracker& t, const data& d)
+template <typename T>
+template <typename U>
+APRS_TRACK_INLINE_NO_DISABLE resource_allocator<T>::resource_allocator(const resource_allocator<U>& other) : resource_(other.resource())
 {
-    string_t packet;
+}
 
-    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(t, d));
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE T* resource_allocator<T>::allocate(size_t n)
+{
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+}
 
-    packet.append(t.message());
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE void resource_allocator<T>::deallocate(T* p, size_t n)
+{
+    resource_->deallocate(p, n * sizeof(T), alignof(T));
+}
 
-    return packet;
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE resource_allocator<T> resource_allocator<T>::select_on_container_copy_construction() const
+{
+    // copies go to the resource in scope, not to the resource of the original
+    return resource_allocator();
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(const tracker& t, const data& d)
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE std::pmr::memory_resource* resource_allocator<T>::resource() const
 {
-    string_t packet;
+    return resource_;
+}
 
-    char compression_type = 0b00111000 + 33; // current, RMC, compressed
+template <typename T, typename U>
+APRS_TRACK_INLINE_NO_DISABLE bool operator==(const resource_allocator<T>& lhs, const resource_allocator<U>& rhs)
+{
+    return lhs.resource() == rhs.resource() || lhs.resource()->is_equal(*rhs.resource());
+}
 
-    packet.append(encode_position_packet_compressed_no_timestamp_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.lat, d.lon, t.symbol_table(), t.symbol_code(), d.track_degrees.value_or(0), d.speed_knots.value_or(0), compression_type));
+#endif // APRS_TRACK_PMR
 
-    if (d.alt_feet.has_value())
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t to_string(mic_e_status status)
+{
+    switch (status)
     {
-        packet.append(encode_altitude(d.alt_feet.value()));
+        case mic_e_status::off_duty: return "off_duty";
+        case mic_e_status::en_route: return "en_route";
+        case mic_e_status::in_service: return "in_service";
+        case mic_e_status::returning: return "returning";
+        case mic_e_status::commited: return "commited";
+        case mic_e_status::special: return "special";
+        case mic_e_status::priority: return "priority";
+        case mic_e_status::emergency: return "emergency";
+        case mic_e_status::custom0: return "custom0";
+        case mic_e_status::custom1: return "custom1";
+        case mic_e_status::custom2: return "custom2";
+        case mic_e_status::custom3: return "custom3";
+        case mic_e_status::custom4: return "custom4";
+        case mic_e_status::custom5: return "custom5";
+        case mic_e_status::custom6: return "custom6";
+        default:
+            break;
     }
+    return "unknown";
+}
 
-    return packet;
+APRS_TRACK_INLINE string_t to_string(packet_type type)
+{
+    switch (type)
+    {
+        case packet_type::mic_e: return "mic_e";
+        case packet_type::position: return "position";
+        case packet_type::position_compressed: return "position_compressed";
+        case packet_type::position_with_timestamp: return "position_with_timestamp";
+        case packet_type::position_with_timestamp_utc: return "position_with_timestamp_utc";
+        case packet_type::position_with_timestamp_utc_hms: return "position_with_timestamp_utc_hms";
+        case packet_type::position_compressed_with_timestamp: return "position_compressed_with_timestamp";
+        case packet_type::position_compressed_with_timestamp_utc: return "position_compressed_with_timestamp_utc";
+        case packet_type::position_compressed_with_timestamp_utc_hms: return "position_compressed_with_timestamp_utc_hms";
+        case packet_type::smallest: return "smallest";
+        default:
+            break;
+    }
+    return "";
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp(const tracker& t, const data& d)
+APRS_TRACK_INLINE callsign_key make_callsign_key(std::string_view callsign)
 {
-    string_t packet;
+    // Packs a callsign like N0CALL-9, letters and digits only, lower case
+    // letters are converted to upper case
+    //
+    // Returns an invalid key if the callsign cannot be represented in AX.25
 
-    packet.append(encode_position_packet_compressed_no_timestamp_no_message(t, d));
+    size_t dash = callsign.find('-');
+    std::string_view call = callsign.substr(0, dash);
 
-    packet.append(t.message());
+    callsign_key key;
 
-    return packet;
+    if (call.empty() || call.size() > 6)
+    {
+        return key;
+    }
+
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        char c = i < call.size() ? call[i] : ' ';
+        if (c >= 'a' && c <= 'z')
+        {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+        if (i < call.size() && !((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+        {
+            return key;
+        }
+        value = (value << 8) | static_cast<unsigned char>(c);
+    }
+
+    int ssid = 0;
+
+    if (dash != std::string_view::npos)
+    {
+        std::string_view ssid_str = callsign.substr(dash + 1);
+        if (ssid_str.empty() || ssid_str.size() > 2)
+        {
+            return key;
+        }
+        for (char c : ssid_str)
+        {
+            if (c < '0' || c > '9')
+            {
+                return key;
+            }
+            ssid = ssid * 10 + (c - '0');
+        }
+        if (ssid > 15)
+        {
+            return key;
+        }
+    }
+
+    key.value = (value << 16) | static_cast<uint64_t>(ssid);
+
+    return key;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(const tracker& t, const data& d)
+APRS_TRACK_INLINE callsign_key make_callsign_key(const unsigned char* address)
 {
-    string_t packet;
+    // Packs a 7 byte AX.25 address, with the characters shifted left by one bit
+    //
+    // Returns an invalid key if the address has characters other than
+    // letters and digits, or spaces other than at the end
 
-    packet.append(encode_mic_e_packet_no_message(t.from().c_str(), t.path().c_str(), d.lat, d.lon, t.mic_e_status(), d.track_degrees.value_or(0), d.speed_knots.value_or(0), t.symbol_table(), t.symbol_code(), t.ambiguity()));
+    uint64_t value = 0;
+    bool end = false;
 
-    if (d.alt_feet.has_value())
+    for (size_t i = 0; i < 6; i++)
     {
-        packet.append(encode_mic_e_alt_feet(d.alt_feet.value()));
+        char c = static_cast<char>(address[i] >> 1);
+        if (c == ' ')
+        {
+            end = true;
+        }
+        else if (end || !((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+        {
+            return callsign_key();
+        }
+        value = (value << 8) | static_cast<unsigned char>(c);
     }
 
-    return packet;
+    if (value >> 40 == ' ')
+    {
+        return callsign_key();
+    }
+
+    callsign_key key;
+    key.value = (value << 16) | static_cast<uint64_t>((address[6] >> 1) & 0x0F);
+
+    return key;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_packet(const tracker& t, const data& d)
+APRS_TRACK_INLINE string_t to_string(callsign_key key)
 {
-    string_t packet;
+    char buffer[10];
+    size_t size = 0;
 
-    packet.append(encode_mic_e_packet_no_message(t, d));
+    for (int shift = 56; shift >= 16; shift -= 8)
+    {
+        char c = static_cast<char>((key.value >> shift) & 0xFF);
+        if (c == ' ' || c == 0)
+        {
+            break;
+        }
+        buffer[size++] = c;
+    }
 
-    packet.append(t.message());
+    uint8_t ssid = key.ssid();
 
-    return packet;
+    if (ssid > 0)
+    {
+        buffer[size++] = '-';
+        if (ssid >= 10)
+        {
+            buffer[size++] = '1';
+        }
+        buffer[size++] = static_cast<char>('0' + ssid % 10);
+    }
+
+    return string_t(buffer, size);
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE bool decode_packet(std::string_view packet, decoded_packet& p)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-APRS_TRACK_DETAIL_NAMESPACE_END
+    // Splits a TNC2 packet, classifies it by its data type identifier, and
+    // decodes the position of position, mic-e, object and item packets
+    //
+    //   N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-090/036
+    //
+    //   from  N0CALL
+    //   to    APRS
+    //   path  WIDE1-1
+    //   info  !4903.50N/07201.75W-090/036
+    //   kinds position_packet, 49.058333, -72.029167, 90 degrees, 36 knots
+    //
+    // Third party packets are decoded as the packet they carry, up to two
+    // levels deep, packets nested deeper are left undecoded
+    // Returns false if the packet has no header
 
-APRS_TRACK_NAMESPACE_END
+    constexpr int max_third_party_depth = 2;
 
-// **************************************************************** //
-//                                                                  //
-//                                                                  //
-//                                                                  //
-//                                                                  //
-// encoding library                                                 //
-//                                                                  //
-//                                                                  //
-//                                                                  //
-//                                                                  //
-// **************************************************************** //
+    p = decoded_packet();
 
-// **************************************************************** //
-//                                                                  //
-//                                                                  //
-// private definitions                                              //
-//                                                                  //
-//                                                                  //
-// **************************************************************** //
+    for (int depth = 0; ; depth++)
+    {
+        size_t header_end = packet.find(':');
+        size_t from_end = packet.find('>');
 
-#include <string> // for std::string.
-#include <string_view> // for std::string_view.
-#include <tuple> // for std::tuple and std::tie.
-#include <cmath> // for mathematical functions like std::abs, std::modf, and std::round.
-#include <cstdio> // for std::snprintf.
-#include <cassert>
+        if (header_end == std::string_view::npos || from_end == std::string_view::npos || from_end > header_end || from_end == 0)
+        {
+            if (depth == 0)
+            {
+                return false;
+            }
+            break; // the third party packet is kept as is
+        }
 
-APRS_TRACK_NAMESPACE_BEGIN
+        p.from = packet.substr(0, from_end);
 
-APRS_TRACK_DETAIL_NAMESPACE_BEGIN
+        std::string_view to_path = packet.substr(from_end + 1, header_end - from_end - 1);
+        size_t to_end = to_path.find(',');
 
-char packet_type_without_timestamp(bool m);
-char packet_type_with_timestamp(bool m);
+        p.to = to_path.substr(0, to_end);
+        p.path = to_end == std::string_view::npos ? std::string_view() : to_path.substr(to_end + 1);
+        p.info = packet.substr(header_end + 1);
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+        while (!p.info.empty() && (p.info.back() == '\r' || p.info.back() == '\n'))
+        {
+            p.info.remove_suffix(1);
+        }
 
-APRS_TRACK_INLINE char packet_type_without_timestamp(bool messaging)
-{
-    return messaging ? '=' : '!';
-}
+        if (p.info.empty() || p.info[0] != '}' || depth == max_third_party_depth)
+        {
+            break;
+        }
 
-APRS_TRACK_INLINE char packet_type_with_timestamp(bool messaging)
-{
-   return messaging ? '@' : '/';
-}
+        packet = p.info.substr(1);
+    }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    std::string_view info = p.info;
 
-// **************************************************************** //
-//                                                                  //
-// common position handling                                         //
-//                                                                  //
-// **************************************************************** //
+    if (info.empty())
+    {
+        return true;
+    }
 
-struct position_ddm
-{
-    char lat = '\0';
-    int lat_d = 0;
-    double lat_m = 0.0;
-    char lon = '\0';
-    int lon_d = 0;
-    double lon_m = 0.0;
-};
+    switch (info[0])
+    {
+        case '!':
+        case '=':
+            p.kinds = position_packet;
+            p.has_position = decode_position(info.substr(1), p.fix, p.symbol_table, p.symbol_code);
+            break;
+        case '/':
+        case '@':
+            p.kinds = position_packet;
+            p.has_position = info.size() > 8 && decode_position(info.substr(8), p.fix, p.symbol_table, p.symbol_code);
+            break;
+        case '`':
+        case '\'':
+        case 0x1C:
+        case 0x1D:
+            p.kinds = position_packet;
+            p.has_position = decode_mic_e_position(p.to, info, p.fix, p.symbol_table, p.symbol_code);
+            break;
+        case '$':
+            p.kinds = position_packet; // NMEA sentences are not decoded
+            break;
+        case ';':
+            p.kinds = object_packet; // ;NAME_____*DDHHMMz, then the position
+            p.has_position = info.size() > 18 && decode_position(info.substr(18), p.fix, p.symbol_table, p.symbol_code);
+            break;
+        case ')':
+        {
+            p.kinds = item_packet; // )NAME!, a 3 to 9 character name, then the position
+            size_t name_end = info.find_first_of("!_", 1);
+            p.has_position = name_end != std::string_view::npos && name_end >= 4 && name_end <= 10 &&
+                decode_position(info.substr(name_end + 1), p.fix, p.symbol_table, p.symbol_code);
+            break;
+        }
+        case ':':
+        {
+            p.kinds = message_packet; // :ADDRESSEE:text
+            std::string_view addressee = info.substr(1, 9);
+            std::string_view text = info.size() > 11 ? info.substr(11) : std::string_view();
+            if (addressee.starts_with("NWS") || addressee.starts_with("SKY") || addressee.starts_with("CWA") || addressee.starts_with("BOM"))
+            {
+                p.kinds |= nws_packet;
+            }
+            if (text.starts_with("PARM.") || text.starts_with("UNIT.") || text.starts_with("EQNS.") || text.starts_with("BITS."))
+            {
+                p.kinds |= telemetry_packet;
+            }
+            break;
+        }
+        case '?':
+            p.kinds = query_packet;
+            break;
+        case '>':
+            p.kinds = status_packet;
+            break;
+        case 'T':
+            p.kinds = telemetry_packet;
+            break;
+        case '{':
+            p.kinds = user_defined_packet;
+            break;
+        case '_':
+            p.kinds = weather_packet;
+            break;
+        case '}':
+            return true; // third party, not unwrapped, see above
+        default:
+            break;
+    }
 
-struct position_ddm_string
-{
-    string_t lat;
-    string_t lon;
-};
+    if (p.has_position && p.symbol_code == '_')
+    {
+        p.kinds |= weather_packet;
+    }
 
-std::tuple<int, int, double> dd_to_dms(double dd);
-std::tuple<int, double> dd_to_ddm(double dd);
-position_ddm dd_to_ddm(double lat, double lon);
-string_t format_number_to_string(double number, int width, int precision);
-string_t format_number_to_string(double number, int precision);
-string_t format_n_digits_string(int number, int digits);
-string_t format_two_digits_string(int number);
-position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity);
-position_ddm_string to_ddm_short_string(const position_ddm& p);
-void add_position_ambiguity(string_t& position, int ambiguity);
-string_t encode_compressed_lon(double lon);
-string_t encode_compressed_lat(double lat);
-string_t encode_compressed_lat_lon(double lat, double lon);
+    return true;
+}
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE bool callsign_key::valid() const
+{
+    return value != 0;
+}
 
-APRS_TRACK_INLINE std::tuple<int, int, double> dd_to_dms(double dd)
+APRS_TRACK_INLINE uint8_t callsign_key::ssid() const
 {
-    // Example algorithm:
-    //
-    // Input DD = 37.7749
-    // 
-    // D = integer part of 37.7749 = 37
-    // DM = fractional part of 37.7749 * 60 = 0.7749 * 60 = 46.494
-    // M = integer part of 46.494 = 46
-    // S = fractional part of 46.494 * 60 = 0.494 * 60 = 29.64
-    // 
-    // Output DMS = 37° 46' 29.64"
+    return static_cast<uint8_t>(value & 0x0F);
+}
 
-    double d, dm, m, s;
-    double dd_abs = std::abs(dd);
-    dm = std::modf(dd_abs, &d);
-    if (dd < 0)
-    {
-        d = -d;
-    }
-    dm = dm * 60.0;
-    s = std::modf(dm, &m);
-    s = s * 60.0;
-    return std::make_tuple(static_cast<int>(d), static_cast<int>(m), s);
+#ifdef APRS_TRACK_PMR
+
+APRS_TRACK_INLINE tracker::tracker() : tracker(std::pmr::get_default_resource())
+{
 }
 
-APRS_TRACK_INLINE std::tuple<int, double> dd_to_ddm(double dd)
+APRS_TRACK_INLINE tracker::tracker(std::pmr::memory_resource* resource) :
+    from_(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE make_with_resource<string_t>(resource)),
+    message_data_(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE make_with_resource<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE message_data_t>(resource)),
+    packet_cache_(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE make_with_resource<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_cache_t>(resource)),
+    history_(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE make_with_resource<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE history_t>(resource)),
+    resource_(resource)
 {
-    int d, m;
-    double s;
-    std::tie(d, m, s) = dd_to_dms(dd);
-    double m_s = m + (s / 60.0);
-    return std::make_tuple(d, m_s);
 }
 
-APRS_TRACK_INLINE position_ddm dd_to_ddm(double lat, double lon)
+APRS_TRACK_INLINE tracker::tracker(const tracker& other) : tracker(other.resource_)
 {
-    position_ddm ddm;
-    std::tie(ddm.lat_d, ddm.lat_m) = dd_to_ddm(lat);
-    std::tie(ddm.lon_d, ddm.lon_m) = dd_to_ddm(lon);
-    ddm.lat_d = std::abs(ddm.lat_d);
-    ddm.lon_d = std::abs(ddm.lon_d);
-    ddm.lat = lat >= 0 ? 'N' : 'S';
-    ddm.lon = lon >= 0 ? 'E' : 'W';
-    return ddm;
+    // A copy allocates from the resource of the tracker it was copied from
+
+    *this = other;
 }
 
-APRS_TRACK_INLINE string_t format_number_to_string(double number, int width, int precision)
+APRS_TRACK_INLINE tracker& tracker::operator=(const tracker& other)
 {
-    // Converts a double to a formatted string representation with specific width and precision
+    // The tracker keeps its resource, like its containers, and the copied
+    // strings, including those of the cached packets, are allocated from it
     //
-    // Parameters:
-    //
-    //   number    - the floating-point value to format
-    //   width     - minimum width for the resulting string (padding with leading zeros if > 0)
-    //   precision - decimal precision (number of digits after decimal point)
-    //               if precision is 0, formats as integer without decimal point
-    //               the number is rounded to the specified precision
-    //
-    // Examples:
-    //
-    //   format_number_to_string(37.7749, 4)    ->  37.7749
-    //   format_number_to_string(37.7749, 1)    ->  37.8
-    //   format_number_to_string(37.7749, 0)    ->  37
-    //   format_number_to_string(37.7749, 5, 2) ->  037.77
-    //   format_number_to_string(0.7749, 5, 2)  ->  000.77
-    //   format_number_to_string(5.5, 8, 4)     ->  0005.5000
-    //   format_number_to_string(0.5, 8, 4)     ->  0000.5000
-    //   format_number_to_string(-5.5, 8, 4)    -> -005.5000
-
-    string_t pretty_number_str;
+    // An assignment from a temporary copies too, moving the strings would
+    // keep them allocated from the resource of the temporary
 
-    if (precision == 0)
+    if (this == &other)
     {
-        double i;
-        double f = std::modf(number, &i);
-        (void)f;
-
-        char buffer[32];
+        return *this;
+    }
 
-        if (width > 0)
-        {
-            std::snprintf(buffer, sizeof(buffer), "%0*d", width, static_cast<int>(i));
-        }
-        else
-        {
-            std::snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(i));
-        }
+    memory_resource_scope scope(resource_);
+
+    from_ = other.from_;
+    message_data_ = other.message_data_;
+#ifdef APRS_TRACK_HEAP_FREE
+    settings_ = other.settings_;
+#else
+    shared_message_ = other.shared_message_;
+    profile_ = other.profile_;
+    // the settings set on the tracker are stored with it, those of a profile are shared
+    settings_ = (other.overrides_ != 0 && other.resource_ != resource_) ? copy_settings(*other.settings_) : other.settings_;
+#endif
+    packet_cache_ = other.packet_cache_;
+    history_ = other.history_;
+    history_distance_cm_ = other.history_distance_cm_;
+    history_heading_change_ = other.history_heading_change_;
+    history_speed_sum_ = other.history_speed_sum_;
+    last_time = other.last_time;
+    phase_ = other.phase_;
+    total_packets_ = other.total_packets_;
+    total_bytes_ = other.total_bytes_;
+    total_airtime_seconds_ = other.total_airtime_seconds_;
+    revision_ = other.revision_;
+    profile_version_ = other.profile_version_;
+    data_ = other.data_;
+    last_update_seconds = other.last_update_seconds;
+    message_data_length_ = other.message_data_length_;
+    history_head_ = other.history_head_;
+    history_count_ = other.history_count_;
+    history_speed_count_ = other.history_speed_count_;
+    overrides_ = other.overrides_;
+    previous_track_degrees_ = other.previous_track_degrees_;
+    updated_ = other.updated_;
+    packet_cache_enabled_ = other.packet_cache_enabled_;
+
+    return *this;
+}
+
+#endif // APRS_TRACK_PMR
 
-        pretty_number_str = buffer;
-    }
-    else
-    {
-        char buffer[32];
+APRS_TRACK_INLINE void tracker::algorithm(enum algorithm a)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::algorithm).algorithm = a;
+}
 
-        if (width > 0)
-        {
-            std::snprintf(buffer, sizeof(buffer), "%0*.*f", width + 1, precision, number);
-        }
-        else
-        {
-            std::snprintf(buffer, sizeof(buffer), "%.*f", precision, number);
-        }
+APRS_TRACK_INLINE enum algorithm tracker::algorithm() const
+{
+    return settings().algorithm;
+}
 
-        pretty_number_str = buffer;
-    }
+APRS_TRACK_INLINE void tracker::symbol_code(char c)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::symbol_code).symbol_code = c;
+    invalidate_packet_cache();
+}
 
-    return pretty_number_str;
+APRS_TRACK_INLINE char tracker::symbol_code() const
+{
+    return settings().symbol_code;
 }
 
-APRS_TRACK_INLINE string_t format_number_to_string(double number, int precision)
+APRS_TRACK_INLINE void tracker::symbol_table(char t)
 {
-    return format_number_to_string(number, 0, precision);
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::symbol_table).symbol_table = t;
+    invalidate_packet_cache();
 }
 
-APRS_TRACK_INLINE string_t format_n_digits_string(int number, int width)
+APRS_TRACK_INLINE char tracker::symbol_table() const
 {
-    if (width <= 0)
-    {
-        //return std::to_string(number);
-        return string_t(std::to_string(number).c_str());
-    }
+    return settings().symbol_table;
+}
 
-    char buffer[32];
-    std::snprintf(buffer, sizeof(buffer), "%0*d", width, number);
-    return string_t(buffer);
+APRS_TRACK_INLINE void tracker::from(std::string_view f)
+{
+    from_ = f.data();
+    invalidate_packet_cache();
 }
 
-APRS_TRACK_INLINE string_t format_two_digits_string(int number)
+APRS_TRACK_INLINE const string_t& tracker::from() const
 {
-    return format_n_digits_string(number, 2);
+    return from_;
 }
 
-APRS_TRACK_INLINE position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity)
+APRS_TRACK_INLINE void tracker::to(std::string_view t)
 {
-    position_ddm_string s;
-    s.lat = format_number_to_string(p.lat_d, 2, 0);
-    s.lat.append(format_number_to_string(p.lat_m, 4, 2));
-    s.lat.append(1, p.lat);
-    add_position_ambiguity(s.lat, ambiguity);
-    s.lon = format_number_to_string(p.lon_d, 3, 0);
-    s.lon.append(format_number_to_string(p.lon_m, 4, 2));
-    s.lon.append(1, p.lon);
-    return s;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::to).to = t.data();
+    invalidate_packet_cache();
 }
 
-APRS_TRACK_INLINE position_ddm_string to_ddm_short_string(const position_ddm& p)
+APRS_TRACK_INLINE const string_t& tracker::to() const
 {
-    return to_ddm_short_string(p, 0);
+    return settings().to;
 }
 
-APRS_TRACK_INLINE void add_position_ambiguity(string_t& position, int ambiguity)
+APRS_TRACK_INLINE void tracker::path(std::string_view p)
 {
-    if (!(ambiguity > 0))
-    {
-        return;
-    }
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::path).path = p.data();
+    invalidate_packet_cache();
+}
 
-    for (size_t i = position.size() - 2, count = 0; i > 0 && count < static_cast<size_t>(ambiguity); i--)
-    {
-        if (position[i] == '.')
-        {
-            continue;
-        }
-        position[i] = ' ';
-        count++;
-    }
+APRS_TRACK_INLINE const string_t& tracker::path() const
+{
+    return settings().path;
 }
 
-APRS_TRACK_INLINE string_t encode_compressed_lon(double lon)
+APRS_TRACK_INLINE void tracker::ambiguity(int a)
 {
-    string_t result;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::ambiguity).ambiguity = a;
+    invalidate_packet_cache();
+}
 
-    long num = static_cast<long>(std::round(190463 * (180 + lon)));
+APRS_TRACK_INLINE int tracker::ambiguity() const
+{
+    return settings().ambiguity;
+}
 
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
+APRS_TRACK_INLINE void tracker::messaging(bool m)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::messaging).messaging = m;
+    invalidate_packet_cache();
+}
 
-    return result;
+APRS_TRACK_INLINE bool tracker::messaging() const
+{
+    return settings().messaging;
 }
 
-APRS_TRACK_INLINE string_t encode_compressed_lat(double lat)
+APRS_TRACK_INLINE void tracker::mic_e_status(enum mic_e_status s)
 {
-    string_t result;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::mic_e_status).mic_e_status = s;
+    invalidate_packet_cache();
+}
 
-    long num = static_cast<long>(std::round(380926 * (90 - lat)));
+APRS_TRACK_INLINE enum mic_e_status tracker::mic_e_status() const
+{
+    return settings().mic_e_status;
+}
 
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
-    num /= 91;
-    result.insert(result.begin(), static_cast<char>((num % 91) + 33));
+APRS_TRACK_INLINE void tracker::low_speed(double speed_mps)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    return result;
+    modify_settings(profile_field::low_speed).low_speed_knots = mps_to_knots(speed_mps);
 }
 
-APRS_TRACK_INLINE string_t encode_compressed_lat_lon(double lat, double lon)
+APRS_TRACK_INLINE double tracker::low_speed() const
 {
-    string_t result;
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    result.append(encode_compressed_lat(lat));
-    result.append(encode_compressed_lon(lon));
+    return knots_to_mps(settings().low_speed_knots);
+}
 
-    return result;
+APRS_TRACK_INLINE void tracker::high_speed(double speed_mps)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    modify_settings(profile_field::high_speed).high_speed_knots = mps_to_knots(speed_mps);
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE double tracker::high_speed() const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-// **************************************************************** //
-//                                                                  //
-// timestamp                                                        //
-//                                                                  //
-// **************************************************************** //
+    return knots_to_mps(settings().high_speed_knots);
+}
 
-string_t encode_timestamp_dhm(int day, int hour, int min);
-string_t encode_utc_timestamp_dhm(int day, int hour, int min);
-string_t encode_utc_timestamp_hms(int hour, int min, int sec);
+APRS_TRACK_INLINE void tracker::slow_rate(int seconds)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::slow_rate).slow_rate = seconds;
+}
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE int tracker::slow_rate() const
+{
+    return settings().slow_rate;
+}
 
-APRS_TRACK_INLINE string_t encode_timestamp_dhm(int day, int hour, int min)
+APRS_TRACK_INLINE void tracker::fast_rate(int seconds)
 {
-    string_t dhm;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::fast_rate).fast_rate = seconds;
+}
 
-    dhm.append(format_two_digits_string(day));
-    dhm.append(format_two_digits_string(hour));
-    dhm.append(format_two_digits_string(min));
+APRS_TRACK_INLINE int tracker::fast_rate() const
+{
+    return settings().fast_rate;
+}
 
-    dhm.append("/");
+APRS_TRACK_INLINE void tracker::turn_time(int seconds)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::turn_time).turn_time = seconds;
+}
 
-    return dhm;
+APRS_TRACK_INLINE int tracker::turn_time() const
+{
+    return settings().turn_time;
 }
 
-APRS_TRACK_INLINE string_t encode_utc_timestamp_dhm(int day, int hour, int min)
+APRS_TRACK_INLINE void tracker::turn_angle(int degrees)
 {
-    string_t dhm;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::turn_angle).turn_angle = degrees;
+}
 
-    dhm.append(format_two_digits_string(day));
-    dhm.append(format_two_digits_string(hour));
-    dhm.append(format_two_digits_string(min));
+APRS_TRACK_INLINE int tracker::turn_angle() const
+{
+    return settings().turn_angle;
+}
 
-    dhm.append("z");
+APRS_TRACK_INLINE void tracker::turn_slope(int value)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::turn_slope).turn_slope = value;
+}
 
-    return dhm;
+APRS_TRACK_INLINE int tracker::turn_slope() const
+{
+    return settings().turn_slope;
 }
 
-APRS_TRACK_INLINE string_t encode_utc_timestamp_hms(int hour, int min, int sec)
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+template <typename CharType, typename Traits>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const std::basic_string_view<CharType, Traits>& m)
 {
-    string_t dhm;
+#ifndef APRS_TRACK_HEAP_FREE
+    shared_message_.reset();
+#endif
 
-    dhm.append(format_two_digits_string(hour));
-    dhm.append(format_two_digits_string(min));
-    dhm.append(format_two_digits_string(sec));
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(m.data());
+    size_t size = m.size() * sizeof(CharType);
+    message_data_.assign(data, data + size);
 
-    dhm.append("h");
+    // the storage might have truncated the message with APRS_TRACK_HEAP_FREE
+    message_data_length_ = static_cast<uint32_t>((std::min)(m.size(), message_data_.size() / sizeof(CharType)));
+}
 
-    return dhm;
+template <typename CharType>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const CharType* m)
+{
+    message(std::basic_string_view<CharType>(m));
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+template <typename CharType>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(const CharType* m, size_t count)
+{
+    message(std::basic_string_view<CharType>(m, count));
+}
 
-// **************************************************************** //
-//                                                                  //
-// header                                                           //
-//                                                                  //
-// **************************************************************** //
+template <std::ranges::input_range InputRange>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(InputRange&& input_range)
+{
+    message(std::ranges::begin(input_range), std::ranges::end(input_range));
+}
 
-string_t encode_header(std::string_view from, std::string_view to, std::string_view path);
+template <std::input_iterator InputIterator>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(InputIterator begin, InputIterator end)
+{
+#ifndef APRS_TRACK_HEAP_FREE
+    shared_message_.reset();
+#endif
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    message_data_.assign(begin, end);
+    message_data_length_ = static_cast<uint32_t>(message_data_.size());
+}
 
-APRS_TRACK_INLINE string_t encode_header(std::string_view from, std::string_view to, std::string_view path)
+template <std::output_iterator<unsigned char> OutputIterator>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::message(OutputIterator output)
 {
-    // Encode the header of a packet:
-    //
-    // Example:
-    //
-    //   N0CALL>APRS,TCPIP*,qAC,N0CALL:
-    //   ~~~~~~ ~~~~ ~~~~~~~~~~~~~~~~~
-    //   from  >to  ,path             :
+    std::span<const unsigned char> bytes = message_bytes();
+    std::copy(bytes.begin(), bytes.end(), output);
+}
 
-    string_t packet;
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    packet.append(from.data());
-    packet.append(1, '>');
-    packet.append(to.data());
+#ifndef APRS_TRACK_HEAP_FREE
 
-    if (path.empty() == false)
-    {
-        packet.append(1, ',');
-        packet.append(path.data());
-    }
+APRS_TRACK_INLINE void tracker::message(const message_handle& m)
+{
+    shared_message_ = m;
+    message_data_.clear();
+    message_data_length_ = 0;
+}
 
-    packet.append(1, ':');
+#endif // APRS_TRACK_HEAP_FREE
 
-    return packet;
+APRS_TRACK_INLINE string_t tracker::message() const
+{
+    std::string_view m = message_view();
+    return string_t(m.data(), m.size());
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE std::u8string tracker::u8message() const
+{
+    std::string_view m = message_view();
+    return std::u8string(reinterpret_cast<const char8_t*>(m.data()), m.size());
+}
 
-// **************************************************************** //
-//                                                                  //
-// position no timestamp                                            //
-//                                                                  //
-// **************************************************************** //
+APRS_TRACK_INLINE std::string_view tracker::message_view() const
+{
+#ifndef APRS_TRACK_HEAP_FREE
+    if (shared_message_)
+    {
+        return std::string_view(reinterpret_cast<const char*>(shared_message_->bytes.data()), shared_message_->length);
+    }
+#endif
+    return std::string_view(reinterpret_cast<const char*>(message_data_.data()), message_data_length_);
+}
 
-string_t encode_position_data_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
-string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
-string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
+APRS_TRACK_INLINE std::span<const unsigned char> tracker::message_bytes() const
+{
+#ifndef APRS_TRACK_HEAP_FREE
+    if (shared_message_)
+    {
+        return std::span<const unsigned char>(shared_message_->bytes.data(), shared_message_->bytes.size());
+    }
+#endif
+    return std::span<const unsigned char>(message_data_.data(), message_data_.size());
+}
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+#endif
 
-APRS_TRACK_INLINE string_t encode_position_data_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+template <class Rep, class Period>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::interval(std::chrono::duration<Rep, Period> interval)
 {
-    // 
-    //  Data Format:
-    // 
-    //     !   Lat  Sym  Lon  Sym Code   Comment
-    //     =
-    //    ------------------------------------------
-    //     1    8    1    9      1        0-43
-    //
-    //  Examples:
-    //
-    //    !4903.50N/07201.75W-Test 001234
-    //    !4903.50N/07201.75W-Test /A=001234
-    //    !49  .  N/072  .  W-
-    //
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::interval).interval_seconds = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::seconds>(interval).count());
+}
 
-    string_t data;
+template <Position T>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::position(const T& p)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    data.append(1, type);
+    data_.lat = p.lat;
+    data_.lon = p.lon;
 
-    position_ddm ddm = dd_to_ddm(lat, lon);
-    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+    unsigned int fields = packet_field_lat | packet_field_lon;
 
-    data.append(ddm_str.lat);
+    if constexpr (has_speed<T>)
+    {
+        data_.speed_knots = mps_to_knots(p.speed);
+        data_.has_speed = 1;
+        fields |= packet_field_course_speed;
+    }
 
-    data.append(1, symbol_table);
+    if constexpr (has_track<T>)
+    {
+        data_.track_degrees = p.track;
+        data_.has_track = 1;
+        fields |= packet_field_course_speed;
+    }
 
-    data.append(ddm_str.lon);
+    if constexpr (has_day_hour_minute_seconds<T>)
+    {
+        data_.day = static_cast<uint8_t>(p.day);
+        data_.hour = static_cast<uint8_t>(p.hour);
+        data_.minute = static_cast<uint8_t>(p.minute);
+        data_.second = static_cast<uint8_t>(p.second);
+        data_.has_time = 1;
+        fields |= packet_field_time;
+    }
 
-    data.append(1, symbol_code);
+    if constexpr (has_altitude<T>)
+    {
+        data_.alt_feet = meters_to_feet(p.alt);
+        data_.has_alt = 1;
+        fields |= packet_field_alt;
+    }
 
-    return data;
+    mark_dirty(fields);
+    record_history();
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE void tracker::interval_seconds(int interval_seconds)
 {
-    string_t packet;
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::interval).interval_seconds = interval_seconds;
+}
 
-    packet.append(encode_header(from, to, path));
+APRS_TRACK_INLINE void tracker::position(double lat, double lon)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_position_data_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, ambiguity));
+    data_.lat = lat;
+    data_.lon = lon;
 
-    return packet;
+    mark_dirty(packet_field_lat | packet_field_lon);
+    record_history();
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees)
 {
-    string_t packet;
-
-    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity));
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_course_speed(track_degrees, speed_knots));
+    data_.lat = lat;
+    data_.lon = lon;
+    data_.speed_knots = mps_to_knots(speed_mps);
+    data_.track_degrees = track_degrees;
+    data_.has_speed = 1;
+    data_.has_track = 1;
 
-    return packet;
+    mark_dirty(packet_field_lat | packet_field_lon | packet_field_course_speed);
+    record_history();
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees, double alt_meters)
 {
-    string_t packet;
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity));
+    data_.lat = lat;
+    data_.lon = lon;
+    data_.speed_knots = mps_to_knots(speed_mps);
+    data_.track_degrees = track_degrees;
+    data_.has_speed = 1;
+    data_.has_track = 1;
+    data_.alt_feet = meters_to_feet(alt_meters);
+    data_.has_alt = 1;
 
-    packet.append(encode_altitude(alt_feet));
+    mark_dirty(packet_field_lat | packet_field_lon | packet_field_course_speed | packet_field_alt);
+    record_history();
+}
 
-    return packet;
+APRS_TRACK_INLINE void tracker::position(double lat, double lon, double speed_mps, double track_degrees, double alt_meters, int day, int hour, int minute, int second)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    data_.lat = lat;
+    data_.lon = lon;
+    data_.speed_knots = mps_to_knots(speed_mps);
+    data_.track_degrees = track_degrees;
+    data_.has_speed = 1;
+    data_.has_track = 1;
+    data_.alt_feet = meters_to_feet(alt_meters);
+    data_.has_alt = 1;
+    data_.day = static_cast<uint8_t>(day);
+    data_.hour = static_cast<uint8_t>(hour);
+    data_.minute = static_cast<uint8_t>(minute);
+    data_.second = static_cast<uint8_t>(second);
+    data_.has_time = 1;
+
+    mark_dirty(packet_field_all);
+    record_history();
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+APRS_TRACK_INLINE void tracker::time(int day, int hour, int minute, int second)
 {
-    string_t packet;
+    data_.day = static_cast<uint8_t>(day);
+    data_.hour = static_cast<uint8_t>(hour);
+    data_.minute = static_cast<uint8_t>(minute);
+    data_.second = static_cast<uint8_t>(second);
+    data_.has_time = 1;
 
-    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity, speed_knots, track_degrees));
+    mark_dirty(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_field_time);
+}
 
-    packet.append(encode_altitude(alt_feet));
+APRS_TRACK_INLINE void tracker::time(int hour, int minute, int second)
+{
+    data_.hour = static_cast<uint8_t>(hour);
+    data_.minute = static_cast<uint8_t>(minute);
+    data_.second = static_cast<uint8_t>(second);
+    data_.has_time = 1;
 
-    return packet;
+    mark_dirty(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_field_time);
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE void tracker::time(int minute, int second)
+{
+    data_.minute = static_cast<uint8_t>(minute);
+    data_.second = static_cast<uint8_t>(second);
+    data_.has_time = 1;
 
-// **************************************************************** //
-//                                                                  //
-// position with timestamp dhm                                      //
-//                                                                  //
-// **************************************************************** //
-
-string_t encode_position_data_with_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
-string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
-string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
-
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
-
-APRS_TRACK_INLINE string_t encode_position_data_with_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
-{
-    // 
-    //  Data Format:
-    // 
-    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
-    //     @
-    //    -----------------------------------------------
-    //     1    7     8     1    9      1        0-43
-    //
-    //  Examples:
-    //
-    //    /092345z4903.50N/07201.75W>Test1234
-    //    @092345/4903.50N/07201.75W>Test1234
-    //
-
-    string_t data;
-
-    data.append(1, type);
-
-    data.append(encode_timestamp_dhm(day, hour, min));
-
-    position_ddm ddm = dd_to_ddm(lat, lon);
-    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
-
-    data.append(ddm_str.lat);
-
-    data.append(1, symbol_table);
-
-    data.append(ddm_str.lon);
-
-    data.append(1, symbol_code);
-
-    return data;
+    mark_dirty(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_field_time);
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+APRS_TRACK_INLINE void tracker::speed(double speed_mps)
 {
-    string_t packet;
-
-    packet.append(encode_header(from, to, path));
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_position_data_with_timestamp_dhm(packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+    data_.speed_knots = mps_to_knots(speed_mps);
+    data_.has_speed = 1;
 
-    return packet;
+    mark_dirty(packet_field_course_speed);
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+APRS_TRACK_INLINE void tracker::alt(double alt_meters)
 {
-    string_t packet;
-
-    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_course_speed(track_degrees, speed_knots));
+    data_.alt_feet = meters_to_feet(alt_meters);
+    data_.has_alt = 1;
 
-    return packet;
+    mark_dirty(packet_field_alt);
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+APRS_TRACK_INLINE void tracker::track(double track_degrees)
 {
-    string_t packet;
-
-    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    packet.append(encode_altitude(alt_feet));
+    data_.track_degrees = track_degrees;
+    data_.has_track = 1;
 
-    return packet;
+    mark_dirty(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_field_course_speed);
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+APRS_TRACK_INLINE void tracker::update()
 {
-    string_t packet;
-
-    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+    // Wall clock time, as the phase and the snapshots, if the clock steps
+    // back the interval restarts from the new time, see update(now)
 
-    packet.append(encode_course_speed(track_degrees, speed_knots));
-
-    packet.append(encode_altitude(alt_feet));
-
-    return packet;
+    update(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()));
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
-
-// **************************************************************** //
-//                                                                  //
-// position with timestamp hms                                      //
-//                                                                  //
-// **************************************************************** //
-
-string_t encode_position_data_with_utc_timestamp_hms(char type, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
-string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
-
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
-
-APRS_TRACK_INLINE string_t encode_position_data_with_utc_timestamp_hms(char type, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+APRS_TRACK_INLINE void tracker::update(std::chrono::milliseconds now)
 {
-    // 
-    //  Data Format:
-    // 
-    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
-    //     @
-    //    -----------------------------------------------
-    //     1    7     8     1    9      1        0-43
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // The time is in milliseconds since the epoch, UTC, from the system
+    // clock or from a GNSS receiver, a fleet can be updated with one time
     //
-    //  Examples:
+    // Without a phase, a beacon is sent when the interval elapsed since the
+    // last beacon, trackers started together beacon together
     //
-    //    /092345z4903.50N/07201.75W>Test1234
-    //    @092345/4903.50N/07201.75W>Test1234
-    //    @234517h4903.50N/07201.75W>Test1234
+    // With a phase, the time is divided in slots of the interval, starting
+    // at the phase, periodic trackers beacon once per slot, at its start,
+    // and the first beacon of any tracker waits for the start of its slot
 
-    string_t data;
+#ifndef APRS_TRACK_HEAP_FREE
+    apply_profile();
+#endif
 
-    data.append(1, type);
+    using namespace std::chrono;
 
-    data.append(encode_utc_timestamp_hms(hour, min, sec));
+    const tracker_profile& s = settings();
 
-    position_ddm ddm = dd_to_ddm(lat, lon);
-    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+    int period_seconds = (s.algorithm == algorithm::smart_beaconing) ? s.slow_rate : static_cast<int>(s.interval_seconds);
+    milliseconds period = seconds(std::max(period_seconds, 1));
 
-    data.append(ddm_str.lat);
+    if (phase_.count() >= 0 && last_time.count() == 0)
+    {
+        // the start of the current slot, as if the tracker beaconed then
+        last_time = phase_ + period * beacon_slot(now, phase_, period);
+    }
 
-    data.append(1, symbol_table);
+    if (now < last_time)
+    {
+        // the clock stepped back, instead of waiting for it to catch up
+        // the interval or the slot restarts from now
+        last_time = now;
+    }
 
-    data.append(ddm_str.lon);
+    auto elapsed_time = duration_cast<seconds>(now - last_time).count();
 
-    data.append(1, symbol_code);
+    last_update_seconds = static_cast<unsigned int>(std::max<int64_t>(elapsed_time, 0));
 
-    return data;
+    if (s.algorithm == algorithm::smart_beaconing)
+    {
+        if (smart_beaconing_test())
+        {
+            last_time = now;
+            previous_track_degrees_ = data_.has_track ? static_cast<int32_t>(data_.track_degrees) : 0;
+            updated_ = true;
+            return;
+        }
+    }
+    else if (s.algorithm == algorithm::periodic)
+    {
+        bool due = (phase_.count() >= 0) ?
+            beacon_slot(now, phase_, period) > beacon_slot(last_time, phase_, period) :
+            last_update_seconds >= s.interval_seconds;
+
+        if (due)
+        {
+            last_time = now;
+            updated_ = true;
+            return;
+        }
+    }
+
+    updated_ = false;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+APRS_TRACK_INLINE bool tracker::updated() const
 {
-    string_t packet;
+    return updated_;
+}
 
-    packet.append(encode_header(from, to, path));
+APRS_TRACK_INLINE void tracker::phase(std::chrono::milliseconds offset)
+{
+    // Slots repeat every interval, offsets a multiple of the interval apart
+    // are the same phase, negative disables the phase
 
-    packet.append(encode_position_data_with_utc_timestamp_hms(packet_type_with_timestamp(messaging), hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    return packet;
+    phase_ = offset;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+APRS_TRACK_INLINE void tracker::phase_from_callsign()
 {
-    string_t packet;
-    
-    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    packet.append(encode_course_speed(track_degrees, speed_knots));
-    
-    return packet;
+    phase_ = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE callsign_phase(std::string_view(from_.data(), from_.size()));
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+APRS_TRACK_INLINE std::chrono::milliseconds tracker::phase() const
 {
-    string_t packet;
-
-    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    packet.append(encode_altitude(alt_feet));
-    
-    return packet;
+    return phase_;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+APRS_TRACK_INLINE string_t tracker::packet_string_no_message(packet_type p) const
 {
-    string_t packet;
-   
-    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    packet.append(encode_course_speed(track_degrees, speed_knots));
-    
-    packet.append(encode_altitude(alt_feet));
-    
-    return packet;
-}
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    // The last packet of each type is kept together with the quantized fix
+    // it was encoded from, and the offsets of its fields
+    //
+    // The fix setters mark the fields they change as dirty, if no field is
+    // dirty the cached packet is returned as is, otherwise only the fields
+    // whose quantized value changed are rendered again in place
+    //
+    // A full encode is done when the configuration changed, when an optional
+    // field appeared or disappeared, or when a field changed its length
 
-// **************************************************************** //
-//                                                                  //
-// position with utc timestamp                                      //
-//                                                                  //
-// **************************************************************** //
+    if (p == packet_type::smallest)
+    {
+        p = smallest_packet_type();
+    }
 
-string_t encode_position_data_with_utc_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
-string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double altitude_feet);
+    if (!packet_cache_enabled_)
+    {
+        return encode_packet_no_message(p);
+    }
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+    size_t index = static_cast<size_t>(p);
 
-APRS_TRACK_INLINE string_t encode_position_data_with_utc_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
-{
-    // 
-    //  Data Format:
-    // 
-    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
-    //     @
-    //    -----------------------------------------------
-    //     1    7     8     1    9      1        0-43
-    //
-    //  Examples:
-    //
-    //    /092345z4903.50N/07201.75W>Test1234
-    //    @092345/4903.50N/07201.75W>Test1234
-    //
+    if (packet_cache_.size() <= index)
+    {
+#ifdef APRS_TRACK_PMR
+        // the cached packets are stored with the tracker
+        memory_resource_scope scope(resource_);
+#endif
+        packet_cache_.resize(index + 1);
+    }
 
-    string_t data;
+    packet_cache_entry& entry = packet_cache_[index];
 
-    data.append(1, type);
+    if (entry.valid && entry.revision == revision_ && entry.dirty == 0)
+    {
+        return entry.packet;
+    }
 
-    data.append(encode_utc_timestamp_dhm(day, hour, min));
+    data d = fix();
 
-    position_ddm ddm = dd_to_ddm(lat, lon);
-    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+    packet_cache_key key;
 
-    data.append(ddm_str.lat);
+    if (!make_packet_cache_key(p, d, key))
+    {
+        entry.valid = false;
+        return encode_packet_no_message(p);
+    }
 
-    data.append(1, symbol_table);
+    bool render = !entry.valid || entry.revision != revision_ || entry.key.flags != key.flags || !entry.layout.valid;
 
-    data.append(ddm_str.lon);
+    if (!render)
+    {
+        unsigned int fields = entry.dirty & changed_packet_fields(entry.key, key);
 
-    data.append(1, symbol_code);
+        if (fields != 0 && !render_packet_fields(p, *this, d, entry.layout, fields, entry.packet))
+        {
+            render = true;
+        }
+    }
 
-    return data;
+    if (render)
+    {
+        entry.packet = encode_packet_no_message(p);
+        entry.layout = make_packet_layout(p, *this, d, entry.packet.size());
+        entry.revision = revision_;
+        entry.valid = true;
+    }
+
+    entry.key = key;
+    entry.dirty = 0;
+
+    return entry.packet;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+APRS_TRACK_INLINE string_t tracker::packet_string(packet_type p) const
 {
-    string_t packet;
+    string_t packet = packet_string_no_message(p);
 
-    packet.append(encode_header(from, to, path));
+    std::string_view m = message_view();
+    packet.append(m.data(), m.size());
 
-    packet.append(encode_position_data_with_utc_timestamp_dhm(packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
-    
     return packet;
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+#ifdef APRS_TRACK_PMR
+
+APRS_TRACK_INLINE string_t tracker::packet_string_no_message(packet_type p, std::pmr::memory_resource* resource) const
 {
-    string_t packet;
-  
-    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    packet.append(encode_course_speed(track_degrees, speed_knots));
-    
-    return packet;
+    memory_resource_scope scope(resource);
+    return packet_string_no_message(p);
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+APRS_TRACK_INLINE string_t tracker::packet_string(packet_type p, std::pmr::memory_resource* resource) const
 {
-    string_t packet;
+    memory_resource_scope scope(resource);
+    return packet_string(p);
+}
 
-    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+#endif // APRS_TRACK_PMR
 
-    packet.append(encode_altitude(alt_feet));
+APRS_TRACK_INLINE string_t tracker::encode_packet_no_message(packet_type p) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    return packet;
-}
+    data d = fix();
 
-APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
-{
     string_t packet;
 
-    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
-    
-    packet.append(encode_course_speed(track_degrees, speed_knots));
-    
-    packet.append(encode_altitude(alt_feet));
-    
+    switch (p)
+    {
+        case aprs::track::packet_type::mic_e:
+            packet = encode_mic_e_packet_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position:
+            packet = encode_position_packet_no_timestamp_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_compressed:
+            packet = encode_position_packet_compressed_no_timestamp_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_compressed_with_timestamp:
+            packet = encode_position_packet_compressed_with_timestamp_dhm_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_compressed_with_timestamp_utc:
+            packet = encode_position_packet_compressed_with_utc_timestamp_dhm_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_compressed_with_timestamp_utc_hms:
+            packet = encode_position_packet_compressed_with_utc_timestamp_hms_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_with_timestamp:
+            packet = encode_position_packet_with_timestamp_dhm_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_with_timestamp_utc:
+            packet = encode_position_packet_with_utc_timestamp_dhm_no_message(*this, d);
+            break;
+        case aprs::track::packet_type::position_with_timestamp_utc_hms:
+            packet = encode_position_packet_with_utc_timestamp_hms_no_message(*this, d);
+            break;
+        default:
+            break;
+    }
+
     return packet;
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
-
-// **************************************************************** //
-//                                                                  //
-// position compression                                             //
-//                                                                  //
-// **************************************************************** //
+APRS_TRACK_INLINE void tracker::invalidate_packet_cache()
+{
+    revision_++;
+}
 
-string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code);
-string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type);
-string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
-string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type);
-string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type);
-string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
-string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type);
-string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, double alt_feet);
-string_t encode_compressed_course_speed(double course_degrees, double speed_knots);
-string_t encode_compressed_altitude(double altitude_feet);
-int compression_type_to_int(compression_type type);
+APRS_TRACK_INLINE APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data tracker::fix() const
+{
+    return APRS_TRACK_DETAIL_NAMESPACE_REFERENCE make_data(data_);
+}
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE void tracker::mark_dirty(unsigned int fields)
+{
+    for (APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_cache_entry& entry : packet_cache_)
+    {
+        entry.dirty |= fields;
+    }
+}
 
-APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code)
+APRS_TRACK_INLINE void tracker::packet_cache(bool enabled)
 {
+    // The packet cache is off by default
     //
-    //  Data Format:
-    //
-    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
-    //     =
-    //    --------------------------------------------------------------------------------------------------
-    //     1    1          4           4            1                   2                  1       0-40
-    //
-    //  Examples:
-    //
-    //    =/5L!!<*e7>7P[
-    //
+    // When it is enabled the const packet accessors update the cache,
+    // a tracker must then not be encoded from several threads at once,
+    // even through a const reference
 
-    string_t data;
+    packet_cache_enabled_ = enabled;
+    packet_cache_.clear();
+}
 
-    data.append(1, type);
+APRS_TRACK_INLINE bool tracker::packet_cache() const
+{
+    return packet_cache_enabled_;
+}
 
-    data.append(1, symbol_table);
+APRS_TRACK_INLINE void tracker::history_capacity(size_t capacity)
+{
+    // The storage is allocated here once, and is not reallocated by position()
+    // The history is cleared, a capacity of 0 disables the history
 
-    data.append(encode_compressed_lat(lat));
-    data.append(encode_compressed_lon(lon));
+    history_.clear();
+    history_.resize(capacity);
+    history_head_ = 0;
+    history_count_ = 0;
+    history_speed_count_ = 0;
+    history_distance_cm_ = 0;
+    history_heading_change_ = 0;
+    history_speed_sum_ = 0;
+}
 
-    data.append(1, symbol_code);
+APRS_TRACK_INLINE size_t tracker::history_capacity() const
+{
+    return history_.size();
+}
 
-    return data;
+APRS_TRACK_INLINE size_t tracker::history_size() const
+{
+    return history_count_;
 }
 
-APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type)
+APRS_TRACK_INLINE APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data tracker::history(size_t index) const
 {
-    //
-    //  Data Format:
-    //
-    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
-    //     =
-    //    --------------------------------------------------------------------------------------------------
-    //     1    1          4           4            1                   2                  1       0-40
-    //
-    //  Examples:
-    //
-    //    =/5L!!<*e7>7P[
-    //
+    // Index 0 is the oldest fix, an index past history_size() returns an empty fix
 
-    string_t data;
+    if (index >= history_count_)
+    {
+        return {};
+    }
 
-    data.append(1, type);
+    size_t capacity = history_.size();
+    size_t oldest = (history_head_ + capacity - history_count_) % capacity;
 
-    data.append(1, symbol_table);
+    return APRS_TRACK_DETAIL_NAMESPACE_REFERENCE unpack_data(history_[(oldest + index) % capacity].fix);
+}
 
-    data.append(encode_compressed_lat(lat));
-    data.append(encode_compressed_lon(lon));
+APRS_TRACK_INLINE double tracker::history_distance() const
+{
+    return history_distance_cm_ / 100.0;
+}
 
-    data.append(1, symbol_code);
+APRS_TRACK_INLINE double tracker::history_heading_change() const
+{
+    return history_heading_change_ / 100.0;
+}
 
-    data.append(1, static_cast<char>(compression_type));
+APRS_TRACK_INLINE double tracker::history_average_speed() const
+{
+    if (history_speed_count_ == 0)
+    {
+        return 0.0;
+    }
 
-    return data;
+    double speed_knots = static_cast<double>(history_speed_sum_) / history_speed_count_ / 100.0;
+
+    return APRS_TRACK_DETAIL_NAMESPACE_REFERENCE knots_to_mps(speed_knots);
 }
 
-APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type)
+#ifndef APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE void tracker::snapshot(std::vector<unsigned char>& out) const
 {
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Appends a record of the tracker state: the configuration, the fix,
+    // the time of the last beacon and the course at the last beacon
     //
-    //  Data Format:
-    //
-    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
-    //     =
-    //    --------------------------------------------------------------------------------------------------
-    //     1    1          4           4            1                   2                  1       0-40
-    //
-    //  Examples:
+    // The time of the last beacon is wall clock time, so that a restored
+    // tracker keeps its beacon phase across restarts
     //
-    //    =/5L!!<*e7>7P[
+    // The records can be appended to a file as the trackers change, and
+    // restored in order, see restore()
+
+    size_t start = out.size();
+
+    write_le(out, 0, 4); // record length, set at the end
+    out.push_back(tracker_snapshot_version);
+
+    write_snapshot_string(out, std::string_view(from_.data(), from_.size()));
+    const tracker_profile& s = settings();
+
+    write_snapshot_string(out, std::string_view(s.to.data(), s.to.size()));
+    write_snapshot_string(out, std::string_view(s.path.data(), s.path.size()));
+    // the message bytes and its length in characters, which keep messages
+    // set from wider characters
+    std::span<const unsigned char> message = message_bytes();
+    write_snapshot_string(out, std::string_view(reinterpret_cast<const char*>(message.data()), message.size()));
+    write_le(out, shared_message_ ? shared_message_->length : message_data_length_, 4);
+
+    write_float64(out, data_.lat);
+    write_float64(out, data_.lon);
+    write_float64(out, data_.alt_feet);
+    write_float64(out, data_.speed_knots);
+    write_float64(out, data_.track_degrees);
+    out.push_back(data_.day);
+    out.push_back(data_.hour);
+    out.push_back(data_.minute);
+    out.push_back(data_.second);
+    out.push_back(static_cast<unsigned char>(
+        (data_.has_speed ? track_log_has_speed : 0) |
+        (data_.has_track ? track_log_has_track : 0) |
+        (data_.has_alt ? track_log_has_alt : 0) |
+        (data_.has_time ? track_log_has_time : 0)));
+
+    write_le(out, s.interval_seconds, 4);
+    write_float64(out, s.low_speed_knots);
+    write_float64(out, s.high_speed_knots);
+    write_le(out, static_cast<uint32_t>(s.slow_rate), 4);
+    write_le(out, static_cast<uint32_t>(s.fast_rate), 4);
+    write_le(out, static_cast<uint32_t>(s.turn_time), 4);
+    write_le(out, static_cast<uint32_t>(s.turn_angle), 4);
+    write_le(out, static_cast<uint32_t>(s.turn_slope), 4);
+    write_le(out, static_cast<uint32_t>(s.baud_rate), 4);
+    out.push_back(static_cast<unsigned char>(s.symbol_code));
+    out.push_back(static_cast<unsigned char>(s.symbol_table));
+    out.push_back(static_cast<unsigned char>(s.ambiguity));
+    out.push_back(static_cast<unsigned char>(s.algorithm));
+    out.push_back(static_cast<unsigned char>(s.mic_e_status));
+    out.push_back(s.messaging ? 1 : 0);
+    out.push_back(packet_cache_enabled_ ? 1 : 0);
+    write_le(out, overrides_, 4);
+
+    write_le(out, static_cast<uint64_t>(last_time.count()), 8);
+    write_le(out, static_cast<uint64_t>(phase_.count()), 8);
+    write_le(out, static_cast<uint32_t>(previous_track_degrees_), 4);
+    write_le(out, total_packets_, 8);
+    write_le(out, total_bytes_, 8);
+    write_float64(out, total_airtime_seconds_);
+
+    size_t length = out.size() - start;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        out[start + i] = static_cast<unsigned char>(length >> (8 * i));
+    }
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE size_t tracker::restore(std::span<const unsigned char> bytes)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Restores the record at the start of the bytes, returns the size of the
+    // record, or 0 if it is not a valid record, the tracker is unchanged then
     //
+    // The packet cache and the history are cleared, the profile is kept,
+    // and applied again on the next update()
 
-    string_t data;
+    if (bytes.size() < 5)
+    {
+        return 0;
+    }
 
-    data.append(1, type);
+    size_t length = static_cast<size_t>(read_le(bytes.data(), 4));
 
-    data.append(1, symbol_table);
+    uint8_t version = bytes[4];
 
-    data.append(encode_compressed_lat(lat));
-    data.append(encode_compressed_lon(lon));
+    if (length < 5 || length > bytes.size() || version < 1 || version > tracker_snapshot_version)
+    {
+        return 0;
+    }
 
-    data.append(1, symbol_code);
+    snapshot_reader r;
+    r.p = bytes.data() + 5;
+    r.end = bytes.data() + length;
 
-    data.append(encode_compressed_course_speed(course_degrees, speed_knots));
+    std::string_view from = r.string();
+    std::string_view to = r.string();
+    std::string_view path = r.string();
+    std::string_view message = r.string();
+    size_t message_length = (version >= 4) ? static_cast<size_t>(r.le(4)) : message.size(); // in characters
 
-    data.append(1, static_cast<char>(compression_type));
+    fix_data fix;
 
-    return data;
+    if (version >= 3)
+    {
+        fix.lat = r.float64();
+        fix.lon = r.float64();
+        fix.alt_feet = r.float64();
+        fix.speed_knots = r.float64();
+        fix.track_degrees = r.float64();
+    }
+    else
+    {
+        // versions 1 and 2 have the fix in fixed point
+        packed_data packed;
+        packed.lat = static_cast<int32_t>(r.le(4));
+        packed.lon = static_cast<int32_t>(r.le(4));
+        packed.alt = static_cast<int32_t>(r.le(4));
+        packed.speed = static_cast<uint32_t>(r.le(version >= 2 ? 4 : 2));
+        packed.track = static_cast<uint16_t>(r.le(2));
+        packed.has_speed = 1;
+        packed.has_track = 1;
+        packed.has_alt = 1;
+        data d = unpack_data(packed);
+        fix.lat = d.lat;
+        fix.lon = d.lon;
+        fix.alt_feet = d.alt_feet.value();
+        fix.speed_knots = d.speed_knots.value();
+        fix.track_degrees = d.track_degrees.value();
+    }
+
+    fix.day = static_cast<uint8_t>(r.le(1));
+    fix.hour = static_cast<uint8_t>(r.le(1));
+    fix.minute = static_cast<uint8_t>(r.le(1));
+    fix.second = static_cast<uint8_t>(r.le(1));
+    uint8_t flags = static_cast<uint8_t>(r.le(1));
+    fix.has_speed = (flags & track_log_has_speed) ? 1 : 0;
+    fix.has_track = (flags & track_log_has_track) ? 1 : 0;
+    fix.has_alt = (flags & track_log_has_alt) ? 1 : 0;
+    fix.has_time = (flags & track_log_has_time) ? 1 : 0;
+
+    unsigned int interval_seconds = static_cast<unsigned int>(r.le(4));
+    double low_speed_knots = r.float64();
+    double high_speed_knots = r.float64();
+
+    // the rates, and the course at the last beacon, have 16 bits before version 3
+    auto read_int = [&]() { return (version >= 3) ? static_cast<int>(static_cast<int32_t>(r.le(4))) : static_cast<int>(static_cast<int16_t>(r.le(2))); };
+    int slow_rate = read_int();
+    int fast_rate = read_int();
+    int turn_time = read_int();
+    int turn_angle = read_int();
+    int turn_slope = read_int();
+    int baud_rate = static_cast<int32_t>(r.le(4));
+    char symbol_code = static_cast<char>(r.le(1));
+    char symbol_table = static_cast<char>(r.le(1));
+    int8_t ambiguity = static_cast<int8_t>(r.le(1));
+    uint8_t algorithm_value = static_cast<uint8_t>(r.le(1));
+    uint8_t mic_e_status_value = static_cast<uint8_t>(r.le(1));
+    bool aprs_messaging = r.le(1) != 0;
+    bool packet_cache_enabled = r.le(1) != 0;
+    uint32_t overrides = static_cast<uint32_t>(r.le(4));
+
+    int64_t last_beacon = static_cast<int64_t>(r.le(8));
+    int64_t phase = (version >= 2) ? static_cast<int64_t>(r.le(8)) : -1; // version 1 has no phase
+    int32_t previous_track_degrees = read_int();
+    uint64_t total_packets = r.le(8);
+    uint64_t total_bytes = r.le(8);
+    double total_airtime_seconds = r.float64();
+
+    if (!r.ok || algorithm_value > static_cast<uint8_t>(algorithm::none) || mic_e_status_value > static_cast<uint8_t>(mic_e_status::unknown))
+    {
+        return 0;
+    }
+
+    from_.assign(from.data(), from.size());
+    this->message(message.begin(), message.end());
+    message_data_length_ = static_cast<uint32_t>((std::min)(message_length, message_data_.size())); // a length past the bytes is clamped
+
+    data_ = fix;
+
+    tracker_profile& s = modify_settings(profile_field::none);
+    s.to.assign(to.data(), to.size());
+    s.path.assign(path.data(), path.size());
+    s.interval_seconds = interval_seconds;
+    s.low_speed_knots = low_speed_knots;
+    s.high_speed_knots = high_speed_knots;
+    s.slow_rate = slow_rate;
+    s.fast_rate = fast_rate;
+    s.turn_time = turn_time;
+    s.turn_angle = turn_angle;
+    s.turn_slope = turn_slope;
+    s.baud_rate = baud_rate;
+    s.symbol_code = symbol_code;
+    s.symbol_table = symbol_table;
+    s.ambiguity = ambiguity;
+    s.algorithm = static_cast<enum algorithm>(algorithm_value);
+    s.mic_e_status = static_cast<enum mic_e_status>(mic_e_status_value);
+    s.messaging = aprs_messaging;
+    packet_cache_enabled_ = packet_cache_enabled;
+    overrides_ = overrides;
+    profile_version_ = 0;
+
+    last_time = std::chrono::milliseconds(last_beacon);
+    phase_ = std::chrono::milliseconds(phase);
+    previous_track_degrees_ = previous_track_degrees;
+    total_packets_ = static_cast<size_t>(total_packets);
+    total_bytes_ = static_cast<size_t>(total_bytes);
+    total_airtime_seconds_ = total_airtime_seconds;
+    updated_ = false;
+
+    packet_cache_.clear();
+    invalidate_packet_cache();
+    history_capacity(history_capacity());
+
+    return length;
 }
 
-APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type)
+APRS_TRACK_INLINE void tracker::record_history()
 {
-    //
-    //  Data Format:
-    //
-    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
-    //     =
-    //    --------------------------------------------------------------------------------------------------
-    //     1    1          4           4            1                   2                  1       0-40
-    //
-    //  Examples:
-    //
-    //    =/5L!!<*e7>7P[
-    //
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-    string_t data;
+    size_t capacity = history_.size();
 
-    data.append(1, type);
+    if (capacity == 0)
+    {
+        return;
+    }
 
-    data.append(1, symbol_table);
+    history_entry entry;
+    entry.fix = pack_data(make_data(data_));
 
-    data.append(encode_compressed_lat(lat));
-    data.append(encode_compressed_lon(lon));
+    if (history_count_ > 0)
+    {
+        size_t newest = (history_head_ + capacity - 1) % capacity;
+        entry = make_history_entry(history_[newest].fix, entry.fix);
+    }
 
-    data.append(1, symbol_code);
+    if (history_count_ == capacity)
+    {
+        // The oldest fix is evicted, the next fix becomes the oldest
+        // and its distance and heading change no longer count
 
-    data.append(encode_compressed_altitude(alt_feet));
+        const history_entry& evicted = history_[history_head_];
 
-    data.append(1, static_cast<char>(compression_type));
+        if (evicted.fix.has_speed)
+        {
+            history_speed_sum_ -= evicted.fix.speed;
+            history_speed_count_--;
+        }
 
-    return data;
-}
+        if (capacity > 1)
+        {
+            // with a single fix there is no next fix, and the sums stay 0
+            const history_entry& oldest = history_[(history_head_ + 1) % capacity];
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type)
-{
-    string_t packet;
+            history_distance_cm_ -= oldest.distance_cm;
+            history_heading_change_ -= oldest.heading_change;
+        }
+    }
+    else
+    {
+        history_count_++;
+    }
 
-    packet.append(encode_header(from, to, path));
+    history_[history_head_] = entry;
+    history_head_ = static_cast<uint32_t>((history_head_ + 1) % capacity);
 
-    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, compression_type));
+    if (history_count_ > 1)
+    {
+        history_distance_cm_ += entry.distance_cm;
+        history_heading_change_ += entry.heading_change;
+    }
 
-    return packet;
+    if (entry.fix.has_speed)
+    {
+        history_speed_sum_ += entry.fix.speed;
+        history_speed_count_++;
+    }
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type)
+APRS_TRACK_INLINE const tracker_profile& tracker::settings() const
 {
-    string_t packet;
-
-    packet.append(encode_header(from, to, path));
-    
-    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, course_degrees, speed_knots, compression_type));
-
-    return packet;
+#ifdef APRS_TRACK_HEAP_FREE
+    return settings_;
+#else
+    return *settings_;
+#endif
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type)
+APRS_TRACK_INLINE tracker_profile& tracker::modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field field)
 {
-    string_t packet;
-
-    packet.append(encode_header(from, to, path));
+    // The field is marked as set on the tracker, the profile no longer changes it
+    //
+    // The settings are shared with the profile, or with copies of the tracker,
+    // until the first change, which copies them
+
+#ifdef APRS_TRACK_HEAP_FREE
+    overrides_ |= static_cast<uint32_t>(field);
+    return settings_;
+#else
+    if (overrides_ == 0 || settings_.use_count() != 1)
+    {
+        std::shared_ptr<tracker_profile> s = copy_settings(*settings_);
+        settings_ = s;
+        overrides_ |= static_cast<uint32_t>(field);
+        return *s;
+    }
 
-    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, alt_feet, compression_type));
+    overrides_ |= static_cast<uint32_t>(field);
 
-    return packet;
+    // the settings were copied by this function, they are not const
+    return const_cast<tracker_profile&>(*settings_);
+#endif
 }
 
-APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, double alt_feet)
-{
-    string_t packet;
+#ifndef APRS_TRACK_HEAP_FREE
 
-    packet.append(encode_header(from, to, path));
+APRS_TRACK_INLINE std::shared_ptr<tracker_profile> tracker::copy_settings(const tracker_profile& p) const
+{
+#ifdef APRS_TRACK_PMR
+    // the settings are stored with the tracker
+    memory_resource_scope scope(resource_);
+    return std::allocate_shared<tracker_profile>(resource_allocator<tracker_profile>(resource_), p);
+#else
+    return std::make_shared<tracker_profile>(p);
+#endif
+}
 
-    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, course_degrees, speed_knots, compression_type));
+APRS_TRACK_INLINE void tracker::profile(std::shared_ptr<shared_profile> p)
+{
+    // The settings set on the tracker before are replaced by the profile,
+    // the settings set after are kept when the profile changes
 
-    packet.append(encode_altitude(alt_feet));
+    profile_ = std::move(p);
+    profile_version_ = 0;
+    overrides_ = 0;
 
-    return packet;
+    apply_profile();
 }
 
-APRS_TRACK_INLINE string_t encode_compressed_course_speed(double course_degrees, double speed_knots)
+APRS_TRACK_INLINE const std::shared_ptr<shared_profile>& tracker::profile() const
 {
-    string_t course_speed(2, '\0');
+    return profile_;
+}
 
-    // course degrees is expressed in degrees 0 to 359, clockwise from due north
-    // if the value exceeds 359, it is wrapped around to 0
-    while (course_degrees >= 360.0)
+APRS_TRACK_INLINE void tracker::apply_profile()
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (!profile_)
     {
-        course_degrees -= 360.0;
+        return;
+    }
+
+    uint64_t version = profile_->version();
+
+    if (version == profile_version_)
+    {
+        return;
     }
 
-    int c = static_cast<int>(course_degrees / 4.0);
-    int s = static_cast<int>(std::round(std::log(speed_knots + 1.0) / std::log(1.08)));
+    std::shared_ptr<const tracker_profile> p = profile_->load();
 
-    course_speed[0] = static_cast<char>(c + 33);
-    course_speed[1] = static_cast<char>(s + 33);
+    profile_version_ = version;
 
-    return course_speed;
+    if (overrides_ == 0)
+    {
+        // the tracker reads the settings from the profile
+        settings_ = std::move(p);
+    }
+    else
+    {
+        std::shared_ptr<tracker_profile> s = copy_settings(*p);
+        copy_profile_fields(*settings_, *s, overrides_);
+        settings_ = std::move(s);
+    }
+
+    invalidate_packet_cache();
 }
 
-APRS_TRACK_INLINE string_t encode_compressed_altitude(double altitude_feet)
+#endif // APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE std::u8string tracker::u8packet_string(packet_type p) const
 {
-    int cs = static_cast<int>(std::round(std::log(altitude_feet) / std::log(1.002)));
+    string_t packet = packet_string(p);
+    std::u8string u8packet(packet.begin(), packet.end());
+    return u8packet;
+}
 
-    int c = cs / 91;
-    int s = cs % 91;
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    string_t out(2, '\0');
+template <std::output_iterator<unsigned char> OutputIterator>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::packet(packet_type p, OutputIterator output) const
+{
+    string_t packet = packet_string_no_message(p);
 
-    out[0] = static_cast<char>(c + 33);
-    out[1] = static_cast<char>(s + 33);
+    OutputIterator current = std::copy(reinterpret_cast<const unsigned char*>(packet.data()), reinterpret_cast<const unsigned char*>(packet.data() + packet.size()), output);
 
-    return out;
+    std::span<const unsigned char> bytes = message_bytes();
+    std::copy(bytes.begin(), bytes.end(), current);
 }
 
-APRS_TRACK_INLINE int compression_type_to_int(compression_type type)
+template <std::ranges::output_range<unsigned char> OutputRange>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::packet(packet_type p, OutputRange&& output_range) const
 {
-    switch (type)
+    packet(p, std::ranges::begin(output_range));
+}
+
+template <std::output_iterator<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> OutputIterator>
+APRS_TRACK_INLINE_NO_DISABLE void tracker::history(OutputIterator output) const
+{
+    // Writes the fixes from the oldest to the newest
+
+    for (size_t i = 0; i < history_count_; i++)
     {
-        case compression_type::old_other_compressed: return 0b00000000;
-        case compression_type::old_other_tnc_b_text: return 0b00000001;
-        case compression_type::old_other_software: return 0b00000010;
-        case compression_type::old_other_tbd_1: return 0b00000011;
-        case compression_type::old_other_kpc3: return 0b00000100;
-        case compression_type::old_other_pico: return 0b00000101;
-        case compression_type::old_other_other_tracker: return 0b00000110;
-        case compression_type::old_other_digipeater: return 0b00000111;
+        *output++ = history(i);
+    }
+}
 
-        case compression_type::old_gll_compressed: return 0b00001000;
-        case compression_type::old_gll_tnc_b_text: return 0b00001001;
-        case compression_type::old_gll_software: return 0b00001010;
-        case compression_type::old_gll_tbd_1: return 0b00001011;
-        case compression_type::old_gll_kpc3: return 0b00001100;
-        case compression_type::old_gll_pico: return 0b00001101;
-        case compression_type::old_gll_other_tracker: return 0b00001110;
-        case compression_type::old_gll_digipeater: return 0b00001111;
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-        case compression_type::old_gga_compressed: return 0b00010000;
-        case compression_type::old_gga_tnc_b_text: return 0b00010001;
-        case compression_type::old_gga_software: return 0b00010010;
-        case compression_type::old_gga_tbd_1: return 0b00010011;
-        case compression_type::old_gga_kpc3: return 0b00010100;
-        case compression_type::old_gga_pico: return 0b00010101;
-        case compression_type::old_gga_other_tracker: return 0b00010110;
-        case compression_type::old_gga_digipeater: return 0b00010111;
+APRS_TRACK_INLINE bool tracker::smart_beaconing_test()
+{
+    int speed_knots = data_.has_speed ? static_cast<int>(data_.speed_knots) : 0;
+    int course_degrees = data_.has_track ? static_cast<int>(data_.track_degrees) : 0;
+    int prev_course_degrees = previous_track_degrees_;
+    const tracker_profile& s = settings();
+    int low_speed_knots_int = static_cast<int>(std::round(s.low_speed_knots));
+    int high_speed_knots_int = static_cast<int>(std::round(s.high_speed_knots));
 
-        case compression_type::old_rmc_compressed: return 0b00011000;
-        case compression_type::old_rmc_tnc_b_text: return 0b00011001;
-        case compression_type::old_rmc_software: return 0b00011010;
-        case compression_type::old_rmc_tbd_1: return 0b00011011;
-        case compression_type::old_rmc_kpc3: return 0b00011100;
-        case compression_type::old_rmc_pico: return 0b00011101;
-        case compression_type::old_rmc_other_tracker: return 0b00011110;
-        case compression_type::old_rmc_digipeater: return 0b00011111;
+    bool result = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE smart_beaconing_test(speed_knots, prev_course_degrees, course_degrees, low_speed_knots_int, high_speed_knots_int, s.slow_rate,
+        s.fast_rate, s.turn_time, s.turn_angle, s.turn_slope, last_update_seconds);
 
-        case compression_type::current_other_compressed: return 0b00100000;
-        case compression_type::current_other_tnc_b_text: return 0b00100001;
-        case compression_type::current_other_software: return 0b00100010;
-        case compression_type::current_other_tbd_1: return 0b00100011;
-        case compression_type::current_other_kpc3: return 0b00100100;
-        case compression_type::current_other_pico: return 0b00100101;
-        case compression_type::current_other_other_tracker: return 0b00100110;
-        case compression_type::current_other_digipeater: return 0b00100111;
+    return result;
+}
 
-        case compression_type::current_gll_compressed: return 0b00101000;
-        case compression_type::current_gll_tnc_b_text: return 0b00101001;
-        case compression_type::current_gll_software: return 0b00101010;
-        case compression_type::current_gll_tbd_1: return 0b00101011;
-        case compression_type::current_gll_kpc3: return 0b00101100;
-        case compression_type::current_gll_pico: return 0b00101101;
-        case compression_type::current_gll_other_tracker: return 0b00101110;
-        case compression_type::current_gll_digipeater: return 0b00101111;
+APRS_TRACK_INLINE void tracker::baud_rate(int baud)
+{
+    modify_settings(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE profile_field::baud_rate).baud_rate = baud;
+}
 
-        case compression_type::current_gga_compressed: return 0b00110000;
-        case compression_type::current_gga_tnc_b_text: return 0b00110001;
-        case compression_type::current_gga_software: return 0b00110010;
-        case compression_type::current_gga_tbd_1: return 0b00110011;
-        case compression_type::current_gga_kpc3: return 0b00110100;
-        case compression_type::current_gga_pico: return 0b00110101;
-        case compression_type::current_gga_other_tracker: return 0b00110110;
-        case compression_type::current_gga_digipeater: return 0b00110111;
+APRS_TRACK_INLINE int tracker::baud_rate() const
+{
+    return settings().baud_rate;
+}
 
-        case compression_type::current_rmc_compressed: return 0b00111000;
-        case compression_type::current_rmc_tnc_b_text: return 0b00111001;
-        case compression_type::current_rmc_software: return 0b00111010;
-        case compression_type::current_rmc_tbd_1: return 0b00111011;
-        case compression_type::current_rmc_kpc3: return 0b00111100;
-        case compression_type::current_rmc_pico: return 0b00111101;
-        case compression_type::current_rmc_other_tracker: return 0b00111110;
-        case compression_type::current_rmc_digipeater: return 0b00111111;
+APRS_TRACK_INLINE packet_type tracker::smallest_packet_type() const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-        default:
-            break;
+    // Candidates are the encodings which can carry every field present in the fix
+    //
+    //   - Mic-E replaces the destination address, and has no APRS messaging flag
+    //   - compressed positions cannot express position ambiguity
+    //   - only the timestamped formats carry the time, the uncompressed and
+    //     compressed formats with a UTC day/hour/minute timestamp are considered
+    //
+    // The candidate with the least airtime wins, bit stuffing can make a
+    // shorter packet take longer to transmit
+
+    packet_type candidates[3];
+    size_t count = 0;
+
+    const tracker_profile& s = settings();
+
+    if (data_.has_time)
+    {
+        if (s.ambiguity == 0)
+        {
+            candidates[count++] = packet_type::position_compressed_with_timestamp_utc;
+        }
+        candidates[count++] = packet_type::position_with_timestamp_utc;
+    }
+    else
+    {
+        if (!s.messaging)
+        {
+            candidates[count++] = packet_type::mic_e;
+        }
+        if (s.ambiguity == 0)
+        {
+            candidates[count++] = packet_type::position_compressed;
+        }
+        candidates[count++] = packet_type::position;
     }
 
-    return 0;
+    packet_type smallest = candidates[0];
+    packet_airtime smallest_airtime = airtime(smallest);
+
+    for (size_t i = 1; i < count; i++)
+    {
+        packet_airtime a = airtime(candidates[i]);
+        if (a.frame_bits < smallest_airtime.frame_bits || (a.frame_bits == smallest_airtime.frame_bits && a.packet_bytes < smallest_airtime.packet_bytes))
+        {
+            smallest = candidates[i];
+            smallest_airtime = a;
+        }
+    }
+
+    return smallest;
 }
 
-#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE packet_airtime tracker::airtime(packet_type p) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
 
-// **************************************************************** //
-//                                                                  //
-// mic-e                                                            //
-//                                                                  //
-// **************************************************************** //
+    string_t packet = packet_string(p);
 
-string_t encode_mic_e_data(char type, double lat, double lon, double course_degrees, double speed_knots, char symbol_table, char symbol_code);
-string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity);
-string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
-void add_mic_e_position_ambiguity(string_t& destination_address, int ambiguity);
-void encode_mic_e_status(int a, int b, int c, bool custom, string_t& destination_address);
-void encode_mic_e_lat_direction(char direction, string_t& destination_address);
-void encode_mic_lon_offset(bool offset, string_t& destination_address);
-void encode_mic_lon_direction(char direction, string_t& destination_address);
-std::tuple<int, int, int, bool> encode_mic_e_status(mic_e_status status);
-void encode_mic_e_status(mic_e_status status, string_t& destination_address);
-string_t encode_mic_e_lat(double lat);
-string_t encode_mic_e_lat(double lat, mic_e_status status);
-string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity);
-char encode_mic_e_lon_degrees(int lon_d);
-char encode_mic_e_lon_minutes(int lon_m);
-char encode_mic_e_lon_hundred_minutes(int lon_h);
-string_t encode_mic_e_lon(double lon);
-string_t encode_mic_e_course_speed(double course_degrees, double speed_knots);
-string_t encode_mic_e_course_speed_alternate(double course_degrees, double speed_knots);
-string_t encode_mic_e_alt(double alt_meters);
-string_t encode_mic_e_alt_feet(double alt_feet);
+    return estimate_airtime(std::string_view(packet.data(), packet.size()), settings().baud_rate);
+}
 
-#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+APRS_TRACK_INLINE void tracker::account(const packet_airtime& a)
+{
+    total_packets_++;
+    total_bytes_ += a.packet_bytes;
+    total_airtime_seconds_ += a.seconds;
+}
 
-APRS_TRACK_INLINE double round_number(double number)
+APRS_TRACK_INLINE size_t tracker::total_packets() const
 {
-    double factor = 10.0;
-    return std::round(number * factor) / factor;
+    return total_packets_;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_data(char type, double lat, double lon, double course_degrees, double speed_knots, char symbol_table, char symbol_code)
+APRS_TRACK_INLINE size_t tracker::total_bytes() const
 {
-    (void)lat;
+    return total_bytes_;
+}
 
-    string_t data;
+APRS_TRACK_INLINE double tracker::total_airtime_seconds() const
+{
+    return total_airtime_seconds_;
+}
 
-    data.append(1, type);
+#ifndef APRS_TRACK_HEAP_FREE
 
-    data.append(encode_mic_e_lon(lon));
-    data.append(encode_mic_e_course_speed(course_degrees, speed_knots));
+APRS_TRACK_INLINE shared_profile::shared_profile(const tracker_profile& p) : profile_(std::make_shared<const tracker_profile>(p))
+{
+}
 
-    data.append(1, symbol_code);
-    data.append(1, symbol_table);
+APRS_TRACK_INLINE void shared_profile::store(const tracker_profile& p)
+{
+    std::shared_ptr<const tracker_profile> profile = std::make_shared<const tracker_profile>(p);
+#if defined(__cpp_lib_atomic_shared_ptr)
+    profile_.store(std::move(profile));
+#else
+    std::lock_guard lock(mutex_);
+    profile_.swap(profile);
+#endif
+    version_.fetch_add(1, std::memory_order_release);
+}
 
-    return data;
+APRS_TRACK_INLINE std::shared_ptr<const tracker_profile> shared_profile::load() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return profile_.load();
+#else
+    std::lock_guard lock(mutex_);
+    return profile_;
+#endif
 }
 
-// support type... first character
-// 
+APRS_TRACK_INLINE uint64_t shared_profile::version() const
+{
+    return version_.load(std::memory_order_acquire);
+}
 
-APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity)
+APRS_TRACK_INLINE message_handle message_pool::intern(std::string_view message)
 {
-    string_t packet;
+    auto it = messages_.find(message);
 
-    string_t lat_str = encode_mic_e_lat(lat, lon, status, ambiguity);
+    if (it != messages_.end())
+    {
+        return it->second;
+    }
 
-    packet.append(encode_header(from, lat_str.data(), path));
+    auto m = std::make_shared<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE shared_message>();
+    m->bytes.assign(message.begin(), message.end());
+    m->length = message.size();
 
-    packet.append(encode_mic_e_data('`', lat, lon, course_degrees, speed_knots, symbol_table, symbol_code));
+    std::string_view key(reinterpret_cast<const char*>(m->bytes.data()), m->bytes.size());
+    messages_.emplace(key, m);
 
-    return packet;
+    return m;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+APRS_TRACK_INLINE size_t message_pool::size() const
 {
-    string_t packet;
-
-    packet.append(encode_mic_e_packet_no_message(from, path, lat, lon, status, course_degrees, speed_knots, symbol_table, symbol_code, ambiguity));
-
-    packet.append(encode_mic_e_alt_feet(alt_feet));
-
-    return packet;
+    return messages_.size();
 }
 
-APRS_TRACK_INLINE void add_mic_e_position_ambiguity(string_t& destination_address, int ambiguity)
+APRS_TRACK_INLINE size_t message_pool::bytes() const
 {
-    if (!(ambiguity > 0))
+    size_t total = 0;
+    for (const auto& [key, m] : messages_)
     {
-        return;
+        total += m->bytes.size();
     }
+    return total;
+}
 
-    for (size_t i = destination_address.size() - 1, count = 0; count < static_cast<size_t>(ambiguity) && i < destination_address.size(); i--, count++)
+APRS_TRACK_INLINE size_t message_pool::collect()
+{
+    // Drops the messages which are only referenced by the pool
+
+    size_t count = 0;
+
+    for (auto it = messages_.begin(); it != messages_.end();)
     {
-        if (destination_address[i] >= 'P' && destination_address[i] <= 'Y')
-        {
-            destination_address[i] = 'Z';
-        }
-        else if (destination_address[i] >= '0' && destination_address[i] <= '9')
+        if (it->second.use_count() == 1)
         {
-            destination_address[i] = 'L';
+            it = messages_.erase(it);
+            count++;
         }
-        else if (destination_address[i] >= 'A' && destination_address[i] <= 'J')
+        else
         {
-            destination_address[i] = 'K';
+            ++it;
         }
     }
+
+    return count;
 }
 
-APRS_TRACK_INLINE void insert_mic_e_type(string_t& data, std::string_view type)
+#endif // APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE void transmit_arbiter::baud_rate(int baud)
 {
-    assert(data.size() >= 9);
-    data.insert(9, type.data());
+    baud_rate_ = baud;
 }
 
-APRS_TRACK_INLINE void append_mic_e_manufacturer(string_t& packet_or_data, std::string_view manufacturer_version)
+APRS_TRACK_INLINE int transmit_arbiter::baud_rate() const
 {
-    assert(manufacturer_version.size() >= 1);
-    packet_or_data.append(manufacturer_version.data(), manufacturer_version.size());
+    return baud_rate_;
 }
 
-APRS_TRACK_INLINE void encode_mic_e_status(int a, int b, int c, bool custom, string_t& destination_address)
+APRS_TRACK_INLINE void transmit_arbiter::txdelay(std::chrono::milliseconds delay)
 {
-    int message_bits[3] = {a, b, c};
+    txdelay_ = delay;
+}
 
-    for (size_t i = 0; i < 3; i++)
+APRS_TRACK_INLINE std::chrono::milliseconds transmit_arbiter::txdelay() const
+{
+    return txdelay_;
+}
+
+APRS_TRACK_INLINE void transmit_arbiter::budget(double channel_fraction)
+{
+    budget_ = channel_fraction;
+}
+
+APRS_TRACK_INLINE double transmit_arbiter::budget() const
+{
+    return budget_;
+}
+
+APRS_TRACK_INLINE void transmit_arbiter::burst(std::chrono::milliseconds airtime)
+{
+    burst_ = airtime;
+    tokens_ = airtime;
+}
+
+APRS_TRACK_INLINE std::chrono::milliseconds transmit_arbiter::burst() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(burst_);
+}
+
+APRS_TRACK_INLINE void transmit_arbiter::jitter(std::chrono::milliseconds max_jitter)
+{
+    jitter_ = max_jitter;
+}
+
+APRS_TRACK_INLINE std::chrono::milliseconds transmit_arbiter::jitter() const
+{
+    return jitter_;
+}
+
+APRS_TRACK_INLINE void transmit_arbiter::seed(uint32_t seed)
+{
+    // xorshift has to start from a non zero state
+    random_state_ = seed != 0 ? seed : 0x9E3779B9;
+}
+
+APRS_TRACK_INLINE std::chrono::microseconds transmit_arbiter::airtime(std::string_view packet) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // The transmitter is keyed up for TXDELAY before the frame is sent
+
+    packet_airtime a = estimate_airtime(packet, baud_rate_);
+
+    return txdelay_ + std::chrono::microseconds(static_cast<int64_t>(std::ceil(a.seconds * 1000000.0)));
+}
+
+APRS_TRACK_INLINE bool transmit_arbiter::request(std::string_view packet, bool emergency, std::chrono::milliseconds now)
+{
+    // Decides if a frame can be transmitted at "now"
+    //
+    // The channel time is budgeted with a token bucket, tokens are airtime
+    // and are refilled at "budget" seconds of airtime per second, up to "burst"
+    //
+    // After each transmission the channel is held for the frame airtime plus
+    // a random jitter, so that stations sharing the radio do not transmit back to back
+    //
+    // Emergency frames are always granted immediately, their airtime is
+    // still charged to the bucket
+    //
+    // A frame longer than the burst is granted once the bucket is full,
+    // the bucket then goes negative and the next frame waits for the debt
+    // to be refilled, otherwise such a frame would never be sent
+    //
+    // The time is supplied by the caller, the arbiter never reads a clock,
+    // and the jitter is generated from the seed, making the arbiter deterministic
+
+    refill(now);
+
+    std::chrono::microseconds cost = airtime(packet);
+
+    if (!emergency)
     {
-        // this handling is not necessary due to how the
-        // lat ambiguity is applied later, but it is useful in testing
-        if (destination_address[i] == ' ')
+        if (now < next_time_)
         {
-            if (message_bits[i] == 1 && custom)
+            deferred_++;
+            return false;
+        }
+
+        if (tokens_ < cost && tokens_ < burst_)
+        {
+            if (budget_ > 0.0)
             {
-                destination_address[i] = 'K';
+                std::chrono::microseconds needed = std::min(cost, burst_);
+                auto wait = std::chrono::microseconds(static_cast<int64_t>(std::ceil((needed - tokens_).count() / budget_)));
+                next_time_ = now + std::chrono::ceil<std::chrono::milliseconds>(wait);
             }
-            else if (message_bits[i] == 1 && !custom)
+            deferred_++;
+            return false;
+        }
+    }
+
+    tokens_ -= cost;
+
+    std::chrono::milliseconds spacing = std::chrono::ceil<std::chrono::milliseconds>(cost);
+
+    if (jitter_.count() > 0)
+    {
+        spacing += std::chrono::milliseconds(next_random() % (static_cast<uint32_t>(jitter_.count()) + 1));
+    }
+
+    next_time_ = std::max(next_time_, now + spacing);
+
+    granted_++;
+    total_airtime_ += cost;
+
+    return true;
+}
+
+APRS_TRACK_INLINE bool transmit_arbiter::request(const tracker& t, packet_type p, std::chrono::milliseconds now)
+{
+    // A tracker reporting an emergency has priority, no matter the packet type
+
+    string_t packet = t.packet_string(p);
+
+    return request(std::string_view(packet.data(), packet.size()), t.mic_e_status() == mic_e_status::emergency, now);
+}
+
+APRS_TRACK_INLINE std::chrono::milliseconds transmit_arbiter::next_time() const
+{
+    return next_time_;
+}
+
+APRS_TRACK_INLINE size_t transmit_arbiter::granted() const
+{
+    return granted_;
+}
+
+APRS_TRACK_INLINE size_t transmit_arbiter::deferred() const
+{
+    return deferred_;
+}
+
+APRS_TRACK_INLINE std::chrono::microseconds transmit_arbiter::total_airtime() const
+{
+    return total_airtime_;
+}
+
+APRS_TRACK_INLINE void transmit_arbiter::refill(std::chrono::milliseconds now)
+{
+    if (!started_)
+    {
+        started_ = true;
+        last_refill_ = now;
+        return;
+    }
+
+    if (now <= last_refill_)
+    {
+        return;
+    }
+
+    std::chrono::microseconds elapsed = now - last_refill_;
+    last_refill_ = now;
+
+    tokens_ += std::chrono::microseconds(static_cast<int64_t>(elapsed.count() * budget_));
+
+    if (tokens_ > burst_)
+    {
+        tokens_ = burst_;
+    }
+}
+
+APRS_TRACK_INLINE uint32_t transmit_arbiter::next_random()
+{
+    // xorshift32
+
+    uint32_t x = random_state_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random_state_ = x;
+    return x;
+}
+
+APRS_TRACK_INLINE duplicate_filter::duplicate_filter() : duplicate_filter(APRS_TRACK_DUPLICATE_CAPACITY)
+{
+}
+
+APRS_TRACK_INLINE duplicate_filter::duplicate_filter(size_t capacity, std::chrono::milliseconds window) : window_(window)
+{
+    // The capacity is rounded up to a power of 2, and to a bucket at least
+
+    size_t size = 8;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+
+    table_.resize(size);
+
+    // the heap free storage might be smaller, keep a power of 2
+    while (table_.size() & (table_.size() - 1))
+    {
+        table_.resize(table_.size() & (table_.size() - 1));
+    }
+}
+
+APRS_TRACK_INLINE void duplicate_filter::window(std::chrono::milliseconds window)
+{
+    window_ = window;
+}
+
+APRS_TRACK_INLINE std::chrono::milliseconds duplicate_filter::window() const
+{
+    return window_;
+}
+
+APRS_TRACK_INLINE size_t duplicate_filter::capacity() const
+{
+    return table_.size();
+}
+
+APRS_TRACK_INLINE bool duplicate_filter::check(std::string_view packet, std::chrono::milliseconds now)
+{
+    return check(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE packet_fingerprint(packet), now);
+}
+
+APRS_TRACK_INLINE bool duplicate_filter::check(const unsigned char* frame, size_t size, std::chrono::milliseconds now)
+{
+    return check(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE frame_fingerprint(frame, size), now);
+}
+
+APRS_TRACK_INLINE bool duplicate_filter::check(uint64_t fingerprint, std::chrono::milliseconds now)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Returns true if the packet was seen in the window, otherwise
+    // remembers it and returns false
+    //
+    // The window starts when the packet is first seen, duplicates do not extend it
+
+    if (table_.size() < 8)
+    {
+        return false;
+    }
+
+    if (fingerprint == 0)
+    {
+        fingerprint = 1;
+    }
+
+    int64_t t = now.count();
+    int64_t window = window_.count();
+
+    size_t bucket = static_cast<size_t>(fingerprint >> 32) & (table_.size() - 1) & ~size_t(7);
+
+    duplicate_entry* entries = &table_[bucket];
+    duplicate_entry* free_entry = nullptr;
+    duplicate_entry* oldest_entry = entries;
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        duplicate_entry& e = entries[i];
+
+        bool live = e.fingerprint != 0 && t - e.time < window;
+
+        if (live)
+        {
+            if (e.fingerprint == fingerprint)
             {
-                destination_address[i] = 'Z';
+                duplicates_++;
+                return true;
             }
-            else if (message_bits[i] == 0)
+            if (e.time < oldest_entry->time)
             {
-                destination_address[i] = 'L';
+                oldest_entry = &e;
             }
-            continue;
         }
+        else if (free_entry == nullptr)
+        {
+            free_entry = &e;
+        }
+    }
 
-        if (message_bits[i] == 1 && custom)
+    if (free_entry == nullptr)
+    {
+        free_entry = oldest_entry;
+        evictions_++;
+    }
+
+    free_entry->fingerprint = fingerprint;
+    free_entry->time = t;
+
+    return false;
+}
+
+APRS_TRACK_INLINE void duplicate_filter::clear()
+{
+    std::fill(table_.begin(), table_.end(), APRS_TRACK_DETAIL_NAMESPACE_REFERENCE duplicate_entry{});
+    duplicates_ = 0;
+    evictions_ = 0;
+}
+
+APRS_TRACK_INLINE size_t duplicate_filter::duplicates() const
+{
+    return duplicates_;
+}
+
+APRS_TRACK_INLINE size_t duplicate_filter::evictions() const
+{
+    return evictions_;
+}
+
+APRS_TRACK_INLINE void digipeater::callsign(std::string_view callsign)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    callsign_ = string_t(callsign.data(), callsign.size());
+    has_callsign_ = encode_ax25_address(callsign, false, false, callsign_address_) == 7;
+}
+
+APRS_TRACK_INLINE string_t digipeater::callsign() const
+{
+    return callsign_;
+}
+
+APRS_TRACK_INLINE void digipeater::aliases(std::string_view aliases)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Comma separated list of aliases, like WIDE1-1,RELAY
+    // Addresses which cannot be represented in AX.25 are skipped
+
+    aliases_ = string_t(aliases.data(), aliases.size());
+    alias_count_ = 0;
+
+    for (size_t start = 0; start < aliases.size() && alias_count_ < 8;)
+    {
+        size_t end = aliases.find(',', start);
+        if (end == std::string_view::npos)
         {
-            destination_address[i] = 'A' + (destination_address[i] - '0');
+            end = aliases.size();
         }
-        else if (message_bits[i] == 1 && !custom)
+        if (encode_ax25_address(aliases.substr(start, end - start), false, false, alias_addresses_[alias_count_]) == 7)
         {
-            destination_address[i] = 'P' + (destination_address[i] - '0');
+            alias_count_++;
         }
+        start = end + 1;
     }
 }
 
-APRS_TRACK_INLINE void encode_mic_e_lat_direction(char direction, string_t& destination_address)
+APRS_TRACK_INLINE string_t digipeater::aliases() const
 {
-    // this handling is not necessary due to how the
-    // lat ambiguity is applied later, but it is useful in testing
-    if (destination_address[3] == ' ')
+    return aliases_;
+}
+
+APRS_TRACK_INLINE void digipeater::max_hops(int n)
+{
+    max_hops_ = std::clamp(n, 0, 7);
+}
+
+APRS_TRACK_INLINE int digipeater::max_hops() const
+{
+    return max_hops_;
+}
+
+APRS_TRACK_INLINE void digipeater::preemptive(bool enable)
+{
+    preemptive_ = enable;
+}
+
+APRS_TRACK_INLINE bool digipeater::preemptive() const
+{
+    return preemptive_;
+}
+
+APRS_TRACK_INLINE size_t digipeater::digipeat(unsigned char* frame, size_t size, size_t capacity)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Returns the size of the repeated frame, or 0 if the frame is not repeated
+    // A WIDEn-N frame grows by 7 bytes if the capacity allows it, and if it
+    // has less than 8 digipeaters, otherwise N is only decremented
+
+    if (!has_callsign_)
     {
-        if (direction == 'N')
+        return 0;
+    }
+
+    size_t address_count = 0;
+
+    while ((address_count + 1) * 7 <= size && address_count < 10)
+    {
+        address_count++;
+        if (frame[address_count * 7 - 1] & 1)
         {
-            destination_address[3] = 'Z';
+            break;
         }
-        else if (direction == 'S')
+    }
+
+    size_t header_size = address_count * 7;
+
+    if (address_count < 2 || (frame[header_size - 1] & 1) == 0 || header_size + 2 + 2 > size)
+    {
+        return 0;
+    }
+
+    size_t next = 2;
+
+    while (next < address_count && (frame[next * 7 + 6] & 0b10000000))
+    {
+        next++;
+    }
+
+    if (next == address_count)
+    {
+        return 0; // no digipeaters, or all used
+    }
+
+    auto is_alias = [&](const unsigned char* address) {
+        for (size_t i = 0; i < alias_count_; i++)
         {
-            destination_address[3] = 'L';
+            if (ax25_address_equal(address, alias_addresses_[i]))
+            {
+                return true;
+            }
         }
-        return;
+        return false;
+    };
+
+    size_t target = next;
+    bool insert = false;
+
+    const unsigned char* address = frame + next * 7;
+
+    int n = 0;
+    int remaining = 0;
+
+    if (ax25_address_equal(address, callsign_address_) || is_alias(address))
+    {
+        // repeated as is
+    }
+    else if (ax25_wide_hops(address, n, remaining))
+    {
+        if (n > max_hops_ || remaining > n)
+        {
+            return 0;
+        }
+        insert = true;
     }
+    else if (preemptive_)
+    {
+        target = address_count;
+
+        for (size_t i = next + 1; i < address_count; i++)
+        {
+            if (ax25_address_equal(frame + i * 7, callsign_address_) || is_alias(frame + i * 7))
+            {
+                target = i;
+                break;
+            }
+        }
+
+        if (target == address_count)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    // the addresses before the next unused one do not change
+    uint16_t prefix_register = fcs_register(0xFFFF, frame, next * 7);
+    uint16_t old_register = fcs_register(prefix_register, frame + next * 7, header_size - next * 7);
+    uint16_t fcs = static_cast<uint16_t>(frame[size - 2] | (frame[size - 1] << 8));
+    size_t body_size = size - header_size - 2; // control, PID and information field
+
+    for (size_t i = next; i < target; i++)
+    {
+        frame[i * 7 + 6] |= 0b10000000;
+    }
+
+    unsigned char* a = frame + target * 7;
+
+    if (!insert)
+    {
+        // the callsign or an alias, replaced with the callsign
+        unsigned char last = a[6] & 1;
+        std::memcpy(a, callsign_address_, 7);
+        a[6] = static_cast<unsigned char>((a[6] & 0b01111110) | 0b10000000 | last);
+    }
+    else
+    {
+        remaining--;
+
+        a[6] = static_cast<unsigned char>((a[6] & 0b11100001) | (remaining << 1));
+        if (remaining == 0)
+        {
+            a[6] |= 0b10000000;
+        }
+
+        if (address_count < 10 && size + 7 <= capacity)
+        {
+            std::memmove(a + 7, a, size - target * 7);
+            std::memcpy(a, callsign_address_, 7);
+            a[6] = static_cast<unsigned char>((a[6] & 0b01111110) | 0b10000000);
+            header_size += 7;
+            size += 7;
+        }
+    }
+
+    // The FCS is affine in the frame bytes, the body is unchanged, so the
+    // change of the CRC register after the addresses is shifted through the body
+
+    uint16_t new_register = fcs_register(prefix_register, frame + next * 7, header_size - next * 7);
+    fcs ^= fcs_shift(static_cast<uint16_t>(old_register ^ new_register), body_size);
+
+    frame[size - 2] = static_cast<unsigned char>(fcs & 0xFF);
+    frame[size - 1] = static_cast<unsigned char>(fcs >> 8);
+
+    repeated_++;
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t digipeater::repeated() const
+{
+    return repeated_;
+}
+
+APRS_TRACK_INLINE station_table::station_table() : station_table(16)
+{
+}
+
+APRS_TRACK_INLINE station_table::station_table(size_t capacity)
+{
+    reserve(capacity);
+}
+
+APRS_TRACK_INLINE bool station_table::update(callsign_key key, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Inserts the station, or replaces its fix
+    // Returns false if the key is not valid, or if the table is full
+
+    if (!key.valid())
+    {
+        return false;
+    }
+
+    if ((size_ + 1) * 4 > table_.size() * 3 && !rehash(table_.size() * 2))
+    {
+        // full, only updates of known stations
+        if (table_.size() == 0 || !contains(key))
+        {
+            return false;
+        }
+    }
+
+    size_t mask = table_.size() - 1;
+    size_t i = slot(key);
+
+    while (table_[i].key != 0 && table_[i].key != key.value)
+    {
+        i = (i + 1) & mask;
+    }
+
+    if (table_[i].key == 0)
+    {
+        table_[i].key = key.value;
+        size_++;
+    }
+
+    table_[i].fix = pack_data(d);
+
+    return true;
+}
+
+APRS_TRACK_INLINE bool station_table::update(std::string_view callsign, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d)
+{
+    return update(make_callsign_key(callsign), d);
+}
+
+APRS_TRACK_INLINE std::optional<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> station_table::find(callsign_key key) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (!key.valid() || table_.size() == 0)
+    {
+        return std::nullopt;
+    }
+
+    size_t mask = table_.size() - 1;
+
+    for (size_t i = slot(key); table_[i].key != 0; i = (i + 1) & mask)
+    {
+        if (table_[i].key == key.value)
+        {
+            return unpack_data(table_[i].fix);
+        }
+    }
+
+    return std::nullopt;
+}
+
+APRS_TRACK_INLINE std::optional<APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data> station_table::find(std::string_view callsign) const
+{
+    return find(make_callsign_key(callsign));
+}
+
+APRS_TRACK_INLINE bool station_table::contains(callsign_key key) const
+{
+    if (!key.valid() || table_.size() == 0)
+    {
+        return false;
+    }
+
+    size_t mask = table_.size() - 1;
+
+    for (size_t i = slot(key); table_[i].key != 0; i = (i + 1) & mask)
+    {
+        if (table_[i].key == key.value)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+APRS_TRACK_INLINE bool station_table::erase(callsign_key key)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Removes the station, and shifts back the entries after it which
+    // would not be found anymore, no tombstones are left behind
+
+    if (!key.valid() || table_.size() == 0)
+    {
+        return false;
+    }
+
+    size_t mask = table_.size() - 1;
+    size_t i = slot(key);
+
+    while (table_[i].key != key.value)
+    {
+        if (table_[i].key == 0)
+        {
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+
+    size_t hole = i;
+
+    for (size_t j = (hole + 1) & mask; table_[j].key != 0; j = (j + 1) & mask)
+    {
+        size_t home = slot(callsign_key{ table_[j].key });
+
+        // the entry can move into the hole if its home is not between the hole and the entry
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            table_[hole] = table_[j];
+            hole = j;
+        }
+    }
+
+    table_[hole] = station_entry();
+    size_--;
+
+    return true;
+}
+
+APRS_TRACK_INLINE void station_table::clear()
+{
+    std::fill(table_.begin(), table_.end(), APRS_TRACK_DETAIL_NAMESPACE_REFERENCE station_entry{});
+    size_ = 0;
+}
+
+APRS_TRACK_INLINE void station_table::reserve(size_t count)
+{
+    // Grows the table to hold count stations without rehashing
+
+    size_t capacity = 16;
+    while (capacity * 3 < count * 4)
+    {
+        capacity *= 2;
+    }
+
+    if (capacity > table_.size())
+    {
+        rehash(capacity);
+    }
+}
+
+APRS_TRACK_INLINE size_t station_table::size() const
+{
+    return size_;
+}
+
+APRS_TRACK_INLINE size_t station_table::capacity() const
+{
+    return table_.size() * 3 / 4;
+}
+
+APRS_TRACK_INLINE size_t station_table::slot(callsign_key key) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    return static_cast<size_t>(mix64(key.value)) & (table_.size() - 1);
+}
+
+APRS_TRACK_INLINE bool station_table::rehash(size_t capacity)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Moves the entries to a table of the given power of 2 size
+    // Returns false if the table cannot grow
+
+#ifdef APRS_TRACK_HEAP_FREE
+    // the inline table is sized once, to the largest power of 2 which fits
+    if (table_.size() != 0)
+    {
+        return false;
+    }
+    capacity = station_table_t::capacity();
+    while (capacity & (capacity - 1))
+    {
+        capacity &= capacity - 1;
+    }
+    table_.resize(capacity);
+    return true;
+#else
+    station_table_t previous(table_.get_allocator());
+    previous.swap(table_);
+
+    table_.resize(capacity);
+
+    size_t mask = capacity - 1;
+
+    for (const station_entry& e : previous)
+    {
+        if (e.key != 0)
+        {
+            size_t i = slot(callsign_key{ e.key });
+            while (table_[i].key != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            table_[i] = e;
+        }
+    }
+
+    return true;
+#endif
+}
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE station_grid::station_grid() : station_grid(1.0)
+{
+}
+
+APRS_TRACK_INLINE station_grid::station_grid(double cell_degrees)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Smaller cells mean fewer stations to test in small queries,
+    // and more cells to visit in large ones, 1 degree cells take 256 KB
+
+    cell_degrees_ = std::clamp(cell_degrees, 0.05, 90.0);
+    rows_ = static_cast<int>(std::ceil(180.0 / cell_degrees_));
+    cols_ = static_cast<int>(std::ceil(360.0 / cell_degrees_));
+
+    cells_.assign(static_cast<size_t>(rows_) * static_cast<size_t>(cols_), grid_npos);
+    index_.assign(16, grid_npos);
+}
+
+APRS_TRACK_INLINE void station_grid::update(callsign_key key, double lat, double lon)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Inserts the station, or moves it
+
+    constexpr double radians = 3.14159265358979323846 / 180.0;
+
+    if (!key.valid())
+    {
+        return;
+    }
+
+    lat = std::clamp(lat, -90.0, 90.0);
+    lon = std::clamp(lon, -180.0, 180.0);
+
+    double x = std::cos(lat * radians) * std::cos(lon * radians);
+    double y = std::cos(lat * radians) * std::sin(lon * radians);
+    double z = std::sin(lat * radians);
+    uint32_t c = cell(lat, lon);
+
+#if defined(__cpp_lib_shared_mutex)
+    std::unique_lock lock(mutex_);
+#endif
+    uint32_t n = find_node(key.value);
+
+    if (n == grid_npos)
+    {
+        if (free_ != grid_npos)
+        {
+            n = free_;
+            free_ = nodes_[n].next;
+            nodes_[n] = grid_node();
+        }
+        else
+        {
+            n = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+
+        nodes_[n].key = key.value;
+        index_insert(key.value, n);
+        size_++;
+    }
+
+    grid_node& node = nodes_[n];
+
+    node.x = x;
+    node.y = y;
+    node.z = z;
+    node.lat = pack_degrees(lat);
+    node.lon = pack_degrees(lon);
+
+    if (node.cell != c)
+    {
+        if (node.cell != grid_npos)
+        {
+            unlink(n);
+        }
+        link(n, c);
+    }
+}
+
+APRS_TRACK_INLINE bool station_grid::erase(callsign_key key)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+#if defined(__cpp_lib_shared_mutex)
+    std::unique_lock lock(mutex_);
+#endif
+    uint32_t n = find_node(key.value);
+
+    if (n == grid_npos)
+    {
+        return false;
+    }
+
+    unlink(n);
+    index_erase(key.value);
+
+    nodes_[n] = grid_node();
+    nodes_[n].next = free_;
+    free_ = n;
+    size_--;
+
+    return true;
+}
+
+APRS_TRACK_INLINE bool station_grid::contains(callsign_key key) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+#if defined(__cpp_lib_shared_mutex)
+    std::shared_lock lock(mutex_);
+#endif
+    return find_node(key.value) != grid_npos;
+}
+
+APRS_TRACK_INLINE void station_grid::clear()
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+#if defined(__cpp_lib_shared_mutex)
+    std::unique_lock lock(mutex_);
+#endif
+    std::fill(cells_.begin(), cells_.end(), grid_npos);
+    std::fill(index_.begin(), index_.end(), grid_npos);
+    nodes_.clear();
+    free_ = grid_npos;
+    size_ = 0;
+}
+
+APRS_TRACK_INLINE size_t station_grid::size() const
+{
+#if defined(__cpp_lib_shared_mutex)
+    std::shared_lock lock(mutex_);
+#endif
+    return size_;
+}
+
+APRS_TRACK_INLINE double station_grid::cell_degrees() const
+{
+    return cell_degrees_;
+}
+
+APRS_TRACK_INLINE uint32_t station_grid::cell(double lat, double lon) const
+{
+    int row = std::clamp(static_cast<int>(std::floor((lat + 90.0) / cell_degrees_)), 0, rows_ - 1);
+    int col = static_cast<int>(std::floor((lon + 180.0) / cell_degrees_)) % cols_;
+
+    return static_cast<uint32_t>(row * cols_ + col);
+}
+
+APRS_TRACK_INLINE uint32_t station_grid::find_node(uint64_t key) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (key == 0)
+    {
+        return grid_npos;
+    }
+
+    size_t mask = index_.size() - 1;
+
+    for (size_t i = static_cast<size_t>(mix64(key)) & mask; index_[i] != grid_npos; i = (i + 1) & mask)
+    {
+        if (nodes_[index_[i]].key == key)
+        {
+            return index_[i];
+        }
+    }
+
+    return grid_npos;
+}
+
+APRS_TRACK_INLINE void station_grid::link(uint32_t node, uint32_t cell)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    grid_node& n = nodes_[node];
+
+    n.cell = cell;
+    n.prev = grid_npos;
+    n.next = cells_[cell];
+
+    if (n.next != grid_npos)
+    {
+        nodes_[n.next].prev = node;
+    }
+
+    cells_[cell] = node;
+}
+
+APRS_TRACK_INLINE void station_grid::unlink(uint32_t node)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    grid_node& n = nodes_[node];
+
+    if (n.prev != grid_npos)
+    {
+        nodes_[n.prev].next = n.next;
+    }
+    else
+    {
+        cells_[n.cell] = n.next;
+    }
+
+    if (n.next != grid_npos)
+    {
+        nodes_[n.next].prev = n.prev;
+    }
+
+    n.cell = grid_npos;
+    n.prev = grid_npos;
+    n.next = grid_npos;
+}
+
+APRS_TRACK_INLINE void station_grid::index_insert(uint64_t key, uint32_t node)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // The index is kept at most 3/4 full, and rebuilt from the nodes when it grows
+
+    if ((size_ + 1) * 4 > index_.size() * 3)
+    {
+        index_.assign(index_.size() * 2, grid_npos);
+
+        size_t mask = index_.size() - 1;
+
+        for (uint32_t n = 0; n < nodes_.size(); n++)
+        {
+            if (nodes_[n].key != 0 && nodes_[n].key != key)
+            {
+                size_t i = static_cast<size_t>(mix64(nodes_[n].key)) & mask;
+                while (index_[i] != grid_npos)
+                {
+                    i = (i + 1) & mask;
+                }
+                index_[i] = n;
+            }
+        }
+    }
+
+    size_t mask = index_.size() - 1;
+    size_t i = static_cast<size_t>(mix64(key)) & mask;
+
+    while (index_[i] != grid_npos)
+    {
+        i = (i + 1) & mask;
+    }
+
+    index_[i] = node;
+}
+
+APRS_TRACK_INLINE void station_grid::index_erase(uint64_t key)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Backward shift deletion, as in station_table::erase
+
+    size_t mask = index_.size() - 1;
+    size_t i = static_cast<size_t>(mix64(key)) & mask;
+
+    while (nodes_[index_[i]].key != key)
+    {
+        i = (i + 1) & mask;
+    }
+
+    size_t hole = i;
+
+    for (size_t j = (hole + 1) & mask; index_[j] != grid_npos; j = (j + 1) & mask)
+    {
+        size_t home = static_cast<size_t>(mix64(nodes_[index_[j]].key)) & mask;
+
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            index_[hole] = index_[j];
+            hole = j;
+        }
+    }
+
+    index_[hole] = grid_npos;
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE uint32_t filter_engine::add_client()
+{
+    // Adds a client without a filter, returns its id, ids of removed clients are reused
+
+    uint32_t client;
+
+    if (!free_clients_.empty())
+    {
+        client = free_clients_.back();
+        free_clients_.pop_back();
+        active_[client] = true;
+    }
+    else
+    {
+        client = static_cast<uint32_t>(active_.size());
+        active_.push_back(true);
+        stamps_.push_back(0);
+    }
+
+    client_count_++;
+
+    return client;
+}
+
+APRS_TRACK_INLINE void filter_engine::remove_client(uint32_t client)
+{
+    if (client >= active_.size() || !active_[client])
+    {
+        return;
+    }
+
+    remove(include_, client);
+    remove(exclude_, client);
+
+    active_[client] = false;
+    free_clients_.push_back(client);
+    client_count_--;
+}
+
+APRS_TRACK_INLINE size_t filter_engine::client_count() const
+{
+    return client_count_;
+}
+
+APRS_TRACK_INLINE bool filter_engine::filter(uint32_t client, std::string_view filter)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Replaces the filter of a client, space separated terms like:
+    //
+    //   r/47.6/-122.3/50     within 50 km
+    //   a/48/-123/47/-122    in the area, north, west, south, east
+    //   p/N0/K1              source callsigns starting with N0 or K1
+    //   b/N0CALL-9/W1*       source callsigns, with a trailing wildcard
+    //   t/pmw                positions, messages and weather, of poimqstunw
+    //   -p/CW                excludes the packets matched
+    //
+    // Returns false if a term is not supported or not valid, the other terms apply
+
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double radians = pi / 180.0;
+    constexpr double earth_radius_meters = 6371008.8;
+
+    if (client >= active_.size() || !active_[client])
+    {
+        return false;
+    }
+
+    remove(include_, client);
+    remove(exclude_, client);
+
+    bool ok = true;
+
+    auto next_param = [](std::string_view& args) {
+        size_t end = args.find('/');
+        std::string_view param = args.substr(0, end);
+        args = end == std::string_view::npos ? std::string_view() : args.substr(end + 1);
+        return param;
+    };
+
+    auto number = [](std::string_view s, double& value) {
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        return ec == std::errc() && end == s.data() + s.size();
+    };
+
+    for (size_t start = 0; start < filter.size();)
+    {
+        size_t end = filter.find(' ', start);
+        if (end == std::string_view::npos)
+        {
+            end = filter.size();
+        }
+
+        std::string_view term = filter.substr(start, end - start);
+        start = end + 1;
+
+        if (term.empty())
+        {
+            continue;
+        }
+
+        bool exclude = term[0] == '-';
+        if (exclude)
+        {
+            term.remove_prefix(1);
+        }
+
+        filter_index& index = exclude ? exclude_ : include_;
+
+        if (term.size() < 3 || term[1] != '/')
+        {
+            ok = false;
+            continue;
+        }
+
+        std::string_view args = term.substr(2);
+
+        switch (term[0])
+        {
+            case 'p':
+                while (!args.empty())
+                {
+                    std::string_view prefix = next_param(args);
+                    if (prefix.empty())
+                    {
+                        ok = false;
+                        continue;
+                    }
+                    add_prefix(index, prefix, client);
+                }
+                break;
+            case 'b':
+                while (!args.empty())
+                {
+                    std::string_view callsign = next_param(args);
+                    if (callsign.empty())
+                    {
+                        ok = false;
+                    }
+                    else if (callsign.back() == '*')
+                    {
+                        add_prefix(index, callsign.substr(0, callsign.size() - 1), client);
+                    }
+                    else
+                    {
+                        add_callsign(index, callsign, client);
+                    }
+                }
+                break;
+            case 't':
+            {
+                constexpr std::string_view letters = "poimqstunw";
+                for (char c : next_param(args))
+                {
+                    size_t k = letters.find(c);
+                    if (k == std::string_view::npos)
+                    {
+                        ok = false;
+                        continue;
+                    }
+                    filter_client_terms& terms = filter_terms(index, client);
+                    if ((terms.kinds & (1u << k)) == 0)
+                    {
+                        terms.kinds |= 1u << k;
+                        index.kinds[k].push_back(client);
+                    }
+                }
+                if (!args.empty())
+                {
+                    ok = false; // t/types/call/distance is not supported
+                }
+                break;
+            }
+            case 'r':
+            {
+                double lat = 0.0;
+                double lon = 0.0;
+                double km = 0.0;
+                if (!number(next_param(args), lat) || !number(next_param(args), lon) || !number(next_param(args), km) || !args.empty() ||
+                    lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0 || km < 0.0)
+                {
+                    ok = false;
+                    break;
+                }
+
+                double angle = std::min(km * 1000.0 / earth_radius_meters, pi);
+                double chord = 2.0 * std::sin(angle / 2.0);
+
+                filter_region r;
+                r.client = client;
+                r.circle = true;
+                r.x = std::cos(lat * radians) * std::cos(lon * radians);
+                r.y = std::cos(lat * radians) * std::sin(lon * radians);
+                r.z = std::sin(lat * radians);
+                r.threshold = chord * chord;
+
+                double dlat = angle / radians;
+                double dlon = 180.0;
+                double sin_dlon = std::sin(angle) / std::cos(lat * radians);
+
+                if (lat + dlat < 90.0 && lat - dlat > -90.0 && angle < pi / 2 && sin_dlon < 1.0)
+                {
+                    dlon = std::asin(sin_dlon) / radians;
+                }
+
+                region_cells(r, lat + dlat, lon - dlon, lat - dlat, lon + dlon);
+                add_region(index, r);
+                break;
+            }
+            case 'a':
+            {
+                double north = 0.0;
+                double west = 0.0;
+                double south = 0.0;
+                double east = 0.0;
+                if (!number(next_param(args), north) || !number(next_param(args), west) || !number(next_param(args), south) || !number(next_param(args), east) ||
+                    !args.empty() || south > north || north > 90.0 || south < -90.0 || west < -180.0 || west > 180.0 || east < -180.0 || east > 180.0)
+                {
+                    ok = false;
+                    break;
+                }
+
+                filter_region r;
+                r.client = client;
+                r.north = pack_degrees(north);
+                r.west = pack_degrees(west);
+                r.south = pack_degrees(south);
+                r.east = pack_degrees(east);
+
+                region_cells(r, north, west, south, east);
+                add_region(index, r);
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+    }
+
+    return ok;
+}
+
+APRS_TRACK_INLINE void filter_engine::add_prefix(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, std::string_view prefix, uint32_t client)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    uint32_t node = 0;
+
+    for (char c : prefix)
+    {
+        size_t child = filter_trie_child(c);
+        if (index.trie[node].children[child] == 0)
+        {
+            uint32_t next;
+            if (!index.free_nodes.empty())
+            {
+                next = index.free_nodes.back();
+                index.free_nodes.pop_back();
+            }
+            else
+            {
+                next = static_cast<uint32_t>(index.trie.size());
+                index.trie.emplace_back();
+            }
+            index.trie[next].parent = node;
+            index.trie[next].child = static_cast<uint8_t>(child);
+            index.trie[node].children[child] = next;
+            index.trie[node].child_count++;
+        }
+        node = index.trie[node].children[child];
+    }
+
+    filter_client_terms& terms = filter_terms(index, client);
+
+    if (std::find(terms.nodes.begin(), terms.nodes.end(), node) == terms.nodes.end())
+    {
+        terms.nodes.push_back(node);
+        index.trie[node].clients.push_back(client);
+    }
+}
+
+APRS_TRACK_INLINE void filter_engine::add_callsign(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, std::string_view callsign, uint32_t client)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    uint64_t hash = filter_callsign_hash(callsign);
+    filter_client_terms& terms = filter_terms(index, client);
+
+    if (std::find(terms.callsigns.begin(), terms.callsigns.end(), hash) == terms.callsigns.end())
+    {
+        terms.callsigns.push_back(hash);
+        index.callsigns[hash].push_back(client);
+    }
+}
+
+APRS_TRACK_INLINE void filter_engine::add_region(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_region& r)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    uint32_t id;
+
+    if (!index.free_regions.empty())
+    {
+        id = index.free_regions.back();
+        index.free_regions.pop_back();
+        index.regions[id] = r;
+    }
+    else
+    {
+        id = static_cast<uint32_t>(index.regions.size());
+        index.regions.push_back(r);
+    }
+
+    filter_terms(index, r.client).regions.push_back(id);
+
+    if (index.cells.empty())
+    {
+        index.cells.resize(180 * 360);
+    }
+
+    for (int row = r.row_begin; row <= r.row_end; row++)
+    {
+        for (int col = r.col_begin; col <= r.col_end; col++)
+        {
+            index.cells[static_cast<size_t>(row * 360 + ((col % 360) + 360) % 360)].push_back(id);
+        }
+    }
+}
+
+APRS_TRACK_INLINE void filter_engine::remove(APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, uint32_t client)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Removes the client from the index, visiting only the terms it added,
+    // the trie nodes left without clients and children are freed
+
+    if (client >= index.clients.size())
+    {
+        return;
+    }
+
+    filter_client_terms& terms = index.clients[client];
+
+    for (uint32_t node : terms.nodes)
+    {
+        std::erase(index.trie[node].clients, client);
+    }
+
+    for (uint32_t node : terms.nodes)
+    {
+        prune_filter_trie(index, node);
+    }
+
+    for (uint64_t hash : terms.callsigns)
+    {
+        auto it = index.callsigns.find(hash);
+        if (it != index.callsigns.end())
+        {
+            std::erase(it->second, client);
+            if (it->second.empty())
+            {
+                index.callsigns.erase(it);
+            }
+        }
+    }
+
+    for (size_t k = 0; k < packet_kind_count; k++)
+    {
+        if ((terms.kinds & (1u << k)) != 0)
+        {
+            std::erase(index.kinds[k], client);
+        }
+    }
+
+    for (uint32_t id : terms.regions)
+    {
+        filter_region& r = index.regions[id];
+
+        for (int row = r.row_begin; row <= r.row_end; row++)
+        {
+            for (int col = r.col_begin; col <= r.col_end; col++)
+            {
+                std::erase(index.cells[static_cast<size_t>(row * 360 + ((col % 360) + 360) % 360)], id);
+            }
+        }
+
+        r = filter_region();
+        index.free_regions.push_back(id);
+    }
+
+    terms.nodes.clear();
+    terms.callsigns.clear();
+    terms.regions.clear();
+    terms.kinds = 0;
+}
+
+APRS_TRACK_INLINE size_t filter_engine::trie_size() const
+{
+    // The trie nodes allocated by the include and exclude indexes, freed nodes included
+
+    return include_.trie.size() + exclude_.trie.size();
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
+
+APRS_TRACK_INLINE feed_decoder::feed_decoder(size_t workers, size_t queue_capacity)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    workers = (std::max)(workers, size_t(1));
+
+    for (size_t i = 0; i < workers; i++)
+    {
+        workers_.push_back(std::make_unique<feed_worker>(queue_capacity));
+    }
+
+    for (std::unique_ptr<feed_worker>& w : workers_)
+    {
+        w->thread = std::thread([&worker = *w]() { run_feed_worker(worker); });
+    }
+}
+
+APRS_TRACK_INLINE feed_decoder::~feed_decoder()
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Records which were not polled are dropped
+
+    for (std::unique_ptr<feed_worker>& w : workers_)
+    {
+        w->stop.store(true, std::memory_order_release);
+    }
+
+    for (std::unique_ptr<feed_worker>& w : workers_)
+    {
+        w->thread.join();
+    }
+}
+
+APRS_TRACK_INLINE bool feed_decoder::try_push(std::string_view line)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Queues the line to the worker of its source callsign, returns false
+    // if the queue of the worker is full
+    //
+    // Callsigns are sharded by their key, so N0CALL and N0CALL-0 go to the
+    // same worker, callsigns without a key by their bytes
+
+    size_t from_end = line.find('>');
+    std::string_view from = line.substr(0, from_end == std::string_view::npos ? 0 : from_end);
+
+    callsign_key key = make_callsign_key(from);
+    uint64_t hash = key.valid() ? mix64(key.value) : hash_bytes(reinterpret_cast<const unsigned char*>(from.data()), from.size(), 0);
+
+    feed_worker& w = *workers_[hash % workers_.size()];
+
+    feed_line* slot = w.input.reserve();
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    slot->text.assign(line);
+    slot->sequence = pushed_++;
+    slot->pushed = std::chrono::steady_clock::now();
+
+    w.input.commit();
+
+    w.max_queue_depth = (std::max)(w.max_queue_depth, w.input.size());
+
+    return true;
+}
+
+APRS_TRACK_INLINE size_t feed_decoder::workers() const
+{
+    return workers_.size();
+}
+
+APRS_TRACK_INLINE std::vector<feed_stage_stats> feed_decoder::stats() const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Called from the thread which pushes and polls
+
+    std::vector<feed_stage_stats> stats;
+
+    for (const std::unique_ptr<feed_worker>& w : workers_)
+    {
+        feed_stage_stats s;
+        s.lines = w->lines.load(std::memory_order_relaxed);
+        s.queue_depth = w->input.size();
+        s.max_queue_depth = w->max_queue_depth;
+        s.output_depth = w->output.size();
+        s.max_output_depth = w->max_output_depth.load(std::memory_order_relaxed);
+        if (s.lines > 0)
+        {
+            s.decode_latency_ns = static_cast<double>(w->decode_latency_ns.load(std::memory_order_relaxed)) / static_cast<double>(s.lines);
+        }
+        s.max_decode_latency_ns = static_cast<double>(w->max_decode_latency_ns.load(std::memory_order_relaxed));
+        if (w->polled > 0)
+        {
+            s.poll_latency_ns = static_cast<double>(w->poll_latency_ns) / static_cast<double>(w->polled);
+        }
+        stats.push_back(s);
+    }
+
+    return stats;
+}
+
+#endif
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE track_log_writer::track_log_writer() : track_log_writer(1024)
+{
+}
+
+APRS_TRACK_INLINE track_log_writer::track_log_writer(size_t block_size) : block_size_(std::max<size_t>(block_size, 1))
+{
+    // magic, version and 3 reserved bytes
+    bytes_ = { 'A', 'P', 'T', 'L', 1, 0, 0, 0 };
+}
+
+APRS_TRACK_INLINE void track_log_writer::append(int64_t time, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d)
+{
+    track_log_entry entry;
+    entry.time = time;
+    entry.fix = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE pack_data(d);
+    append(entry);
+}
+
+APRS_TRACK_INLINE void track_log_writer::append(const track_log_entry& entry)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (index_.empty() || index_.back().count == block_size_)
+    {
+        track_log_block block;
+        block.first_time = entry.time;
+        block.offset = bytes_.size();
+        index_.push_back(block);
+        state_ = track_log_state{};
+    }
+
+    encode_track_log_fix(bytes_, state_, entry.time, entry.fix);
+
+    track_log_block& block = index_.back();
+    block.last_time = entry.time;
+    block.count++;
+    size_++;
+}
+
+APRS_TRACK_INLINE size_t track_log_writer::size() const
+{
+    return size_;
+}
+
+APRS_TRACK_INLINE std::vector<unsigned char> track_log_writer::finish() const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // The writer can keep appending, finish() can be called again later
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(bytes_.size() + index_.size() * track_log_block_size + track_log_footer_size);
+    bytes.assign(bytes_.begin(), bytes_.end());
+
+    for (const track_log_block& block : index_)
+    {
+        write_track_log_block(bytes, block);
+    }
+
+    write_le(bytes, bytes_.size(), 8); // index offset
+    write_le(bytes, size_, 8);
+    write_le(bytes, index_.size(), 4);
+    bytes.insert(bytes.end(), { 'A', 'P', 'T', 'L' });
+
+    return bytes;
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE track_log_reader::track_log_reader(std::span<const unsigned char> bytes)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (bytes.size() < track_log_header_size + track_log_footer_size)
+    {
+        return;
+    }
+
+    const unsigned char* header = bytes.data();
+    const unsigned char* footer = bytes.data() + bytes.size() - track_log_footer_size;
+
+    if (std::memcmp(header, "APTL", 4) != 0 || header[4] != 1 || std::memcmp(footer + 20, "APTL", 4) != 0)
+    {
+        return;
+    }
+
+    uint64_t index_offset = read_le(footer, 8);
+    uint64_t size = read_le(footer + 8, 8);
+    uint64_t block_count = read_le(footer + 16, 4);
+
+    // The index sits between the blocks and the footer, checked without
+    // overflow as the footer values are not trusted
+
+    size_t end = bytes.size() - track_log_footer_size;
+
+    if (index_offset < track_log_header_size || index_offset > end || block_count != (end - index_offset) / track_log_block_size || (end - index_offset) % track_log_block_size != 0)
+    {
+        return;
+    }
+
+    bytes_ = bytes;
+    size_ = static_cast<size_t>(size);
+    block_count_ = static_cast<size_t>(block_count);
+    index_offset_ = static_cast<size_t>(index_offset);
+}
+
+APRS_TRACK_INLINE bool track_log_reader::valid() const
+{
+    return !bytes_.empty();
+}
+
+APRS_TRACK_INLINE size_t track_log_reader::size() const
+{
+    return size_;
+}
+
+APRS_TRACK_INLINE size_t track_log_reader::block_count() const
+{
+    return block_count_;
+}
+
+APRS_TRACK_INLINE APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_block track_log_reader::block(size_t index) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    return read_track_log_block(bytes_.data() + index_offset_ + index * track_log_block_size);
+}
+
+APRS_TRACK_INLINE std::span<const unsigned char> track_log_reader::block_bytes(size_t index) const
+{
+    // A block spans from its offset to the offset of the next block, or to the index
+
+    uint64_t begin = block(index).offset;
+    uint64_t end = (index + 1 < block_count_) ? block(index + 1).offset : index_offset_;
+
+    if (begin > end || end > index_offset_)
+    {
+        return {};
+    }
+
+    return bytes_.subspan(static_cast<size_t>(begin), static_cast<size_t>(end - begin));
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator track_log_reader::begin() const
+{
+    iterator it;
+    it.reader_ = this;
+    it.load_block(0);
+    return it;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator track_log_reader::end() const
+{
+    iterator it;
+    it.reader_ = this;
+    it.block_ = block_count_;
+    return it;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator track_log_reader::seek(int64_t time) const
+{
+    // The first fix at or after the time, the times are expected to not decrease
+    //
+    // The index is searched for the first block ending at or after the time,
+    // then that block is decoded up to the fix
+
+    size_t low = 0;
+    size_t high = block_count_;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (block(middle).last_time < time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    iterator it;
+    it.reader_ = this;
+    it.load_block(low);
+
+    iterator last = end();
+
+    while (it != last && it->time < time)
+    {
+        ++it;
+    }
+
+    return it;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator::reference track_log_reader::iterator::operator*() const
+{
+    return entry_;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator::pointer track_log_reader::iterator::operator->() const
+{
+    return &entry_;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator& track_log_reader::iterator::operator++()
+{
+    remaining_--;
+
+    if (remaining_ > 0)
+    {
+        decode();
+    }
+    else
+    {
+        load_block(block_ + 1);
+    }
+
+    return *this;
+}
+
+APRS_TRACK_INLINE track_log_reader::iterator track_log_reader::iterator::operator++(int)
+{
+    iterator previous = *this;
+    ++(*this);
+    return previous;
+}
+
+APRS_TRACK_INLINE bool track_log_reader::iterator::operator==(const iterator& other) const
+{
+    return block_ == other.block_ && remaining_ == other.remaining_;
+}
+
+APRS_TRACK_INLINE void track_log_reader::iterator::load_block(size_t block)
+{
+    block_ = block;
+    remaining_ = 0;
+
+    if (block_ >= reader_->block_count_)
+    {
+        block_ = reader_->block_count_;
+        return;
+    }
+
+    std::span<const unsigned char> bytes = reader_->block_bytes(block_);
+
+    p_ = bytes.data();
+    end_ = bytes.data() + bytes.size();
+    remaining_ = reader_->block(block_).count;
+    state_ = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE track_log_state{};
+
+    if (remaining_ == 0)
+    {
+        load_block(block_ + 1);
+        return;
+    }
+
+    decode();
+}
+
+APRS_TRACK_INLINE void track_log_reader::iterator::decode()
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (!decode_track_log_fix(p_, end_, state_))
+    {
+        // a corrupt block ends the iteration
+        block_ = reader_->block_count_;
+        remaining_ = 0;
+        return;
+    }
+
+    make_track_log_entry(state_, entry_);
+}
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_INLINE position_store::position_store()
+{
+}
+
+APRS_TRACK_INLINE position_store::position_store(size_t chunk_size) : chunk_size_((std::max)(chunk_size, size_t(1)))
+{
+}
+
+APRS_TRACK_INLINE bool position_store::append(callsign_key station, int64_t time, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE data& d)
+{
+    track_log_entry entry;
+    entry.time = time;
+    entry.fix = APRS_TRACK_DETAIL_NAMESPACE_REFERENCE pack_data(d);
+    return append(station, entry);
+}
+
+APRS_TRACK_INLINE bool position_store::append(callsign_key station, const track_log_entry& entry)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Returns false if the key is not valid, or if the fix is older than
+    // the last fix of the station
+
+    if (!station.valid())
+    {
+        return false;
+    }
+
+    auto [it, inserted] = index_.try_emplace(station.value, static_cast<uint32_t>(series_.size()));
+
+    if (inserted)
+    {
+        series_.emplace_back();
+        series_.back().key = station.value;
+    }
+
+    position_series& series = series_[it->second];
+
+    if (!series.chunks.empty() && entry.time < series.chunks.back().last_time)
+    {
+        return false;
+    }
+
+    if (series.chunks.empty() || series.chunks.back().count == chunk_size_)
+    {
+        if (!series.chunks.empty())
+        {
+            for (bit_column& c : series.chunks.back().columns)
+            {
+                c.words.shrink_to_fit();
+            }
+        }
+        series.chunks.emplace_back();
+    }
+
+    append_position_chunk(series, entry.time, entry.fix);
+    size_++;
+
+    return true;
+}
+
+APRS_TRACK_INLINE size_t position_store::size() const
+{
+    return size_;
+}
+
+APRS_TRACK_INLINE size_t position_store::station_count() const
+{
+    return series_.size();
+}
+
+APRS_TRACK_INLINE size_t position_store::memory_bytes() const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // The columns, the chunks and the series, without the index
+
+    size_t bytes = series_.capacity() * sizeof(position_series);
+
+    for (const position_series& series : series_)
+    {
+        bytes += series.chunks.capacity() * sizeof(position_chunk);
+        for (const position_chunk& chunk : series.chunks)
+        {
+            for (const bit_column& c : chunk.columns)
+            {
+                bytes += c.words.capacity() * sizeof(uint64_t);
+            }
+        }
+    }
+
+    return bytes;
+}
+
+APRS_TRACK_INLINE void position_store::clear()
+{
+    series_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#ifdef APRS_TRACK_HAS_MMAP
+
+APRS_TRACK_INLINE mapped_file::mapped_file(const char* path)
+{
+    open(path);
+}
+
+APRS_TRACK_INLINE mapped_file::~mapped_file()
+{
+    close();
+}
+
+APRS_TRACK_INLINE mapped_file::mapped_file(mapped_file&& other) noexcept : data_(other.data_), size_(other.size_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+APRS_TRACK_INLINE mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+APRS_TRACK_INLINE bool mapped_file::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping is kept after the descriptor is closed
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    data_ = data;
+    size_ = static_cast<size_t>(st.st_size);
+
+    return true;
+}
+
+APRS_TRACK_INLINE void mapped_file::close()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+APRS_TRACK_INLINE bool mapped_file::is_open() const
+{
+    return data_ != nullptr;
+}
+
+APRS_TRACK_INLINE std::span<const unsigned char> mapped_file::bytes() const
+{
+    return std::span<const unsigned char>(static_cast<const unsigned char*>(data_), size_);
+}
+
+#endif // APRS_TRACK_HAS_MMAP
+
+APRS_TRACK_INLINE bool geojson_reader::finish()
+{
+    // Returns true if a complete and well formed document was read
+
+    if (!in_string_)
+    {
+        end_token();
+    }
+
+    return !error_ && started_ && depth_ == 0 && !in_string_;
+}
+
+APRS_TRACK_INLINE void geojson_reader::reset()
+{
+    *this = geojson_reader();
+}
+
+APRS_TRACK_INLINE bool geojson_reader::valid() const
+{
+    return !error_;
+}
+
+APRS_TRACK_INLINE size_t geojson_reader::size() const
+{
+    return size_;
+}
+
+APRS_TRACK_INLINE void geojson_reader::end_token()
+{
+    // Numbers are only parsed inside of a position, other numbers and the
+    // true, false and null literals are skipped
+
+    if (token_size_ == 0 && !token_overflow_)
+    {
+        return;
+    }
+
+    if (coordinates_depth_ != 0 && depth_ == coordinates_depth_ + 1 && value_count_ < 3)
+    {
+        double value = 0.0;
+        auto [end, ec] = std::from_chars(token_, token_ + token_size_, value);
+        if (token_overflow_ || ec != std::errc() || end != token_ + token_size_)
+        {
+            error_ = true;
+        }
+        values_[value_count_++] = value;
+    }
+
+    token_size_ = 0;
+    token_overflow_ = false;
+}
+
+APRS_TRACK_INLINE size_t geojson_reader::scan(std::string_view chunk)
+{
+    // Consumes the chunk up to and including the end of the next position
+    // Returns the number of characters consumed, ready_ is set if a position ended
+
+    static constexpr std::string_view coordinates = "coordinates";
+
+    for (size_t i = 0; i < chunk.size(); i++)
+    {
+        char c = chunk[i];
+
+        if (in_string_)
+        {
+            if (escape_)
+            {
+                escape_ = false;
+                key_size_ = 0xFF; // keys with escapes are not matched
+            }
+            else if (c == '\\')
+            {
+                escape_ = true;
+            }
+            else if (c == '"')
+            {
+                in_string_ = false;
+                key_coordinates_ = in_key_ && key_size_ == coordinates.size();
+            }
+            else if (in_key_ && key_size_ != 0xFF)
+            {
+                key_size_ = (key_size_ < coordinates.size() && c == coordinates[key_size_]) ? static_cast<uint8_t>(key_size_ + 1) : 0xFF;
+            }
+            continue;
+        }
+
+        switch (c)
+        {
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                end_token();
+                break;
+            case '{':
+            case '[':
+                if (depth_ == 64)
+                {
+                    error_ = true;
+                    return i + 1;
+                }
+                started_ = true;
+                if (c == '{')
+                {
+                    objects_ |= uint64_t(1) << depth_;
+                    expect_key_ = true;
+                }
+                else
+                {
+                    objects_ &= ~(uint64_t(1) << depth_);
+                }
+                depth_++;
+                if (c == '[' && pending_coordinates_)
+                {
+                    coordinates_depth_ = depth_;
+                }
+                else if (c == '[' && coordinates_depth_ != 0 && depth_ == coordinates_depth_ + 1)
+                {
+                    value_count_ = 0;
+                }
+                pending_coordinates_ = false;
+                break;
+            case '}':
+            case ']':
+            {
+                end_token();
+                bool object = depth_ > 0 && ((objects_ >> (depth_ - 1)) & 1) != 0;
+                if (depth_ == 0 || object != (c == '}'))
+                {
+                    error_ = true;
+                    return i + 1;
+                }
+                if (c == ']' && coordinates_depth_ != 0 && depth_ == coordinates_depth_ + 1 && value_count_ >= 2)
+                {
+                    position_.lon = values_[0];
+                    position_.lat = values_[1];
+                    position_.alt_meters = value_count_ > 2 ? std::optional<double>(values_[2]) : std::nullopt;
+                    ready_ = true;
+                    size_++;
+                }
+                depth_--;
+                if (depth_ < coordinates_depth_)
+                {
+                    coordinates_depth_ = 0;
+                }
+                expect_key_ = false;
+                pending_coordinates_ = false;
+                if (ready_)
+                {
+                    return i + 1;
+                }
+                break;
+            }
+            case ':':
+                end_token();
+                expect_key_ = false;
+                pending_coordinates_ = key_coordinates_;
+                break;
+            case ',':
+                end_token();
+                expect_key_ = depth_ > 0 && ((objects_ >> (depth_ - 1)) & 1) != 0;
+                pending_coordinates_ = false;
+                break;
+            case '"':
+                in_string_ = true;
+                in_key_ = expect_key_;
+                key_size_ = 0;
+                pending_coordinates_ = false;
+                break;
+            default:
+                if (token_size_ < sizeof(token_))
+                {
+                    token_[token_size_++] = c;
+                }
+                else
+                {
+                    token_overflow_ = true;
+                }
+                pending_coordinates_ = false;
+                break;
+        }
+
+        if (error_)
+        {
+            return i + 1;
+        }
+    }
+
+    return chunk.size();
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+template <class F>
+APRS_TRACK_INLINE_NO_DISABLE void track_log_reader::for_each(F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Same as iterating, without the iterator state, the fastest way to scan a log
+
+    for (size_t b = 0; b < block_count_; b++)
+    {
+        std::span<const unsigned char> bytes = block_bytes(b);
+
+        const unsigned char* p = bytes.data();
+        const unsigned char* end = bytes.data() + bytes.size();
+
+        track_log_state state;
+        track_log_entry entry;
+
+        for (uint32_t i = block(b).count; i > 0; i--)
+        {
+            if (!decode_track_log_fix(p, end, state))
+            {
+                return;
+            }
+
+            make_track_log_entry(state, entry);
+
+            f(entry);
+        }
+    }
+}
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t position_store::query_time(int64_t begin, int64_t end, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, const track_log_entry&) for the fixes from begin
+    // to end, inclusive, returns the number of fixes
+
+    position_query q;
+    q.begin = begin;
+    q.end = end;
+
+    size_t count = 0;
+
+    for (const position_series& series : series_)
+    {
+        count += scan(series, q, f);
+    }
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t position_store::query_box(int64_t begin, int64_t end, double north, double west, double south, double east, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, const track_log_entry&) for the fixes from begin
+    // to end in the area, the area wraps around the antimeridian if west is
+    // greater than east, returns the number of fixes
+
+    position_query q;
+    q.begin = begin;
+    q.end = end;
+    q.box = true;
+    q.north = pack_degrees(north);
+    q.west = pack_degrees(west);
+    q.south = pack_degrees(south);
+    q.east = pack_degrees(east);
+
+    size_t count = 0;
+
+    for (const position_series& series : series_)
+    {
+        count += scan(series, q, f);
+    }
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t position_store::history(callsign_key station, int64_t begin, int64_t end, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, const track_log_entry&) for the fixes of one
+    // station from begin to end, in time order
+
+    auto it = index_.find(station.value);
+
+    if (it == index_.end())
+    {
+        return 0;
+    }
+
+    position_query q;
+    q.begin = begin;
+    q.end = end;
+
+    return scan(series_[it->second], q, f);
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t position_store::scan(const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE position_series& series, APRS_TRACK_DETAIL_NAMESPACE_REFERENCE position_query& q, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    if (q.values.empty())
+    {
+        q.values.resize(chunk_size_ * position_column_count);
+        q.matches.resize(chunk_size_);
+    }
+
+    auto column = [&](size_t c) { return q.values.data() + c * chunk_size_; };
+
+    size_t count = 0;
+
+    for (const position_chunk& chunk : series.chunks)
+    {
+        if (!position_chunk_overlaps(chunk, q))
+        {
+            continue;
+        }
+
+        const int64_t* time = column(position_column_time);
+        const int64_t* lat = column(position_column_lat);
+        const int64_t* lon = column(position_column_lon);
+        uint8_t* matches = q.matches.data();
+
+        size_t n = chunk.count;
+        size_t found = 0;
+
+        decode_position_column(chunk, position_column_time, n, column(position_column_time));
+
+        // the times are in order, the fixes after the range are not decoded
+        n = static_cast<size_t>(std::upper_bound(time, time + n, q.end) - time);
+
+        if (q.box)
+        {
+            decode_position_column(chunk, position_column_lat, n, column(position_column_lat));
+            decode_position_column(chunk, position_column_lon, n, column(position_column_lon));
+
+            const int64_t north = q.north;
+            const int64_t south = q.south;
+            const int64_t west = q.west;
+            const int64_t east = q.east;
+            const bool wraps = west > east;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                uint8_t in_time = (time[i] >= q.begin) & (time[i] <= q.end);
+                uint8_t in_lat = (lat[i] >= south) & (lat[i] <= north);
+                uint8_t in_lon = wraps ? ((lon[i] >= west) | (lon[i] <= east)) : ((lon[i] >= west) & (lon[i] <= east));
+                matches[i] = in_time & in_lat & in_lon;
+                found += matches[i];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                matches[i] = (time[i] >= q.begin) & (time[i] <= q.end);
+                found += matches[i];
+            }
+        }
+
+        if (found == 0)
+        {
+            continue;
+        }
+
+        for (size_t c = q.box ? position_column_alt : position_column_lat; c < position_column_count; c++)
+        {
+            decode_position_column(chunk, c, n, column(c));
+        }
+
+        track_log_state state;
+        track_log_entry entry;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!matches[i])
+            {
+                continue;
+            }
+            state.time = time[i];
+            state.lat = static_cast<int32_t>(lat[i]);
+            state.lon = static_cast<int32_t>(lon[i]);
+            state.alt = static_cast<int32_t>(column(position_column_alt)[i]);
+            state.speed = static_cast<uint32_t>(column(position_column_speed)[i]);
+            state.track = static_cast<uint16_t>(column(position_column_track)[i]);
+            state.flags = static_cast<uint8_t>(column(position_column_flags)[i]);
+            make_track_log_entry(state, entry);
+            f(callsign_key{ series.key }, static_cast<const track_log_entry&>(entry));
+        }
+
+        count += found;
+    }
+
+    return count;
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE void station_table::for_each(F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, data) for each station, in table order
+
+    for (const station_entry& e : table_)
+    {
+        if (e.key != 0)
+        {
+            f(callsign_key{ e.key }, unpack_data(e.fix));
+        }
+    }
+}
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t station_grid::query_radius(double lat, double lon, double radius_meters, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, lat, lon) for the stations within the great
+    // circle distance, returns the number of stations
+    //
+    // The distance test compares the chord between the unit vectors of the
+    // positions, without trigonometry, on batches of stations copied out of
+    // the cell lists, a loop the compiler can vectorize
+
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double radians = pi / 180.0;
+    constexpr double earth_radius_meters = 6371008.8;
+    constexpr size_t batch_size = 64;
+
+    if (!(radius_meters >= 0.0))
+    {
+        return 0;
+    }
+
+    double angle = std::min(radius_meters / earth_radius_meters, pi);
+    double chord = 2.0 * std::sin(angle / 2.0);
+    double threshold = chord * chord;
+
+    double qx = std::cos(lat * radians) * std::cos(lon * radians);
+    double qy = std::cos(lat * radians) * std::sin(lon * radians);
+    double qz = std::sin(lat * radians);
+
+    // the cells of the bounding box of the circle
+
+    double dlat = angle / radians;
+    int row_begin = static_cast<int>(std::floor((lat - dlat + 90.0) / cell_degrees_));
+    int row_end = static_cast<int>(std::floor((lat + dlat + 90.0) / cell_degrees_));
+    int col_begin = 0;
+    int col_end = cols_ - 1;
+
+    double sin_dlon = std::sin(angle) / std::cos(lat * radians);
+
+    if (lat + dlat < 90.0 && lat - dlat > -90.0 && angle < pi / 2 && sin_dlon < 1.0)
+    {
+        double dlon = std::asin(sin_dlon) / radians;
+        col_begin = static_cast<int>(std::floor((lon - dlon + 180.0) / cell_degrees_));
+        col_end = static_cast<int>(std::floor((lon + dlon + 180.0) / cell_degrees_));
+    }
+
+#if defined(__cpp_lib_shared_mutex)
+    std::shared_lock lock(mutex_);
+#endif
+    uint32_t ids[batch_size];
+    double bx[batch_size];
+    double by[batch_size];
+    double bz[batch_size];
+    bool hits[batch_size];
+    size_t n = 0;
+    size_t count = 0;
+
+    auto flush = [&]() {
+        for (size_t i = 0; i < n; i++)
+        {
+            double dx = bx[i] - qx;
+            double dy = by[i] - qy;
+            double dz = bz[i] - qz;
+            hits[i] = dx * dx + dy * dy + dz * dz <= threshold;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            if (hits[i])
+            {
+                const grid_node& node = nodes_[ids[i]];
+                f(callsign_key{ node.key }, node.lat / 1e7, node.lon / 1e7);
+                count++;
+            }
+        }
+        n = 0;
+    };
+
+    visit_cells(row_begin, row_end, col_begin, col_end, [&](uint32_t head) {
+        for (uint32_t i = head; i != grid_npos; i = nodes_[i].next)
+        {
+            const grid_node& node = nodes_[i];
+            ids[n] = i;
+            bx[n] = node.x;
+            by[n] = node.y;
+            bz[n] = node.z;
+            if (++n == batch_size)
+            {
+                flush();
+            }
+        }
+    });
+
+    flush();
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t station_grid::query_box(double north, double west, double south, double east, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(callsign_key, lat, lon) for the stations in the box, the box
+    // crosses the antimeridian if west is greater than east, returns the number of stations
+
+    if (south > north)
+    {
+        return 0;
+    }
+
+    bool wraps = west > east;
+
+    int32_t n = pack_degrees(north);
+    int32_t s = pack_degrees(south);
+    int32_t w = pack_degrees(west);
+    int32_t e = pack_degrees(east);
+
+    int row_begin = static_cast<int>(std::floor((south + 90.0) / cell_degrees_));
+    int row_end = static_cast<int>(std::floor((north + 90.0) / cell_degrees_));
+    int col_begin = static_cast<int>(std::floor((west + 180.0) / cell_degrees_));
+    int col_end = static_cast<int>(std::floor((east + 180.0) / cell_degrees_)) + (wraps ? cols_ : 0);
+
+#if defined(__cpp_lib_shared_mutex)
+    std::shared_lock lock(mutex_);
+#endif
+    size_t count = 0;
+
+    visit_cells(row_begin, row_end, col_begin, col_end, [&](uint32_t head) {
+        for (uint32_t i = head; i != grid_npos; i = nodes_[i].next)
+        {
+            const grid_node& node = nodes_[i];
+            bool inside = node.lat >= s && node.lat <= n &&
+                (wraps ? (node.lon >= w || node.lon <= e) : (node.lon >= w && node.lon <= e));
+            if (inside)
+            {
+                f(callsign_key{ node.key }, node.lat / 1e7, node.lon / 1e7);
+                count++;
+            }
+        }
+    });
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE void station_grid::visit_cells(int row_begin, int row_end, int col_begin, int col_end, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f with the first node of the non empty cells in the range,
+    // columns wrap around, each cell is visited once
+
+    row_begin = std::max(row_begin, 0);
+    row_end = std::min(row_end, rows_ - 1);
+    col_end = std::min(col_end, col_begin + cols_ - 1);
+
+    for (int row = row_begin; row <= row_end; row++)
+    {
+        const uint32_t* cells = &cells_[static_cast<size_t>(row) * static_cast<size_t>(cols_)];
+
+        for (int c = col_begin; c <= col_end; c++)
+        {
+            uint32_t head = cells[((c % cols_) + cols_) % cols_];
+            if (head != grid_npos)
+            {
+                f(head);
+            }
+        }
+    }
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t filter_engine::match(std::string_view packet, F&& f)
+{
+    // Decodes the packet, and calls f(client) for each client whose filter matches
+
+    decoded_packet p;
+
+    if (!decode_packet(packet, p))
+    {
+        return 0;
+    }
+
+    return match(p, std::forward<F>(f));
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t filter_engine::match(const decoded_packet& p, F&& f)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(client) once for each client whose filter matches the packet,
+    // and which does not exclude it, returns the number of clients
+    //
+    // Each client is stamped with the generation of the packet, the excluded
+    // clients first, so the clients matched by several terms are not
+    // deduplicated with a set
+
+    constexpr double radians = 3.14159265358979323846 / 180.0;
+
+    if (++generation_ == 0)
+    {
+        std::fill(stamps_.begin(), stamps_.end(), 0);
+        generation_ = 1;
+    }
+
+    filter_position position;
+
+    if (p.has_position && (!include_.cells.empty() || !exclude_.cells.empty()))
+    {
+        double lat = std::clamp(p.fix.lat, -90.0, 90.0);
+        double lon = std::clamp(p.fix.lon, -180.0, 180.0);
+
+        position.valid = true;
+        position.x = std::cos(lat * radians) * std::cos(lon * radians);
+        position.y = std::cos(lat * radians) * std::sin(lon * radians);
+        position.z = std::sin(lat * radians);
+        position.lat = pack_degrees(lat);
+        position.lon = pack_degrees(lon);
+
+        int row = std::clamp(static_cast<int>(std::floor(lat + 90.0)), 0, 179);
+        int col = static_cast<int>(std::floor(lon + 180.0)) % 360;
+        position.cell = static_cast<size_t>(row * 360 + col);
+    }
+
+    collect(exclude_, p, position, [&](uint32_t client) {
+        stamps_[client] = generation_;
+    });
+
+    size_t count = 0;
+
+    collect(include_, p, position, [&](uint32_t client) {
+        if (stamps_[client] != generation_)
+        {
+            stamps_[client] = generation_;
+            f(client);
+            count++;
+        }
+    });
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE void filter_engine::collect(const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_index& index, const decoded_packet& p, const APRS_TRACK_DETAIL_NAMESPACE_REFERENCE filter_position& position, F&& f) const
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f for the clients of the index matching the packet, a client
+    // can be called more than once
+
+    // prefixes, from the root, for b/*, along the source callsign
+    uint32_t node = 0;
+
+    for (size_t i = 0;; i++)
+    {
+        for (uint32_t client : index.trie[node].clients)
+        {
+            f(client);
+        }
+        if (i == p.from.size())
+        {
+            break;
+        }
+        node = index.trie[node].children[filter_trie_child(p.from[i])];
+        if (node == 0)
+        {
+            break;
+        }
+    }
+
+    if (!index.callsigns.empty())
+    {
+        auto it = index.callsigns.find(filter_callsign_hash(p.from));
+        if (it != index.callsigns.end())
+        {
+            for (uint32_t client : it->second)
+            {
+                f(client);
+            }
+        }
+    }
+
+    for (size_t k = 0; k < packet_kind_count; k++)
+    {
+        if (p.kinds & (1u << k))
+        {
+            for (uint32_t client : index.kinds[k])
+            {
+                f(client);
+            }
+        }
+    }
+
+    if (position.valid && !index.cells.empty())
+    {
+        for (uint32_t id : index.cells[position.cell])
+        {
+            const filter_region& r = index.regions[id];
+
+            bool inside;
+
+            if (r.circle)
+            {
+                double dx = position.x - r.x;
+                double dy = position.y - r.y;
+                double dz = position.z - r.z;
+                inside = dx * dx + dy * dy + dz * dz <= r.threshold;
+            }
+            else
+            {
+                inside = position.lat >= r.south && position.lat <= r.north &&
+                    (r.west > r.east ? (position.lon >= r.west || position.lon <= r.east) : (position.lon >= r.west && position.lon <= r.east));
+            }
+
+            if (inside)
+            {
+                f(r.client);
+            }
+        }
+    }
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE void feed_decoder::push(std::string_view line, F&& f)
+{
+    // Queues the line, polling the decoded records with f while the queue is full
+
+    while (!try_push(line))
+    {
+        if (poll(f) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE size_t feed_decoder::poll(F&& f)
+{
+APRS_TRACK_DETAIL_NAMESPACE_USE
+
+    // Calls f(const feed_record&) for the records decoded so far, at most a
+    // queue of records from each worker, returns the number of records
+
+    size_t count = 0;
+
+    for (std::unique_ptr<feed_worker>& w : workers_)
+    {
+        size_t limit = w->output.capacity();
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < limit; i++)
+        {
+            feed_record* r = w->output.front();
+            if (r == nullptr)
+            {
+                break;
+            }
+            f(static_cast<const feed_record&>(*r));
+            w->poll_latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - r->pushed).count();
+            w->polled++;
+            w->output.pop();
+            count++;
+        }
+    }
+
+    polled_ += count;
+
+    return count;
+}
+
+template <typename F>
+APRS_TRACK_INLINE_NO_DISABLE void feed_decoder::finish(F&& f)
+{
+    // Polls until every line pushed has been decoded and polled
+
+    while (polled_ < pushed_)
+    {
+        if (poll(f) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+#endif
+
+template <class F>
+APRS_TRACK_INLINE_NO_DISABLE bool geojson_reader::feed(std::string_view chunk, F&& f)
+{
+    // Calls f(const geojson_position&) for each position which ends in the chunk
+    // Returns false once the document is malformed
+
+    while (!chunk.empty() && !error_)
+    {
+        chunk.remove_prefix(scan(chunk));
+
+        if (ready_)
+        {
+            ready_ = false;
+            f(position_);
+        }
+    }
+
+    return !error_;
+}
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+template <class F>
+APRS_TRACK_INLINE_NO_DISABLE bool read_geojson(const char* path, F&& f)
+{
+    // Streams a GeoJSON file through a geojson_reader, 16 KiB at a time
+    // Returns false if the file can not be read or is malformed
+
+    std::FILE* file = std::fopen(path, "rb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    geojson_reader reader;
+    char buffer[16 * 1024];
+    bool ok = true;
+
+    while (ok)
+    {
+        size_t n = std::fread(buffer, 1, sizeof(buffer), file);
+        if (n == 0)
+        {
+            break;
+        }
+        ok = reader.feed(std::string_view(buffer, n), f);
+    }
+
+    ok = ok && !std::ferror(file) && reader.finish();
+
+    std::fclose(file);
+
+    return ok;
+}
+
+#endif // APRS_TRACK_HEAP_FREE
+
+APRS_TRACK_NAMESPACE_END
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// private definitions                                              //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+APRS_TRACK_NAMESPACE_BEGIN
+
+APRS_TRACK_DETAIL_NAMESPACE_BEGIN
+
+string_t encode_position_packet_no_timestamp_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_no_timestamp(const tracker& t, const data& d);
+string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+string_t encode_position_packet_with_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_with_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+char packet_type_with_timestamp(bool m);
+
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_with_utc_timestamp_hms(const tracker& t, const data& d);
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_with_utc_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+string_t encode_position_packet_compressed_no_timestamp_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_no_timestamp(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
+string_t encode_compressed_course_speed(double course_degrees, double speed_knots);
+string_t encode_compressed_altitude(double altitude_feet);
+
+string_t encode_position_packet_compressed_with_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_dhm(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_hms_no_message(const tracker& t, const data& d);
+string_t encode_position_packet_compressed_with_utc_timestamp_hms(const tracker& t, const data& d);
+size_t encode_position_packet_compressed_with_timestamp_no_message(const tracker& t, const data& d, char timestamp_format, char* out, size_t out_size);
+size_t encode_position_packet_compressed_with_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, char timestamp_format, int t1, int t2, int t3, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, char* out, size_t out_size);
+size_t write_altitude(double alt_feet, char* out, size_t out_size);
+
+string_t encode_mic_e_packet_no_message(const tracker& t, const data& d);
+string_t encode_mic_e_packet(const tracker& t, const data& d);
+string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_mic_e_alt_feet(double alt_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_no_timestamp_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+
+    if (d.speed_knots.has_value() && d.track_degrees.has_value())
+    {
+        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
+    }
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_altitude(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_no_timestamp_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_timestamp_dhm_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), packet_type_with_timestamp(t.messaging()), d.day, d.hour, d.minute, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+
+    if (d.speed_knots.has_value() && d.track_degrees.has_value())
+    {
+        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
+    }
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_altitude(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_timestamp_dhm_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.hour, d.minute, d.second, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+
+    if (d.speed_knots.has_value() && d.track_degrees.has_value())
+    {
+        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
+    }
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_altitude(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.day, d.hour, d.minute, d.lat, d.lon, t.symbol_table(), t.symbol_code(), t.ambiguity()));
+
+    if (d.speed_knots.has_value() && d.track_degrees.has_value())
+    {
+        packet.append(encode_course_speed(d.track_degrees.value(), d.speed_knots.value()));
+    }
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_altitude(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    char compression_type = 0b00111000 + 33; // current, RMC, compressed
+
+    packet.append(encode_position_packet_compressed_no_timestamp_no_message(t.from().c_str(), t.to().c_str(), t.path().c_str(), t.messaging(), d.lat, d.lon, t.symbol_table(), t.symbol_code(), d.track_degrees.value_or(0), d.speed_knots.value_or(0), compression_type));
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_altitude(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_compressed_no_timestamp_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE size_t encode_position_packet_compressed_with_timestamp_no_message(const tracker& t, const data& d, char timestamp_format, char* out, size_t out_size)
+{
+    // Writes the packet into the caller buffer, returns the number of characters written
+    // or 0 if the buffer is too small, the buffer is not null terminated
+
+    char compression_type = 0b00111000 + 33; // current, RMC, compressed
+
+    int t1 = timestamp_format == 'h' ? d.hour : d.day;
+    int t2 = timestamp_format == 'h' ? d.minute : d.hour;
+    int t3 = timestamp_format == 'h' ? d.second : d.minute;
+
+    size_t size = encode_position_packet_compressed_with_timestamp_no_message(std::string_view(t.from().data(), t.from().size()), std::string_view(t.to().data(), t.to().size()), std::string_view(t.path().data(), t.path().size()),
+        t.messaging(), timestamp_format, t1, t2, t3, d.lat, d.lon, t.symbol_table(), t.symbol_code(), d.track_degrees.value_or(0), d.speed_knots.value_or(0), compression_type, out, out_size);
+
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if (d.alt_feet.has_value())
+    {
+        size_t alt_size = write_altitude(d.alt_feet.value(), out + size, out_size - size);
+        if (alt_size == 0)
+        {
+            return 0;
+        }
+        size += alt_size;
+    }
+
+    return size;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_timestamp_dhm_no_message(const tracker& t, const data& d)
+{
+    char buffer[256];
+
+    size_t size = encode_position_packet_compressed_with_timestamp_no_message(t, d, '/', buffer, sizeof(buffer));
+
+    string_t packet;
+    packet.append(buffer, size);
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_timestamp_dhm(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_compressed_with_timestamp_dhm_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_utc_timestamp_dhm_no_message(const tracker& t, const data& d)
+{
+    char buffer[256];
+
+    size_t size = encode_position_packet_compressed_with_timestamp_no_message(t, d, 'z', buffer, sizeof(buffer));
+
+    string_t packet;
+    packet.append(buffer, size);
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_utc_timestamp_dhm(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_compressed_with_utc_timestamp_dhm_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_utc_timestamp_hms_no_message(const tracker& t, const data& d)
+{
+    char buffer[256];
+
+    size_t size = encode_position_packet_compressed_with_timestamp_no_message(t, d, 'h', buffer, sizeof(buffer));
+
+    string_t packet;
+    packet.append(buffer, size);
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_with_utc_timestamp_hms(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_compressed_with_utc_timestamp_hms_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_mic_e_packet_no_message(t.from().c_str(), t.path().c_str(), d.lat, d.lon, t.mic_e_status(), d.track_degrees.value_or(0), d.speed_knots.value_or(0), t.symbol_table(), t.symbol_code(), t.ambiguity()));
+
+    if (d.alt_feet.has_value())
+    {
+        packet.append(encode_mic_e_alt_feet(d.alt_feet.value()));
+    }
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_packet(const tracker& t, const data& d)
+{
+    string_t packet;
+
+    packet.append(encode_mic_e_packet_no_message(t, d));
+
+    std::string_view m = t.message_view();
+    packet.append(m.data(), m.size());
+
+    return packet;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_DETAIL_NAMESPACE_END
+
+APRS_TRACK_NAMESPACE_END
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+//                                                                  //
+//                                                                  //
+// encoding library                                                 //
+//                                                                  //
+//                                                                  //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// private definitions                                              //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+#include <string> // for std::string.
+#include <string_view> // for std::string_view.
+#include <tuple> // for std::tuple and std::tie.
+#include <cmath> // for mathematical functions like std::abs, std::modf, and std::round.
+#include <cstdio> // for std::snprintf.
+#include <cassert>
+
+APRS_TRACK_NAMESPACE_BEGIN
+
+APRS_TRACK_DETAIL_NAMESPACE_BEGIN
+
+char packet_type_without_timestamp(bool m);
+char packet_type_with_timestamp(bool m);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE char packet_type_without_timestamp(bool messaging)
+{
+    return messaging ? '=' : '!';
+}
+
+APRS_TRACK_INLINE char packet_type_with_timestamp(bool messaging)
+{
+   return messaging ? '@' : '/';
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// fixed capacity storage                                           //
+//                                                                  //
+// **************************************************************** //
+
+template <typename T, size_t N>
+template <typename InputIterator>
+APRS_TRACK_INLINE_NO_DISABLE void fixed_vector<T, N>::assign(InputIterator begin, InputIterator end)
+{
+    size_ = 0;
+    for (; begin != end && size_ < N; ++begin)
+    {
+        elements_[size_++] = static_cast<T>(*begin);
+    }
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE void fixed_vector<T, N>::resize(size_t size)
+{
+    size = (std::min)(size, N);
+    for (size_t i = size_; i < size; i++)
+    {
+        elements_[i] = T{};
+    }
+    size_ = size;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE void fixed_vector<T, N>::clear()
+{
+    size_ = 0;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE size_t fixed_vector<T, N>::size() const
+{
+    return size_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE T* fixed_vector<T, N>::data()
+{
+    return elements_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE const T* fixed_vector<T, N>::data() const
+{
+    return elements_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE T* fixed_vector<T, N>::begin()
+{
+    return elements_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE T* fixed_vector<T, N>::end()
+{
+    return elements_ + size_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE const T* fixed_vector<T, N>::begin() const
+{
+    return elements_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE const T* fixed_vector<T, N>::end() const
+{
+    return elements_ + size_;
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE T& fixed_vector<T, N>::operator[](size_t index)
+{
+    return elements_[index];
+}
+
+template <typename T, size_t N>
+APRS_TRACK_INLINE_NO_DISABLE const T& fixed_vector<T, N>::operator[](size_t index) const
+{
+    return elements_[index];
+}
+
+// **************************************************************** //
+//                                                                  //
+// memory resources                                                 //
+//                                                                  //
+// **************************************************************** //
+
+#ifdef APRS_TRACK_PMR
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE std::pmr::memory_resource*& memory_resource_slot()
+{
+    // The resource of the innermost memory_resource_scope on this thread,
+    // nullptr for the default resource
+    static thread_local std::pmr::memory_resource* resource = nullptr;
+    return resource;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE T make_with_resource(std::pmr::memory_resource* resource)
+{
+    // Constructs a container with an allocator using the resource, if its
+    // allocator can be constructed from a resource, like resource_allocator
+    // or std::pmr::polymorphic_allocator
+
+    if constexpr (requires { typename T::allocator_type; })
+    {
+        if constexpr (std::is_constructible_v<typename T::allocator_type, std::pmr::memory_resource*>)
+        {
+            return T(typename T::allocator_type(resource));
+        }
+        else
+        {
+            return T();
+        }
+    }
+    else
+    {
+        return T();
+    }
+}
+
+#endif // APRS_TRACK_PMR
+
+// **************************************************************** //
+//                                                                  //
+// packed fix                                                       //
+//                                                                  //
+// **************************************************************** //
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE int32_t pack_degrees(double degrees)
+{
+    return static_cast<int32_t>(std::llround(std::clamp(degrees, -180.0, 180.0) * 1e7));
+}
+
+APRS_TRACK_INLINE uint32_t pack_speed(double speed_knots)
+{
+    // kept below INT32_MAX, the deltas of the track log and history are signed
+    return static_cast<uint32_t>(std::llround(std::clamp(speed_knots, 0.0, 21474836.0) * 100.0));
+}
+
+APRS_TRACK_INLINE uint16_t pack_track(double track_degrees)
+{
+    // Courses are 0 to 360 degrees, other values are normalized to 0 to 360
+
+    if (!(track_degrees >= 0.0 && track_degrees <= 360.0))
+    {
+        track_degrees = std::isfinite(track_degrees) ? std::fmod(track_degrees, 360.0) : 0.0;
+        if (track_degrees < 0.0)
+        {
+            track_degrees += 360.0;
+        }
+    }
+
+    return static_cast<uint16_t>(std::llround(track_degrees * 100.0));
+}
+
+APRS_TRACK_INLINE int32_t pack_alt(double alt_feet)
+{
+    return static_cast<int32_t>(std::llround(std::clamp(alt_feet, -21474836.0, 21474836.0) * 100.0));
+}
+
+APRS_TRACK_INLINE packed_data pack_data(const data& d)
+{
+    packed_data p;
+
+    p.lat = pack_degrees(d.lat);
+    p.lon = pack_degrees(d.lon);
+
+    if (d.speed_knots)
+    {
+        p.speed = pack_speed(*d.speed_knots);
+        p.has_speed = 1;
+    }
+
+    if (d.track_degrees)
+    {
+        p.track = pack_track(*d.track_degrees);
+        p.has_track = 1;
+    }
+
+    if (d.alt_feet)
+    {
+        p.alt = pack_alt(*d.alt_feet);
+        p.has_alt = 1;
+    }
+
+    p.day = static_cast<uint8_t>(d.day);
+    p.hour = static_cast<uint8_t>(d.hour);
+    p.minute = static_cast<uint8_t>(d.minute);
+    p.second = static_cast<uint8_t>(d.second);
+    p.has_time = d.has_time ? 1 : 0;
+
+    return p;
+}
+
+APRS_TRACK_INLINE data unpack_data(const packed_data& p)
+{
+    data d;
+
+    d.lat = p.lat / 1e7;
+    d.lon = p.lon / 1e7;
+
+    if (p.has_speed)
+    {
+        d.speed_knots = p.speed / 100.0;
+    }
+
+    if (p.has_track)
+    {
+        d.track_degrees = p.track / 100.0;
+    }
+
+    if (p.has_alt)
+    {
+        d.alt_feet = p.alt / 100.0;
+    }
+
+    d.day = p.day;
+    d.hour = p.hour;
+    d.minute = p.minute;
+    d.second = p.second;
+    d.has_time = p.has_time != 0;
+
+    return d;
+}
+
+APRS_TRACK_INLINE fix_data make_fix_data(const data& d)
+{
+    fix_data f;
+
+    f.lat = d.lat;
+    f.lon = d.lon;
+
+    if (d.speed_knots)
+    {
+        f.speed_knots = *d.speed_knots;
+        f.has_speed = 1;
+    }
+
+    if (d.track_degrees)
+    {
+        f.track_degrees = *d.track_degrees;
+        f.has_track = 1;
+    }
+
+    if (d.alt_feet)
+    {
+        f.alt_feet = *d.alt_feet;
+        f.has_alt = 1;
+    }
+
+    f.day = static_cast<uint8_t>(d.day);
+    f.hour = static_cast<uint8_t>(d.hour);
+    f.minute = static_cast<uint8_t>(d.minute);
+    f.second = static_cast<uint8_t>(d.second);
+    f.has_time = d.has_time ? 1 : 0;
+
+    return f;
+}
+
+APRS_TRACK_INLINE data make_data(const fix_data& f)
+{
+    data d;
+
+    d.lat = f.lat;
+    d.lon = f.lon;
+
+    if (f.has_speed)
+    {
+        d.speed_knots = f.speed_knots;
+    }
+
+    if (f.has_track)
+    {
+        d.track_degrees = f.track_degrees;
+    }
+
+    if (f.has_alt)
+    {
+        d.alt_feet = f.alt_feet;
+    }
+
+    d.day = f.day;
+    d.hour = f.hour;
+    d.minute = f.minute;
+    d.second = f.second;
+    d.has_time = f.has_time != 0;
+
+    return d;
+}
+
+APRS_TRACK_INLINE double distance_meters(double lat1, double lon1, double lat2, double lon2)
+{
+    // Haversine distance, with the mean earth radius
+
+    constexpr double radians = 3.14159265358979323846 / 180.0;
+    constexpr double earth_radius_meters = 6371008.8;
+
+    double dlat = (lat2 - lat1) * radians;
+    double dlon = (lon2 - lon1) * radians;
+
+    double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+        std::cos(lat1 * radians) * std::cos(lat2 * radians) * std::sin(dlon / 2) * std::sin(dlon / 2);
+
+    return 2.0 * earth_radius_meters * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+APRS_TRACK_INLINE history_entry make_history_entry(const packed_data& previous, const packed_data& fix)
+{
+    history_entry entry;
+    entry.fix = fix;
+
+    double meters = distance_meters(previous.lat / 1e7, previous.lon / 1e7, fix.lat / 1e7, fix.lon / 1e7);
+    entry.distance_cm = static_cast<int32_t>(std::min(std::llround(meters * 100.0), static_cast<long long>(INT32_MAX)));
+
+    if (previous.has_track && fix.has_track)
+    {
+        // smallest angle between the two tracks, in 1e-2 degrees
+        int32_t change = std::abs(static_cast<int32_t>(fix.track) - static_cast<int32_t>(previous.track)) % 36000;
+        entry.heading_change = std::min(change, 36000 - change);
+    }
+
+    return entry;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// common position handling                                         //
+//                                                                  //
+// **************************************************************** //
+
+struct position_ddm
+{
+    char lat = '\0';
+    int lat_d = 0;
+    double lat_m = 0.0;
+    char lon = '\0';
+    int lon_d = 0;
+    double lon_m = 0.0;
+};
+
+struct position_ddm_string
+{
+    string_t lat;
+    string_t lon;
+};
+
+std::tuple<int, int, double> dd_to_dms(double dd);
+std::tuple<int, double> dd_to_ddm(double dd);
+position_ddm dd_to_ddm(double lat, double lon);
+string_t format_number_to_string(double number, int width, int precision);
+string_t format_number_to_string(double number, int precision);
+string_t format_n_digits_string(int number, int digits);
+string_t format_two_digits_string(int number);
+position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity);
+position_ddm_string to_ddm_short_string(const position_ddm& p);
+#ifdef APRS_TRACK_PMR
+position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity, std::pmr::memory_resource* resource);
+#endif
+void add_position_ambiguity(string_t& position, int ambiguity);
+int64_t quantize_ddm_minutes(double minutes);
+long quantize_compressed_lat(double lat);
+long quantize_compressed_lon(double lon);
+string_t encode_compressed_lon(double lon);
+string_t encode_compressed_lat(double lat);
+string_t encode_compressed_lat_lon(double lat, double lon);
+size_t write_compressed_lon(double lon, char* out);
+size_t write_compressed_lat(double lat, char* out);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE std::tuple<int, int, double> dd_to_dms(double dd)
+{
+    // Example algorithm:
+    //
+    // Input DD = 37.7749
+    // 
+    // D = integer part of 37.7749 = 37
+    // DM = fractional part of 37.7749 * 60 = 0.7749 * 60 = 46.494
+    // M = integer part of 46.494 = 46
+    // S = fractional part of 46.494 * 60 = 0.494 * 60 = 29.64
+    // 
+    // Output DMS = 37° 46' 29.64"
+
+    double d, dm, m, s;
+    double dd_abs = std::abs(dd);
+    dm = std::modf(dd_abs, &d);
+    if (dd < 0)
+    {
+        d = -d;
+    }
+    dm = dm * 60.0;
+    s = std::modf(dm, &m);
+    s = s * 60.0;
+    return std::make_tuple(static_cast<int>(d), static_cast<int>(m), s);
+}
+
+APRS_TRACK_INLINE std::tuple<int, double> dd_to_ddm(double dd)
+{
+    int d, m;
+    double s;
+    std::tie(d, m, s) = dd_to_dms(dd);
+    double m_s = m + (s / 60.0);
+    return std::make_tuple(d, m_s);
+}
+
+APRS_TRACK_INLINE position_ddm dd_to_ddm(double lat, double lon)
+{
+    position_ddm ddm;
+    std::tie(ddm.lat_d, ddm.lat_m) = dd_to_ddm(lat);
+    std::tie(ddm.lon_d, ddm.lon_m) = dd_to_ddm(lon);
+    ddm.lat_d = std::abs(ddm.lat_d);
+    ddm.lon_d = std::abs(ddm.lon_d);
+    ddm.lat = lat >= 0 ? 'N' : 'S';
+    ddm.lon = lon >= 0 ? 'E' : 'W';
+    return ddm;
+}
+
+APRS_TRACK_INLINE string_t format_number_to_string(double number, int width, int precision)
+{
+    // Converts a double to a formatted string representation with specific width and precision
+    //
+    // Parameters:
+    //
+    //   number    - the floating-point value to format
+    //   width     - minimum width for the resulting string (padding with leading zeros if > 0)
+    //   precision - decimal precision (number of digits after decimal point)
+    //               if precision is 0, formats as integer without decimal point
+    //               the number is rounded to the specified precision
+    //
+    // Examples:
+    //
+    //   format_number_to_string(37.7749, 4)    ->  37.7749
+    //   format_number_to_string(37.7749, 1)    ->  37.8
+    //   format_number_to_string(37.7749, 0)    ->  37
+    //   format_number_to_string(37.7749, 5, 2) ->  037.77
+    //   format_number_to_string(0.7749, 5, 2)  ->  000.77
+    //   format_number_to_string(5.5, 8, 4)     ->  0005.5000
+    //   format_number_to_string(0.5, 8, 4)     ->  0000.5000
+    //   format_number_to_string(-5.5, 8, 4)    -> -005.5000
+
+    string_t pretty_number_str;
+
+    if (precision == 0)
+    {
+        double i;
+        double f = std::modf(number, &i);
+        (void)f;
+
+        char buffer[32];
+
+        if (width > 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%0*d", width, static_cast<int>(i));
+        }
+        else
+        {
+            std::snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(i));
+        }
+
+        pretty_number_str = buffer;
+    }
+    else
+    {
+        char buffer[32];
+
+        if (width > 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%0*.*f", width + 1, precision, number);
+        }
+        else
+        {
+            std::snprintf(buffer, sizeof(buffer), "%.*f", precision, number);
+        }
+
+        pretty_number_str = buffer;
+    }
+
+    return pretty_number_str;
+}
+
+APRS_TRACK_INLINE string_t format_number_to_string(double number, int precision)
+{
+    return format_number_to_string(number, 0, precision);
+}
+
+APRS_TRACK_INLINE string_t format_n_digits_string(int number, int width)
+{
+    char buffer[32];
+    if (width <= 0)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%d", number);
+    }
+    else
+    {
+        std::snprintf(buffer, sizeof(buffer), "%0*d", width, number);
+    }
+    return string_t(buffer);
+}
+
+APRS_TRACK_INLINE string_t format_two_digits_string(int number)
+{
+    return format_n_digits_string(number, 2);
+}
+
+APRS_TRACK_INLINE position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity)
+{
+    position_ddm_string s;
+    s.lat = format_number_to_string(p.lat_d, 2, 0);
+    s.lat.append(format_number_to_string(p.lat_m, 4, 2));
+    s.lat.append(1, p.lat);
+    add_position_ambiguity(s.lat, ambiguity);
+    s.lon = format_number_to_string(p.lon_d, 3, 0);
+    s.lon.append(format_number_to_string(p.lon_m, 4, 2));
+    s.lon.append(1, p.lon);
+    return s;
+}
+
+APRS_TRACK_INLINE position_ddm_string to_ddm_short_string(const position_ddm& p)
+{
+    return to_ddm_short_string(p, 0);
+}
+
+#ifdef APRS_TRACK_PMR
+
+APRS_TRACK_INLINE position_ddm_string to_ddm_short_string(const position_ddm& p, int ambiguity, std::pmr::memory_resource* resource)
+{
+    memory_resource_scope scope(resource);
+    return to_ddm_short_string(p, ambiguity);
+}
+
+#endif // APRS_TRACK_PMR
+
+APRS_TRACK_INLINE void add_position_ambiguity(string_t& position, int ambiguity)
+{
+    if (!(ambiguity > 0))
+    {
+        return;
+    }
+
+    for (size_t i = position.size() - 2, count = 0; i > 0 && count < static_cast<size_t>(ambiguity); i--)
+    {
+        if (position[i] == '.')
+        {
+            continue;
+        }
+        position[i] = ' ';
+        count++;
+    }
+}
+
+APRS_TRACK_INLINE int64_t quantize_ddm_minutes(double minutes)
+{
+    // The minutes in hundredths, as to_ddm_short_string writes them
+
+    string_t formatted = format_number_to_string(minutes, 4, 2);
+
+    int64_t hundredths = 0;
+
+    for (char c : formatted)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            hundredths = hundredths * 10 + (c - '0');
+        }
+    }
+
+    return hundredths;
+}
+
+APRS_TRACK_INLINE long quantize_compressed_lat(double lat)
+{
+    return static_cast<long>(std::round(380926 * (90 - lat)));
+}
+
+APRS_TRACK_INLINE long quantize_compressed_lon(double lon)
+{
+    return static_cast<long>(std::round(190463 * (180 + lon)));
+}
+
+APRS_TRACK_INLINE string_t encode_compressed_lon(double lon)
+{
+    char buffer[4];
+
+    string_t result;
+    result.append(buffer, write_compressed_lon(lon, buffer));
+    return result;
+}
+
+APRS_TRACK_INLINE string_t encode_compressed_lat(double lat)
+{
+    char buffer[4];
+
+    string_t result;
+    result.append(buffer, write_compressed_lat(lat, buffer));
+    return result;
+}
+
+APRS_TRACK_INLINE size_t write_compressed_lon(double lon, char* out)
+{
+    // Writes the 4 base 91 digits of the compressed longitude, most significant first
+
+    long num = quantize_compressed_lon(lon);
+
+    out[3] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[2] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[1] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[0] = static_cast<char>((num % 91) + 33);
+
+    return 4;
+}
+
+APRS_TRACK_INLINE size_t write_compressed_lat(double lat, char* out)
+{
+    // Writes the 4 base 91 digits of the compressed latitude, most significant first
+
+    long num = quantize_compressed_lat(lat);
+
+    out[3] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[2] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[1] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[0] = static_cast<char>((num % 91) + 33);
+
+    return 4;
+}
+
+APRS_TRACK_INLINE string_t encode_compressed_lat_lon(double lat, double lon)
+{
+    string_t result;
+
+    result.append(encode_compressed_lat(lat));
+    result.append(encode_compressed_lon(lon));
+
+    return result;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// timestamp                                                        //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_timestamp_dhm(int day, int hour, int min);
+string_t encode_utc_timestamp_dhm(int day, int hour, int min);
+string_t encode_utc_timestamp_hms(int hour, int min, int sec);
+size_t write_two_digits(int number, char* out);
+size_t write_timestamp(char format, int t1, int t2, int t3, char* out);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_timestamp_dhm(int day, int hour, int min)
+{
+    string_t dhm;
+
+    dhm.append(format_two_digits_string(day));
+    dhm.append(format_two_digits_string(hour));
+    dhm.append(format_two_digits_string(min));
+
+    dhm.append("/");
+
+    return dhm;
+}
+
+APRS_TRACK_INLINE string_t encode_utc_timestamp_dhm(int day, int hour, int min)
+{
+    string_t dhm;
+
+    dhm.append(format_two_digits_string(day));
+    dhm.append(format_two_digits_string(hour));
+    dhm.append(format_two_digits_string(min));
+
+    dhm.append("z");
+
+    return dhm;
+}
+
+APRS_TRACK_INLINE string_t encode_utc_timestamp_hms(int hour, int min, int sec)
+{
+    string_t dhm;
+
+    dhm.append(format_two_digits_string(hour));
+    dhm.append(format_two_digits_string(min));
+    dhm.append(format_two_digits_string(sec));
+
+    dhm.append("h");
+
+    return dhm;
+}
+
+APRS_TRACK_INLINE size_t write_two_digits(int number, char* out)
+{
+    // Same as format_two_digits_string, for numbers between 0 and 99
+
+    out[0] = static_cast<char>('0' + (number / 10) % 10);
+    out[1] = static_cast<char>('0' + number % 10);
+
+    return 2;
+}
+
+APRS_TRACK_INLINE size_t write_timestamp(char format, int t1, int t2, int t3, char* out)
+{
+    // Writes a 7 character timestamp, the format character is the last one:
+    //
+    //   DDHHMM/ - day, hour, minute, local time
+    //   DDHHMMz - day, hour, minute, UTC
+    //   HHMMSSh - hour, minute, second, UTC
+
+    write_two_digits(t1, out);
+    write_two_digits(t2, out + 2);
+    write_two_digits(t3, out + 4);
+
+    out[6] = format;
+
+    return 7;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// header                                                           //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_header(std::string_view from, std::string_view to, std::string_view path);
+size_t encode_header(std::string_view from, std::string_view to, std::string_view path, char* out, size_t out_size);
+#ifdef APRS_TRACK_PMR
+string_t encode_header(std::string_view from, std::string_view to, std::string_view path, std::pmr::memory_resource* resource);
+#endif
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_header(std::string_view from, std::string_view to, std::string_view path)
+{
+    // Encode the header of a packet:
+    //
+    // Example:
+    //
+    //   N0CALL>APRS,TCPIP*,qAC,N0CALL:
+    //   ~~~~~~ ~~~~ ~~~~~~~~~~~~~~~~~
+    //   from  >to  ,path             :
+
+    string_t packet;
+
+    packet.append(from.data(), from.size());
+    packet.append(1, '>');
+    packet.append(to.data(), to.size());
+
+    if (path.empty() == false)
+    {
+        packet.append(1, ',');
+        packet.append(path.data(), path.size());
+    }
+
+    packet.append(1, ':');
+
+    return packet;
+}
+
+#ifdef APRS_TRACK_PMR
+
+APRS_TRACK_INLINE string_t encode_header(std::string_view from, std::string_view to, std::string_view path, std::pmr::memory_resource* resource)
+{
+    memory_resource_scope scope(resource);
+    return encode_header(from, to, path);
+}
+
+#endif // APRS_TRACK_PMR
+
+APRS_TRACK_INLINE size_t encode_header(std::string_view from, std::string_view to, std::string_view path, char* out, size_t out_size)
+{
+    // Same as above, writing into the caller buffer
+    // Returns the number of characters written, or 0 if the buffer is too small
+
+    size_t size = from.size() + 1 + to.size() + (path.empty() ? 0 : path.size() + 1) + 1;
+
+    if (size > out_size)
+    {
+        return 0;
+    }
+
+    char* p = std::copy(from.begin(), from.end(), out);
+    *p++ = '>';
+    p = std::copy(to.begin(), to.end(), p);
+
+    if (path.empty() == false)
+    {
+        *p++ = ',';
+        p = std::copy(path.begin(), path.end(), p);
+    }
+
+    *p++ = ':';
+
+    return size;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position no timestamp                                            //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_position_data_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
+string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
+string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_data_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    // 
+    //  Data Format:
+    // 
+    //     !   Lat  Sym  Lon  Sym Code   Comment
+    //     =
+    //    ------------------------------------------
+    //     1    8    1    9      1        0-43
+    //
+    //  Examples:
+    //
+    //    !4903.50N/07201.75W-Test 001234
+    //    !4903.50N/07201.75W-Test /A=001234
+    //    !49  .  N/072  .  W-
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    position_ddm ddm = dd_to_ddm(lat, lon);
+    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+
+    data.append(ddm_str.lat);
+
+    data.append(1, symbol_table);
+
+    data.append(ddm_str.lon);
+
+    data.append(1, symbol_code);
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, ambiguity));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_no_timestamp_no_message(from, to, path, messaging, lat, lon, symbol_table, symbol_code, ambiguity, speed_knots, track_degrees));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position with timestamp dhm                                      //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_position_data_with_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
+string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
+string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_data_with_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    // 
+    //  Data Format:
+    // 
+    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
+    //     @
+    //    -----------------------------------------------
+    //     1    7     8     1    9      1        0-43
+    //
+    //  Examples:
+    //
+    //    /092345z4903.50N/07201.75W>Test1234
+    //    @092345/4903.50N/07201.75W>Test1234
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(encode_timestamp_dhm(day, hour, min));
+
+    position_ddm ddm = dd_to_ddm(lat, lon);
+    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+
+    data.append(ddm_str.lat);
+
+    data.append(1, symbol_table);
+
+    data.append(ddm_str.lon);
+
+    data.append(1, symbol_code);
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_with_timestamp_dhm(packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_timestamp_dhm_no_message(from, to, path, packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position with timestamp hms                                      //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_position_data_with_utc_timestamp_hms(char type, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
+string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_data_with_utc_timestamp_hms(char type, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    // 
+    //  Data Format:
+    // 
+    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
+    //     @
+    //    -----------------------------------------------
+    //     1    7     8     1    9      1        0-43
+    //
+    //  Examples:
+    //
+    //    /092345z4903.50N/07201.75W>Test1234
+    //    @092345/4903.50N/07201.75W>Test1234
+    //    @234517h4903.50N/07201.75W>Test1234
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(encode_utc_timestamp_hms(hour, min, sec));
+
+    position_ddm ddm = dd_to_ddm(lat, lon);
+    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+
+    data.append(ddm_str.lat);
+
+    data.append(1, symbol_table);
+
+    data.append(ddm_str.lon);
+
+    data.append(1, symbol_code);
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_with_utc_timestamp_hms(packet_type_with_timestamp(messaging), hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+{
+    string_t packet;
+    
+    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+    
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    packet.append(encode_altitude(alt_feet));
+    
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_hms_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int hour, int min, int sec, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+{
+    string_t packet;
+   
+    packet.append(encode_position_packet_with_utc_timestamp_hms_no_message(from, to, path, messaging, hour, min, sec, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+    
+    packet.append(encode_altitude(alt_feet));
+    
+    return packet;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position with utc timestamp                                      //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_position_data_with_utc_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees);
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
+string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet);
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double altitude_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_data_with_utc_timestamp_dhm(char type, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    // 
+    //  Data Format:
+    // 
+    //     /   Time  Lat   Sym  Lon  Sym Code   Comment
+    //     @
+    //    -----------------------------------------------
+    //     1    7     8     1    9      1        0-43
+    //
+    //  Examples:
+    //
+    //    /092345z4903.50N/07201.75W>Test1234
+    //    @092345/4903.50N/07201.75W>Test1234
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(encode_utc_timestamp_dhm(day, hour, min));
+
+    position_ddm ddm = dd_to_ddm(lat, lon);
+    position_ddm_string ddm_str = to_ddm_short_string(ddm, ambiguity);
+
+    data.append(ddm_str.lat);
+
+    data.append(1, symbol_table);
+
+    data.append(ddm_str.lon);
+
+    data.append(1, symbol_code);
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_with_utc_timestamp_dhm(packet_type_with_timestamp(messaging), day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees)
+{
+    string_t packet;
+  
+    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+    
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_with_utc_timestamp_dhm_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, int day, int hour, int min, double lat, double lon, char symbol_table, char symbol_code, int ambiguity, double speed_knots, double track_degrees, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_position_packet_with_utc_timestamp_dhm_no_message(from, to, path, messaging, day, hour, min, lat, lon, symbol_table, symbol_code, ambiguity));
+    
+    packet.append(encode_course_speed(track_degrees, speed_knots));
+    
+    packet.append(encode_altitude(alt_feet));
+    
+    return packet;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position compression                                             //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code);
+string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type);
+string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
+string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type);
+string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type);
+string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type);
+string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type);
+string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, double alt_feet);
+string_t encode_compressed_course_speed(double course_degrees, double speed_knots);
+string_t encode_compressed_altitude(double altitude_feet);
+size_t write_compressed_course_speed(double course_degrees, double speed_knots, char* out);
+int quantize_compressed_course(double course_degrees);
+int quantize_compressed_speed(double speed_knots);
+int compression_type_to_int(compression_type type);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code)
+{
+    //
+    //  Data Format:
+    //
+    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
+    //     =
+    //    --------------------------------------------------------------------------------------------------
+    //     1    1          4           4            1                   2                  1       0-40
+    //
+    //  Examples:
+    //
+    //    =/5L!!<*e7>7P[
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(1, symbol_table);
+
+    data.append(encode_compressed_lat(lat));
+    data.append(encode_compressed_lon(lon));
+
+    data.append(1, symbol_code);
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type)
+{
+    //
+    //  Data Format:
+    //
+    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
+    //     =
+    //    --------------------------------------------------------------------------------------------------
+    //     1    1          4           4            1                   2                  1       0-40
+    //
+    //  Examples:
+    //
+    //    =/5L!!<*e7>7P[
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(1, symbol_table);
+
+    data.append(encode_compressed_lat(lat));
+    data.append(encode_compressed_lon(lon));
+
+    data.append(1, symbol_code);
+
+    data.append(1, static_cast<char>(compression_type));
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type)
+{
+    //
+    //  Data Format:
+    //
+    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
+    //     =
+    //    --------------------------------------------------------------------------------------------------
+    //     1    1          4           4            1                   2                  1       0-40
+    //
+    //  Examples:
+    //
+    //    =/5L!!<*e7>7P[
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(1, symbol_table);
+
+    data.append(encode_compressed_lat(lat));
+    data.append(encode_compressed_lon(lon));
+
+    data.append(1, symbol_code);
+
+    data.append(encode_compressed_course_speed(course_degrees, speed_knots));
+
+    data.append(1, static_cast<char>(compression_type));
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_data_compressed_no_timestamp(char type, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type)
+{
+    //
+    //  Data Format:
+    //
+    //     !   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Speed/Range/Alt  CompType  Comment
+    //     =
+    //    --------------------------------------------------------------------------------------------------
+    //     1    1          4           4            1                   2                  1       0-40
+    //
+    //  Examples:
+    //
+    //    =/5L!!<*e7>7P[
+    //
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(1, symbol_table);
+
+    data.append(encode_compressed_lat(lat));
+    data.append(encode_compressed_lon(lon));
+
+    data.append(1, symbol_code);
+
+    data.append(encode_compressed_altitude(alt_feet));
+
+    data.append(1, static_cast<char>(compression_type));
+
+    return data;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, unsigned char compression_type)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, compression_type));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+    
+    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, course_degrees, speed_knots, compression_type));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double alt_feet, unsigned char compression_type)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, alt_feet, compression_type));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_position_packet_compressed_no_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_header(from, to, path));
+
+    packet.append(encode_position_data_compressed_no_timestamp(packet_type_without_timestamp(messaging), lat, lon, symbol_table, symbol_code, course_degrees, speed_knots, compression_type));
+
+    packet.append(encode_altitude(alt_feet));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_compressed_course_speed(double course_degrees, double speed_knots)
+{
+    string_t course_speed(2, '\0');
+
+    write_compressed_course_speed(course_degrees, speed_knots, course_speed.data());
+
+    return course_speed;
+}
+
+APRS_TRACK_INLINE size_t write_compressed_course_speed(double course_degrees, double speed_knots, char* out)
+{
+    int c = quantize_compressed_course(course_degrees);
+    int s = quantize_compressed_speed(speed_knots);
+
+    out[0] = static_cast<char>(c + 33);
+    out[1] = static_cast<char>(s + 33);
+
+    return 2;
+}
+
+APRS_TRACK_INLINE int quantize_compressed_course(double course_degrees)
+{
+    // course degrees is expressed in degrees 0 to 359, clockwise from due north
+    // if the value exceeds 359, it is wrapped around to 0
+    while (course_degrees >= 360.0)
+    {
+        course_degrees -= 360.0;
+    }
+
+    return static_cast<int>(course_degrees / 4.0);
+}
+
+APRS_TRACK_INLINE int quantize_compressed_speed(double speed_knots)
+{
+    return static_cast<int>(std::round(std::log(speed_knots + 1.0) / std::log(1.08)));
+}
+
+APRS_TRACK_INLINE string_t encode_compressed_altitude(double altitude_feet)
+{
+    int cs = static_cast<int>(std::round(std::log(altitude_feet) / std::log(1.002)));
+
+    int c = cs / 91;
+    int s = cs % 91;
+
+    string_t out(2, '\0');
+
+    out[0] = static_cast<char>(c + 33);
+    out[1] = static_cast<char>(s + 33);
+
+    return out;
+}
+
+APRS_TRACK_INLINE int compression_type_to_int(compression_type type)
+{
+    switch (type)
+    {
+        case compression_type::old_other_compressed: return 0b00000000;
+        case compression_type::old_other_tnc_b_text: return 0b00000001;
+        case compression_type::old_other_software: return 0b00000010;
+        case compression_type::old_other_tbd_1: return 0b00000011;
+        case compression_type::old_other_kpc3: return 0b00000100;
+        case compression_type::old_other_pico: return 0b00000101;
+        case compression_type::old_other_other_tracker: return 0b00000110;
+        case compression_type::old_other_digipeater: return 0b00000111;
+
+        case compression_type::old_gll_compressed: return 0b00001000;
+        case compression_type::old_gll_tnc_b_text: return 0b00001001;
+        case compression_type::old_gll_software: return 0b00001010;
+        case compression_type::old_gll_tbd_1: return 0b00001011;
+        case compression_type::old_gll_kpc3: return 0b00001100;
+        case compression_type::old_gll_pico: return 0b00001101;
+        case compression_type::old_gll_other_tracker: return 0b00001110;
+        case compression_type::old_gll_digipeater: return 0b00001111;
+
+        case compression_type::old_gga_compressed: return 0b00010000;
+        case compression_type::old_gga_tnc_b_text: return 0b00010001;
+        case compression_type::old_gga_software: return 0b00010010;
+        case compression_type::old_gga_tbd_1: return 0b00010011;
+        case compression_type::old_gga_kpc3: return 0b00010100;
+        case compression_type::old_gga_pico: return 0b00010101;
+        case compression_type::old_gga_other_tracker: return 0b00010110;
+        case compression_type::old_gga_digipeater: return 0b00010111;
+
+        case compression_type::old_rmc_compressed: return 0b00011000;
+        case compression_type::old_rmc_tnc_b_text: return 0b00011001;
+        case compression_type::old_rmc_software: return 0b00011010;
+        case compression_type::old_rmc_tbd_1: return 0b00011011;
+        case compression_type::old_rmc_kpc3: return 0b00011100;
+        case compression_type::old_rmc_pico: return 0b00011101;
+        case compression_type::old_rmc_other_tracker: return 0b00011110;
+        case compression_type::old_rmc_digipeater: return 0b00011111;
+
+        case compression_type::current_other_compressed: return 0b00100000;
+        case compression_type::current_other_tnc_b_text: return 0b00100001;
+        case compression_type::current_other_software: return 0b00100010;
+        case compression_type::current_other_tbd_1: return 0b00100011;
+        case compression_type::current_other_kpc3: return 0b00100100;
+        case compression_type::current_other_pico: return 0b00100101;
+        case compression_type::current_other_other_tracker: return 0b00100110;
+        case compression_type::current_other_digipeater: return 0b00100111;
+
+        case compression_type::current_gll_compressed: return 0b00101000;
+        case compression_type::current_gll_tnc_b_text: return 0b00101001;
+        case compression_type::current_gll_software: return 0b00101010;
+        case compression_type::current_gll_tbd_1: return 0b00101011;
+        case compression_type::current_gll_kpc3: return 0b00101100;
+        case compression_type::current_gll_pico: return 0b00101101;
+        case compression_type::current_gll_other_tracker: return 0b00101110;
+        case compression_type::current_gll_digipeater: return 0b00101111;
+
+        case compression_type::current_gga_compressed: return 0b00110000;
+        case compression_type::current_gga_tnc_b_text: return 0b00110001;
+        case compression_type::current_gga_software: return 0b00110010;
+        case compression_type::current_gga_tbd_1: return 0b00110011;
+        case compression_type::current_gga_kpc3: return 0b00110100;
+        case compression_type::current_gga_pico: return 0b00110101;
+        case compression_type::current_gga_other_tracker: return 0b00110110;
+        case compression_type::current_gga_digipeater: return 0b00110111;
+
+        case compression_type::current_rmc_compressed: return 0b00111000;
+        case compression_type::current_rmc_tnc_b_text: return 0b00111001;
+        case compression_type::current_rmc_software: return 0b00111010;
+        case compression_type::current_rmc_tbd_1: return 0b00111011;
+        case compression_type::current_rmc_kpc3: return 0b00111100;
+        case compression_type::current_rmc_pico: return 0b00111101;
+        case compression_type::current_rmc_other_tracker: return 0b00111110;
+        case compression_type::current_rmc_digipeater: return 0b00111111;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// position compressed with timestamp                               //
+//                                                                  //
+// **************************************************************** //
+
+size_t encode_position_data_compressed_with_timestamp(char type, char timestamp_format, int t1, int t2, int t3, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, char* out, size_t out_size);
+size_t encode_position_packet_compressed_with_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, char timestamp_format, int t1, int t2, int t3, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, char* out, size_t out_size);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE size_t encode_position_data_compressed_with_timestamp(char type, char timestamp_format, int t1, int t2, int t3, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, char* out, size_t out_size)
+{
+    //
+    //  Data Format:
+    //
+    //     /   Time   Sym     Comp Lat    Comp Lon     Sym Code   Compressed Course/Speed  CompType  Comment
+    //     @
+    //    -----------------------------------------------------------------------------------------------------
+    //     1     7     1          4           4            1                  2                1       0-40
+    //
+    //  Examples:
+    //
+    //    @092345z/5L!!<*e7>{?!
+    //    /092345h/5L!!<*e7>{?!
+    //
+    //  The timestamp format is '/' for local DHM, 'z' for UTC DHM, or 'h' for UTC HMS
+    //
+    //  Writes into the caller buffer, returns the number of characters written,
+    //  or 0 if the buffer is too small, the buffer is not null terminated
+    //
+
+    if (out_size < 21)
+    {
+        return 0;
+    }
+
+    char* p = out;
+
+    *p++ = type;
+
+    p += write_timestamp(timestamp_format, t1, t2, t3, p);
+
+    *p++ = symbol_table;
+
+    p += write_compressed_lat(lat, p);
+    p += write_compressed_lon(lon, p);
+
+    *p++ = symbol_code;
+
+    p += write_compressed_course_speed(course_degrees, speed_knots, p);
+
+    *p++ = static_cast<char>(compression_type);
+
+    return static_cast<size_t>(p - out);
+}
+
+APRS_TRACK_INLINE size_t encode_position_packet_compressed_with_timestamp_no_message(std::string_view from, std::string_view to, std::string_view path, bool messaging, char timestamp_format, int t1, int t2, int t3, double lat, double lon, char symbol_table, char symbol_code, double course_degrees, double speed_knots, unsigned char compression_type, char* out, size_t out_size)
+{
+    size_t header_size = encode_header(from, to, path, out, out_size);
+
+    if (header_size == 0)
+    {
+        return 0;
+    }
+
+    size_t data_size = encode_position_data_compressed_with_timestamp(packet_type_with_timestamp(messaging), timestamp_format, t1, t2, t3, lat, lon, symbol_table, symbol_code, course_degrees, speed_knots, compression_type, out + header_size, out_size - header_size);
+
+    if (data_size == 0)
+    {
+        return 0;
+    }
+
+    return header_size + data_size;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// mic-e                                                            //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_mic_e_data(char type, double lat, double lon, double course_degrees, double speed_knots, char symbol_table, char symbol_code);
+string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity);
+string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity, double alt_feet);
+void add_mic_e_position_ambiguity(string_t& destination_address, int ambiguity);
+void encode_mic_e_status(int a, int b, int c, bool custom, string_t& destination_address);
+void encode_mic_e_lat_direction(char direction, string_t& destination_address);
+void encode_mic_lon_offset(bool offset, string_t& destination_address);
+void encode_mic_lon_direction(char direction, string_t& destination_address);
+std::tuple<int, int, int, bool> encode_mic_e_status(mic_e_status status);
+void encode_mic_e_status(mic_e_status status, string_t& destination_address);
+string_t encode_mic_e_lat(double lat);
+string_t encode_mic_e_lat(double lat, mic_e_status status);
+string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity);
+#ifdef APRS_TRACK_PMR
+string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity, std::pmr::memory_resource* resource);
+#endif
+char encode_mic_e_lon_degrees(int lon_d);
+char encode_mic_e_lon_minutes(int lon_m);
+char encode_mic_e_lon_hundred_minutes(int lon_h);
+string_t encode_mic_e_lon(double lon);
+string_t encode_mic_e_course_speed(double course_degrees, double speed_knots);
+string_t encode_mic_e_course_speed_alternate(double course_degrees, double speed_knots);
+string_t encode_mic_e_alt(double alt_meters);
+string_t encode_mic_e_alt_feet(double alt_feet);
+std::tuple<int, int, int> quantize_mic_e_lat(double lat);
+std::tuple<int, int, int> quantize_mic_e_lon(double lon);
+int quantize_mic_e_course_speed(double value);
+int quantize_mic_e_alt(double alt_meters);
+int quantize_mic_e_alt_feet(double alt_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE double round_number(double number)
+{
+    double factor = 10.0;
+    return std::round(number * factor) / factor;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_data(char type, double lat, double lon, double course_degrees, double speed_knots, char symbol_table, char symbol_code)
+{
+    (void)lat;
+
+    string_t data;
+
+    data.append(1, type);
+
+    data.append(encode_mic_e_lon(lon));
+    data.append(encode_mic_e_course_speed(course_degrees, speed_knots));
+
+    data.append(1, symbol_code);
+    data.append(1, symbol_table);
+
+    return data;
+}
+
+// support type... first character
+// 
+
+APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity)
+{
+    string_t packet;
+
+    string_t lat_str = encode_mic_e_lat(lat, lon, status, ambiguity);
+
+    packet.append(encode_header(from, lat_str.data(), path));
+
+    packet.append(encode_mic_e_data('`', lat, lon, course_degrees, speed_knots, symbol_table, symbol_code));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_packet_no_message(std::string_view from, std::string_view path, double lat, double lon, mic_e_status status, double course_degrees, double speed_knots, char symbol_table, char symbol_code, int ambiguity, double alt_feet)
+{
+    string_t packet;
+
+    packet.append(encode_mic_e_packet_no_message(from, path, lat, lon, status, course_degrees, speed_knots, symbol_table, symbol_code, ambiguity));
+
+    packet.append(encode_mic_e_alt_feet(alt_feet));
+
+    return packet;
+}
+
+APRS_TRACK_INLINE void add_mic_e_position_ambiguity(string_t& destination_address, int ambiguity)
+{
+    if (!(ambiguity > 0))
+    {
+        return;
+    }
+
+    for (size_t i = destination_address.size() - 1, count = 0; count < static_cast<size_t>(ambiguity) && i < destination_address.size(); i--, count++)
+    {
+        if (destination_address[i] >= 'P' && destination_address[i] <= 'Y')
+        {
+            destination_address[i] = 'Z';
+        }
+        else if (destination_address[i] >= '0' && destination_address[i] <= '9')
+        {
+            destination_address[i] = 'L';
+        }
+        else if (destination_address[i] >= 'A' && destination_address[i] <= 'J')
+        {
+            destination_address[i] = 'K';
+        }
+    }
+}
+
+APRS_TRACK_INLINE void insert_mic_e_type(string_t& data, std::string_view type)
+{
+    assert(data.size() >= 9);
+    data.insert(9, type.data());
+}
+
+APRS_TRACK_INLINE void append_mic_e_manufacturer(string_t& packet_or_data, std::string_view manufacturer_version)
+{
+    assert(manufacturer_version.size() >= 1);
+    packet_or_data.append(manufacturer_version.data(), manufacturer_version.size());
+}
+
+APRS_TRACK_INLINE void encode_mic_e_status(int a, int b, int c, bool custom, string_t& destination_address)
+{
+    int message_bits[3] = {a, b, c};
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        // this handling is not necessary due to how the
+        // lat ambiguity is applied later, but it is useful in testing
+        if (destination_address[i] == ' ')
+        {
+            if (message_bits[i] == 1 && custom)
+            {
+                destination_address[i] = 'K';
+            }
+            else if (message_bits[i] == 1 && !custom)
+            {
+                destination_address[i] = 'Z';
+            }
+            else if (message_bits[i] == 0)
+            {
+                destination_address[i] = 'L';
+            }
+            continue;
+        }
+
+        if (message_bits[i] == 1 && custom)
+        {
+            destination_address[i] = 'A' + (destination_address[i] - '0');
+        }
+        else if (message_bits[i] == 1 && !custom)
+        {
+            destination_address[i] = 'P' + (destination_address[i] - '0');
+        }
+    }
+}
+
+APRS_TRACK_INLINE void encode_mic_e_lat_direction(char direction, string_t& destination_address)
+{
+    // this handling is not necessary due to how the
+    // lat ambiguity is applied later, but it is useful in testing
+    if (destination_address[3] == ' ')
+    {
+        if (direction == 'N')
+        {
+            destination_address[3] = 'Z';
+        }
+        else if (direction == 'S')
+        {
+            destination_address[3] = 'L';
+        }
+        return;
+    }
+
+    if (direction == 'N')
+    {
+        destination_address[3] = destination_address[3] = 'P' + (destination_address[3] - '0');
+    }
+}
+
+APRS_TRACK_INLINE void encode_mic_lon_offset(bool offset, string_t& destination_address)
+{
+    // this handling is not necessary due to how the
+    // lat ambiguity is applied later, but it is useful in testing
+    if (destination_address[4] == ' ')
+    {
+        if (offset)
+        {
+            destination_address[4] = 'Z';
+        }
+        else
+        {
+            destination_address[4] = 'L';
+        }
+        return;
+    }
+
+    if (offset)
+    {
+        destination_address[4] = destination_address[4] = 'P' + (destination_address[4] - '0');
+    }
+}
+
+APRS_TRACK_INLINE void encode_mic_lon_direction(char direction, string_t& destination_address)
+{
+    // this handling is not necessary due to how the
+    // lat ambiguity is applied later, but it is useful in testing
+    if (destination_address[5] == ' ')
+    {
+        if (direction == 'W')
+        {
+            destination_address[5] = 'Z';
+        }
+        else if (direction == 'E')
+        {
+            destination_address[5] = 'L';
+        }
+        return;
+    }
+
+    if (direction == 'W')
+    {
+        destination_address[5] = destination_address[5] = 'P' + (destination_address[5] - '0');
+    }
+}
+
+APRS_TRACK_INLINE std::tuple<int, int, int, bool> encode_mic_e_status(mic_e_status status)
+{
+    int a = 0;
+    int b = 0;
+    int c = 0;
+    bool custom = false;
+
+    //  MIC-E Status Encoding Truth Table
+    //  --------------------------------
+    //  Status         Custom  a b c
+    //  --------------------------------
+    //  off_duty        0      1 1 1
+    //  en_route        0      1 1 0
+    //  in_service      0      1 0 1
+    //  returning       0      1 0 0
+    //  committed       0      0 1 1
+    //  special         0      0 1 0
+    //  priority        0      0 0 1
+    //  emergency       0      0 0 0
+    //  custom0         1      1 1 1
+    //  custom1         1      1 1 0
+    //  custom2         1      1 0 1
+    //  custom3         1      1 0 0
+    //  custom4         1      0 1 1
+    //  custom5         1      0 1 0
+    //  custom6         1      0 0 1
+    //  --------------------------------
+
+    switch (status)
+    {
+    case mic_e_status::off_duty:
+        a = 1;
+        b = 1;
+        c = 1;
+        break;
+    case mic_e_status::en_route:
+        a = 1;
+        b = 1;
+        c = 0;
+        break;
+    case mic_e_status::in_service:
+        a = 1;
+        b = 0;
+        c = 1;
+        break;
+    case mic_e_status::returning:
+        a = 1;
+        b = 0;
+        c = 0;
+        break;
+    case mic_e_status::commited:
+        a = 0;
+        b = 1;
+        c = 1;
+        break;
+    case mic_e_status::special:
+        a = 0;
+        b = 1;
+        c = 0;
+        break;
+    case mic_e_status::priority:
+        a = 0;
+        b = 0;
+        c = 1;
+        break;
+    case mic_e_status::emergency:
+        a = 0;
+        b = 0;
+        c = 0;
+        break;
+    case mic_e_status::custom0:
+        a = 1;
+        b = 1;
+        c = 1;
+        custom = true;
+        break;
+    case mic_e_status::custom1:
+        a = 1;
+        b = 1;
+        c = 0;
+        custom = true;
+        break;
+    case mic_e_status::custom2:
+        a = 1;
+        b = 0;
+        c = 1;
+        custom = true;
+        break;
+    case mic_e_status::custom3:
+        a = 1;
+        b = 0;
+        c = 0;
+        custom = true;
+        break;
+    case mic_e_status::custom4:
+        a = 0;
+        b = 1;
+        c = 1;
+        custom = true;
+        break;
+    case mic_e_status::custom5:
+        a = 0;
+        b = 1;
+        c = 0;
+        custom = true;
+        break;
+    case mic_e_status::custom6:
+        a = 0;
+        b = 0;
+        c = 1;
+        custom = true;
+        break;
+    default:
+        break;
+    }
+
+    return std::make_tuple(a, b, c, custom);
+}
+
+APRS_TRACK_INLINE void encode_mic_e_status(mic_e_status status, string_t& destination_address)
+{
+    int a = 0;
+    int b = 0;
+    int c = 0;
+    bool custom = false;
+
+    std::tie(a, b, c, custom) = encode_mic_e_status(status);
+
+    encode_mic_e_status(a, b, c, custom, destination_address);
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat)
+{
+    // Converts decimal degrees coordinates to mic-e position format:
+    //
+    // 1. Latitude/Longitude Degree Extraction:
+    //    - For a coordinate like 33.4273°, extracts the whole degrees (33°)
+    //    - Uses integer truncation to remove the decimal portion from the absolute value
+    //
+    // 2. Minutes Conversion:
+    //    - Takes the decimal portion (0.4273) and converts to minutes:
+    //      * Subtracts whole degrees: 33.4273° - 33° = 0.4273°
+    //      * Multiplies by 60 to get minutes: 0.4273° × 60 = 25.638 minutes
+    //    
+    // 3. Minutes Separation:
+    //    - Uses modf() to split minutes into whole and decimal parts:
+    //      * Whole minutes: 25
+    //      * Decimal minutes: 0.638
+    //    - Multiplies decimal by 100 to get hundredths: 0.638 × 100 = 63.8
+    //
+    // Final Format: DDMMHH (Degrees, Minutes, Hundredths of minutes)  
+    // Example: 33° 25.638' becomes 332563
+    //
+    // This format matches the mic-e position specification which uses
+    // degrees and decimal minutes rather than decimal degrees
+
+    auto [lat_d, lat_m, lat_h] = quantize_mic_e_lat(lat);
+
+    // Resulting coordinates stored as: 33° 25.638' -> 332563
+
+    char buffer[7];
+    std::snprintf(buffer, sizeof(buffer), "%02d%02d%02d", lat_d, lat_m, lat_h);
+
+    string_t lat_str(buffer);
+
+    return lat_str;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat, mic_e_status status)
+{
+    char direction = (lat >= 0.0) ? 'N' : 'S';
+
+    string_t lat_str = encode_mic_e_lat(lat);
+
+    encode_mic_e_status(status, lat_str);
+    encode_mic_e_lat_direction(direction, lat_str);
+
+    return lat_str;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity)
+{
+    string_t lat_str = encode_mic_e_lat(lat, status);
+
+    double lon_abs = std::fabs(lon);
+    int lon_d = static_cast<int>(lon_abs);
+    bool lon_offset = ((lon_d >= 0 && lon_d <= 9) || lon_d >= 100) ? true : false;
+
+    char lon_direction = lon < 0.0 ? 'W' : 'E';
+
+    encode_mic_lon_offset(lon_offset, lat_str);
+    encode_mic_lon_direction(lon_direction, lat_str);
+
+    add_mic_e_position_ambiguity(lat_str, ambiguity);
+
+    return lat_str;
+}
+
+#ifdef APRS_TRACK_PMR
+
+APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity, std::pmr::memory_resource* resource)
+{
+    memory_resource_scope scope(resource);
+    return encode_mic_e_lat(lat, lon, status, ambiguity);
+}
+
+#endif // APRS_TRACK_PMR
+
+APRS_TRACK_INLINE char encode_mic_e_lon_degrees(int lon_d)
+{
+    int result = 0;
+
+    if (lon_d >= 0 && lon_d <= 9)
+    {
+        result = lon_d + 118;
+    }
+    else if (lon_d >= 10 && lon_d <= 99)
+    {
+        result = lon_d + 28;
+    }
+    else if (lon_d >= 100 && lon_d <= 109)
+    {
+        result = lon_d + 8;
+    }
+    else if (lon_d >= 110 && lon_d <= 179)
+    {
+        result = lon_d - 100 + 28;
+    }
+
+    return static_cast<char>(result);
+}
+
+APRS_TRACK_INLINE char encode_mic_e_lon_minutes(int lon_m)
+{
+    int result = 0;
+
+    if (lon_m >= 0 && lon_m <= 9)
+    {
+        result = lon_m + 88;
+    }
+    else if (lon_m >= 10 && lon_m <= 59)
+    {
+        result = lon_m + 28;
+    }
+
+    return static_cast<char>(result);
+}
+
+APRS_TRACK_INLINE char encode_mic_e_lon_hundred_minutes(int lon_h)
+{
+    int result = 0;
+
+    if (lon_h >= 0 && lon_h <= 99)
+    {
+        result = lon_h + 28;
+    }
+
+    return static_cast<char>(result);
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_lon(double lon)
+{
+    // Similar implementation to latitude encoding, but with additional
+    // table lookups for the longitude degrees, minutes, and hundredths
+    // 
+    // Converts decimal degrees coordinates to mic-e position format:
+    //
+    // 1. Latitude/Longitude Degree Extraction:
+    //    - For a coordinate like 33.4273°, extracts the whole degrees (33°)
+    //    - Uses integer truncation to remove the decimal portion from the absolute value
+    //
+    // 2. Minutes Conversion:
+    //    - Takes the decimal portion (0.4273) and converts to minutes:
+    //      * Subtracts whole degrees: 33.4273° - 33° = 0.4273°
+    //      * Multiplies by 60 to get minutes: 0.4273° × 60 = 25.638 minutes
+    //    
+    // 3. Minutes Separation:
+    //    - Uses modf() to split minutes into whole and decimal parts:
+    //      * Whole minutes: 25
+    //      * Decimal minutes: 0.638
+    //    - Multiplies decimal by 100 to get hundredths: 0.638 × 100 = 63.8
+
+    string_t lon_str;
+
+    auto [lon_d, lon_m, lon_h] = quantize_mic_e_lon(lon);
+
+    lon_str.append(1, encode_mic_e_lon_degrees(lon_d));
+    lon_str.append(1, encode_mic_e_lon_minutes(lon_m));
+    lon_str.append(1, encode_mic_e_lon_hundred_minutes(lon_h));
+
+    return lon_str;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_course_speed(double course_degrees, double speed_knots)
+{
+    string_t course_speed;
+
+    int course = quantize_mic_e_course_speed(course_degrees);
+    int speed = quantize_mic_e_course_speed(speed_knots);
+
+    int sp = (speed / 10) + 'l'; // or + 28
+    int se = (course % 100) + 28;
+
+    int dc = 0;
+
+    if (course >= 0 && course <= 99)
+    {
+        dc = ' '; // or 28
+    }
+    else if (course >= 100 && course <= 199)
+    {
+        dc = '!'; // or 29
+    }
+    else if (course >= 200 && course <= 299)
+    {
+        dc = '"'; // or 30
+    }
+    else if (course >= 300 && course <= 360)
+    {
+        dc = '#'; // or 31
+    }
+
+    int speed_units = speed % 10;
+
+    if (speed_units > 0)
+    {
+        dc = dc + speed_units * 10;
+    }
+
+    course_speed.append(1, static_cast<char>(sp));
+    course_speed.append(1, static_cast<char>(dc));
+    course_speed.append(1, static_cast<char>(se));
+
+    return course_speed;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_course_speed_alternate(double course_degrees, double speed_knots)
+{
+    string_t course_speed;
+
+    int course = static_cast<int>(std::round(course_degrees));
+    int speed = static_cast<int>(std::round(speed_knots));
+
+    int sp = (speed / 10) + 28; // or  l
+    int se = (course % 100) + 28;
+
+    int dc = 0;
+
+    if (course >= 0 && course <= 99)
+    {
+        dc = 28; // or ' '
+    }
+    else if (course >= 100 && course <= 199)
+    {
+        dc = 29; // or !
+    }
+    else if (course >= 200 && course <= 299)
+    {
+        dc = 30; // or "
+    }
+    else if (course >= 300 && course <= 360)
+    {
+        dc = 31; // or #
+    }
+
+    int speed_units = speed % 10;
+
+    if (speed_units > 0)
+    {
+        dc = dc + speed_units * 10;
+    }
+
+    course_speed.append(1, static_cast<char>(sp));
+    course_speed.append(1, static_cast<char>(dc));
+    course_speed.append(1, static_cast<char>(se));
+
+    return course_speed;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_alt(double alt_meters)
+{
+    // Encoded altitude in mic-e format
+    //
+    //   xxx}
+    //
+    // Example:
+    //
+    //   altitude = 59.06 feet = 18 meters
+    //   relative altitude = 18 + 10000 = 10018
+    //                       ~~
+    //   base-91 encoding: 10018 = 1*91² + 19*91 + 8
+    //                             ~       ~~      ~
+    //   ASCII characters: 1+33=34 '"', 19+33=52 '4', 8 + 33=41 ')'
+    //                     ~            ~~            ~
+    //   result: "4)}
+
+    string_t alt_str(4, '\0');
+
+    int alt_meters_int = quantize_mic_e_alt(alt_meters);
+    int relative_alt = alt_meters_int + 10000;
+
+    int v0 = relative_alt / (91 * 91);
+    int r = relative_alt % (91 * 91);
+    int v1 = r / 91;
+    int v2 = r % 91;
+
+    alt_str[0] = static_cast<char>(v0 + 33);
+    alt_str[1] = static_cast<char>(v1 + 33);
+    alt_str[2] = static_cast<char>(v2 + 33);
+    alt_str[3] = '}';
+
+    return alt_str;
+}
+
+APRS_TRACK_INLINE string_t encode_mic_e_alt_feet(double alt_feet)
+{
+    return encode_mic_e_alt(quantize_mic_e_alt_feet(alt_feet));
+}
+
+APRS_TRACK_INLINE std::tuple<int, int, int> quantize_mic_e_lat(double lat)
+{
+    // Degrees, minutes and hundredths of minutes, as encoded in the destination address
+
+    double lat_abs = std::fabs(lat);
+
+    int lat_d = static_cast<int>(lat_abs);
+
+    double lat_m = (lat_abs - lat_d) * 60.0;
+    double lat_m_f = 0.0;
+    double lat_m_i = std::modf(lat_m, &lat_m_f) * 100.0;
+    lat_m_i = std::round(lat_m_i);
+
+    return std::make_tuple(lat_d, static_cast<int>(lat_m_f), static_cast<int>(lat_m_i));
+}
+
+APRS_TRACK_INLINE std::tuple<int, int, int> quantize_mic_e_lon(double lon)
+{
+    // Degrees, minutes and hundredths of minutes, the hundredths are truncated
+    // after rounding to a tenth, unlike the latitude
+
+    double lon_abs = std::fabs(lon);
+
+    int lon_d = static_cast<int>(lon_abs);
+
+    double lon_m = (lon_abs - lon_d) * 60.0;
+    double lon_m_f = 0.0;
+    double lon_m_i = std::modf(lon_m, &lon_m_f) * 100.0;
+    lon_m_i = round_number(lon_m_i);
+
+    return std::make_tuple(lon_d, static_cast<int>(lon_m), static_cast<int>(lon_m_i));
+}
+
+APRS_TRACK_INLINE int quantize_mic_e_course_speed(double value)
+{
+    return static_cast<int>(round_number(value));
+}
+
+APRS_TRACK_INLINE int quantize_mic_e_alt(double alt_meters)
+{
+    return static_cast<int>(std::round(alt_meters));
+}
+
+APRS_TRACK_INLINE int quantize_mic_e_alt_feet(double alt_feet)
+{
+    return quantize_mic_e_alt(alt_feet * 0.3048);
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+//  common data extensions                                          //
+//                                                                  //
+// **************************************************************** //
+
+string_t encode_course_speed(double course_degrees, double speed_knots);
+string_t encode_altitude(double alt_feet);
+size_t write_altitude(double alt_feet, char* out, size_t out_size);
+int quantize_course_speed(double value);
+int quantize_altitude(double alt_feet);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE string_t encode_course_speed(double course_degrees, double speed_knots)
+{
+    // 
+    //  Data Format:
+    // 
+    //    Course / Speed
+    //    --------------
+    //      3    1   3   
+    //
+    //  Example:
+    //
+    //    088/036 - a course 88 degrees, traveling at 36 knots
+    //    000/000 - the course is unknown
+    //       /    - the course is unknown
+    //
+    //  Course is expressed in degrees 001 to 360, clockwise from due north
+    //
+
+    int course_degrees_int = quantize_course_speed(course_degrees);
+    int speed_knots_int = quantize_course_speed(speed_knots);
+
+    string_t course_speed;
+    course_speed.append(format_n_digits_string(course_degrees_int, 3));
+    course_speed.append("/");
+    course_speed.append(format_n_digits_string(speed_knots_int, 3));
+    return course_speed;
+}
+
+APRS_TRACK_INLINE string_t encode_altitude(double alt_feet)
+{
+    //
+    //  Data Format:
+    //
+    //    /A=aaaaaa
+    //    ----------
+    //     3   6
+    //
+    //  Example:
+    //
+    //    /A=001234 - an altitude of 1234 feet
+    //    /A=123456 - the altitude is 123456 feet
+    //
+    //  Altitude is expressed in feet above sea level
+    //
+
+    int alt_feet_int = quantize_altitude(alt_feet);
+
+    string_t altitude;
+    altitude.append("/A=");
+    altitude.append(format_n_digits_string(alt_feet_int, 6));
+    return altitude;
+}
+
+APRS_TRACK_INLINE size_t write_altitude(double alt_feet, char* out, size_t out_size)
+{
+    // Same as encode_altitude, writing into the caller buffer
+    // Returns the number of characters written, or 0 if the buffer is too small
+
+    char buffer[32];
+
+    int size = std::snprintf(buffer, sizeof(buffer), "/A=%06d", quantize_altitude(alt_feet));
+
+    if (size <= 0 || static_cast<size_t>(size) > out_size)
+    {
+        return 0;
+    }
+
+    std::copy(buffer, buffer + size, out);
+
+    return static_cast<size_t>(size);
+}
+
+APRS_TRACK_INLINE int quantize_course_speed(double value)
+{
+    return static_cast<int>(std::round(value));
+}
+
+APRS_TRACK_INLINE int quantize_altitude(double alt_feet)
+{
+    return static_cast<int>(std::round(alt_feet));
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// ax.25 frame and airtime                                          //
+//                                                                  //
+// **************************************************************** //
+
+struct fcs_table
+{
+    uint16_t values[256] = {};
+};
+
+uint16_t compute_fcs(const unsigned char* data, size_t size);
+size_t encode_ax25_address(std::string_view address, bool destination, bool last, unsigned char* output);
+size_t encode_ax25_frame(std::string_view packet, unsigned char* output, size_t output_size);
+size_t hdlc_bit_count(const unsigned char* data, size_t size);
+packet_airtime estimate_airtime(std::string_view packet, int baud_rate);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE uint16_t compute_fcs(const unsigned char* data, size_t size)
+{
+    // CRC-16/X.25, the AX.25 frame check sequence
+    //
+    // Polynomial x^16 + x^12 + x^5 + 1, bit reversed 0x8408, initial value 0xFFFF
+    // and inverted result, transmitted least significant byte first
+    //
+    // Example:
+    //
+    //   compute_fcs("123456789") -> 0x906E
+
+    return static_cast<uint16_t>(~fcs_register(0xFFFF, data, size));
+}
+
+constexpr fcs_table make_fcs_table()
+{
+    fcs_table table;
+
+    for (int i = 0; i < 256; i++)
+    {
+        uint16_t crc = static_cast<uint16_t>(i);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0x8408) : static_cast<uint16_t>(crc >> 1);
+        }
+        table.values[i] = crc;
+    }
+
+    return table;
+}
+
+APRS_TRACK_INLINE uint16_t fcs_register(uint16_t crc, const unsigned char* data, size_t size)
+{
+    // The CRC-16/X.25 register after the data, a byte at a time,
+    // compute_fcs without the initial value and the inversion
+
+    static constexpr fcs_table table = make_fcs_table();
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = static_cast<uint16_t>((crc >> 8) ^ table.values[(crc ^ data[i]) & 0xFF]);
+    }
+
+    return crc;
+}
+
+APRS_TRACK_INLINE size_t encode_ax25_address(std::string_view address, bool destination, bool last, unsigned char* output)
+{
+    // Encodes a TNC2 address like N0CALL-9 or WIDE1-1* as a 7 byte AX.25 address
+    //
+    //   N0CALL-9 -> 'N'<<1 '0'<<1 'C'<<1 'A'<<1 'L'<<1 'L'<<1 0b0CRSSSSE
+    //
+    //   C - command bit, set on the destination address
+    //       or the has-been-repeated bit, set on repeated digipeaters
+    //   R - reserved bits, always set
+    //   S - the 4 bit SSID
+    //   E - set on the last address of the address field
+    //
+    // Returns 7, or 0 if the address cannot be represented in AX.25
+
+    bool repeated = false;
+
+    if (!address.empty() && address.back() == '*')
+    {
+        repeated = true;
+        address.remove_suffix(1);
+    }
+
+    size_t dash = address.find('-');
+    std::string_view call = address.substr(0, dash);
+
+    if (call.empty() || call.size() > 6)
+    {
+        return 0;
+    }
+
+    int ssid = 0;
+
+    if (dash != std::string_view::npos)
+    {
+        std::string_view ssid_str = address.substr(dash + 1);
+        if (ssid_str.empty() || ssid_str.size() > 2)
+        {
+            return 0;
+        }
+        for (char c : ssid_str)
+        {
+            if (c < '0' || c > '9')
+            {
+                return 0;
+            }
+            ssid = ssid * 10 + (c - '0');
+        }
+        if (ssid > 15)
+        {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        char c = i < call.size() ? call[i] : ' ';
+        output[i] = static_cast<unsigned char>(static_cast<unsigned char>(c) << 1);
+    }
+
+    unsigned char ssid_byte = static_cast<unsigned char>(0b01100000 | (ssid << 1));
+
+    if (destination || repeated)
+    {
+        ssid_byte |= 0b10000000;
+    }
+
+    if (last)
+    {
+        ssid_byte |= 0b00000001;
+    }
+
+    output[6] = ssid_byte;
+
+    return 7;
+}
+
+APRS_TRACK_INLINE size_t encode_ax25_frame(std::string_view packet, unsigned char* output, size_t output_size)
+{
+    // Encodes a TNC2 packet as an AX.25 UI frame, without the HDLC flags
+    //
+    // Example:
+    //
+    //   N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-
+    //
+    //   APRS    N0CALL  WIDE1-1  0x03     0xF0  !4903.50N/07201.75W-  FCS
+    //   ~~~~~~~ ~~~~~~~ ~~~~~~~  ~~~~~~~  ~~~~  ~~~~~~~~~~~~~~~~~~~~  ~~~
+    //   to      from    path     control  PID   information field     2 bytes
+    //
+    // Returns the frame size, or 0 if the packet cannot be encoded or does not fit in the output
+
+    size_t header_end = packet.find(':');
+    size_t from_end = packet.find('>');
+
+    if (header_end == std::string_view::npos || from_end == std::string_view::npos || from_end > header_end)
+    {
+        return 0;
+    }
+
+    std::string_view from = packet.substr(0, from_end);
+    std::string_view to_path = packet.substr(from_end + 1, header_end - from_end - 1);
+    std::string_view info = packet.substr(header_end + 1);
+
+    size_t to_end = to_path.find(',');
+    std::string_view to = to_path.substr(0, to_end);
+    std::string_view path = to_end == std::string_view::npos ? std::string_view() : to_path.substr(to_end + 1);
+
+    size_t path_count = 0;
+    size_t last_repeated = 0;
+
+    for (size_t start = 0; start < path.size();)
+    {
+        size_t end = path.find(',', start);
+        if (end == std::string_view::npos)
+        {
+            end = path.size();
+        }
+        path_count++;
+        if (end > start && path[end - 1] == '*')
+        {
+            last_repeated = path_count;
+        }
+        start = end + 1;
+    }
+
+    if (path_count > 8)
+    {
+        return 0;
+    }
+
+    size_t frame_size = (2 + path_count) * 7 + 2 + info.size() + 2;
+
+    if (frame_size > output_size)
+    {
+        return 0;
+    }
+
+    size_t offset = 0;
+
+    if (encode_ax25_address(to, true, false, output + offset) == 0)
+    {
+        return 0;
+    }
+    offset += 7;
+
+    if (encode_ax25_address(from, false, path_count == 0, output + offset) == 0)
+    {
+        return 0;
+    }
+    offset += 7;
+
+    size_t index = 0;
+
+    for (size_t start = 0; start < path.size();)
+    {
+        size_t end = path.find(',', start);
+        if (end == std::string_view::npos)
+        {
+            end = path.size();
+        }
+        index++;
+        if (encode_ax25_address(path.substr(start, end - start), false, index == path_count, output + offset) == 0)
+        {
+            return 0;
+        }
+        // TNC2 only marks the last repeated digipeater, all digipeaters before it were used too
+        if (index <= last_repeated)
+        {
+            output[offset + 6] |= 0b10000000;
+        }
+        offset += 7;
+        start = end + 1;
+    }
+
+    output[offset++] = 0x03; // UI frame
+    output[offset++] = 0xF0; // no layer 3 protocol
+
+    for (char c : info)
+    {
+        output[offset++] = static_cast<unsigned char>(c);
+    }
+
+    uint16_t fcs = compute_fcs(output, offset);
+
+    output[offset++] = static_cast<unsigned char>(fcs & 0xFF);
+    output[offset++] = static_cast<unsigned char>(fcs >> 8);
+
+    return offset;
+}
+
+APRS_TRACK_INLINE size_t hdlc_bit_count(const unsigned char* data, size_t size)
+{
+    // Counts the bits needed to transmit a frame with HDLC framing
+    //
+    // Bytes are sent least significant bit first, a 0 bit is stuffed after
+    // every five consecutive 1 bits, and the frame is enclosed by two 0x7E flags
+    //
+    // Example:
+    //
+    //   0xFF -> 11111 0 111, 9 bits, plus 16 flag bits = 25
+
+    size_t bits = 16;
+    int ones = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        unsigned char byte = data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            bits++;
+            if ((byte >> bit) & 1)
+            {
+                if (++ones == 5)
+                {
+                    bits++;
+                    ones = 0;
+                }
+            }
+            else
+            {
+                ones = 0;
+            }
+        }
+    }
+
+    return bits;
+}
+
+APRS_TRACK_INLINE packet_airtime estimate_airtime(std::string_view packet, int baud_rate)
+{
+    packet_airtime a;
+
+    a.packet_bytes = packet.size();
+
+    unsigned char frame[8 * 7 + 2 * 7 + 2 + 256 + 2];
+
+    size_t frame_size = encode_ax25_frame(packet, frame, sizeof(frame));
+
+    if (frame_size > 0)
+    {
+        a.frame_bytes = frame_size;
+        a.frame_bits = hdlc_bit_count(frame, frame_size);
+    }
+    else
+    {
+        // not a valid AX.25 packet, approximate the frame from the TNC2 packet
+        a.frame_bytes = packet.size() + 2 + 2;
+        a.frame_bits = a.frame_bytes * 8 + 16;
+    }
+
+    if (baud_rate > 0)
+    {
+        a.seconds = static_cast<double>(a.frame_bits) / baud_rate;
+    }
+
+    return a;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// duplicate detection                                              //
+//                                                                  //
+// **************************************************************** //
+
+void fingerprint_address(std::string_view address, unsigned char* output);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE uint64_t mix64(uint64_t value)
+{
+    // The murmur3 finalizer
+
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+APRS_TRACK_INLINE uint64_t hash_bytes(const unsigned char* data, size_t size, uint64_t seed)
+{
+    // Non cryptographic hash, 8 bytes at a time
+
+    uint64_t h = seed ^ (size * 0x9E3779B97F4A7C15ull);
+
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ mix64(word)) * 0x9E3779B97F4A7C15ull;
+        h = (h << 31) | (h >> 33);
+    }
+
+    uint64_t tail = 0;
+
+    for (size_t shift = 0; i < size; i++, shift += 8)
+    {
+        tail |= static_cast<uint64_t>(data[i]) << shift;
+    }
+
+    return mix64(h ^ mix64(tail));
+}
+
+APRS_TRACK_INLINE void fingerprint_address(std::string_view address, unsigned char* output)
+{
+    // The AX.25 form of the address, without the command, repeated and
+    // last bits, addresses which are not AX.25 addresses are hashed
+
+    std::memset(output, 0, 7);
+
+    if (encode_ax25_address(address, false, false, output) == 7)
+    {
+        output[6] &= 0b00011110;
+        return;
+    }
+
+    uint64_t h = hash_bytes(reinterpret_cast<const unsigned char*>(address.data()), address.size(), 0);
+    std::memcpy(output, &h, 7);
+    output[6] |= 1; // never the same as an AX.25 address
+}
+
+APRS_TRACK_INLINE uint64_t packet_fingerprint(std::string_view packet)
+{
+    // Fingerprint of a TNC2 packet, of the source, destination and
+    // information field, trailing spaces and line endings are ignored
+    //
+    //   N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W- -> APRS N0CALL !4903.50N/07201.75W-
+
+    size_t header_end = packet.find(':');
+    size_t from_end = packet.find('>');
+
+    if (header_end == std::string_view::npos || from_end == std::string_view::npos || from_end > header_end)
+    {
+        return hash_bytes(reinterpret_cast<const unsigned char*>(packet.data()), packet.size(), 0);
+    }
+
+    std::string_view from = packet.substr(0, from_end);
+    std::string_view to = packet.substr(from_end + 1, header_end - from_end - 1);
+    to = to.substr(0, to.find(','));
+    std::string_view info = packet.substr(header_end + 1);
+
+    while (!info.empty() && (info.back() == ' ' || info.back() == '\r' || info.back() == '\n'))
+    {
+        info.remove_suffix(1);
+    }
+
+    unsigned char addresses[14];
+    fingerprint_address(to, addresses);
+    fingerprint_address(from, addresses + 7);
+
+    uint64_t h = hash_bytes(addresses, sizeof(addresses), 0);
+
+    return hash_bytes(reinterpret_cast<const unsigned char*>(info.data()), info.size(), h);
+}
+
+APRS_TRACK_INLINE uint64_t frame_fingerprint(const unsigned char* frame, size_t size)
+{
+    // Fingerprint of an AX.25 UI frame, with the FCS and without the HDLC flags,
+    // the same as the fingerprint of the TNC2 form of the packet
+
+    size_t offset = 0;
+
+    // the addresses end with the address with the last bit set
+    while (offset + 7 <= size && offset < 70)
+    {
+        offset += 7;
+        if (frame[offset - 1] & 1)
+        {
+            break;
+        }
+    }
+
+    if (offset < 14 || (frame[offset - 1] & 1) == 0 || offset + 2 + 2 > size)
+    {
+        return hash_bytes(frame, size, 0);
+    }
+
+    unsigned char addresses[14];
+    std::memcpy(addresses, frame, 14);
+    addresses[6] &= 0b00011110;
+    addresses[13] &= 0b00011110;
+
+    const unsigned char* info = frame + offset + 2; // control and PID
+    size_t info_size = size - offset - 2 - 2; // FCS
+
+    while (info_size > 0 && (info[info_size - 1] == ' ' || info[info_size - 1] == '\r' || info[info_size - 1] == '\n'))
+    {
+        info_size--;
+    }
+
+    uint64_t h = hash_bytes(addresses, sizeof(addresses), 0);
+
+    return hash_bytes(info, info_size, h);
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// digipeater                                                       //
+//                                                                  //
+// **************************************************************** //
+
+struct fcs_shift_table
+{
+    uint16_t columns[16][16] = {}; // columns[k][i], bit i of the register after 2^k zero bytes
+};
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+constexpr uint16_t apply_fcs_operator(const uint16_t (&columns)[16], uint16_t crc)
+{
+    uint16_t result = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        result ^= static_cast<uint16_t>(columns[i] & (0 - ((crc >> i) & 1)));
+    }
+    return result;
+}
+
+constexpr fcs_shift_table make_fcs_shift_table()
+{
+    fcs_shift_table table;
+
+    for (int i = 0; i < 16; i++)
+    {
+        uint16_t crc = static_cast<uint16_t>(1 << i);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0x8408) : static_cast<uint16_t>(crc >> 1);
+        }
+        table.columns[0][i] = crc;
+    }
+
+    for (int k = 1; k < 16; k++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            table.columns[k][i] = apply_fcs_operator(table.columns[k - 1], table.columns[k - 1][i]);
+        }
+    }
+
+    return table;
+}
+
+APRS_TRACK_INLINE uint16_t fcs_shift(uint16_t crc, size_t size)
+{
+    // The register after size zero bytes, without the initial value,
+    // in one step per set bit of size rather than one per byte
+
+    static constexpr fcs_shift_table table = make_fcs_shift_table();
+
+    for (int k = 0; k < 16 && size != 0; k++, size >>= 1)
+    {
+        if (size & 1)
+        {
+            crc = apply_fcs_operator(table.columns[k], crc);
+        }
+    }
+
+    return crc;
+}
+
+APRS_TRACK_INLINE bool ax25_address_equal(const unsigned char* a, const unsigned char* b)
+{
+    // Compares the callsign and the SSID, ignoring the flag bits
+
+    return std::memcmp(a, b, 6) == 0 && (a[6] & 0b00011110) == (b[6] & 0b00011110);
+}
+
+APRS_TRACK_INLINE bool ax25_wide_hops(const unsigned char* address, int& n, int& remaining)
+{
+    // Parses WIDEn-N addresses, n is the number of hops requested,
+    // and N, the remaining hops, from the SSID
+    //
+    //   WIDE2-1 -> n = 2, remaining = 1
+
+    const char wide[] = "WIDE";
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        if ((address[i] >> 1) != wide[i])
+        {
+            return false;
+        }
+    }
+
+    char digit = static_cast<char>(address[4] >> 1);
+
+    if (digit < '1' || digit > '7' || (address[5] >> 1) != ' ')
+    {
+        return false;
+    }
+
+    n = digit - '0';
+    remaining = (address[6] >> 1) & 0x0F;
+
+    return remaining > 0;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// packet decoding                                                  //
+//                                                                  //
+// **************************************************************** //
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE bool decode_position(std::string_view s, data& d, char& symbol_table, char& symbol_code)
+{
+    // Decodes an uncompressed or a compressed position, and the course,
+    // speed and altitude which follow it
+    //
+    //   4903.50N/07201.75W-090/036/A=001234
+    //   /5L!!<*e7>7P[
+    //
+    // Spaces of position ambiguity are decoded as zeros
+
+    if (s.empty())
+    {
+        return false;
+    }
+
+    if ((s[0] >= '0' && s[0] <= '9') || s[0] == ' ')
+    {
+        if (s.size() < 19)
+        {
+            return false;
+        }
+
+        bool ok = true;
+
+        auto digits = [&](size_t offset, size_t count) {
+            int value = 0;
+            for (size_t i = offset; i < offset + count; i++)
+            {
+                char c = s[i] == ' ' ? '0' : s[i];
+                if (c < '0' || c > '9')
+                {
+                    ok = false;
+                }
+                value = value * 10 + (c - '0');
+            }
+            return value;
+        };
+
+        int lat_degrees = digits(0, 2);
+        int lat_minutes = digits(2, 2);
+        int lat_hundredths = digits(5, 2);
+        int lon_degrees = digits(9, 3);
+        int lon_minutes = digits(12, 2);
+        int lon_hundredths = digits(15, 2);
+
+        char ns = s[7];
+        char ew = s[17];
+
+        if (!ok || s[4] != '.' || s[14] != '.' || (ns != 'N' && ns != 'S') || (ew != 'E' && ew != 'W') ||
+            lat_degrees > 90 || lon_degrees > 180 || lat_minutes >= 60 || lon_minutes >= 60)
+        {
+            return false;
+        }
+
+        d.lat = (lat_degrees + (lat_minutes + lat_hundredths / 100.0) / 60.0) * (ns == 'S' ? -1.0 : 1.0);
+        d.lon = (lon_degrees + (lon_minutes + lon_hundredths / 100.0) / 60.0) * (ew == 'W' ? -1.0 : 1.0);
+
+        symbol_table = s[8];
+        symbol_code = s[18];
+
+        std::string_view rest = s.substr(19);
+
+        // ccc/sss, the course and speed in knots
+        if (rest.size() >= 7 && rest[3] == '/')
+        {
+            bool extension = true;
+            int course = 0;
+            int speed = 0;
+            for (size_t i = 0; i < 7; i++)
+            {
+                if (i == 3)
+                {
+                    continue;
+                }
+                if (rest[i] < '0' || rest[i] > '9')
+                {
+                    extension = false;
+                    break;
+                }
+                (i < 3 ? course : speed) = (i < 3 ? course : speed) * 10 + (rest[i] - '0');
+            }
+            if (extension)
+            {
+                if (course > 0 && course <= 360)
+                {
+                    d.track_degrees = course % 360;
+                }
+                d.speed_knots = speed;
+                rest.remove_prefix(7);
+            }
+        }
+
+        decode_altitude(rest, d);
+
+        return true;
+    }
+
+    if (s.size() < 13)
+    {
+        return false;
+    }
+
+    for (size_t i = 1; i < 9; i++)
+    {
+        if (s[i] < '!' || s[i] > '{')
+        {
+            return false;
+        }
+    }
+
+    auto base91 = [&](size_t offset) {
+        int64_t value = 0;
+        for (size_t i = offset; i < offset + 4; i++)
+        {
+            value = value * 91 + (s[i] - 33);
+        }
+        return value;
+    };
+
+    d.lat = 90.0 - base91(1) / 380926.0;
+    d.lon = -180.0 + base91(5) / 190463.0;
+
+    symbol_table = s[0];
+    symbol_code = s[9];
+
+    int c = s[10] - 33;
+    int v = s[11] - 33;
+    int t = s[12] - 33;
+
+    if (s[10] != ' ' && c >= 0 && c <= 90 && v >= 0 && v <= 90)
+    {
+        if ((t & 0x18) == 0x10)
+        {
+            d.alt_feet = std::pow(1.002, c * 91 + v); // from a GGA sentence
+        }
+        else if (c <= 89)
+        {
+            d.track_degrees = (c * 4) % 360;
+            d.speed_knots = std::pow(1.08, v) - 1.0;
+        }
+    }
+
+    decode_altitude(s.substr(13), d);
+
+    return true;
+}
+
+APRS_TRACK_INLINE bool decode_mic_e_position(std::string_view to, std::string_view info, data& d, char& symbol_table, char& symbol_code)
+{
+    // Decodes the latitude from the destination address, and the longitude,
+    // speed, course and altitude from the information field
+    //
+    //   T2SP0W `c.l+@&'/'"G:}
+    //
+    // 0-9, A-J and P-Y are digits, K, L and Z are ambiguous digits,
+    // P-Z in the 4th, 5th and 6th characters are north, +100 degrees longitude and west
+
+    if (to.size() < 6 || info.size() < 9)
+    {
+        return false;
+    }
+
+    int digits[6];
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        char c = to[i];
+        if (c >= '0' && c <= '9')
+        {
+            digits[i] = c - '0';
+        }
+        else if (c >= 'A' && c <= 'J')
+        {
+            digits[i] = c - 'A';
+        }
+        else if (c >= 'P' && c <= 'Y')
+        {
+            digits[i] = c - 'P';
+        }
+        else if (c == 'K' || c == 'L' || c == 'Z')
+        {
+            digits[i] = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    auto flag = [&](size_t i) { return to[i] >= 'P' && to[i] <= 'Z'; };
+
+    int lat_degrees = digits[0] * 10 + digits[1];
+    int lat_minutes = digits[2] * 10 + digits[3];
+    int lat_hundredths = digits[4] * 10 + digits[5];
+
+    int lon_degrees = static_cast<unsigned char>(info[1]) - 28;
+    int lon_minutes = static_cast<unsigned char>(info[2]) - 28;
+    int lon_hundredths = static_cast<unsigned char>(info[3]) - 28;
+
+    if (flag(4))
+    {
+        lon_degrees += 100;
+    }
+    if (lon_degrees >= 180 && lon_degrees <= 189)
+    {
+        lon_degrees -= 80;
+    }
+    else if (lon_degrees >= 190 && lon_degrees <= 199)
+    {
+        lon_degrees -= 190;
+    }
+    if (lon_minutes >= 60)
+    {
+        lon_minutes -= 60;
+    }
+
+    if (lat_degrees > 90 || lat_minutes >= 60 || lon_degrees < 0 || lon_degrees > 180 ||
+        lon_minutes < 0 || lon_minutes >= 60 || lon_hundredths < 0 || lon_hundredths > 99)
+    {
+        return false;
+    }
+
+    d.lat = (lat_degrees + (lat_minutes + lat_hundredths / 100.0) / 60.0) * (flag(3) ? 1.0 : -1.0);
+    d.lon = (lon_degrees + (lon_minutes + lon_hundredths / 100.0) / 60.0) * (flag(5) ? -1.0 : 1.0);
+
+    int sp = static_cast<unsigned char>(info[4]) - 28;
+    int dc = static_cast<unsigned char>(info[5]) - 28;
+    int se = static_cast<unsigned char>(info[6]) - 28;
+
+    if (sp >= 0 && dc >= 0 && se >= 0)
+    {
+        int speed = sp * 10 + dc / 10;
+        int course = (dc % 10) * 100 + se;
+        if (speed >= 800)
+        {
+            speed -= 800;
+        }
+        if (course >= 400)
+        {
+            course -= 400;
+        }
+        d.speed_knots = speed;
+        if (course > 0 && course <= 360)
+        {
+            d.track_degrees = course % 360;
+        }
+    }
+
+    symbol_code = info[7];
+    symbol_table = info[8];
+
+    // xxx}, the altitude in meters above -10000, in base 91, after an optional type character
+    std::string_view rest = info.substr(9);
+    size_t brace = rest.find('}');
+
+    if (brace == 3 || brace == 4)
+    {
+        int meters = 0;
+        bool valid = true;
+        for (size_t i = brace - 3; i < brace; i++)
+        {
+            if (rest[i] < '!' || rest[i] > '{')
+            {
+                valid = false;
+            }
+            meters = meters * 91 + (rest[i] - 33);
+        }
+        if (valid)
+        {
+            d.alt_feet = (meters - 10000) * 3.28084;
+        }
+    }
+
+    return true;
+}
+
+APRS_TRACK_INLINE void decode_altitude(std::string_view comment, data& d)
+{
+    // /A=001234, the altitude in feet, anywhere in the comment
+
+    size_t a = comment.find("/A=");
+
+    if (a == std::string_view::npos || comment.size() < a + 9)
+    {
+        return;
+    }
+
+    int feet = 0;
+    const char* begin = comment.data() + a + 3;
+    auto [end, ec] = std::from_chars(begin, begin + 6, feet);
+
+    if (ec == std::errc() && end == begin + 6)
+    {
+        d.alt_feet = feet;
+    }
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+#ifndef APRS_TRACK_HEAP_FREE
+
+// **************************************************************** //
+//                                                                  //
+// filter engine                                                    //
+//                                                                  //
+// **************************************************************** //
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE size_t filter_trie_child(char c)
+{
+    // A-Z, 0-9, - and any other character, lower case letters are folded
+
+    if (c >= 'a' && c <= 'z')
+    {
+        return static_cast<size_t>(c - 'a');
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        return static_cast<size_t>(c - 'A');
+    }
+    if (c >= '0' && c <= '9')
+    {
+        return static_cast<size_t>(26 + c - '0');
+    }
+    return c == '-' ? 36 : 37;
+}
+
+APRS_TRACK_INLINE void prune_filter_trie(filter_index& index, uint32_t node)
+{
+    // Frees the node, and then its ancestors, while they have no clients and no children
+
+    while (node != 0 && index.trie[node].parent != grid_npos && index.trie[node].clients.empty() && index.trie[node].child_count == 0)
+    {
+        filter_trie_node& n = index.trie[node];
+        uint32_t parent = n.parent;
+
+        index.trie[parent].children[n.child] = 0;
+        index.trie[parent].child_count--;
+
+        n = filter_trie_node();
+        n.parent = grid_npos;
+        index.free_nodes.push_back(node);
+
+        node = parent;
+    }
+}
+
+APRS_TRACK_INLINE filter_client_terms& filter_terms(filter_index& index, uint32_t client)
+{
+    if (index.clients.size() <= client)
+    {
+        index.clients.resize(client + 1);
+    }
+
+    return index.clients[client];
+}
+
+APRS_TRACK_INLINE uint64_t filter_callsign_hash(std::string_view callsign)
+{
+    // Hash of the upper case callsign
+
+    unsigned char buffer[16];
+
+    if (callsign.size() > sizeof(buffer))
+    {
+        return hash_bytes(reinterpret_cast<const unsigned char*>(callsign.data()), callsign.size(), 0);
+    }
+
+    for (size_t i = 0; i < callsign.size(); i++)
+    {
+        char c = callsign[i];
+        buffer[i] = static_cast<unsigned char>(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+    }
+
+    return hash_bytes(buffer, callsign.size(), 0);
+}
+
+APRS_TRACK_INLINE void region_cells(filter_region& r, double north, double west, double south, double east)
+{
+    // The 1 degree cells overlapped by the bounding box, west can be less
+    // than -180 and east more than 180, columns wrap around
+
+    r.row_begin = std::clamp(static_cast<int>(std::floor(south + 90.0)), 0, 179);
+    r.row_end = std::clamp(static_cast<int>(std::floor(north + 90.0)), 0, 179);
+    r.col_begin = static_cast<int>(std::floor(west + 180.0));
+    r.col_end = static_cast<int>(std::floor(east + 180.0)) + (west > east ? 360 : 0);
+
+    if (r.col_end - r.col_begin >= 360)
+    {
+        r.col_begin = 0;
+        r.col_end = 359;
+    }
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+#endif // APRS_TRACK_HEAP_FREE
+
+#if defined(APRS_TRACK_HAS_THREADS) && !defined(APRS_TRACK_HEAP_FREE)
+
+// **************************************************************** //
+//                                                                  //
+// feed decoding                                                    //
+//                                                                  //
+// **************************************************************** //
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE spsc_queue<T>::spsc_queue(size_t capacity) : slots_(std::bit_ceil((std::max)(capacity, size_t(2)))), mask_(slots_.size() - 1)
+{
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE T* spsc_queue<T>::reserve()
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size())
+    {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ == slots_.size())
+        {
+            return nullptr;
+        }
+    }
+    return &slots_[tail & mask_];
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE void spsc_queue<T>::commit()
+{
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE T* spsc_queue<T>::front()
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_)
+    {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_)
+        {
+            return nullptr;
+        }
+    }
+    return &slots_[head & mask_];
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE void spsc_queue<T>::pop()
+{
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE size_t spsc_queue<T>::size() const
+{
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+}
+
+template <typename T>
+APRS_TRACK_INLINE_NO_DISABLE size_t spsc_queue<T>::capacity() const
+{
+    return slots_.size();
+}
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE void feed_backoff(size_t& idle)
+{
+    // Spins a little, then yields, then sleeps, while a queue is empty or full
+
+    idle++;
+    if (idle < 64)
+    {
+        return;
+    }
+    if (idle < 256)
+    {
+        std::this_thread::yield();
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+APRS_TRACK_INLINE void run_feed_worker(feed_worker& w)
+{
+    // Decodes the lines of the worker until it is stopped and its queue is empty
+
+    size_t idle = 0;
+
+    while (true)
+    {
+        feed_line* line = w.input.front();
+
+        if (line == nullptr)
+        {
+            if (w.stop.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            feed_backoff(idle);
+            continue;
+        }
+
+        feed_record* r = w.output.reserve();
+
+        if (r == nullptr)
+        {
+            if (w.stop.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            feed_backoff(idle);
+            continue;
+        }
+
+        idle = 0;
+
+        decoded_packet p;
+        decode_packet(line->text, p);
+
+        r->sequence = line->sequence;
+        r->station = make_callsign_key(p.from);
+        r->kinds = p.kinds;
+        r->has_position = p.has_position;
+        r->symbol_table = p.symbol_table;
+        r->symbol_code = p.symbol_code;
+        r->fix = p.fix;
+        r->pushed = line->pushed;
+
+        w.output.commit();
+        w.input.pop();
+
+        int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - r->pushed).count();
+
+        // only this thread writes these, loads and stores are enough
+        w.lines.store(w.lines.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        w.decode_latency_ns.store(w.decode_latency_ns.load(std::memory_order_relaxed) + latency, std::memory_order_relaxed);
+        if (latency > w.max_decode_latency_ns.load(std::memory_order_relaxed))
+        {
+            w.max_decode_latency_ns.store(latency, std::memory_order_relaxed);
+        }
+        size_t depth = w.output.size();
+        if (depth > w.max_output_depth.load(std::memory_order_relaxed))
+        {
+            w.max_output_depth.store(depth, std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+#endif
+
+// **************************************************************** //
+//                                                                  //
+// packet memoization                                               //
+//                                                                  //
+// **************************************************************** //
+
+bool make_packet_cache_key(packet_type p, const data& d, packet_cache_key& key);
+unsigned int changed_packet_fields(const packet_cache_key& previous, const packet_cache_key& current);
+packet_layout make_packet_layout(packet_type p, const tracker& t, const data& d, size_t packet_size);
+bool render_packet_fields(packet_type p, const tracker& t, const data& d, const packet_layout& layout, unsigned int fields, string_t& packet);
+bool replace_packet_field(string_t& packet, const packet_field_span& span, const char* value, size_t size);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE bool make_packet_cache_key(packet_type p, const data& d, packet_cache_key& key)
+{
+    // Quantizes the fix with the same quantize_* helpers as the encoder
+    // of the packet type, so that fixes with equal keys encode to the same bytes
+    //
+    // Only the fields the packet type encodes are part of the key,
+    // the course and speed of an uncompressed packet only if both are known,
+    // and the day, hour, minute and second only as far as the timestamp has them
+    //
+    // Returns false if the packet should not be cached
+
+    constexpr unsigned int has_course_speed = 1;
+    constexpr unsigned int has_alt = 2;
+    constexpr unsigned int lat_positive = 4;
+    constexpr unsigned int lon_positive = 8;
+
+    key = packet_cache_key{};
+
+    if (d.alt_feet.has_value())
+    {
+        key.flags |= has_alt;
+    }
+
+    switch (p)
+    {
+        case packet_type::position_with_timestamp:
+        case packet_type::position_with_timestamp_utc:
+        case packet_type::position_compressed_with_timestamp:
+        case packet_type::position_compressed_with_timestamp_utc:
+            key.day = d.day;
+            key.hour = d.hour;
+            key.minute = d.minute;
+            break;
+        case packet_type::position_with_timestamp_utc_hms:
+        case packet_type::position_compressed_with_timestamp_utc_hms:
+            key.hour = d.hour;
+            key.minute = d.minute;
+            key.second = d.second;
+            break;
+        default:
+            break;
+    }
+
+    switch (p)
+    {
+        case packet_type::position:
+        case packet_type::position_with_timestamp:
+        case packet_type::position_with_timestamp_utc:
+        case packet_type::position_with_timestamp_utc_hms:
+        {
+            position_ddm ddm = dd_to_ddm(d.lat, d.lon);
+
+            key.lat = ddm.lat_d * 100000LL + quantize_ddm_minutes(ddm.lat_m);
+            key.lon = ddm.lon_d * 100000LL + quantize_ddm_minutes(ddm.lon_m);
+            key.flags |= d.lat >= 0 ? lat_positive : 0u;
+            key.flags |= d.lon >= 0 ? lon_positive : 0u;
+
+            if (d.speed_knots.has_value() && d.track_degrees.has_value())
+            {
+                key.flags |= has_course_speed;
+                key.course = quantize_course_speed(d.track_degrees.value());
+                key.speed = quantize_course_speed(d.speed_knots.value());
+            }
+
+            if (d.alt_feet.has_value())
+            {
+                key.alt = quantize_altitude(d.alt_feet.value());
+            }
+
+            return true;
+        }
+        case packet_type::position_compressed:
+        case packet_type::position_compressed_with_timestamp:
+        case packet_type::position_compressed_with_timestamp_utc:
+        case packet_type::position_compressed_with_timestamp_utc_hms:
+        {
+            key.lat = quantize_compressed_lat(d.lat);
+            key.lon = quantize_compressed_lon(d.lon);
+            key.course = quantize_compressed_course(d.track_degrees.value_or(0));
+            key.speed = quantize_compressed_speed(d.speed_knots.value_or(0));
+
+            if (d.alt_feet.has_value())
+            {
+                key.alt = quantize_altitude(d.alt_feet.value());
+            }
+
+            return true;
+        }
+        case packet_type::mic_e:
+        {
+            auto [lat_d, lat_m, lat_h] = quantize_mic_e_lat(d.lat);
+            auto [lon_d, lon_m, lon_h] = quantize_mic_e_lon(d.lon);
+
+            key.lat = lat_d * 1000000LL + lat_m * 1000LL + lat_h;
+            key.lon = lon_d * 1000000LL + lon_m * 1000LL + lon_h;
+            key.flags |= d.lat >= 0.0 ? lat_positive : 0u;
+            key.flags |= d.lon < 0.0 ? 0u : lon_positive;
+            key.course = quantize_mic_e_course_speed(d.track_degrees.value_or(0));
+            key.speed = quantize_mic_e_course_speed(d.speed_knots.value_or(0));
+
+            if (d.alt_feet.has_value())
+            {
+                key.alt = quantize_mic_e_alt_feet(d.alt_feet.value());
+            }
+
+            return true;
+        }
+        default:
+            break;
+    }
+
+    return false;
+}
+
+APRS_TRACK_INLINE unsigned int changed_packet_fields(const packet_cache_key& previous, const packet_cache_key& current)
+{
+    unsigned int fields = 0;
+
+    if (previous.lat != current.lat)
+    {
+        fields |= packet_field_lat;
+    }
+
+    if (previous.lon != current.lon)
+    {
+        fields |= packet_field_lon;
+    }
+
+    if (previous.course != current.course || previous.speed != current.speed)
+    {
+        fields |= packet_field_course_speed;
+    }
+
+    if (previous.alt != current.alt)
+    {
+        fields |= packet_field_alt;
+    }
+
+    if (previous.day != current.day || previous.hour != current.hour || previous.minute != current.minute || previous.second != current.second)
+    {
+        fields |= packet_field_time;
+    }
+
+    return fields;
+}
+
+APRS_TRACK_INLINE packet_layout make_packet_layout(packet_type p, const tracker& t, const data& d, size_t packet_size)
+{
+    // Computes the field offsets of a packet encoded from the tracker and the fix
+    //
+    //   position                   =LLLLLLLLSLLLLLLLLLC[ccc/sss][/A=aaaaaa]
+    //   position with timestamp    @TTTTTTTLLLLLLLLSLLLLLLLLLC[ccc/sss][/A=aaaaaa]
+    //   compressed                 =SLLLLLLLLCcsT[/A=aaaaaa]
+    //   compressed with timestamp  @TTTTTTTSLLLLLLLLCcsT[/A=aaaaaa]
+    //   Mic-E                      DDDDDD in the destination, `LLLcsSCS[aaa}]
+    //
+    // The layout is only valid if the offsets add up to the packet size,
+    // an encoder which produced a field of unexpected length disables in place rendering
+
+    packet_layout layout;
+
+    bool has_course_speed = d.speed_knots.has_value() && d.track_degrees.has_value();
+    bool has_alt = d.alt_feet.has_value();
+
+    size_t to_size = p == packet_type::mic_e ? 6 : t.to().size();
+    size_t header_size = t.from().size() + 1 + to_size + (t.path().empty() ? 0 : t.path().size() + 1) + 1;
+
+    size_t offset = header_size + 1; // after the data type identifier
+
+    switch (p)
+    {
+        case packet_type::position:
+        case packet_type::position_with_timestamp:
+        case packet_type::position_with_timestamp_utc:
+        case packet_type::position_with_timestamp_utc_hms:
+            if (p != packet_type::position)
+            {
+                layout.time = { offset, 7 };
+                offset += 7;
+            }
+            layout.lat = { offset, 8 };
+            offset += 8 + 1;
+            layout.lon = { offset, 9 };
+            offset += 9 + 1;
+            if (has_course_speed)
+            {
+                layout.course_speed = { offset, 7 };
+                offset += 7;
+            }
+            if (has_alt)
+            {
+                layout.alt = { offset, 9 };
+                offset += 9;
+            }
+            break;
+        case packet_type::position_compressed:
+        case packet_type::position_compressed_with_timestamp:
+        case packet_type::position_compressed_with_timestamp_utc:
+        case packet_type::position_compressed_with_timestamp_utc_hms:
+            if (p != packet_type::position_compressed)
+            {
+                layout.time = { offset, 7 };
+                offset += 7;
+            }
+            offset += 1;
+            layout.lat = { offset, 4 };
+            offset += 4;
+            layout.lon = { offset, 4 };
+            offset += 4 + 1;
+            layout.course_speed = { offset, 2 };
+            offset += 2 + 1;
+            if (has_alt)
+            {
+                layout.alt = { offset, 9 };
+                offset += 9;
+            }
+            break;
+        case packet_type::mic_e:
+            layout.destination = { t.from().size() + 1, 6 };
+            layout.lon = { offset, 3 };
+            offset += 3;
+            layout.course_speed = { offset, 3 };
+            offset += 3 + 2;
+            if (has_alt)
+            {
+                layout.alt = { offset, 4 };
+                offset += 4;
+            }
+            break;
+        default:
+            return layout;
+    }
+
+    layout.valid = offset == packet_size;
+
+    return layout;
+}
+
+APRS_TRACK_INLINE bool render_packet_fields(packet_type p, const tracker& t, const data& d, const packet_layout& layout, unsigned int fields, string_t& packet)
+{
+    // Renders the given fields in place, using the same encoders as a full encode
+    //
+    // Returns false if a field did not fit its span, the caller has to encode the full packet
+
+    bool compressed = p == packet_type::position_compressed ||
+        p == packet_type::position_compressed_with_timestamp ||
+        p == packet_type::position_compressed_with_timestamp_utc ||
+        p == packet_type::position_compressed_with_timestamp_utc_hms;
+
+    if (p == packet_type::mic_e)
+    {
+        if (fields & (packet_field_lat | packet_field_lon))
+        {
+            string_t destination = encode_mic_e_lat(d.lat, d.lon, t.mic_e_status(), t.ambiguity());
+            if (!replace_packet_field(packet, layout.destination, destination.data(), destination.size()))
+            {
+                return false;
+            }
+        }
+
+        if (fields & packet_field_lon)
+        {
+            string_t lon = encode_mic_e_lon(d.lon);
+            if (!replace_packet_field(packet, layout.lon, lon.data(), lon.size()))
+            {
+                return false;
+            }
+        }
+
+        if (fields & packet_field_course_speed)
+        {
+            string_t course_speed = encode_mic_e_course_speed(d.track_degrees.value_or(0), d.speed_knots.value_or(0));
+            if (!replace_packet_field(packet, layout.course_speed, course_speed.data(), course_speed.size()))
+            {
+                return false;
+            }
+        }
+
+        if ((fields & packet_field_alt) && d.alt_feet.has_value())
+        {
+            string_t alt = encode_mic_e_alt_feet(d.alt_feet.value());
+            if (!replace_packet_field(packet, layout.alt, alt.data(), alt.size()))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (compressed)
+    {
+        char buffer[8];
+
+        if ((fields & packet_field_time) && layout.time.size > 0)
+        {
+            char format = p == packet_type::position_compressed_with_timestamp ? '/' : (p == packet_type::position_compressed_with_timestamp_utc ? 'z' : 'h');
+            int t1 = format == 'h' ? d.hour : d.day;
+            int t2 = format == 'h' ? d.minute : d.hour;
+            int t3 = format == 'h' ? d.second : d.minute;
+            if (!replace_packet_field(packet, layout.time, buffer, write_timestamp(format, t1, t2, t3, buffer)))
+            {
+                return false;
+            }
+        }
+
+        if ((fields & packet_field_lat) && !replace_packet_field(packet, layout.lat, buffer, write_compressed_lat(d.lat, buffer)))
+        {
+            return false;
+        }
+
+        if ((fields & packet_field_lon) && !replace_packet_field(packet, layout.lon, buffer, write_compressed_lon(d.lon, buffer)))
+        {
+            return false;
+        }
+
+        if ((fields & packet_field_course_speed) && !replace_packet_field(packet, layout.course_speed, buffer, write_compressed_course_speed(d.track_degrees.value_or(0), d.speed_knots.value_or(0), buffer)))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if ((fields & packet_field_time) && layout.time.size > 0)
+        {
+            string_t time;
+            if (p == packet_type::position_with_timestamp)
+            {
+                time = encode_timestamp_dhm(d.day, d.hour, d.minute);
+            }
+            else if (p == packet_type::position_with_timestamp_utc)
+            {
+                time = encode_utc_timestamp_dhm(d.day, d.hour, d.minute);
+            }
+            else
+            {
+                time = encode_utc_timestamp_hms(d.hour, d.minute, d.second);
+            }
+            if (!replace_packet_field(packet, layout.time, time.data(), time.size()))
+            {
+                return false;
+            }
+        }
+
+        if (fields & (packet_field_lat | packet_field_lon))
+        {
+            position_ddm_string ddm = to_ddm_short_string(dd_to_ddm(d.lat, d.lon), t.ambiguity());
+            if ((fields & packet_field_lat) && !replace_packet_field(packet, layout.lat, ddm.lat.data(), ddm.lat.size()))
+            {
+                return false;
+            }
+            if ((fields & packet_field_lon) && !replace_packet_field(packet, layout.lon, ddm.lon.data(), ddm.lon.size()))
+            {
+                return false;
+            }
+        }
+
+        if ((fields & packet_field_course_speed) && layout.course_speed.size > 0)
+        {
+            string_t course_speed = encode_course_speed(d.track_degrees.value(), d.speed_knots.value());
+            if (!replace_packet_field(packet, layout.course_speed, course_speed.data(), course_speed.size()))
+            {
+                return false;
+            }
+        }
+    }
+
+    if ((fields & packet_field_alt) && layout.alt.size > 0)
+    {
+        string_t alt = encode_altitude(d.alt_feet.value());
+        if (!replace_packet_field(packet, layout.alt, alt.data(), alt.size()))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+APRS_TRACK_INLINE bool replace_packet_field(string_t& packet, const packet_field_span& span, const char* value, size_t size)
+{
+    if (size != span.size || span.offset + size > packet.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        packet[span.offset + i] = value[i];
+    }
+
+    return true;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// fixed point encoding                                             //
+//                                                                  //
+// **************************************************************** //
+
+// Encoders for targets without an FPU, every computation is done with integers
+//
+// Coordinates are in micro degrees, speed in hundredths of a knot,
+// course in degrees and altitude in feet
+//
+// The output is the same as the double encoders given the same inputs,
+// lat = lat_udeg / 1e6, speed_knots = speed_cknots / 100.0, except
+// where the double encoders are ill-conditioned: on exact rounding ties,
+// which the double arithmetic resolves either way, and on exact minute
+// boundaries in Mic-E, where the double encoders can emit 100 hundredths
+
+struct fixed_data
+{
+    int32_t lat_udeg = 0;
+    int32_t lon_udeg = 0;
+    int32_t speed_cknots = 0;
+    int32_t track_degrees = 0;
+    int32_t alt_feet = 0;
+    bool has_course_speed = false;
+    bool has_alt = false;
+};
+
+int64_t round_div(int64_t numerator, int64_t denominator);
+size_t write_n_digits(int32_t number, int width, char* out);
+size_t encode_compressed_lat_fixed(int32_t lat_udeg, char* out);
+size_t encode_compressed_lon_fixed(int32_t lon_udeg, char* out);
+size_t encode_compressed_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out);
+size_t encode_ddm_lat_fixed(int32_t lat_udeg, int ambiguity, char* out);
+size_t encode_ddm_lon_fixed(int32_t lon_udeg, char* out);
+size_t encode_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out);
+size_t encode_altitude_fixed(int32_t alt_feet, char* out);
+size_t encode_mic_e_lat_fixed(int32_t lat_udeg, int32_t lon_udeg, mic_e_status status, int ambiguity, char* out);
+size_t encode_mic_e_lon_fixed(int32_t lon_udeg, char* out);
+size_t encode_mic_e_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out);
+size_t encode_mic_e_alt_fixed(int32_t alt_feet, char* out);
+size_t encode_position_packet_no_timestamp_fixed(std::string_view from, std::string_view to, std::string_view path, bool messaging, const fixed_data& d, char symbol_table, char symbol_code, int ambiguity, char* out, size_t out_size);
+size_t encode_position_packet_compressed_no_timestamp_fixed(std::string_view from, std::string_view to, std::string_view path, bool messaging, const fixed_data& d, char symbol_table, char symbol_code, char* out, size_t out_size);
+size_t encode_mic_e_packet_fixed(std::string_view from, std::string_view path, const fixed_data& d, mic_e_status status, char symbol_table, char symbol_code, int ambiguity, char* out, size_t out_size);
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// Smallest speed, in hundredths of a knot, for each compressed speed value
+// round(log(speed + 1) / log(1.08)), generated from the double encoder
+inline constexpr int32_t compressed_speed_thresholds[] = {
+    4, 13, 22, 31, 42, 53, 65, 79, 93, 108,
+    125, 143, 162, 183, 206, 230, 257, 285, 316, 349,
+    385, 424, 465, 511, 559, 612, 669, 731, 797, 869,
+    946, 1030, 1120, 1218, 1323, 1437, 1560, 1693, 1836, 1991,
+    2158, 2339, 2534, 2745, 2972, 3218, 3483, 3770, 4079, 4414,
+    4775, 5165, 5586, 6041, 6532, 7062, 7635, 8254, 8922, 9644,
+    10423, 11265, 12174, 13156, 14217, 15362, 16599, 17935, 19378, 20936,
+    22619, 24436, 26399, 28519, 30808, 33281, 35951, 38836, 41950, 45314,
+    48947, 52871, 57109, 61686, 66628, 71967, 77732, 83958, 90683, 97946,
+};
+
+APRS_TRACK_INLINE int64_t round_div(int64_t numerator, int64_t denominator)
+{
+    // Division rounding half away from zero, like std::round, denominator > 0
+
+    if (numerator >= 0)
+    {
+        return (numerator + denominator / 2) / denominator;
+    }
+
+    return -((-numerator + denominator / 2) / denominator);
+}
+
+APRS_TRACK_INLINE size_t write_n_digits(int32_t number, int width, char* out)
+{
+    // Same output as snprintf "%0*d"
+
+    char digits[12];
+    size_t count = 0;
+
+    uint32_t value = number < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(number)) : static_cast<uint32_t>(number);
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    size_t size = 0;
+
+    if (number < 0)
+    {
+        out[size++] = '-';
+    }
+
+    while (size + count < static_cast<size_t>(width > 0 ? width : 0))
+    {
+        out[size++] = '0';
+    }
+
+    while (count > 0)
+    {
+        out[size++] = digits[--count];
+    }
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t encode_compressed_lat_fixed(int32_t lat_udeg, char* out)
+{
+    // 380926 * (90 - lat), with lat in micro degrees
+
+    int64_t num = round_div(380926LL * (90000000LL - lat_udeg), 1000000);
+
+    out[3] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[2] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[1] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[0] = static_cast<char>((num % 91) + 33);
+
+    return 4;
+}
+
+APRS_TRACK_INLINE size_t encode_compressed_lon_fixed(int32_t lon_udeg, char* out)
+{
+    // 190463 * (180 + lon), with lon in micro degrees
+
+    int64_t num = round_div(190463LL * (180000000LL + lon_udeg), 1000000);
+
+    out[3] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[2] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[1] = static_cast<char>((num % 91) + 33);
+    num /= 91;
+    out[0] = static_cast<char>((num % 91) + 33);
+
+    return 4;
+}
+
+APRS_TRACK_INLINE size_t encode_compressed_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out)
+{
+    // The speed is looked up in the threshold table instead of computing the logarithm,
+    // speeds over 979 knots are clamped
+
+    while (course_degrees >= 360)
+    {
+        course_degrees -= 360;
+    }
+
+    // the number of thresholds less than or equal to the speed
+    int s = static_cast<int>(std::upper_bound(std::begin(compressed_speed_thresholds), std::end(compressed_speed_thresholds), speed_cknots) - std::begin(compressed_speed_thresholds));
+
+    out[0] = static_cast<char>(course_degrees / 4 + 33);
+    out[1] = static_cast<char>(s + 33);
+
+    return 2;
+}
+
+APRS_TRACK_INLINE size_t encode_ddm_lat_fixed(int32_t lat_udeg, int ambiguity, char* out)
+{
+    // DDMM.mmN, same as to_ddm_short_string
+
+    uint32_t lat_abs = static_cast<uint32_t>(lat_udeg < 0 ? -static_cast<int64_t>(lat_udeg) : lat_udeg);
+
+    int32_t d = static_cast<int32_t>(lat_abs / 1000000);
+    int32_t hundredths = static_cast<int32_t>(round_div(static_cast<int64_t>(lat_abs % 1000000) * 6, 1000)); // minutes * 100
+
+    write_n_digits(d, 2, out);
+    write_n_digits(hundredths / 100, 2, out + 2);
+    out[4] = '.';
+    write_n_digits(hundredths % 100, 2, out + 5);
+    out[7] = lat_udeg >= 0 ? 'N' : 'S';
+
+    if (ambiguity > 0)
+    {
+        // same as add_position_ambiguity
+        for (size_t i = 6, count = 0; i > 0 && count < static_cast<size_t>(ambiguity); i--)
+        {
+            if (out[i] == '.')
+            {
+                continue;
+            }
+            out[i] = ' ';
+            count++;
+        }
+    }
+
+    return 8;
+}
+
+APRS_TRACK_INLINE size_t encode_ddm_lon_fixed(int32_t lon_udeg, char* out)
+{
+    // DDDMM.mmE, same as to_ddm_short_string
+
+    uint32_t lon_abs = static_cast<uint32_t>(lon_udeg < 0 ? -static_cast<int64_t>(lon_udeg) : lon_udeg);
+
+    int32_t d = static_cast<int32_t>(lon_abs / 1000000);
+    int32_t hundredths = static_cast<int32_t>(round_div(static_cast<int64_t>(lon_abs % 1000000) * 6, 1000));
+
+    write_n_digits(d, 3, out);
+    write_n_digits(hundredths / 100, 2, out + 3);
+    out[5] = '.';
+    write_n_digits(hundredths % 100, 2, out + 6);
+    out[8] = lon_udeg >= 0 ? 'E' : 'W';
+
+    return 9;
+}
+
+APRS_TRACK_INLINE size_t encode_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out)
+{
+    // ccc/sss, same as encode_course_speed
+
+    size_t size = write_n_digits(course_degrees, 3, out);
+    out[size++] = '/';
+    size += write_n_digits(static_cast<int32_t>(round_div(speed_cknots, 100)), 3, out + size);
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t encode_altitude_fixed(int32_t alt_feet, char* out)
+{
+    // /A=aaaaaa, same as encode_altitude
+
+    out[0] = '/';
+    out[1] = 'A';
+    out[2] = '=';
+
+    return 3 + write_n_digits(alt_feet, 6, out + 3);
+}
+
+APRS_TRACK_INLINE size_t encode_mic_e_lat_fixed(int32_t lat_udeg, int32_t lon_udeg, mic_e_status status, int ambiguity, char* out)
+{
+    // Same as encode_mic_e_lat(lat, lon, status, ambiguity), the digits
+    // are computed with integers and written to the output, the status,
+    // direction, longitude offset and ambiguity are then applied in place
+
+    uint32_t lat_abs = static_cast<uint32_t>(lat_udeg < 0 ? -static_cast<int64_t>(lat_udeg) : lat_udeg);
+    uint32_t lon_abs = static_cast<uint32_t>(lon_udeg < 0 ? -static_cast<int64_t>(lon_udeg) : lon_udeg);
+
+    int32_t lat_d = static_cast<int32_t>(lat_abs / 1000000);
+    int64_t minutes_100000 = static_cast<int64_t>(lat_abs % 1000000) * 6; // minutes * 100000
+    int32_t lat_m = static_cast<int32_t>(minutes_100000 / 100000);
+    int32_t lat_h = static_cast<int32_t>(round_div(minutes_100000 % 100000, 1000));
+
+    char digits[8];
+    size_t size = write_n_digits(lat_d, 2, digits);
+    size += write_n_digits(lat_m, 2, digits + size);
+    size += write_n_digits(lat_h, 2, digits + size);
+
+    // the double encoder writes into a 7 character buffer, 6 digits at most
+    size = size < 6 ? size : 6;
+    std::copy(digits, digits + size, out);
+
+    auto [a, b, c, custom] = encode_mic_e_status(status);
+    int message_bits[3] = { a, b, c };
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (message_bits[i] == 1)
+        {
+            out[i] = static_cast<char>((custom ? 'A' : 'P') + (out[i] - '0'));
+        }
+    }
+
+    int32_t lon_d = static_cast<int32_t>(lon_abs / 1000000);
+
+    if (lat_udeg >= 0)
+    {
+        out[3] = static_cast<char>('P' + (out[3] - '0'));
+    }
+
+    if ((lon_d >= 0 && lon_d <= 9) || lon_d >= 100)
+    {
+        out[4] = static_cast<char>('P' + (out[4] - '0'));
+    }
+
+    if (lon_udeg < 0)
+    {
+        out[5] = static_cast<char>('P' + (out[5] - '0'));
+    }
+
+    // same as add_mic_e_position_ambiguity
+    for (size_t i = size - 1, count = 0; ambiguity > 0 && count < static_cast<size_t>(ambiguity) && i < size; i--, count++)
+    {
+        if (out[i] >= 'P' && out[i] <= 'Y')
+        {
+            out[i] = 'Z';
+        }
+        else if (out[i] >= '0' && out[i] <= '9')
+        {
+            out[i] = 'L';
+        }
+        else if (out[i] >= 'A' && out[i] <= 'J')
+        {
+            out[i] = 'K';
+        }
+    }
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t encode_mic_e_lon_fixed(int32_t lon_udeg, char* out)
+{
+    // Same as encode_mic_e_lon, the hundredths of minutes are rounded
+    // to a tenth and truncated, as round_number does
+
+    uint32_t lon_abs = static_cast<uint32_t>(lon_udeg < 0 ? -static_cast<int64_t>(lon_udeg) : lon_udeg);
+
+    int32_t lon_d = static_cast<int32_t>(lon_abs / 1000000);
+    int64_t minutes_100000 = static_cast<int64_t>(lon_abs % 1000000) * 6;
+    int32_t lon_m = static_cast<int32_t>(minutes_100000 / 100000);
+    int32_t lon_h = static_cast<int32_t>(round_div(minutes_100000 % 100000, 100) / 10);
+
+    out[0] = encode_mic_e_lon_degrees(lon_d);
+    out[1] = encode_mic_e_lon_minutes(lon_m);
+    out[2] = encode_mic_e_lon_hundred_minutes(lon_h);
+
+    return 3;
+}
+
+APRS_TRACK_INLINE size_t encode_mic_e_course_speed_fixed(int32_t course_degrees, int32_t speed_cknots, char* out)
+{
+    // Same as encode_mic_e_course_speed, the speed is rounded to a tenth and truncated
+
+    int course = course_degrees;
+    int speed = static_cast<int>(round_div(speed_cknots, 10) / 10);
+
+    int sp = (speed / 10) + 'l';
+    int se = (course % 100) + 28;
+
+    int dc = 0;
+
+    if (course >= 0 && course <= 99)
+    {
+        dc = ' ';
+    }
+    else if (course >= 100 && course <= 199)
+    {
+        dc = '!';
+    }
+    else if (course >= 200 && course <= 299)
+    {
+        dc = '"';
+    }
+    else if (course >= 300 && course <= 360)
+    {
+        dc = '#';
+    }
+
+    int speed_units = speed % 10;
+
+    if (speed_units > 0)
+    {
+        dc = dc + speed_units * 10;
+    }
+
+    out[0] = static_cast<char>(sp);
+    out[1] = static_cast<char>(dc);
+    out[2] = static_cast<char>(se);
+
+    return 3;
+}
+
+APRS_TRACK_INLINE size_t encode_mic_e_alt_fixed(int32_t alt_feet, char* out)
+{
+    // Same as encode_mic_e_alt_feet, 1 foot is 0.3048 meters
+
+    int32_t relative_alt = static_cast<int32_t>(round_div(static_cast<int64_t>(alt_feet) * 3048, 10000)) + 10000;
+
+    out[0] = static_cast<char>(relative_alt / (91 * 91) + 33);
+    out[1] = static_cast<char>((relative_alt % (91 * 91)) / 91 + 33);
+    out[2] = static_cast<char>((relative_alt % (91 * 91)) % 91 + 33);
+    out[3] = '}';
+
+    return 4;
+}
+
+APRS_TRACK_INLINE size_t encode_position_packet_no_timestamp_fixed(std::string_view from, std::string_view to, std::string_view path, bool messaging, const fixed_data& d, char symbol_table, char symbol_code, int ambiguity, char* out, size_t out_size)
+{
+    // Same as encode_position_packet_no_timestamp_no_message(const tracker&, const data&)
+    // Returns the number of characters written, or 0 if the buffer is too small
+
+    size_t size = encode_header(from, to, path, out, out_size);
+
+    if (size == 0 || out_size - size < 1 + 8 + 1 + 9 + 1 + 7 + 12)
+    {
+        return 0;
+    }
+
+    out[size++] = packet_type_without_timestamp(messaging);
+    size += encode_ddm_lat_fixed(d.lat_udeg, ambiguity, out + size);
+    out[size++] = symbol_table;
+    size += encode_ddm_lon_fixed(d.lon_udeg, out + size);
+    out[size++] = symbol_code;
+
+    if (d.has_course_speed)
+    {
+        size += encode_course_speed_fixed(d.track_degrees, d.speed_cknots, out + size);
+    }
+
+    if (d.has_alt)
+    {
+        size += encode_altitude_fixed(d.alt_feet, out + size);
+    }
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t encode_position_packet_compressed_no_timestamp_fixed(std::string_view from, std::string_view to, std::string_view path, bool messaging, const fixed_data& d, char symbol_table, char symbol_code, char* out, size_t out_size)
+{
+    // Same as encode_position_packet_compressed_no_timestamp_no_message(const tracker&, const data&)
+    // Returns the number of characters written, or 0 if the buffer is too small
+
+    size_t size = encode_header(from, to, path, out, out_size);
+
+    if (size == 0 || out_size - size < 1 + 1 + 4 + 4 + 1 + 2 + 1 + 14)
+    {
+        return 0;
+    }
+
+    out[size++] = packet_type_without_timestamp(messaging);
+    out[size++] = symbol_table;
+    size += encode_compressed_lat_fixed(d.lat_udeg, out + size);
+    size += encode_compressed_lon_fixed(d.lon_udeg, out + size);
+    out[size++] = symbol_code;
+    size += encode_compressed_course_speed_fixed(d.has_course_speed ? d.track_degrees : 0, d.has_course_speed ? d.speed_cknots : 0, out + size);
+    out[size++] = static_cast<char>(0b00111000 + 33); // current, RMC, compressed
+
+    if (d.has_alt)
+    {
+        size += encode_altitude_fixed(d.alt_feet, out + size);
+    }
+
+    return size;
+}
+
+APRS_TRACK_INLINE size_t encode_mic_e_packet_fixed(std::string_view from, std::string_view path, const fixed_data& d, mic_e_status status, char symbol_table, char symbol_code, int ambiguity, char* out, size_t out_size)
+{
+    // Same as encode_mic_e_packet_no_message(const tracker&, const data&)
+    // Returns the number of characters written, or 0 if the buffer is too small
+
+    char destination[8];
+    size_t destination_size = encode_mic_e_lat_fixed(d.lat_udeg, d.lon_udeg, status, ambiguity, destination);
+
+    size_t size = encode_header(from, std::string_view(destination, destination_size), path, out, out_size);
+
+    if (size == 0 || out_size - size < 1 + 3 + 3 + 2 + 4)
+    {
+        return 0;
+    }
+
+    out[size++] = '`';
+    size += encode_mic_e_lon_fixed(d.lon_udeg, out + size);
+    size += encode_mic_e_course_speed_fixed(d.has_course_speed ? d.track_degrees : 0, d.has_course_speed ? d.speed_cknots : 0, out + size);
+    out[size++] = symbol_code;
+    out[size++] = symbol_table;
+
+    if (d.has_alt)
+    {
+        size += encode_mic_e_alt_fixed(d.alt_feet, out + size);
+    }
+
+    return size;
+}
+
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+// **************************************************************** //
+//                                                                  //
+// track log                                                        //
+//                                                                  //
+// **************************************************************** //
+
+// Track log layout, all integers little endian:
+//
+//   header: "APTL", version 1, 3 reserved bytes
+//   blocks: fixes, see track_log_writer
+//   index:  per block, first time (8), last time (8), offset (8), count (4), reserved (4)
+//   footer: index offset (8), fix count (8), block count (4), "APTL"
+
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE uint64_t zigzag_encode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+APRS_TRACK_INLINE int64_t zigzag_decode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+APRS_TRACK_INLINE void write_varint(std::vector<unsigned char>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+APRS_TRACK_INLINE bool read_varint(const unsigned char*& p, const unsigned char* end, uint64_t& value)
+{
+    // Most values of a steady track fit in a byte
+
+    if (p < end && *p < 0x80)
+    {
+        value = *p++;
+        return true;
+    }
+
+    uint64_t result = 0;
+
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        unsigned char b = *p++;
+        result |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+APRS_TRACK_INLINE void write_le(std::vector<unsigned char>& out, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++)
+    {
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+APRS_TRACK_INLINE uint64_t read_le(const unsigned char* p, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+APRS_TRACK_INLINE void encode_track_log_fix(std::vector<unsigned char>& out, track_log_state& s, int64_t time, const packed_data& fix)
+{
+    // The time and position of a vehicle change by about the same amount
+    // from fix to fix, the change of their delta is encoded, which is 0
+    // or close to 0 most of the time
+
+    int64_t time_delta = time - s.time;
+    int64_t lat_delta = static_cast<int64_t>(fix.lat) - s.lat;
+    int64_t lon_delta = static_cast<int64_t>(fix.lon) - s.lon;
+
+    int64_t values[6] = {
+        time_delta - s.time_delta,
+        lat_delta - s.lat_delta,
+        lon_delta - s.lon_delta,
+        static_cast<int64_t>(fix.alt) - s.alt,
+        static_cast<int64_t>(fix.speed) - s.speed,
+        static_cast<int64_t>(fix.track) - s.track,
+    };
+
+    uint8_t flags = static_cast<uint8_t>(
+        (fix.has_speed ? track_log_has_speed : 0) |
+        (fix.has_track ? track_log_has_track : 0) |
+        (fix.has_alt ? track_log_has_alt : 0) |
+        (fix.has_time ? track_log_has_time : 0));
+
+    uint8_t fields = (flags != s.flags) ? track_log_flags : 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (values[i] != 0)
+        {
+            fields |= static_cast<uint8_t>(1 << i);
+        }
+    }
+
+    out.push_back(fields);
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (values[i] != 0)
+        {
+            write_varint(out, zigzag_encode(values[i]));
+        }
+    }
+
+    if (fields & track_log_flags)
+    {
+        out.push_back(flags);
+    }
+
+    s.time = time;
+    s.time_delta = time_delta;
+    s.lat = fix.lat;
+    s.lat_delta = lat_delta;
+    s.lon = fix.lon;
+    s.lon_delta = lon_delta;
+    s.alt = fix.alt;
+    s.speed = fix.speed;
+    s.track = fix.track;
+    s.flags = flags;
+
+    if (!s.started)
+    {
+        // the first fix of a block is absolute, the second a plain delta
+        s.time_delta = 0;
+        s.lat_delta = 0;
+        s.lon_delta = 0;
+        s.started = true;
+    }
+}
+
+APRS_TRACK_INLINE bool decode_track_log_fix(const unsigned char*& p, const unsigned char* end, track_log_state& s)
+{
+    if (p >= end)
+    {
+        return false;
+    }
+
+    uint8_t fields = *p++;
+    uint64_t value = 0;
 
-    if (direction == 'N')
+    if (fields & track_log_time)
     {
-        destination_address[3] = destination_address[3] = 'P' + (destination_address[3] - '0');
+        if (!read_varint(p, end, value)) return false;
+        s.time_delta += zigzag_decode(value);
     }
-}
 
-APRS_TRACK_INLINE void encode_mic_lon_offset(bool offset, string_t& destination_address)
-{
-    // this handling is not necessary due to how the
-    // lat ambiguity is applied later, but it is useful in testing
-    if (destination_address[4] == ' ')
+    if (fields & track_log_lat)
     {
-        if (offset)
-        {
-            destination_address[4] = 'Z';
-        }
-        else
-        {
-            destination_address[4] = 'L';
-        }
-        return;
+        if (!read_varint(p, end, value)) return false;
+        s.lat_delta += zigzag_decode(value);
     }
 
-    if (offset)
+    if (fields & track_log_lon)
     {
-        destination_address[4] = destination_address[4] = 'P' + (destination_address[4] - '0');
+        if (!read_varint(p, end, value)) return false;
+        s.lon_delta += zigzag_decode(value);
     }
-}
 
-APRS_TRACK_INLINE void encode_mic_lon_direction(char direction, string_t& destination_address)
-{
-    // this handling is not necessary due to how the
-    // lat ambiguity is applied later, but it is useful in testing
-    if (destination_address[5] == ' ')
+    s.time += s.time_delta;
+    s.lat = static_cast<int32_t>(s.lat + s.lat_delta);
+    s.lon = static_cast<int32_t>(s.lon + s.lon_delta);
+
+    if (fields & track_log_alt)
     {
-        if (direction == 'W')
-        {
-            destination_address[5] = 'Z';
-        }
-        else if (direction == 'E')
-        {
-            destination_address[5] = 'L';
-        }
-        return;
+        if (!read_varint(p, end, value)) return false;
+        s.alt = static_cast<int32_t>(s.alt + zigzag_decode(value));
     }
 
-    if (direction == 'W')
+    if (fields & track_log_speed)
     {
-        destination_address[5] = destination_address[5] = 'P' + (destination_address[5] - '0');
+        if (!read_varint(p, end, value)) return false;
+        s.speed = static_cast<uint32_t>(s.speed + zigzag_decode(value));
     }
-}
 
-APRS_TRACK_INLINE std::tuple<int, int, int, bool> encode_mic_e_status(mic_e_status status)
-{
-    int a = 0;
-    int b = 0;
-    int c = 0;
-    bool custom = false;
+    if (fields & track_log_track)
+    {
+        if (!read_varint(p, end, value)) return false;
+        s.track = static_cast<uint16_t>(s.track + zigzag_decode(value));
+    }
 
-    //  MIC-E Status Encoding Truth Table
-    //  --------------------------------
-    //  Status         Custom  a b c
-    //  --------------------------------
-    //  off_duty        0      1 1 1
-    //  en_route        0      1 1 0
-    //  in_service      0      1 0 1
-    //  returning       0      1 0 0
-    //  committed       0      0 1 1
-    //  special         0      0 1 0
-    //  priority        0      0 0 1
-    //  emergency       0      0 0 0
-    //  custom0         1      1 1 1
-    //  custom1         1      1 1 0
-    //  custom2         1      1 0 1
-    //  custom3         1      1 0 0
-    //  custom4         1      0 1 1
-    //  custom5         1      0 1 0
-    //  custom6         1      0 0 1
-    //  --------------------------------
+    if (fields & track_log_flags)
+    {
+        if (p >= end) return false;
+        s.flags = *p++;
+    }
 
-    switch (status)
+    if (!s.started)
     {
-    case mic_e_status::off_duty:
-        a = 1;
-        b = 1;
-        c = 1;
-        break;
-    case mic_e_status::en_route:
-        a = 1;
-        b = 1;
-        c = 0;
-        break;
-    case mic_e_status::in_service:
-        a = 1;
-        b = 0;
-        c = 1;
-        break;
-    case mic_e_status::returning:
-        a = 1;
-        b = 0;
-        c = 0;
-        break;
-    case mic_e_status::commited:
-        a = 0;
-        b = 1;
-        c = 1;
-        break;
-    case mic_e_status::special:
-        a = 0;
-        b = 1;
-        c = 0;
-        break;
-    case mic_e_status::priority:
-        a = 0;
-        b = 0;
-        c = 1;
-        break;
-    case mic_e_status::emergency:
-        a = 0;
-        b = 0;
-        c = 0;
-        break;
-    case mic_e_status::custom0:
-        a = 1;
-        b = 1;
-        c = 1;
-        custom = true;
-        break;
-    case mic_e_status::custom1:
-        a = 1;
-        b = 1;
-        c = 0;
-        custom = true;
-        break;
-    case mic_e_status::custom2:
-        a = 1;
-        b = 0;
-        c = 1;
-        custom = true;
-        break;
-    case mic_e_status::custom3:
-        a = 1;
-        b = 0;
-        c = 0;
-        custom = true;
-        break;
-    case mic_e_status::custom4:
-        a = 0;
-        b = 1;
-        c = 1;
-        custom = true;
-        break;
-    case mic_e_status::custom5:
-        a = 0;
-        b = 1;
-        c = 0;
-        custom = true;
-        break;
-    case mic_e_status::custom6:
-        a = 0;
-        b = 0;
-        c = 1;
-        custom = true;
-        break;
-    default:
-        break;
+        s.time_delta = 0;
+        s.lat_delta = 0;
+        s.lon_delta = 0;
+        s.started = true;
     }
 
-    return std::make_tuple(a, b, c, custom);
+    return true;
 }
 
-APRS_TRACK_INLINE void encode_mic_e_status(mic_e_status status, string_t& destination_address)
+APRS_TRACK_INLINE void write_track_log_block(std::vector<unsigned char>& out, const track_log_block& block)
 {
-    int a = 0;
-    int b = 0;
-    int c = 0;
-    bool custom = false;
+    write_le(out, static_cast<uint64_t>(block.first_time), 8);
+    write_le(out, static_cast<uint64_t>(block.last_time), 8);
+    write_le(out, block.offset, 8);
+    write_le(out, block.count, 4);
+    write_le(out, 0, 4);
+}
 
-    std::tie(a, b, c, custom) = encode_mic_e_status(status);
+APRS_TRACK_INLINE track_log_block read_track_log_block(const unsigned char* p)
+{
+    track_log_block block;
+    block.first_time = static_cast<int64_t>(read_le(p, 8));
+    block.last_time = static_cast<int64_t>(read_le(p + 8, 8));
+    block.offset = read_le(p + 16, 8);
+    block.count = static_cast<uint32_t>(read_le(p + 24, 4));
+    return block;
+}
 
-    encode_mic_e_status(a, b, c, custom, destination_address);
+APRS_TRACK_INLINE void make_track_log_entry(const track_log_state& s, track_log_entry& entry)
+{
+    entry.time = s.time;
+    entry.fix.lat = s.lat;
+    entry.fix.lon = s.lon;
+    entry.fix.alt = s.alt;
+    entry.fix.speed = s.speed;
+    entry.fix.track = s.track;
+    entry.fix.has_speed = (s.flags & track_log_has_speed) ? 1 : 0;
+    entry.fix.has_track = (s.flags & track_log_has_track) ? 1 : 0;
+    entry.fix.has_alt = (s.flags & track_log_has_alt) ? 1 : 0;
+    entry.fix.has_time = (s.flags & track_log_has_time) ? 1 : 0;
+
+    if (entry.fix.has_time)
+    {
+        utc_day_hour_minute_second(s.time, entry.fix);
+    }
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat)
+APRS_TRACK_INLINE void utc_day_hour_minute_second(int64_t time, packed_data& fix)
 {
-    // Converts decimal degrees coordinates to mic-e position format:
-    //
-    // 1. Latitude/Longitude Degree Extraction:
-    //    - For a coordinate like 33.4273°, extracts the whole degrees (33°)
-    //    - Uses integer truncation to remove the decimal portion from the absolute value
-    //
-    // 2. Minutes Conversion:
-    //    - Takes the decimal portion (0.4273) and converts to minutes:
-    //      * Subtracts whole degrees: 33.4273° - 33° = 0.4273°
-    //      * Multiplies by 60 to get minutes: 0.4273° × 60 = 25.638 minutes
-    //    
-    // 3. Minutes Separation:
-    //    - Uses modf() to split minutes into whole and decimal parts:
-    //      * Whole minutes: 25
-    //      * Decimal minutes: 0.638
-    //    - Multiplies decimal by 100 to get hundredths: 0.638 × 100 = 63.8
-    //
-    // Final Format: DDMMHH (Degrees, Minutes, Hundredths of minutes)  
-    // Example: 33° 25.638' becomes 332563
-    //
-    // This format matches the mic-e position specification which uses
-    // degrees and decimal minutes rather than decimal degrees
+    // Day of the month from the days since the epoch, see
+    // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
 
-    double lat_abs = std::fabs(lat);
+    int64_t days = time / 86400;
+    int64_t seconds = time % 86400;
 
-    int lat_d = static_cast<int>(lat_abs);
+    if (seconds < 0)
+    {
+        seconds += 86400;
+        days--;
+    }
 
-    double lat_m = (lat_abs - lat_d) * 60.0;
-    double lat_m_f = 0.0;
-    double lat_m_i = std::modf(lat_m, &lat_m_f) * 100.0;
-    lat_m_i = std::round(lat_m_i);
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
 
-    // Resulting coordinates stored as: 33° 25.638' -> 332563
+    fix.day = static_cast<uint8_t>(doy - (153 * mp + 2) / 5 + 1);
+    fix.hour = static_cast<uint8_t>(seconds / 3600);
+    fix.minute = static_cast<uint8_t>((seconds / 60) % 60);
+    fix.second = static_cast<uint8_t>(seconds % 60);
+}
 
-    char buffer[7];
-    std::snprintf(buffer, sizeof(buffer), "%02d%02d%02d", lat_d, static_cast<int>(lat_m_f), static_cast<int>(lat_m_i));
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    string_t lat_str(buffer);
+#ifndef APRS_TRACK_HEAP_FREE
 
-    return lat_str;
-}
+// **************************************************************** //
+//                                                                  //
+// position store                                                   //
+//                                                                  //
+// **************************************************************** //
 
-APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat, mic_e_status status)
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE void write_bits(bit_column& c, uint64_t value, size_t count)
 {
-    char direction = (lat >= 0.0) ? 'N' : 'S';
+    // Appends the low count bits of value, count is 1 to 64
 
-    string_t lat_str = encode_mic_e_lat(lat);
+    if (count < 64)
+    {
+        value &= (uint64_t(1) << count) - 1;
+    }
 
-    encode_mic_e_status(status, lat_str);
-    encode_mic_e_lat_direction(direction, lat_str);
+    size_t offset = c.bits & 63;
 
-    return lat_str;
+    if (offset == 0)
+    {
+        c.words.push_back(value);
+    }
+    else
+    {
+        c.words.back() |= value << offset;
+        if (offset + count > 64)
+        {
+            c.words.push_back(value >> (64 - offset));
+        }
+    }
+
+    c.bits += count;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_lat(double lat, double lon, mic_e_status status, int ambiguity)
+APRS_TRACK_INLINE uint64_t read_bits(const bit_column& c, size_t& position, size_t count)
 {
-    string_t lat_str = encode_mic_e_lat(lat, status);
+    size_t word = position >> 6;
+    size_t offset = position & 63;
 
-    double lon_abs = std::fabs(lon);
-    int lon_d = static_cast<int>(lon_abs);
-    bool lon_offset = ((lon_d >= 0 && lon_d <= 9) || lon_d >= 100) ? true : false;
+    uint64_t value = c.words[word] >> offset;
 
-    char lon_direction = lon < 0.0 ? 'W' : 'E';
+    if (offset + count > 64 && word + 1 < c.words.size())
+    {
+        value |= c.words[word + 1] << (64 - offset);
+    }
 
-    encode_mic_lon_offset(lon_offset, lat_str);
-    encode_mic_lon_direction(lon_direction, lat_str);
+    if (count < 64)
+    {
+        value &= (uint64_t(1) << count) - 1;
+    }
 
-    add_mic_e_position_ambiguity(lat_str, ambiguity);
+    position += count;
 
-    return lat_str;
+    return value;
 }
 
-APRS_TRACK_INLINE char encode_mic_e_lon_degrees(int lon_d)
+APRS_TRACK_INLINE void write_position_value(bit_column& c, int64_t value)
 {
-    int result = 0;
+    // 0, 10 and 7 bits, 110 and 12 bits, 1110 and 20 bits, or 1111 and 64 bits,
+    // of the zigzag encoded value, the prefix is written first bit first
 
-    if (lon_d >= 0 && lon_d <= 9)
+    uint64_t v = zigzag_encode(value);
+
+    if (v == 0)
     {
-        result = lon_d + 118;
+        write_bits(c, 0, 1);
     }
-    else if (lon_d >= 10 && lon_d <= 99)
+    else if (v < (uint64_t(1) << 7))
     {
-        result = lon_d + 28;
+        write_bits(c, 0b01 | (v << 2), 9);
     }
-    else if (lon_d >= 100 && lon_d <= 109)
+    else if (v < (uint64_t(1) << 12))
     {
-        result = lon_d + 8;
+        write_bits(c, 0b011 | (v << 3), 15);
     }
-    else if (lon_d >= 110 && lon_d <= 179)
+    else if (v < (uint64_t(1) << 20))
     {
-        result = lon_d - 100 + 28;
+        write_bits(c, 0b0111 | (v << 4), 24);
+    }
+    else
+    {
+        write_bits(c, 0b1111, 4);
+        write_bits(c, v, 64);
     }
-
-    return static_cast<char>(result);
 }
 
-APRS_TRACK_INLINE char encode_mic_e_lon_minutes(int lon_m)
+APRS_TRACK_INLINE int64_t read_position_value(const bit_column& c, size_t& position)
 {
-    int result = 0;
+    // The prefix is the number of 1 bits before a 0, read at once
 
-    if (lon_m >= 0 && lon_m <= 9)
-    {
-        result = lon_m + 88;
-    }
-    else if (lon_m >= 10 && lon_m <= 59)
+    constexpr size_t prefix_bits[5] = { 1, 2, 3, 4, 4 };
+    constexpr size_t value_bits[5] = { 0, 7, 12, 20, 64 };
+
+    size_t peek = position;
+    size_t ones = static_cast<size_t>(std::countr_one(read_bits(c, peek, 4)));
+
+    position += prefix_bits[ones];
+
+    if (ones == 0)
     {
-        result = lon_m + 28;
+        return 0;
     }
 
-    return static_cast<char>(result);
+    return zigzag_decode(read_bits(c, position, value_bits[ones]));
 }
 
-APRS_TRACK_INLINE char encode_mic_e_lon_hundred_minutes(int lon_h)
+APRS_TRACK_INLINE void append_position_chunk(position_series& series, int64_t time, const packed_data& fix)
 {
-    int result = 0;
+    // Appends the fix to the last chunk of the series
 
-    if (lon_h >= 0 && lon_h <= 99)
+    position_chunk& chunk = series.chunks.back();
+
+    int64_t values[position_column_count] = {
+        time,
+        fix.lat,
+        fix.lon,
+        fix.alt,
+        fix.speed,
+        fix.track,
+        (fix.has_speed ? track_log_has_speed : 0) |
+        (fix.has_track ? track_log_has_track : 0) |
+        (fix.has_alt ? track_log_has_alt : 0) |
+        (fix.has_time ? track_log_has_time : 0),
+    };
+
+    for (size_t i = 0; i < position_column_count; i++)
     {
-        result = lon_h + 28;
+        if (chunk.count == 0)
+        {
+            series.last[i] = 0;
+            series.last_delta[i] = 0;
+        }
+
+        int64_t delta = values[i] - series.last[i];
+
+        if (i <= position_column_lon)
+        {
+            write_position_value(chunk.columns[i], delta - series.last_delta[i]);
+            series.last_delta[i] = chunk.count == 0 ? 0 : delta;
+        }
+        else
+        {
+            write_position_value(chunk.columns[i], delta);
+        }
+
+        series.last[i] = values[i];
     }
 
-    return static_cast<char>(result);
+    if (chunk.count == 0)
+    {
+        chunk.first_time = time;
+    }
+
+    chunk.last_time = time;
+    chunk.north = (std::max)(chunk.north, fix.lat);
+    chunk.south = (std::min)(chunk.south, fix.lat);
+    chunk.east = (std::max)(chunk.east, fix.lon);
+    chunk.west = (std::min)(chunk.west, fix.lon);
+    chunk.count++;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_lon(double lon)
+APRS_TRACK_INLINE void decode_position_column(const position_chunk& chunk, size_t column, size_t count, int64_t* out)
 {
-    // Similar implementation to latitude encoding, but with additional
-    // table lookups for the longitude degrees, minutes, and hundredths
-    // 
-    // Converts decimal degrees coordinates to mic-e position format:
-    //
-    // 1. Latitude/Longitude Degree Extraction:
-    //    - For a coordinate like 33.4273°, extracts the whole degrees (33°)
-    //    - Uses integer truncation to remove the decimal portion from the absolute value
+    // Decodes the first count values of the column
     //
-    // 2. Minutes Conversion:
-    //    - Takes the decimal portion (0.4273) and converts to minutes:
-    //      * Subtracts whole degrees: 33.4273° - 33° = 0.4273°
-    //      * Multiplies by 60 to get minutes: 0.4273° × 60 = 25.638 minutes
-    //    
-    // 3. Minutes Separation:
-    //    - Uses modf() to split minutes into whole and decimal parts:
-    //      * Whole minutes: 25
-    //      * Decimal minutes: 0.638
-    //    - Multiplies decimal by 100 to get hundredths: 0.638 × 100 = 63.8
+    // The next 64 bits are loaded at once, a run of 0 values is decoded
+    // from their trailing zeros, the other values from their prefix
 
-    string_t lon_str;
+    constexpr size_t prefix_bits[4] = { 0, 2, 3, 4 };
+    constexpr size_t value_bits[4] = { 0, 7, 12, 20 };
 
-    double lon_abs = std::fabs(lon);
+    if (count == 0)
+    {
+        return;
+    }
 
-    int lon_d = static_cast<int>(lon_abs);
+    const bit_column& c = chunk.columns[column];
+    const uint64_t* words = c.words.data();
+    const size_t size = c.words.size();
+    const bool delta_of_delta = column <= position_column_lon;
 
-    double lon_m = (lon_abs - lon_d) * 60.0;
-    double lon_m_f = 0.0;
-    double lon_m_i = std::modf(lon_m, &lon_m_f) * 100.0;
-    lon_m_i = round_number(lon_m_i);
+    size_t position = 0;
+    int64_t value = read_position_value(c, position); // the first fix is absolute
+    int64_t delta = 0;
 
-    lon_str.append(1, encode_mic_e_lon_degrees(lon_d));
-    lon_str.append(1, encode_mic_e_lon_minutes(static_cast<int>(lon_m)));
-    lon_str.append(1, encode_mic_e_lon_hundred_minutes(static_cast<int>(lon_m_i)));
+    out[0] = value;
 
-    return lon_str;
-}
+    for (size_t i = 1; i < count;)
+    {
+        size_t word = position >> 6;
+        size_t offset = position & 63;
 
-APRS_TRACK_INLINE string_t encode_mic_e_course_speed(double course_degrees, double speed_knots)
-{
-    string_t course_speed;
+        uint64_t bits = words[word] >> offset;
+        if (offset != 0 && word + 1 < size)
+        {
+            bits |= words[word + 1] << (64 - offset);
+        }
 
-    int course = static_cast<int>(round_number(course_degrees));
-    int speed = static_cast<int>(round_number(speed_knots));
+        if ((bits & 1) == 0)
+        {
+            size_t run = (std::min)(static_cast<size_t>(std::countr_zero(bits)), count - i);
+            for (size_t r = 0; r < run; r++)
+            {
+                value += delta;
+                out[i++] = value;
+            }
+            position += run;
+            continue;
+        }
 
-    int sp = (speed / 10) + 'l'; // or + 28
-    int se = (course % 100) + 28;
+        size_t ones = static_cast<size_t>(std::countr_one(bits & 0xF));
+        int64_t v;
 
-    int dc = 0;
+        if (ones < 4)
+        {
+            v = zigzag_decode((bits >> prefix_bits[ones]) & ((uint64_t(1) << value_bits[ones]) - 1));
+            position += prefix_bits[ones] + value_bits[ones];
+        }
+        else
+        {
+            position += 4;
+            v = zigzag_decode(read_bits(c, position, 64));
+        }
 
-    if (course >= 0 && course <= 99)
-    {
-        dc = ' '; // or 28
+        if (delta_of_delta)
+        {
+            delta += v;
+            value += delta;
+        }
+        else
+        {
+            value += v;
+        }
+
+        out[i++] = value;
     }
-    else if (course >= 100 && course <= 199)
+}
+
+APRS_TRACK_INLINE bool position_chunk_overlaps(const position_chunk& chunk, const position_query& q)
+{
+    if (chunk.count == 0 || chunk.last_time < q.begin || chunk.first_time > q.end)
     {
-        dc = '!'; // or 29
+        return false;
     }
-    else if (course >= 200 && course <= 299)
+
+    if (!q.box)
     {
-        dc = '"'; // or 30
+        return true;
     }
-    else if (course >= 300 && course <= 360)
+
+    if (chunk.south > q.north || chunk.north < q.south)
     {
-        dc = '#'; // or 31
+        return false;
     }
 
-    int speed_units = speed % 10;
-
-    if (speed_units > 0)
+    if (q.west <= q.east)
     {
-        dc = dc + speed_units * 10;
+        return chunk.west <= q.east && chunk.east >= q.west;
     }
 
-    course_speed.append(1, static_cast<char>(sp));
-    course_speed.append(1, static_cast<char>(dc));
-    course_speed.append(1, static_cast<char>(se));
-
-    return course_speed;
+    return chunk.east >= q.west || chunk.west <= q.east;
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_course_speed_alternate(double course_degrees, double speed_knots)
-{
-    string_t course_speed;
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    int course = static_cast<int>(std::round(course_degrees));
-    int speed = static_cast<int>(std::round(speed_knots));
+#endif // APRS_TRACK_HEAP_FREE
 
-    int sp = (speed / 10) + 28; // or  l
-    int se = (course % 100) + 28;
+// **************************************************************** //
+//                                                                  //
+// tracker snapshot                                                 //
+//                                                                  //
+// **************************************************************** //
 
-    int dc = 0;
+// A tracker snapshot record, all integers little endian:
+//
+//   length (4), version (1), from, to, path and message, each a length (2) and bytes,
+//   the fix, the configuration, the time of the last beacon in milliseconds
+//   since the epoch or 0, the beacon phase, the course at the last beacon,
+//   and the statistics
 
-    if (course >= 0 && course <= 99)
-    {
-        dc = 28; // or ' '
-    }
-    else if (course >= 100 && course <= 199)
-    {
-        dc = 29; // or !
-    }
-    else if (course >= 200 && course <= 299)
-    {
-        dc = 30; // or "
-    }
-    else if (course >= 300 && course <= 360)
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
+
+APRS_TRACK_INLINE uint64_t snapshot_reader::le(size_t bytes)
+{
+    if (!ok || static_cast<size_t>(end - p) < bytes)
     {
-        dc = 31; // or #
+        ok = false;
+        return 0;
     }
 
-    int speed_units = speed % 10;
+    uint64_t value = read_le(p, bytes);
+    p += bytes;
+    return value;
+}
 
-    if (speed_units > 0)
+APRS_TRACK_INLINE double snapshot_reader::float64()
+{
+    uint64_t bits = le(8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+APRS_TRACK_INLINE std::string_view snapshot_reader::string()
+{
+    size_t size = static_cast<size_t>(le(2));
+
+    if (!ok || static_cast<size_t>(end - p) < size)
     {
-        dc = dc + speed_units * 10;
+        ok = false;
+        return {};
     }
 
-    course_speed.append(1, static_cast<char>(sp));
-    course_speed.append(1, static_cast<char>(dc));
-    course_speed.append(1, static_cast<char>(se));
+    std::string_view s(reinterpret_cast<const char*>(p), size);
+    p += size;
+    return s;
+}
 
-    return course_speed;
+APRS_TRACK_INLINE void write_float64(std::vector<unsigned char>& out, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write_le(out, bits, 8);
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_alt(double alt_meters)
+APRS_TRACK_INLINE void write_snapshot_string(std::vector<unsigned char>& out, std::string_view s)
 {
-    // Encoded altitude in mic-e format
-    //
-    //   xxx}
-    //
-    // Example:
-    //
-    //   altitude = 59.06 feet = 18 meters
-    //   relative altitude = 18 + 10000 = 10018
-    //                       ~~
-    //   base-91 encoding: 10018 = 1*91² + 19*91 + 8
-    //                             ~       ~~      ~
-    //   ASCII characters: 1+33=34 '"', 19+33=52 '4', 8 + 33=41 ')'
-    //                     ~            ~~            ~
-    //   result: "4)}
+    size_t size = (std::min)(s.size(), size_t(0xFFFF));
+    write_le(out, size, 2);
+    out.insert(out.end(), s.begin(), s.begin() + size);
+}
 
-    string_t alt_str(4, '\0');
+#endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    int alt_meters_int = static_cast<int>(std::round(alt_meters));
-    int relative_alt = alt_meters_int + 10000;
+// **************************************************************** //
+//                                                                  //
+// beacon phase                                                     //
+//                                                                  //
+// **************************************************************** //
 
-    int v0 = relative_alt / (91 * 91);
-    int r = relative_alt % (91 * 91);
-    int v1 = r / 91;
-    int v2 = r % 91;
+#ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-    alt_str[0] = static_cast<char>(v0 + 33);
-    alt_str[1] = static_cast<char>(v1 + 33);
-    alt_str[2] = static_cast<char>(v2 + 33);
-    alt_str[3] = '}';
+APRS_TRACK_INLINE std::chrono::milliseconds callsign_phase(std::string_view callsign)
+{
+    // FNV-1a of the callsign, spread over an hour, the slots repeat every
+    // interval so only the offset within the interval matters
 
-    return alt_str;
+    uint32_t hash = 2166136261u;
+
+    for (char c : callsign)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+
+    return std::chrono::milliseconds(hash % 3600000u);
 }
 
-APRS_TRACK_INLINE string_t encode_mic_e_alt_feet(double alt_feet)
+APRS_TRACK_INLINE int64_t beacon_slot(std::chrono::milliseconds time, std::chrono::milliseconds phase, std::chrono::milliseconds period)
 {
-    double alt_meters = alt_feet * 0.3048;
-    return encode_mic_e_alt(alt_meters);
+    // Index of the period the time falls in, the periods start at the phase
+
+    int64_t t = (time - phase).count();
+    int64_t p = period.count();
+
+    return (t >= 0) ? (t / p) : -((-t + p - 1) / p);
 }
 
 #endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
+APRS_TRACK_DETAIL_NAMESPACE_END
+
+APRS_TRACK_NAMESPACE_END
+
 // **************************************************************** //
 //                                                                  //
-//  common data extensions                                          //
+// tracker profile                                                  //
 //                                                                  //
 // **************************************************************** //
 
-string_t encode_course_speed(double course_degrees, double speed_knots);
-string_t encode_altitude(double alt_feet);
+APRS_TRACK_NAMESPACE_BEGIN
+
+APRS_TRACK_DETAIL_NAMESPACE_BEGIN
 
 #ifndef APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
-APRS_TRACK_INLINE string_t encode_course_speed(double course_degrees, double speed_knots)
+APRS_TRACK_INLINE void copy_profile_fields(const tracker_profile& from, tracker_profile& to, uint32_t fields)
 {
-    // 
-    //  Data Format:
-    // 
-    //    Course / Speed
-    //    --------------
-    //      3    1   3   
-    //
-    //  Example:
-    //
-    //    088/036 - a course 88 degrees, traveling at 36 knots
-    //    000/000 - the course is unknown
-    //       /    - the course is unknown
-    //
-    //  Course is expressed in degrees 001 to 360, clockwise from due north
-    //
+    auto copy = [&](profile_field field) { return (fields & static_cast<uint32_t>(field)) != 0; };
 
-    int course_degrees_int = static_cast<int>(std::round(course_degrees));
-    int speed_knots_int = static_cast<int>(std::round(speed_knots));
-
-    string_t course_speed;
-    course_speed.append(format_n_digits_string(course_degrees_int, 3));
-    course_speed.append("/");
-    course_speed.append(format_n_digits_string(speed_knots_int, 3));
-    return course_speed;
+    if (copy(profile_field::to)) to.to = from.to;
+    if (copy(profile_field::path)) to.path = from.path;
+    if (copy(profile_field::symbol_code)) to.symbol_code = from.symbol_code;
+    if (copy(profile_field::symbol_table)) to.symbol_table = from.symbol_table;
+    if (copy(profile_field::ambiguity)) to.ambiguity = from.ambiguity;
+    if (copy(profile_field::messaging)) to.messaging = from.messaging;
+    if (copy(profile_field::mic_e_status)) to.mic_e_status = from.mic_e_status;
+    if (copy(profile_field::algorithm)) to.algorithm = from.algorithm;
+    if (copy(profile_field::interval)) to.interval_seconds = from.interval_seconds;
+    if (copy(profile_field::low_speed)) to.low_speed_knots = from.low_speed_knots;
+    if (copy(profile_field::high_speed)) to.high_speed_knots = from.high_speed_knots;
+    if (copy(profile_field::slow_rate)) to.slow_rate = from.slow_rate;
+    if (copy(profile_field::fast_rate)) to.fast_rate = from.fast_rate;
+    if (copy(profile_field::turn_time)) to.turn_time = from.turn_time;
+    if (copy(profile_field::turn_angle)) to.turn_angle = from.turn_angle;
+    if (copy(profile_field::turn_slope)) to.turn_slope = from.turn_slope;
+    if (copy(profile_field::baud_rate)) to.baud_rate = from.baud_rate;
 }
 
-APRS_TRACK_INLINE string_t encode_altitude(double alt_feet)
-{
-    //
-    //  Data Format:
-    //
-    //    /A=aaaaaa
-    //    ----------
-    //     3   6
-    //
-    //  Example:
-    //
-    //    /A=001234 - an altitude of 1234 feet
-    //    /A=123456 - the altitude is 123456 feet
-    //
-    //  Altitude is expressed in feet above sea level
-    //
+#ifndef APRS_TRACK_HEAP_FREE
 
-    int alt_feet_int = static_cast<int>(std::round(alt_feet));
+APRS_TRACK_INLINE const std::shared_ptr<const tracker_profile>& default_tracker_profile()
+{
+    // The settings of the trackers which have no profile, until they are changed
 
-    string_t altitude;
-    altitude.append("/A=");
-    altitude.append(format_n_digits_string(alt_feet_int, 6));
-    return altitude;
+    static const std::shared_ptr<const tracker_profile> profile = std::make_shared<const tracker_profile>();
+    return profile;
 }
 
+#endif // APRS_TRACK_HEAP_FREE
+
 #endif // APRS_TRACK_PUBLIC_FORWARD_DECLARATIONS_ONLY
 
 APRS_TRACK_DETAIL_NAMESPACE_END
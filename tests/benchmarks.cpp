@@ -0,0 +1,2117 @@
+// **************************************************************** //
+// libaprstrack - APRS tracking library                             //
+// Version 0.1.0                                                    //
+// https://github.com/iontodirel/libaprstrack                       //
+// Copyright (c) 2025 Ion Todirel                                   //
+// **************************************************************** //
+//
+// benchmarks.cpp
+//
+// MIT License
+//
+// Copyright (c) 2025 Ion Todirel
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "../aprstrack.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <filesystem>
+#include <cmath>
+#include <unordered_map>
+#include <thread>
+#include <charconv>
+
+using namespace aprs::track;
+using namespace aprs::track::detail;
+
+#ifndef ASSETS_DIR
+#define ASSETS_DIR "../assets"
+#endif
+
+// Bytes allocated with the global operator new, for the memory benchmarks
+size_t allocated_bytes = 0;
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // the replaced operators use malloc and free
+#endif
+
+void* operator new(size_t size)
+{
+    allocated_bytes += size;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+struct route_point
+{
+    double lat = 0.0;
+    double lon = 0.0;
+};
+
+std::vector<route_point> load_route_points(const std::string& file_name)
+{
+    std::vector<route_point> points;
+
+    std::ifstream file(std::string(ASSETS_DIR) + "/" + file_name);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        route_point p;
+        if (std::sscanf(line.c_str(), "%lf, %lf", &p.lat, &p.lon) == 2)
+        {
+            points.push_back(p);
+        }
+    }
+
+    return points;
+}
+
+template<class F>
+double measure_ns_per_op(size_t ops, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// transmit arbiter                                                 //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_transmit_arbiter(const std::string& route_file)
+{
+    // Simulates a vehicle, its trailer and a weather sensor sharing one radio
+    //
+    // Each route point is one second of simulated time, every tracker
+    // asks for the channel on its own beacon interval, the arbiter decides
+
+    using namespace std::chrono;
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    tracker vehicle;
+    vehicle.from("N0CALL-9");
+    vehicle.path("WIDE1-1,WIDE2-1");
+    vehicle.symbol_table('/');
+    vehicle.symbol_code('>');
+    vehicle.mic_e_status(mic_e_status::en_route);
+
+    tracker trailer;
+    trailer.from("N0CALL-11");
+    trailer.path("WIDE1-1");
+    trailer.symbol_table('/');
+    trailer.symbol_code('<');
+    trailer.messaging(false);
+
+    tracker weather;
+    weather.from("N0CALL-13");
+    weather.path("WIDE2-1");
+    weather.symbol_table('/');
+    weather.symbol_code('_');
+    weather.message("WX");
+
+    struct station
+    {
+        tracker* t;
+        packet_type type;
+        seconds interval;
+        bool pending = false;
+    };
+
+    station stations[] = {
+        { &vehicle, packet_type::mic_e, seconds(30) },
+        { &trailer, packet_type::position_compressed, seconds(30) },
+        { &weather, packet_type::position, seconds(60) },
+    };
+
+    transmit_arbiter arbiter;
+    arbiter.seed(1);
+    arbiter.budget(0.05);
+
+    size_t requests = 0;
+
+    double ns = measure_ns_per_op(points.size(), [&]() {
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            const route_point& p = points[i];
+
+            vehicle.position(p.lat, p.lon);
+            trailer.position(p.lat, p.lon);
+
+            if (i == 0)
+            {
+                weather.position(p.lat, p.lon);
+            }
+
+            // The vehicle reports an emergency in the middle of the route
+            vehicle.mic_e_status(i == points.size() / 2 ? mic_e_status::emergency : mic_e_status::en_route);
+
+            milliseconds now = seconds(i);
+
+            // Deferred beacons are retried every second until granted
+
+            for (station& s : stations)
+            {
+                if (i % s.interval.count() == 0 || (s.t == &vehicle && vehicle.mic_e_status() == mic_e_status::emergency))
+                {
+                    s.pending = true;
+                }
+
+                if (s.pending)
+                {
+                    requests++;
+                    s.pending = !arbiter.request(*s.t, s.type, now);
+                }
+            }
+        }
+    });
+
+    double utilization = duration<double>(arbiter.total_airtime()).count() / static_cast<double>(points.size());
+
+    std::printf("transmit_arbiter %-20s points: %6zu requests: %5zu granted: %5zu deferred: %5zu channel: %5.2f%% %8.1f ns/point\n",
+        route_file.c_str(), points.size(), requests, arbiter.granted(), arbiter.deferred(), utilization * 100.0, ns);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// compressed encoding                                              //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_compressed_encoding(const std::string& route_file)
+{
+    // Encodes every route point, compares the existing compressed format
+    // with the compressed timestamped formats, and the string path with
+    // writing directly into a caller buffer
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    tracker t;
+    t.from("N0CALL-9");
+    t.path("WIDE1-1,WIDE2-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+
+    size_t checksum = 0;
+
+    auto run = [&](const char* name, packet_type type) {
+        double ns = measure_ns_per_op(points.size(), [&]() {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                t.position(points[i].lat, points[i].lon, 10.0, static_cast<double>(i % 360), 100.0);
+                t.time(static_cast<int>(i / 60) % 60, static_cast<int>(i % 60), 0);
+                checksum += t.packet_string(type).size();
+            }
+        });
+        std::printf("%-48s %-20s %8.1f ns/packet\n", name, route_file.c_str(), ns);
+    };
+
+    run("position_compressed", packet_type::position_compressed);
+    run("position_compressed_with_timestamp", packet_type::position_compressed_with_timestamp);
+    run("position_compressed_with_timestamp_utc", packet_type::position_compressed_with_timestamp_utc);
+    run("position_compressed_with_timestamp_utc_hms", packet_type::position_compressed_with_timestamp_utc_hms);
+    run("position_with_timestamp_utc", packet_type::position_with_timestamp_utc);
+
+    char buffer[256];
+
+    double ns = measure_ns_per_op(points.size(), [&]() {
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            size_t size = encode_position_packet_compressed_with_timestamp_no_message("N0CALL-9", "APRS", "WIDE1-1,WIDE2-1", false, 'h',
+                static_cast<int>(i / 3600) % 24, static_cast<int>(i / 60) % 60, static_cast<int>(i % 60),
+                points[i].lat, points[i].lon, '/', '>', static_cast<double>(i % 360), 10.0, 0b00111000 + 33, buffer, sizeof(buffer));
+            checksum += size;
+        }
+    });
+    std::printf("%-48s %-20s %8.1f ns/packet\n", "compressed_with_timestamp (caller buffer)", route_file.c_str(), ns);
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// packet memoization                                               //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_packet_cache(const std::string& route_file)
+{
+    // Fixed stations beaconing the same position over and over
+    //
+    // One tracker per route point, the first pass encodes every packet,
+    // the following passes set the same fix again and hit the cache
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    size_t count = std::min<size_t>(points.size(), 5000);
+
+    std::vector<tracker> trackers(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        trackers[i].from("N0CALL-10");
+        trackers[i].path("WIDE2-1");
+        trackers[i].symbol_table('/');
+        trackers[i].symbol_code('#');
+        trackers[i].messaging(true);
+        trackers[i].message("PHG2360 digipeater");
+        trackers[i].packet_cache(true);
+    }
+
+    packet_type types[] = { packet_type::position, packet_type::position_compressed, packet_type::mic_e };
+
+    size_t checksum = 0;
+
+    for (packet_type type : types)
+    {
+        auto pass = [&]() {
+            return measure_ns_per_op(count, [&]() {
+                for (size_t i = 0; i < count; i++)
+                {
+                    trackers[i].position(points[i].lat, points[i].lon);
+                    checksum += trackers[i].packet_string(type).size();
+                }
+            });
+        };
+
+        double cold = pass();
+        double warm = pass();
+
+        std::printf("packet_cache %-20s %-20s trackers: %5zu encode: %8.1f ns/packet cached: %8.1f ns/packet\n",
+            to_string(type).c_str(), route_file.c_str(), count, cold, warm);
+    }
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// incremental encoding                                             //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_incremental_encoding(const std::string& route_file)
+{
+    // A vehicle driving the route, one fix per second, the time advances,
+    // the altitude is flat, and the speed and course only change at turns
+    //
+    // The same fixes are encoded with the packet cache disabled (full encode)
+    // and enabled (only the changed fields are rendered)
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    packet_type types[] = {
+        packet_type::mic_e,
+        packet_type::position,
+        packet_type::position_compressed,
+        packet_type::position_with_timestamp_utc,
+        packet_type::position_compressed_with_timestamp_utc_hms,
+    };
+
+    size_t checksum = 0;
+
+    for (packet_type type : types)
+    {
+        double ns[2] = {};
+
+        for (int incremental = 0; incremental < 2; incremental++)
+        {
+            tracker t;
+            t.from("N0CALL-9");
+            t.path("WIDE1-1,WIDE2-1");
+            t.symbol_table('/');
+            t.symbol_code('>');
+            t.mic_e_status(mic_e_status::en_route);
+            t.packet_cache(incremental == 1);
+
+            ns[incremental] = measure_ns_per_op(points.size(), [&]() {
+                for (size_t i = 0; i < points.size(); i++)
+                {
+                    int seconds = static_cast<int>(i);
+                    double course = static_cast<double>((i / 120) * 45 % 360);
+                    t.position(points[i].lat, points[i].lon, 13.4, course, 52.0, 1, (seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60);
+                    checksum += t.packet_string(type).size();
+                }
+            });
+        }
+
+        std::printf("incremental %-44s %-20s full: %8.1f ns/packet incremental: %8.1f ns/packet\n",
+            to_string(type).c_str(), route_file.c_str(), ns[0], ns[1]);
+    }
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// fixed point encoding                                             //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_fixed_point_encoding(const std::string& route_file)
+{
+    // Encodes the route with the double encoders and with the integer
+    // only encoders, the fixes are quantized to micro degrees first so
+    // both encode the same inputs
+    //
+    // On the host both paths have an FPU, the difference is much larger
+    // on targets where the double math is done in software
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    std::vector<fixed_data> fixed(points.size());
+    std::vector<data> doubles(points.size());
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        fixed[i].lat_udeg = static_cast<int32_t>(std::lround(points[i].lat * 1000000.0));
+        fixed[i].lon_udeg = static_cast<int32_t>(std::lround(points[i].lon * 1000000.0));
+        fixed[i].track_degrees = static_cast<int32_t>(i % 360);
+        fixed[i].speed_cknots = static_cast<int32_t>(2600 + i % 500);
+        fixed[i].alt_feet = 170;
+        fixed[i].has_course_speed = true;
+        fixed[i].has_alt = true;
+
+        doubles[i].lat = fixed[i].lat_udeg / 1000000.0;
+        doubles[i].lon = fixed[i].lon_udeg / 1000000.0;
+        doubles[i].track_degrees = fixed[i].track_degrees;
+        doubles[i].speed_knots = fixed[i].speed_cknots / 100.0;
+        doubles[i].alt_feet = fixed[i].alt_feet;
+    }
+
+    tracker t;
+    t.from("N0CALL-9");
+    t.to("APRS");
+    t.path("WIDE1-1,WIDE2-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
+
+    size_t checksum = 0;
+    char buffer[256];
+
+    struct
+    {
+        const char* name;
+        string_t (*encode_double)(const tracker&, const data&);
+    } formats[] = {
+        { "position", encode_position_packet_no_timestamp_no_message },
+        { "position_compressed", encode_position_packet_compressed_no_timestamp_no_message },
+        { "mic_e", encode_mic_e_packet_no_message },
+    };
+
+    for (size_t f = 0; f < std::size(formats); f++)
+    {
+        double ns_double = measure_ns_per_op(points.size(), [&]() {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                checksum += formats[f].encode_double(t, doubles[i]).size();
+            }
+        });
+
+        double ns_fixed = measure_ns_per_op(points.size(), [&]() {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                size_t size = 0;
+                if (f == 0)
+                {
+                    size = encode_position_packet_no_timestamp_fixed("N0CALL-9", "APRS", "WIDE1-1,WIDE2-1", false, fixed[i], '/', '>', 0, buffer, sizeof(buffer));
+                }
+                else if (f == 1)
+                {
+                    size = encode_position_packet_compressed_no_timestamp_fixed("N0CALL-9", "APRS", "WIDE1-1,WIDE2-1", false, fixed[i], '/', '>', buffer, sizeof(buffer));
+                }
+                else
+                {
+                    size = encode_mic_e_packet_fixed("N0CALL-9", "WIDE1-1,WIDE2-1", fixed[i], mic_e_status::en_route, '/', '>', 0, buffer, sizeof(buffer));
+                }
+                checksum += size;
+            }
+        });
+
+        std::printf("fixed_point %-20s %-20s double: %8.1f ns/packet fixed: %8.1f ns/packet\n",
+            formats[f].name, route_file.c_str(), ns_double, ns_fixed);
+    }
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// tracker memory                                                   //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_tracker_memory(size_t count)
+{
+    // Footprint of a fleet of trackers, the heap used by the callsign and
+    // path strings depends on the string_t in use and is not counted
+
+    std::printf("sizeof(tracker): %zu bytes, sizeof(data): %zu bytes, sizeof(fix_data): %zu bytes\n",
+        sizeof(tracker), sizeof(data), sizeof(fix_data));
+
+    std::vector<tracker> trackers(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        trackers[i].from("N0CALL");
+        trackers[i].path("WIDE1-1");
+    }
+
+    size_t checksum = 0;
+
+    double ns = measure_ns_per_op(count, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            trackers[i].position(47.6 + i * 1e-5, -122.3, 10.0, static_cast<double>(i % 360), 100.0);
+            checksum += trackers[i].packet_string_no_message(packet_type::position).size();
+        }
+    });
+
+    std::printf("tracker_memory %zu trackers: %.1f MB inline, %.1f ns/update and encode\n",
+        count, (count * sizeof(tracker)) / (1024.0 * 1024.0), ns);
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// shared messages                                                  //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_shared_messages(size_t count, size_t distinct)
+{
+    // Trackers with a copy of their comment, and trackers referencing
+    // one of a few interned comments
+
+    std::vector<std::string> comments;
+    for (size_t i = 0; i < distinct; i++)
+    {
+        comments.push_back("147." + std::to_string(100 + i) + "MHz T110 +060 club " + std::to_string(i));
+    }
+
+    size_t checksum = 0;
+
+    for (bool shared : { false, true })
+    {
+        std::vector<tracker> trackers(count);
+        message_pool pool;
+
+        size_t before = allocated_bytes;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (shared)
+            {
+                trackers[i].message(pool.intern(comments[i % distinct]));
+            }
+            else
+            {
+                trackers[i].message(comments[i % distinct].c_str());
+            }
+        }
+
+        size_t message_bytes = allocated_bytes - before;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            trackers[i].from("N0CALL");
+            trackers[i].path("WIDE1-1");
+            trackers[i].position(47.6 + i * 1e-5, -122.3);
+        }
+
+        double ns = measure_ns_per_op(count, [&]() {
+            for (size_t i = 0; i < count; i++)
+            {
+                checksum += trackers[i].packet_string(packet_type::position).size();
+            }
+        });
+
+        std::printf("shared_messages %zu trackers %zu comments %-8s message heap: %8.1f KB, %8.1f ns/packet\n",
+            count, distinct, shared ? "shared" : "copied", message_bytes / 1024.0, ns);
+    }
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// shared profiles                                                  //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_shared_profiles(size_t count)
+{
+    // Changing the path and symbol of a fleet, by setting them on every
+    // tracker, and by storing a new shared profile which the trackers
+    // apply in their update
+
+    tracker_profile p;
+    p.to = "APRS";
+    p.path = "WIDE1-1";
+    p.algorithm = algorithm::periodic;
+
+    auto shared = std::make_shared<shared_profile>(p);
+
+    std::vector<tracker> individual(count);
+    std::vector<tracker> profiled(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        individual[i].from("N0CALL");
+        individual[i].to("APRS");
+        individual[i].path("WIDE1-1");
+        individual[i].algorithm(algorithm::periodic);
+        individual[i].position(47.6 + i * 1e-5, -122.3);
+
+        profiled[i].profile(shared);
+        profiled[i].from("N0CALL");
+        profiled[i].position(47.6 + i * 1e-5, -122.3);
+    }
+
+    size_t checksum = 0;
+
+    double ns_individual = measure_ns_per_op(count, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            individual[i].path("WIDE2-1");
+            individual[i].symbol_code('[');
+            individual[i].update();
+            checksum += individual[i].updated();
+        }
+    });
+
+    double ns_profile = measure_ns_per_op(count, [&]() {
+        p.path = "WIDE2-1";
+        p.symbol_code = '[';
+        shared->store(p);
+        for (size_t i = 0; i < count; i++)
+        {
+            profiled[i].update();
+            checksum += profiled[i].updated();
+        }
+    });
+
+    double ns_update = measure_ns_per_op(count, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            profiled[i].update();
+            checksum += profiled[i].updated();
+        }
+    });
+
+    std::printf("shared_profiles %zu trackers: individual: %8.1f ns/tracker profile: %8.1f ns/tracker update only: %8.1f ns/tracker\n",
+        count, ns_individual, ns_profile, ns_update);
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// position history                                                 //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_history(size_t stations, size_t depth, size_t updates)
+{
+    // Cost of recording a fix in the history of every station, and the
+    // memory a station takes with a history of the given depth
+
+    size_t checksum = 0;
+
+    for (size_t capacity : { size_t(0), depth })
+    {
+        std::vector<tracker> trackers(stations);
+
+        size_t before = allocated_bytes;
+
+        for (size_t i = 0; i < stations; i++)
+        {
+            trackers[i].history_capacity(capacity);
+        }
+
+        size_t history_bytes = allocated_bytes - before;
+
+        double ns = measure_ns_per_op(stations * updates, [&]() {
+            for (size_t u = 0; u < updates; u++)
+            {
+                for (size_t i = 0; i < stations; i++)
+                {
+                    trackers[i].position(47.6 + u * 1e-5, -122.3 + i * 1e-5, 10.0, static_cast<double>((u * 7) % 360));
+                }
+            }
+        });
+
+        for (size_t i = 0; i < stations; i++)
+        {
+            checksum += static_cast<size_t>(trackers[i].history_distance() + trackers[i].history_heading_change());
+        }
+
+        std::printf("history %zu stations depth %4zu: %6.1f ns/position, %8zu bytes/station\n",
+            stations, capacity, ns, sizeof(tracker) + history_bytes / stations);
+    }
+
+    std::printf("checksum: %zu\n", checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// track log                                                        //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+std::vector<track_log_entry> resample_route(const std::vector<route_point>& points, double speed_mps)
+{
+    // One fix per second of a vehicle driving the route at a steady speed,
+    // the course is rounded to a degree, like most GPS receivers report it
+
+    std::vector<track_log_entry> entries;
+
+    int64_t time = 1735689600;
+    double offset = 0.0; // meters into the current segment
+
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        const route_point& a = points[i - 1];
+        const route_point& b = points[i];
+
+        double length = distance_meters(a.lat, a.lon, b.lat, b.lon);
+        double course = std::atan2((b.lon - a.lon) * std::cos(a.lat * 3.14159265358979323846 / 180.0), b.lat - a.lat) * 180.0 / 3.14159265358979323846;
+
+        for (; offset < length; offset += speed_mps)
+        {
+            double f = offset / length;
+
+            data d;
+            d.lat = a.lat + (b.lat - a.lat) * f;
+            d.lon = a.lon + (b.lon - a.lon) * f;
+            d.speed_knots = std::round(mps_to_knots(speed_mps));
+            d.track_degrees = std::fmod(std::round(course) + 360.0, 360.0);
+            d.alt_feet = 150.0;
+            d.has_time = true;
+
+            track_log_entry entry;
+            entry.time = time++;
+            entry.fix = pack_data(d);
+            entries.push_back(entry);
+        }
+
+        offset -= length;
+    }
+
+    return entries;
+}
+
+void benchmark_track_log(const std::string& route_file)
+{
+    // Size of the route as a track log, as its vertices one second apart,
+    // and as the fixes of a vehicle driving it, and the decoding speed
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("%s: no route points\n", route_file.c_str());
+        return;
+    }
+
+    track_log_writer vertices;
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        data d;
+        d.lat = points[i].lat;
+        d.lon = points[i].lon;
+        vertices.append(static_cast<int64_t>(i), d);
+    }
+
+    size_t vertices_bytes = vertices.finish().size();
+
+    std::vector<track_log_entry> entries = resample_route(points, 20.0);
+
+    track_log_writer writer;
+
+    for (const track_log_entry& entry : entries)
+    {
+        writer.append(entry);
+    }
+
+    std::vector<unsigned char> bytes = writer.finish();
+
+    track_log_reader reader(bytes);
+
+    const size_t repeat = 200;
+    int64_t checksum = 0;
+
+    double ns_for_each = measure_ns_per_op(entries.size() * repeat, [&]() {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            reader.for_each([&](const track_log_entry& entry) { checksum += entry.fix.lat; });
+        }
+    });
+
+    double ns_iterator = measure_ns_per_op(entries.size() * repeat, [&]() {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            for (const track_log_entry& entry : reader)
+            {
+                checksum += entry.fix.lon;
+            }
+        }
+    });
+
+    double bytes_per_fix = static_cast<double>(bytes.size()) / entries.size();
+
+    std::printf("track_log %s: %zu vertices %.2f bytes/vertex, %zu fixes %.2f bytes/fix (text: %.2f bytes/vertex)\n",
+        route_file.c_str(), points.size(), static_cast<double>(vertices_bytes) / points.size(), entries.size(), bytes_per_fix,
+        static_cast<double>(std::filesystem::file_size(std::string(ASSETS_DIR) + "/" + route_file)) / points.size());
+    std::printf("track_log decode: for_each %.2f ns/fix %.0f MB/s, iterator %.2f ns/fix %.0f MB/s\n",
+        ns_for_each, bytes_per_fix / ns_for_each * 1000.0, ns_iterator, bytes_per_fix / ns_iterator * 1000.0);
+    std::printf("checksum: %lld\n", static_cast<long long>(checksum));
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// tracker snapshot                                                 //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_snapshot(size_t count)
+{
+    // Snapshot of a fleet of trackers to a file, and a warm restart
+    // restoring them from the memory mapped file
+
+    std::vector<tracker> trackers(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        trackers[i].from("N0CALL-" + std::to_string(i % 16));
+        trackers[i].path("WIDE1-1,WIDE2-1");
+        trackers[i].message("Hello World!");
+        trackers[i].algorithm(algorithm::smart_beaconing);
+        trackers[i].position(47.6 + i * 1e-5, -122.3, 10.0, static_cast<double>(i % 360), 100.0);
+        trackers[i].update();
+    }
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(count * 128);
+
+    double ns_snapshot = measure_ns_per_op(count, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            trackers[i].snapshot(bytes);
+        }
+    });
+
+    std::string path = (std::filesystem::temp_directory_path() / "aprstrack_snapshot.bin").string();
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::vector<tracker> restored(count);
+    size_t restored_count = 0;
+
+    double ns_restore = measure_ns_per_op(count, [&]() {
+#ifdef APRS_TRACK_HAS_MMAP
+        mapped_file file(path.c_str());
+        std::span<const unsigned char> records = file.bytes();
+#else
+        std::span<const unsigned char> records = bytes;
+#endif
+        size_t offset = 0;
+        while (offset < records.size() && restored_count < count)
+        {
+            size_t size = restored[restored_count].restore(records.subspan(offset));
+            if (size == 0)
+            {
+                break;
+            }
+            offset += size;
+            restored_count++;
+        }
+    });
+
+    std::filesystem::remove(path);
+
+    std::printf("snapshot %zu trackers: %.1f bytes/tracker, snapshot %.1f ns/tracker (%.1f ms), restore %.1f ns/tracker (%.1f ms), %zu restored\n",
+        count, static_cast<double>(bytes.size()) / count, ns_snapshot, ns_snapshot * count / 1e6, ns_restore, ns_restore * count / 1e6, restored_count);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// beacon phase                                                     //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_beacon_phase(size_t count, int duration_seconds)
+{
+    // A fleet started at the same time, half periodic, half parked smart
+    // beaconing trackers, updated once a second, the beacons per second
+    // without a phase, with a phase from the callsign, and with assigned slots
+
+    using namespace std::chrono;
+
+    milliseconds start = seconds(1735689600);
+
+    const char* names[] = { "none", "callsign", "slots" };
+
+    for (int mode = 0; mode < 3; mode++)
+    {
+        std::vector<tracker> trackers(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            trackers[i].from("N" + std::to_string(i) + "-9");
+            trackers[i].position(47.6 + i * 1e-5, -122.3, 0.0, 0.0);
+
+            if (i % 2 == 0)
+            {
+                trackers[i].algorithm(algorithm::periodic);
+                trackers[i].interval_seconds(60);
+            }
+            else
+            {
+                trackers[i].algorithm(algorithm::smart_beaconing);
+                trackers[i].slow_rate(60);
+            }
+
+            if (mode == 1)
+            {
+                trackers[i].phase_from_callsign();
+            }
+            else if (mode == 2)
+            {
+                trackers[i].phase(milliseconds(static_cast<int64_t>(i * 60000 / count)));
+            }
+        }
+
+        size_t peak = 0;
+        size_t total = 0;
+
+        for (int second = 0; second < duration_seconds; second++)
+        {
+            size_t beacons = 0;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                trackers[i].update(start + seconds(second));
+                beacons += trackers[i].updated() ? 1 : 0;
+            }
+
+            peak = std::max(peak, beacons);
+            total += beacons;
+        }
+
+        std::printf("beacon_phase %zu trackers %-8s: %zu beacons, peak %5zu/s, mean %.1f/s\n",
+            count, names[mode], total, peak, static_cast<double>(total) / duration_seconds);
+    }
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// duplicate filter                                                 //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_duplicate_filter(const std::string& packets_file)
+{
+    // Replays a corpus of packets 10 ms apart, a third of them heard again
+    // through a different path a few seconds later, with a 30 second window
+    // Compares with a hash map of the packets without their path
+
+    using namespace std::chrono;
+
+    std::vector<std::string> lines;
+
+    std::ifstream file(std::string(ASSETS_DIR) + "/" + packets_file);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.find(':') != std::string::npos)
+        {
+            lines.push_back(line);
+        }
+    }
+
+    struct heard_packet
+    {
+        int64_t time = 0;
+        std::string packet;
+    };
+
+    std::vector<heard_packet> stream;
+
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        int64_t time = static_cast<int64_t>(i) * 10;
+        stream.push_back({ time, lines[i] });
+
+        if (i % 3 == 0)
+        {
+            std::string& packet = lines[i];
+            size_t to_end = packet.find_first_of(",:", packet.find('>'));
+            std::string digipeated = packet.substr(0, to_end) + ",DIGI1*,WIDE2-1" + packet.substr(packet.find(':'));
+            stream.push_back({ time + 500 + static_cast<int64_t>(i * 7919 % 5000), digipeated });
+        }
+    }
+
+    std::stable_sort(stream.begin(), stream.end(), [](const heard_packet& a, const heard_packet& b) { return a.time < b.time; });
+
+    std::vector<std::vector<unsigned char>> frames;
+
+    for (const heard_packet& h : stream)
+    {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(h.packet, frame, sizeof(frame));
+        frames.emplace_back(frame, frame + size);
+    }
+
+    duplicate_filter filter(16384, seconds(30));
+    size_t duplicates = 0;
+
+    size_t before = allocated_bytes;
+
+    double filter_ns = measure_ns_per_op(stream.size(), [&]() {
+        for (const heard_packet& h : stream)
+        {
+            duplicates += filter.check(h.packet, milliseconds(h.time)) ? 1 : 0;
+        }
+    });
+
+    size_t filter_allocated = allocated_bytes - before;
+
+    duplicate_filter frame_filter(16384, seconds(30));
+    size_t frame_duplicates = 0;
+
+    double frame_ns = measure_ns_per_op(frames.size(), [&]() {
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            if (frames[i].empty())
+            {
+                continue;
+            }
+            frame_duplicates += frame_filter.check(frames[i].data(), frames[i].size(), milliseconds(stream[i].time)) ? 1 : 0;
+        }
+    });
+
+    std::unordered_map<std::string, int64_t> seen;
+    size_t map_duplicates = 0;
+
+    before = allocated_bytes;
+
+    double map_ns = measure_ns_per_op(stream.size(), [&]() {
+        for (const heard_packet& h : stream)
+        {
+            std::string_view packet = h.packet;
+            size_t to_end = packet.find_first_of(",:", packet.find('>'));
+            std::string key = std::string(packet.substr(0, to_end)) + std::string(packet.substr(packet.find(':')));
+            auto it = seen.find(key);
+            if (it != seen.end() && h.time - it->second < 30000)
+            {
+                map_duplicates++;
+                continue;
+            }
+            seen[key] = h.time;
+        }
+    });
+
+    size_t map_allocated = allocated_bytes - before;
+
+    std::printf("duplicate_filter %zu packets: %zu duplicates, %.1f ns/packet, %zu bytes allocated, %zu evictions\n",
+        stream.size(), duplicates, filter_ns, filter_allocated, filter.evictions());
+    std::printf("duplicate_filter %zu frames : %zu duplicates, %.1f ns/frame\n",
+        frames.size(), frame_duplicates, frame_ns);
+    std::printf("duplicate_filter unordered_map: %zu duplicates, %.1f ns/packet, %zu bytes allocated\n",
+        map_duplicates, map_ns, map_allocated);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// digipeater                                                       //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_digipeater(const std::string& packets_file)
+{
+    // The packets of a corpus sent with WIDE1-1,WIDE2-2, WIDE2-2 and
+    // WIDE2-1 paths through a digipeater, compared with recomputing the FCS
+    // over the whole frame after the addresses change
+
+    std::vector<std::string> packets;
+
+    std::ifstream file(std::string(ASSETS_DIR) + "/" + packets_file);
+    std::string line;
+
+    const char* paths[] = { ",WIDE1-1,WIDE2-2", ",DIGI1*,WIDE2-2", ",DIGI1*,WIDE2-1" };
+
+    while (std::getline(file, line))
+    {
+        size_t header_end = line.find(':');
+        if (header_end == std::string::npos)
+        {
+            continue;
+        }
+        size_t to_end = line.find_first_of(",:", line.find('>'));
+        packets.push_back(line.substr(0, to_end) + paths[packets.size() % 3] + line.substr(header_end));
+    }
+
+    std::vector<unsigned char> frames;
+    std::vector<size_t> sizes;
+
+    for (const std::string& packet : packets)
+    {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(packet, frame, sizeof(frame));
+        if (size > 0)
+        {
+            frames.insert(frames.end(), frame, frame + sizeof(frame));
+            sizes.push_back(size);
+        }
+    }
+
+    digipeater d;
+    d.callsign("DIGI");
+    d.aliases("WIDE1-1");
+
+    std::vector<unsigned char> work = frames;
+    std::vector<size_t> repeated_sizes(sizes.size());
+
+    double digipeat_ns = measure_ns_per_op(sizes.size(), [&]() {
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            repeated_sizes[i] = d.digipeat(&work[i * 330], sizes[i], 330);
+        }
+    });
+
+    size_t repeated = 0;
+    size_t bad_fcs = 0;
+
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        size_t size = repeated_sizes[i];
+        if (size == 0)
+        {
+            continue;
+        }
+        repeated++;
+        uint16_t fcs = static_cast<uint16_t>(work[i * 330 + size - 2] | (work[i * 330 + size - 1] << 8));
+        bad_fcs += compute_fcs(&work[i * 330], size - 2) == fcs ? 0 : 1;
+    }
+
+    work = frames;
+    uint16_t checksum = 0;
+
+    double full_fcs_ns = measure_ns_per_op(sizes.size(), [&]() {
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            checksum ^= compute_fcs(&work[i * 330], sizes[i] - 2);
+        }
+    });
+
+    std::printf("digipeater %zu frames: %zu repeated, %zu bad FCS, %.1f ns/frame, %.0f frames/s\n",
+        sizes.size(), repeated, bad_fcs, digipeat_ns, 1e9 / digipeat_ns);
+    std::printf("digipeater full FCS   : %.1f ns/frame (%04X)\n", full_fcs_ns, checksum);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// station table                                                    //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+std::string make_benchmark_callsign(size_t i)
+{
+    // Distinct callsigns like KB3XYZ-9, 2 x 26 x 10 x 26^3 x 16 of them
+
+    std::string callsign;
+    callsign += (i & 1) ? 'K' : 'W';
+    i >>= 1;
+    callsign += static_cast<char>('A' + i % 26);
+    i /= 26;
+    callsign += static_cast<char>('0' + i % 10);
+    i /= 10;
+    for (int c = 0; c < 3; c++)
+    {
+        callsign += static_cast<char>('A' + i % 26);
+        i /= 26;
+    }
+    callsign += "-" + std::to_string(i % 16);
+    return callsign;
+}
+
+void benchmark_station_table(size_t stations, size_t operations)
+{
+    // Inserts stations, then a mix of 50% position updates of known
+    // stations, 40% lookups and 10% new stations, as heard on a busy
+    // igate, with the callsigns as strings, compared with a hash map of strings
+
+    std::vector<std::string> callsigns;
+    for (size_t i = 0; i < stations + operations / 10 + 1; i++)
+    {
+        callsigns.push_back(make_benchmark_callsign(i * 7919 % 4326400 + i / 4326400));
+    }
+
+    data d;
+    d.lat = 47.6080436707;
+    d.lon = -122.3130035400;
+    d.speed_knots = 10.0;
+
+    uint32_t random = 12345;
+    std::vector<uint32_t> ops(operations);
+    for (uint32_t& op : ops)
+    {
+        random = random * 1664525 + 1013904223;
+        op = random >> 8;
+    }
+
+    station_table table;
+    size_t found = 0;
+
+    double table_insert_ns = measure_ns_per_op(stations, [&]() {
+        for (size_t i = 0; i < stations; i++)
+        {
+            table.update(callsigns[i], d);
+        }
+    });
+
+    size_t table_bytes = table.capacity() * 4 / 3 * 32; // the live table, not the tables it grew from
+    size_t next = stations;
+
+    double table_mixed_ns = measure_ns_per_op(operations, [&]() {
+        for (uint32_t op : ops)
+        {
+            size_t kind = op % 10;
+            const std::string& callsign = callsigns[(op / 10) % stations];
+            if (kind < 5)
+            {
+                d.lat += 1e-6;
+                table.update(callsign, d);
+            }
+            else if (kind < 9)
+            {
+                found += table.find(callsign).has_value() ? 1 : 0;
+            }
+            else
+            {
+                table.update(callsigns[next++], d);
+            }
+        }
+    });
+
+    // the same with the keys made once, as from AX.25 frames
+
+    std::vector<callsign_key> keys;
+    for (const std::string& callsign : callsigns)
+    {
+        keys.push_back(make_callsign_key(callsign));
+    }
+
+    station_table key_table(stations);
+    for (size_t i = 0; i < stations; i++)
+    {
+        key_table.update(keys[i], d);
+    }
+
+    next = stations;
+    size_t key_found = 0;
+
+    double key_mixed_ns = measure_ns_per_op(operations, [&]() {
+        for (uint32_t op : ops)
+        {
+            size_t kind = op % 10;
+            callsign_key key = keys[(op / 10) % stations];
+            if (kind < 5)
+            {
+                d.lat += 1e-6;
+                key_table.update(key, d);
+            }
+            else if (kind < 9)
+            {
+                key_found += key_table.contains(key) ? 1 : 0;
+            }
+            else
+            {
+                key_table.update(keys[next++], d);
+            }
+        }
+    });
+
+    size_t before = allocated_bytes;
+
+    std::unordered_map<std::string, data> map;
+    size_t map_found = 0;
+
+    double map_insert_ns = measure_ns_per_op(stations, [&]() {
+        for (size_t i = 0; i < stations; i++)
+        {
+            map[callsigns[i]] = d;
+        }
+    });
+
+    size_t map_bytes = allocated_bytes - before;
+    next = stations;
+
+    double map_mixed_ns = measure_ns_per_op(operations, [&]() {
+        for (uint32_t op : ops)
+        {
+            size_t kind = op % 10;
+            const std::string& callsign = callsigns[(op / 10) % stations];
+            if (kind < 5)
+            {
+                d.lat += 1e-6;
+                map[callsign] = d;
+            }
+            else if (kind < 9)
+            {
+                map_found += map.find(callsign) != map.end() ? 1 : 0;
+            }
+            else
+            {
+                map[callsigns[next++]] = d;
+            }
+        }
+    });
+
+    std::printf("station_table %zu stations: insert %.1f ns, mixed %.1f ns/op, %zu bytes/station, %zu found\n",
+        stations, table_insert_ns, table_mixed_ns, table_bytes / stations, found);
+    std::printf("station_table callsign_key : mixed %.1f ns/op, %zu found\n", key_mixed_ns, key_found);
+    std::printf("station_table unordered_map: insert %.1f ns, mixed %.1f ns/op, %zu bytes/station, %zu found\n",
+        map_insert_ns, map_mixed_ns, map_bytes / stations, map_found);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// station grid                                                     //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_station_grid(size_t stations, int ticks)
+{
+    // Stations driving the routes, shifted over the continental US, each
+    // tick moves every station a few points along its route, then runs
+    // r/lat/lon/50 km and 1 degree a/ box queries around random stations
+    // Compared with testing every station with the haversine distance
+
+    std::vector<route_point> routes[3] = {
+        load_route_points("route1.points.txt"),
+        load_route_points("route2.points.txt"),
+        load_route_points("route3.points.txt"),
+    };
+
+    struct moving_station
+    {
+        callsign_key key;
+        const std::vector<route_point>* route = nullptr;
+        size_t index = 0;
+        double dlat = 0.0;
+        double dlon = 0.0;
+        double lat = 0.0;
+        double lon = 0.0;
+    };
+
+    uint32_t random = 7;
+    auto next = [&](double range) {
+        random = random * 1664525 + 1013904223;
+        return (random >> 8) / 16777216.0 * range;
+    };
+
+    std::vector<moving_station> fleet(stations);
+
+    for (size_t i = 0; i < stations; i++)
+    {
+        moving_station& m = fleet[i];
+        m.key = make_callsign_key(make_benchmark_callsign(i));
+        m.route = &routes[i % 3];
+        m.index = static_cast<size_t>(next(static_cast<double>(m.route->size())));
+        m.dlat = next(20.0) - 15.0; // 32 to 52 degrees north
+        m.dlon = next(50.0); // 122 to 72 degrees west
+    }
+
+    station_grid grid(0.25);
+
+    auto move = [&](moving_station& m) {
+        m.index = (m.index + 5) % m.route->size();
+        m.lat = (*m.route)[m.index].lat + m.dlat;
+        m.lon = (*m.route)[m.index].lon + m.dlon;
+    };
+
+    for (moving_station& m : fleet)
+    {
+        move(m);
+        grid.update(m.key, m.lat, m.lon);
+    }
+
+    const size_t queries = 1000;
+
+    double update_ns = 0.0;
+    double radius_ns = 0.0;
+    double box_ns = 0.0;
+    size_t radius_found = 0;
+    size_t box_found = 0;
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        update_ns += measure_ns_per_op(stations, [&]() {
+            for (moving_station& m : fleet)
+            {
+                move(m);
+                grid.update(m.key, m.lat, m.lon);
+            }
+        });
+
+        std::vector<const moving_station*> centers;
+        for (size_t q = 0; q < queries; q++)
+        {
+            centers.push_back(&fleet[static_cast<size_t>(next(static_cast<double>(stations)))]);
+        }
+
+        radius_ns += measure_ns_per_op(queries, [&]() {
+            for (const moving_station* c : centers)
+            {
+                radius_found += grid.query_radius(c->lat, c->lon, 50000.0, [](callsign_key, double, double) {});
+            }
+        });
+
+        box_ns += measure_ns_per_op(queries, [&]() {
+            for (const moving_station* c : centers)
+            {
+                box_found += grid.query_box(c->lat + 0.5, c->lon - 0.5, c->lat - 0.5, c->lon + 0.5, [](callsign_key, double, double) {});
+            }
+        });
+    }
+
+    // the same radius queries, testing every station
+
+    const size_t scan_queries = 20;
+    size_t scan_found = 0;
+    size_t grid_found = 0;
+
+    double scan_ns = measure_ns_per_op(scan_queries, [&]() {
+        for (size_t q = 0; q < scan_queries; q++)
+        {
+            const moving_station& c = fleet[q * 7919 % stations];
+            for (const moving_station& m : fleet)
+            {
+                scan_found += distance_meters(c.lat, c.lon, m.lat, m.lon) <= 50000.0 ? 1 : 0;
+            }
+        }
+    });
+
+    for (size_t q = 0; q < scan_queries; q++)
+    {
+        const moving_station& c = fleet[q * 7919 % stations];
+        grid_found += grid.query_radius(c.lat, c.lon, 50000.0, [](callsign_key, double, double) {});
+    }
+
+    std::printf("station_grid %zu stations: move %.1f ns, radius 50 km %.1f us (%zu stations), box 1 degree %.1f us (%zu stations)\n",
+        stations, update_ns / ticks, radius_ns / ticks / 1000.0, radius_found / (queries * ticks),
+        box_ns / ticks / 1000.0, box_found / (queries * ticks));
+    std::printf("station_grid scan        : radius 50 km %.1f us, %zu found, %zu found by the grid\n",
+        scan_ns / 1000.0, scan_found, grid_found);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// filter engine                                                    //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_filter_engine(const std::string& packets_file, size_t clients)
+{
+    // Replays a corpus of packets against APRS-IS style client filters,
+    // ranges and areas around the corpus, prefixes, buddies and types,
+    // a tenth of the clients exclude a prefix
+
+    std::vector<std::string> lines;
+
+    std::ifstream file(std::string(ASSETS_DIR) + "/" + packets_file);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.find(':') != std::string::npos)
+        {
+            lines.push_back(line);
+        }
+    }
+
+    uint32_t random = 11;
+    auto next = [&](double range) {
+        random = random * 1664525 + 1013904223;
+        return (random >> 8) / 16777216.0 * range;
+    };
+
+    std::vector<decoded_packet> packets(lines.size());
+    size_t positions = 0;
+
+    double decode_ns = measure_ns_per_op(lines.size(), [&]() {
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            decode_packet(lines[i], packets[i]);
+        }
+    });
+
+    for (const decoded_packet& p : packets)
+    {
+        positions += p.has_position ? 1 : 0;
+    }
+
+    filter_engine engine;
+
+    size_t before = allocated_bytes;
+
+    for (size_t i = 0; i < clients; i++)
+    {
+        uint32_t client = engine.add_client();
+
+        const decoded_packet& p = packets[static_cast<size_t>(next(static_cast<double>(packets.size())))];
+        double lat = p.has_position ? p.fix.lat : 48.0;
+        double lon = p.has_position ? p.fix.lon : -123.0;
+
+        char filter[128];
+
+        switch (i % 10)
+        {
+            case 0: case 1: case 2: case 3:
+                std::snprintf(filter, sizeof(filter), "r/%.2f/%.2f/%d", lat, lon, 10 + static_cast<int>(next(190.0)));
+                break;
+            case 4: case 5:
+                std::snprintf(filter, sizeof(filter), "a/%.2f/%.2f/%.2f/%.2f", lat + 0.5, lon - 0.5, lat - 0.5, lon + 0.5);
+                break;
+            case 6:
+                std::snprintf(filter, sizeof(filter), "p/%.*s", 2 + static_cast<int>(next(3.0)), std::string(p.from).c_str());
+                break;
+            case 7:
+                std::snprintf(filter, sizeof(filter), "b/%s", std::string(p.from).c_str());
+                break;
+            case 8:
+                std::snprintf(filter, sizeof(filter), "t/mw r/%.2f/%.2f/50", lat, lon);
+                break;
+            default:
+                std::snprintf(filter, sizeof(filter), "r/%.2f/%.2f/100 -p/%.*s", lat, lon, 2, std::string(p.from).c_str());
+                break;
+        }
+
+        engine.filter(client, filter);
+    }
+
+    size_t engine_allocated = allocated_bytes - before;
+
+    size_t matched = 0;
+
+    double match_ns = measure_ns_per_op(packets.size(), [&]() {
+        for (const decoded_packet& p : packets)
+        {
+            matched += engine.match(p, [](uint32_t) {});
+        }
+    });
+
+    double total_ns = decode_ns + match_ns;
+
+    std::printf("filter_engine decode     : %.0f ns/packet, %zu of %zu packets with a position\n",
+        decode_ns, positions, packets.size());
+    std::printf("filter_engine match      : %.0f ns/packet, %.1f of %zu clients per packet, %zu KB of filters\n",
+        match_ns, static_cast<double>(matched) / static_cast<double>(packets.size()), clients, engine_allocated / 1024);
+    std::printf("filter_engine throughput : %.0f packets/s, decoded and matched\n",
+        1e9 / total_ns);
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// feed decoding                                                    //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_feed_decoder(const std::string& packets_file, size_t repeats)
+{
+    // Replays a corpus of packets through feed_decoder with 1 to 16 workers,
+    // compared with decode_packet on one thread, and checks that the
+    // records of each station are polled in order
+
+    std::vector<std::string> lines;
+
+    std::ifstream file(std::string(ASSETS_DIR) + "/" + packets_file);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.find(':') != std::string::npos)
+        {
+            lines.push_back(line);
+        }
+    }
+
+    std::vector<std::string> feed;
+
+    for (size_t r = 0; r < repeats; r++)
+    {
+        feed.insert(feed.end(), lines.begin(), lines.end());
+    }
+
+    size_t positions = 0;
+
+    double single_ns = measure_ns_per_op(feed.size(), [&]() {
+        for (const std::string& l : feed)
+        {
+            decoded_packet p;
+            decode_packet(l, p);
+            positions += p.has_position ? 1 : 0;
+        }
+    });
+
+    std::printf("feed_decoder single thread: %.0f ns/line, %.0f lines/s, %u hardware threads\n",
+        single_ns, 1e9 / single_ns, std::thread::hardware_concurrency());
+
+    for (size_t workers : { 1, 2, 4, 8, 16 })
+    {
+        feed_decoder decoder(workers, 4096);
+
+        std::unordered_map<uint64_t, uint64_t> last;
+        size_t out_of_order = 0;
+
+        auto f = [&](const feed_record& r) {
+            if (!r.station.valid())
+            {
+                return;
+            }
+            uint64_t& sequence = last[r.station.value];
+            out_of_order += sequence > r.sequence ? 1 : 0;
+            sequence = r.sequence;
+        };
+
+        double ns = measure_ns_per_op(feed.size(), [&]() {
+            for (const std::string& l : feed)
+            {
+                decoder.push(l, f);
+            }
+            decoder.finish(f);
+        });
+
+        size_t max_queue_depth = 0;
+        size_t max_output_depth = 0;
+        double decode_latency_ns = 0.0;
+        double max_decode_latency_ns = 0.0;
+        double poll_latency_ns = 0.0;
+
+        for (const feed_stage_stats& s : decoder.stats())
+        {
+            max_queue_depth = (std::max)(max_queue_depth, s.max_queue_depth);
+            max_output_depth = (std::max)(max_output_depth, s.max_output_depth);
+            decode_latency_ns += s.decode_latency_ns * static_cast<double>(s.lines) / static_cast<double>(feed.size());
+            max_decode_latency_ns = (std::max)(max_decode_latency_ns, s.max_decode_latency_ns);
+            poll_latency_ns += s.poll_latency_ns * static_cast<double>(s.lines) / static_cast<double>(feed.size());
+        }
+
+        std::printf("feed_decoder %2zu workers   : %.0f ns/line, %.0f lines/s, %.2fx, queue depth max %zu in %zu out, latency decode %.0f us (max %.0f us) poll %.0f us, %zu out of order\n",
+            workers, ns, 1e9 / ns, single_ns / ns, max_queue_depth, max_output_depth,
+            decode_latency_ns / 1000.0, max_decode_latency_ns / 1000.0, poll_latency_ns / 1000.0, out_of_order);
+    }
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// position store                                                   //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_position_store(size_t vehicles, size_t fixes)
+{
+    // A fleet driving the routes at 10 to 30 m/s, shifted apart, reporting
+    // every 5 seconds, appended in time order, then queried by time and by
+    // area, compared with the same fixes in rows, scanned
+
+    std::vector<std::vector<route_point>> routes = {
+        load_route_points("route1.points.txt"),
+        load_route_points("route2.points.txt"),
+        load_route_points("route3.points.txt"),
+    };
+
+    std::vector<std::vector<track_log_entry>> tracks;
+
+    for (size_t v = 0; v < vehicles; v++)
+    {
+        const std::vector<route_point>& points = routes[v % routes.size()];
+
+        if (points.size() < 2)
+        {
+            std::printf("position_store: no route points\n");
+            return;
+        }
+
+        std::vector<track_log_entry> entries = resample_route(points, 10.0 + static_cast<double>(v % 21));
+        std::vector<track_log_entry> track;
+
+        for (size_t i = v % 5; i < entries.size() && track.size() < fixes; i += 5)
+        {
+            track_log_entry entry = entries[i];
+            entry.fix.lat += static_cast<int32_t>((v / 3) % 100) * 100000; // 0.01 degree apart
+            entry.fix.lon += static_cast<int32_t>((v / 3) / 100) * 100000;
+            track.push_back(entry);
+        }
+
+        tracks.push_back(track);
+    }
+
+    std::vector<callsign_key> keys;
+
+    for (size_t v = 0; v < vehicles; v++)
+    {
+        keys.push_back(make_callsign_key(make_benchmark_callsign(v)));
+    }
+
+    size_t total = 0;
+    for (const std::vector<track_log_entry>& track : tracks)
+    {
+        total += track.size();
+    }
+
+    position_store store;
+
+    struct row
+    {
+        callsign_key station;
+        track_log_entry entry;
+    };
+
+    std::vector<row> rows;
+    rows.reserve(total);
+
+    double append_ns = measure_ns_per_op(total, [&]() {
+        for (size_t i = 0; i < fixes; i++)
+        {
+            for (size_t v = 0; v < vehicles; v++)
+            {
+                if (i < tracks[v].size())
+                {
+                    store.append(keys[v], tracks[v][i]);
+                }
+            }
+        }
+    });
+
+    for (size_t i = 0; i < fixes; i++)
+    {
+        for (size_t v = 0; v < vehicles; v++)
+        {
+            if (i < tracks[v].size())
+            {
+                rows.push_back({ keys[v], tracks[v][i] });
+            }
+        }
+    }
+
+    int64_t begin = tracks[0].front().time;
+    int64_t end = tracks[0].back().time;
+    int64_t window_begin = begin + (end - begin) / 2;
+    int64_t window_end = window_begin + 600;
+
+    const track_log_entry& center = tracks[0][tracks[0].size() / 2];
+    double north = center.fix.lat / 1e7 + 0.05;
+    double south = center.fix.lat / 1e7 - 0.05;
+    double west = center.fix.lon / 1e7 - 0.05;
+    double east = center.fix.lon / 1e7 + 0.05;
+
+    int64_t checksum = 0;
+    size_t time_found = 0;
+    size_t box_found = 0;
+    size_t row_time_found = 0;
+    size_t row_box_found = 0;
+
+    auto visit = [&](callsign_key, const track_log_entry& e) { checksum += e.fix.lat; };
+
+    const int repeat = 10;
+
+    double time_ns = measure_ns_per_op(repeat, [&]() {
+        for (int r = 0; r < repeat; r++)
+        {
+            time_found = store.query_time(window_begin, window_end, visit);
+        }
+    });
+
+    double box_ns = measure_ns_per_op(repeat, [&]() {
+        for (int r = 0; r < repeat; r++)
+        {
+            box_found = store.query_box(INT64_MIN, INT64_MAX, north, west, south, east, visit);
+        }
+    });
+
+    int32_t n = pack_degrees(north);
+    int32_t s = pack_degrees(south);
+    int32_t w = pack_degrees(west);
+    int32_t e = pack_degrees(east);
+
+    double row_time_ns = measure_ns_per_op(repeat, [&]() {
+        for (int r = 0; r < repeat; r++)
+        {
+            row_time_found = 0;
+            for (const row& x : rows)
+            {
+                if (x.entry.time >= window_begin && x.entry.time <= window_end)
+                {
+                    visit(x.station, x.entry);
+                    row_time_found++;
+                }
+            }
+        }
+    });
+
+    double row_box_ns = measure_ns_per_op(repeat, [&]() {
+        for (int r = 0; r < repeat; r++)
+        {
+            row_box_found = 0;
+            for (const row& x : rows)
+            {
+                if (x.entry.fix.lat >= s && x.entry.fix.lat <= n && x.entry.fix.lon >= w && x.entry.fix.lon <= e)
+                {
+                    visit(x.station, x.entry);
+                    row_box_found++;
+                }
+            }
+        }
+    });
+
+    std::printf("position_store %zu vehicles, %zu fixes: append %.0f ns/fix (%.1fM fixes/s), %.2f bytes/fix (rows: %zu bytes/fix)\n",
+        vehicles, total, append_ns, 1e3 / append_ns, static_cast<double>(store.memory_bytes()) / static_cast<double>(total), sizeof(row));
+    std::printf("position_store query     : 10 minutes %.2f ms (%zu fixes, rows %.2f ms), 0.1 degree box %.2f ms (%zu fixes, rows %.2f ms, %zu)\n",
+        time_ns / 1e6, time_found, row_time_ns / 1e6, box_ns / 1e6, box_found, row_box_ns / 1e6, row_box_found);
+
+    if (time_found != row_time_found || box_found != row_box_found)
+    {
+        std::printf("position_store: mismatch with the rows\n");
+    }
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// geojson reader                                                   //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+void benchmark_geojson_reader(const std::string& route_file, size_t megabytes)
+{
+    // Writes a synthetic route, laid out like scripts/generate_route.py
+    // writes them, by repeating the route until the file has the given size,
+    // then streams it with read_geojson, compared with reading the whole
+    // file into memory first, as a DOM parser would
+
+    std::vector<route_point> points = load_route_points(route_file);
+
+    if (points.empty())
+    {
+        std::printf("geojson_reader: no route points\n");
+        return;
+    }
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "aprstrack_benchmark_route.geojson.json";
+
+    size_t written = 0;
+
+    {
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr)
+        {
+            std::printf("geojson_reader: could not write %s\n", path.string().c_str());
+            return;
+        }
+
+        std::string text = "{\n  \"features\": [\n    {\n      \"geometry\": {\n        \"coordinates\": [\n";
+
+        for (size_t pass = 0; written + text.size() < megabytes * 1024 * 1024; pass++)
+        {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                char lat[32];
+                char lon[32];
+                char* lat_end = std::to_chars(lat, lat + sizeof(lat), points[i].lat + static_cast<double>(pass) * 1e-5).ptr;
+                char* lon_end = std::to_chars(lon, lon + sizeof(lon), points[i].lon).ptr;
+                text += (pass == 0 && i == 0) ? "          [\n            " : ",\n          [\n            ";
+                text.append(lon, lon_end);
+                text += ",\n            ";
+                text.append(lat, lat_end);
+                text += "\n          ]";
+            }
+
+            if (text.size() > (1 << 20))
+            {
+                written += std::fwrite(text.data(), 1, text.size(), file);
+                text.clear();
+            }
+        }
+
+        text += "\n        ],\n        \"type\": \"LineString\"\n      },\n      \"properties\": {\n        \"name\": \"Generated Route\"\n      },\n      \"type\": \"Feature\"\n    }\n  ],\n  \"type\": \"FeatureCollection\"\n}";
+        written += std::fwrite(text.data(), 1, text.size(), file);
+        std::fclose(file);
+    }
+
+    std::string path_string = path.string();
+
+    size_t streamed = 0;
+    double streamed_lat = 0.0;
+    bool streamed_ok = false;
+    size_t before = allocated_bytes;
+
+    double stream_ns = measure_ns_per_op(1, [&]() {
+        streamed_ok = read_geojson(path_string.c_str(), [&](const geojson_position& p) {
+            streamed_lat += p.lat;
+            streamed++;
+        });
+    });
+
+    size_t stream_bytes = allocated_bytes - before;
+
+    size_t loaded = 0;
+    double loaded_lat = 0.0;
+    bool loaded_ok = false;
+    before = allocated_bytes;
+
+    double load_ns = measure_ns_per_op(1, [&]() {
+        std::ifstream file(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        geojson_reader reader;
+        loaded_ok = reader.feed(text, [&](const geojson_position& p) {
+            loaded_lat += p.lat;
+            loaded++;
+        }) && reader.finish();
+    });
+
+    size_t load_bytes = allocated_bytes - before;
+
+    std::filesystem::remove(path);
+
+    double mb = static_cast<double>(written) / (1024.0 * 1024.0);
+
+    std::printf("geojson_reader %.0f MB, %zu positions: streamed %.0f ms (%.0f MB/s, %.1f ns/position, %zu bytes allocated, %zu bytes of state)\n",
+        mb, streamed, stream_ns / 1e6, mb / (stream_ns / 1e9), stream_ns / static_cast<double>(std::max<size_t>(streamed, 1)), stream_bytes, sizeof(geojson_reader));
+    std::printf("geojson_reader whole file : %.0f ms (%zu bytes allocated)\n", load_ns / 1e6, load_bytes);
+
+    if (!streamed_ok || !loaded_ok || streamed != loaded || streamed_lat != loaded_lat)
+    {
+        std::printf("geojson_reader: mismatch\n");
+    }
+}
+
+// **************************************************************** //
+//                                                                  //
+//                                                                  //
+// memory resource                                                  //
+//                                                                  //
+//                                                                  //
+// **************************************************************** //
+
+#ifdef APRS_TRACK_PMR
+
+void benchmark_memory_resource(size_t count)
+{
+    // One tick of a server encoding a packet for every station, with the
+    // packets allocated from the global heap, and from a monotonic buffer
+    // which is released after the tick
+
+    std::vector<tracker> trackers;
+    trackers.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        tracker& t = trackers.emplace_back(std::pmr::new_delete_resource());
+        t.from("N0CALL-10");
+        t.path("WIDE1-1,WIDE2-1");
+        t.message("Hello World!");
+    }
+
+    std::pmr::monotonic_buffer_resource arena(count * 128);
+
+    size_t checksum = 0;
+
+    auto tick = [&](size_t n) {
+        for (size_t i = 0; i < count; i++)
+        {
+            trackers[i].position(47.6 + i * 1e-5 + n * 1e-4, -122.3, 10.0, static_cast<double>(i % 360), 100.0);
+            string_t packet = trackers[i].packet_string(packet_type::position);
+            checksum += packet.size();
+        }
+    };
+
+    size_t n = 0;
+
+    double ns_heap = measure_ns_per_op(count, [&]() {
+        memory_resource_scope scope(std::pmr::new_delete_resource());
+        tick(n++);
+    });
+
+    double ns_arena = measure_ns_per_op(count, [&]() {
+        {
+            memory_resource_scope scope(&arena);
+            tick(n++);
+        }
+        arena.release();
+    });
+
+    std::printf("memory_resource %zu stations: heap: %8.1f ns/packet monotonic: %8.1f ns/packet\n", count, ns_heap, ns_arena);
+    std::printf("checksum: %zu\n", checksum);
+}
+
+#endif // APRS_TRACK_PMR
+
+int main()
+{
+    benchmark_transmit_arbiter("route1.points.txt");
+    benchmark_transmit_arbiter("route2.points.txt");
+    benchmark_transmit_arbiter("route3.points.txt");
+
+    benchmark_compressed_encoding("route2.points.txt");
+
+    benchmark_packet_cache("route2.points.txt");
+
+    benchmark_incremental_encoding("route2.points.txt");
+
+    benchmark_fixed_point_encoding("route2.points.txt");
+
+    benchmark_tracker_memory(100000);
+
+    benchmark_shared_messages(100000, 50);
+
+    benchmark_shared_profiles(100000);
+
+    benchmark_history(1000, 1000, 2000);
+
+    benchmark_track_log("route2.points.txt");
+
+    benchmark_snapshot(100000);
+
+    benchmark_beacon_phase(10000, 1800);
+
+    benchmark_duplicate_filter("mic_e_packets.txt");
+
+    benchmark_digipeater("mic_e_packets.txt");
+
+    benchmark_station_table(500000, 2000000);
+
+    benchmark_station_grid(200000, 10);
+
+    benchmark_filter_engine("mic_e_packets.txt", 5000);
+
+    benchmark_feed_decoder("mic_e_packets.txt", 10);
+
+    benchmark_position_store(1000, 2000);
+
+    benchmark_geojson_reader("route2.points.txt", 100);
+
+#ifdef APRS_TRACK_PMR
+    benchmark_memory_resource(50000);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// **************************************************************** //
+// libaprstrack - APRS tracking library                             //
+// Version 0.1.0                                                    //
+// https://github.com/iontodirel/libaprstrack                       //
+// Copyright (c) 2025 Ion Todirel                                   //
+// **************************************************************** //
+//
+// convert_track_log.cpp
+//
+// MIT License
+//
+// Copyright (c) 2025 Ion Todirel
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "../aprstrack.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+
+using namespace aprs::track;
+using namespace aprs::track::detail;
+
+// Converts the route assets to track logs
+//
+// The assets have no time, the points are assumed to be one interval apart
+
+std::vector<data> read_points_file(const std::string& file_path)
+{
+    // One "lat, lon" per line, like assets/route1.points.txt
+
+    std::vector<data> points;
+    std::ifstream file(file_path);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        data d;
+        if (std::sscanf(line.c_str(), "%lf, %lf", &d.lat, &d.lon) == 2)
+        {
+            points.push_back(d);
+        }
+    }
+
+    return points;
+}
+
+std::vector<data> read_geojson_file(const std::string& file_path)
+{
+    // The coordinates of the LineString features, like assets/route1.geojson.json
+    // The file is streamed, only the points are kept in memory
+
+    std::vector<data> points;
+
+    bool ok = read_geojson(file_path.c_str(), [&](const geojson_position& position) {
+        data d;
+        d.lat = position.lat;
+        d.lon = position.lon;
+        points.push_back(d);
+    });
+
+    if (!ok)
+    {
+        points.clear();
+    }
+
+    return points;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <input .points.txt or .geojson.json> <output_file_path> [interval_seconds]" << std::endl;
+        return 1;
+    }
+
+    std::string input_file_path = argv[1];
+    std::string output_file_path = argv[2];
+    int64_t interval_seconds = argc > 3 ? std::stoll(argv[3]) : 1;
+
+    std::vector<data> points;
+
+    if (input_file_path.ends_with(".json"))
+    {
+        points = read_geojson_file(input_file_path);
+    }
+    else
+    {
+        points = read_points_file(input_file_path);
+    }
+
+    if (points.empty())
+    {
+        std::cerr << "No points in: " << input_file_path << std::endl;
+        return 1;
+    }
+
+    track_log_writer writer;
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        writer.append(static_cast<int64_t>(i) * interval_seconds, points[i]);
+    }
+
+    std::vector<unsigned char> bytes = writer.finish();
+
+    std::ofstream output(output_file_path, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    std::cout << points.size() << " points, " << bytes.size() << " bytes, "
+        << static_cast<double>(bytes.size()) / points.size() << " bytes per point" << std::endl;
+
+    return 0;
+}
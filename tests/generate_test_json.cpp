@@ -46,9 +46,18 @@ int main(int argc, char* argv[])
     if (argc < 3)
     {
         std::cout << "Usage: " << argv[0] << " <input_file_path_1> <input_file_path_2> ... <output_file_path>" << std::endl;
+        std::cout << "       " << argv[0] << " --binary <json_corpus_file_path>" << std::endl;
+        std::cout << "Inputs are TNC2 packet captures, one packet per line, or .json files from scripts/parse_packets.pl" << std::endl;
+        std::cout << "The binary corpus is written next to the output, with the .bin extension" << std::endl;
         return 1;
     }
 
+    if (std::string(argv[1]) == "--binary")
+    {
+        // Writes the binary corpus of an existing JSON corpus
+        return write_corpus(corpus_path(argv[2]), parse_json_basic(argv[2])) ? 0 : 1;
+    }
+
     std::vector<std::string> input_file_paths;
 
     for (int i = 1; i < (argc - 1); ++i)
@@ -63,7 +72,7 @@ int main(int argc, char* argv[])
 
     for (auto& file_path : input_file_paths)
     {
-        std::vector<packet_data> packets = parse_json(file_path);
+        std::vector<packet_data> packets = file_path.ends_with(".json") ? parse_json(file_path) : parse_tnc2(file_path);
         input_packets.insert(input_packets.end(), packets.begin(), packets.end());
     }
 
@@ -71,6 +80,11 @@ int main(int argc, char* argv[])
 
     write_json_basic(output_file_path, output_packets);
 
+    if (!write_corpus(corpus_path(output_file_path), output_packets))
+    {
+        return 1;
+    }
+
     return 0;
 }
 
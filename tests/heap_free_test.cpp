@@ -0,0 +1,209 @@
+// **************************************************************** //
+// libaprstrack - APRS tracking library                             //
+// Version 0.1.0                                                    //
+// https://github.com/iontodirel/libaprstrack                       //
+// Copyright (c) 2025 Ion Todirel                                   //
+// **************************************************************** //
+//
+// heap_free_test.cpp
+//
+// MIT License
+//
+// Copyright (c) 2025 Ion Todirel
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <etl/string.h>
+#include <cstdlib>
+#include <new>
+
+namespace aprs::track
+{
+    // Fixed capacity string type, the heap free profile requires one
+    using string_t = etl::string<100>;
+}
+
+#define APRS_TRACK_DEFINE_CUSTOM_TYPES
+#define APRS_TRACK_HEAP_FREE
+#include "../aprstrack.hpp"
+
+using namespace aprs::track;
+using namespace aprs::track::detail;
+
+// The global operator new is poisoned while a heap_guard is alive
+// Allocations are counted rather than aborted, so that gtest can report them
+
+namespace
+{
+    size_t allocations = 0;
+    bool poisoned = false;
+
+    struct heap_guard
+    {
+        heap_guard() { allocations = 0; poisoned = true; }
+        ~heap_guard() { poisoned = false; }
+    };
+}
+
+void* operator new(size_t size)
+{
+    if (poisoned)
+    {
+        allocations++;
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(heap_free, tracker_encode)
+{
+    packet_type types[] = {
+        packet_type::mic_e,
+        packet_type::position,
+        packet_type::position_compressed,
+        packet_type::position_with_timestamp,
+        packet_type::position_with_timestamp_utc,
+        packet_type::position_with_timestamp_utc_hms,
+        packet_type::position_compressed_with_timestamp,
+        packet_type::position_compressed_with_timestamp_utc,
+        packet_type::position_compressed_with_timestamp_utc_hms,
+        packet_type::smallest,
+    };
+
+    size_t total_size = 0;
+
+    {
+        heap_guard guard;
+
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1,WIDE2-1");
+        t.symbol_table('/');
+        t.symbol_code('>');
+        t.message("Hello World!");
+        t.algorithm(algorithm::smart_beaconing);
+        t.history_capacity(APRS_TRACK_HISTORY_CAPACITY);
+
+        for (int i = 0; i < 100; i++)
+        {
+            t.position(47.6080436707 + i * 0.0001, -122.3130035400, 10.0, 90.0 + i, 100.0, 1, 2, 3, i % 60);
+            t.update();
+
+            for (packet_type p : types)
+            {
+                string_t packet = t.packet_string(p);
+                total_size += packet.size();
+
+                unsigned char buffer[256];
+                t.packet(p, &buffer[0]);
+            }
+
+            t.mic_e_status(i % 2 ? mic_e_status::en_route : mic_e_status::in_service);
+        }
+
+        EXPECT_TRUE(allocations == 0);
+        EXPECT_TRUE(t.history_size() == APRS_TRACK_HISTORY_CAPACITY);
+
+        // larger capacities are limited to the storage
+        t.history_capacity(APRS_TRACK_HISTORY_CAPACITY + 1);
+        EXPECT_TRUE(t.history_capacity() == APRS_TRACK_HISTORY_CAPACITY);
+    }
+
+    EXPECT_TRUE(total_size > 0);
+}
+
+TEST(heap_free, message_truncated_to_capacity)
+{
+    char message[APRS_TRACK_MESSAGE_CAPACITY + 10];
+    std::fill(std::begin(message), std::end(message), 'a');
+
+    unsigned char output[APRS_TRACK_MESSAGE_CAPACITY + 10] = {};
+
+    heap_guard guard;
+
+    tracker t;
+    t.message(message, sizeof(message));
+    t.message(&output[0]);
+
+    EXPECT_TRUE(std::count(std::begin(output), std::end(output), 'a') == APRS_TRACK_MESSAGE_CAPACITY);
+    EXPECT_TRUE(allocations == 0);
+}
+
+TEST(heap_free, transmit_arbiter)
+{
+    heap_guard guard;
+
+    tracker t;
+    t.from("N0CALL");
+    t.path("WIDE1-1");
+    t.position(47.6080436707, -122.3130035400, 10.0, 90.0, 100.0);
+
+    transmit_arbiter a;
+    a.baud_rate(1200);
+    a.request(t, packet_type::smallest, std::chrono::milliseconds(0));
+
+    EXPECT_TRUE(allocations == 0);
+}
+
+TEST(heap_free, station_table)
+{
+    heap_guard guard;
+
+    station_table s;
+
+    data d;
+    d.lat = 47.6080436707;
+    d.lon = -122.3130035400;
+
+    size_t inserted = 0;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        char callsign[10];
+        std::snprintf(callsign, sizeof(callsign), "N%dA", i);
+        inserted += s.update(callsign, d) ? 1 : 0;
+    }
+
+    EXPECT_TRUE(inserted == s.capacity());
+    EXPECT_TRUE(s.size() == s.capacity());
+    EXPECT_TRUE(s.update("N0A", d)); // known stations are still updated
+    EXPECT_TRUE(allocations == 0);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
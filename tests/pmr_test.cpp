@@ -0,0 +1,231 @@
+// **************************************************************** //
+// libaprstrack - APRS tracking library                             //
+// Version 0.1.0                                                    //
+// https://github.com/iontodirel/libaprstrack                       //
+// Copyright (c) 2025 Ion Todirel                                   //
+// **************************************************************** //
+//
+// pmr_test.cpp
+//
+// MIT License
+//
+// Copyright (c) 2025 Ion Todirel
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <memory_resource>
+
+#define APRS_TRACK_PMR
+#include "../aprstrack.hpp"
+
+using namespace aprs::track;
+using namespace aprs::track::detail;
+
+// Counts the allocations made from an upstream resource
+
+struct counting_resource : std::pmr::memory_resource
+{
+    explicit counting_resource(std::pmr::memory_resource* upstream) : upstream(upstream)
+    {
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations++;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream;
+    size_t allocations = 0;
+};
+
+// Any allocation from the default resource throws while a default_resource_guard is alive
+
+struct default_resource_guard
+{
+    default_resource_guard() : previous(std::pmr::set_default_resource(std::pmr::null_memory_resource()))
+    {
+    }
+
+    ~default_resource_guard()
+    {
+        std::pmr::set_default_resource(previous);
+    }
+
+    std::pmr::memory_resource* previous;
+};
+
+TEST(pmr, encoders)
+{
+    counting_resource arena(std::pmr::new_delete_resource());
+
+    default_resource_guard guard;
+
+    string_t header = encode_header("N0CALL-10", "APRS", "WIDE1-1,WIDE2-1", &arena);
+    EXPECT_TRUE(header == "N0CALL-10>APRS,WIDE1-1,WIDE2-1:");
+    EXPECT_EQ(header.get_allocator().resource(), &arena);
+
+    position_ddm_string ddm = to_ddm_short_string(dd_to_ddm(49.176666666667, -123.94916666667), 0, &arena);
+    EXPECT_TRUE(ddm.lat == "4910.60N");
+    EXPECT_TRUE(ddm.lon == "12356.95W");
+
+    string_t lat = encode_mic_e_lat(49.176666666667, -123.94916666667, mic_e_status::in_service, 0, &arena);
+    EXPECT_TRUE(lat == "T9QPVP");
+
+    EXPECT_GT(arena.allocations, 0);
+}
+
+TEST(pmr, tracker_storage)
+{
+    counting_resource storage(std::pmr::new_delete_resource());
+    counting_resource arena(std::pmr::new_delete_resource());
+
+    default_resource_guard guard;
+
+    tracker t(&storage);
+    t.packet_cache(true);
+    t.from("N0CALL-10");
+    t.to("APRS");
+    t.path("WIDE1-1,WIDE2-1,WIDE3-3");
+    t.message("Hello World! Hello World!");
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47);
+
+    size_t storage_allocations = storage.allocations;
+    EXPECT_GT(storage_allocations, 0);
+
+    string_t packet = t.packet_string(packet_type::position, &arena);
+    EXPECT_TRUE(packet == "N0CALL-10>APRS,WIDE1-1,WIDE2-1,WIDE3-3:!4910.60N/12356.95W>003/016/A=000154Hello World! Hello World!");
+    EXPECT_EQ(packet.get_allocator().resource(), &arena);
+
+    // the cached packet is kept with the tracker, the copies go to the arena
+    EXPECT_GT(storage.allocations, storage_allocations);
+    storage_allocations = storage.allocations;
+
+    size_t arena_allocations = arena.allocations;
+
+    for (int i = 0; i < 10; i++)
+    {
+        t.position(49.176666666667 + i * 0.001, -123.94916666667, 8.2, 3, 47);
+        packet = t.packet_string(packet_type::position, &arena);
+    }
+
+    EXPECT_EQ(storage.allocations, storage_allocations);
+    EXPECT_GT(arena.allocations, arena_allocations);
+}
+
+TEST(pmr, monotonic_buffer)
+{
+    char buffer[16 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    counting_resource storage(std::pmr::new_delete_resource());
+
+    tracker t(&storage);
+    t.from("N0CALL-10");
+    t.path("WIDE1-1,WIDE2-1");
+
+    for (int tick = 0; tick < 100; tick++)
+    {
+        {
+            memory_resource_scope scope(&arena);
+            t.position(49.176666666667 + tick * 0.001, -123.94916666667, 8.2, 3, 47);
+            string_t packet = t.packet_string(packet_type::smallest);
+            EXPECT_GT(packet.size(), 0);
+        }
+        arena.release();
+    }
+}
+
+TEST(pmr, tracker_ignores_scope)
+{
+    counting_resource arena(std::pmr::new_delete_resource());
+
+    tracker t = [&]() {
+        memory_resource_scope scope(&arena);
+        tracker inner;
+        inner.from("N0CALL-10 with a callsign longer than the small string buffer");
+        return inner;
+    }();
+
+    // the tracker outlives the scope, and never allocated from its resource
+    EXPECT_EQ(arena.allocations, 0);
+    t.path("WIDE1-1,WIDE2-1,WIDE3-3,WIDE4-4,WIDE5-5");
+    EXPECT_EQ(arena.allocations, 0);
+}
+
+TEST(pmr, tracker_copy)
+{
+    counting_resource storage(std::pmr::new_delete_resource());
+    counting_resource other_storage(std::pmr::new_delete_resource());
+    counting_resource arena(std::pmr::new_delete_resource());
+
+    default_resource_guard guard;
+
+    tracker t(&storage);
+    t.packet_cache(true);
+    t.from("N0CALL-10 with a callsign longer than the small string buffer");
+    t.path("WIDE1-1,WIDE2-1,WIDE3-3,WIDE4-4,WIDE5-5");
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47);
+    string_t packet = t.packet_string(packet_type::position, &arena);
+
+    // a copy allocates from the resource of the tracker, not the one in scope
+    {
+        memory_resource_scope scope(&arena);
+        size_t arena_allocations = arena.allocations;
+
+        tracker copy(t);
+        EXPECT_EQ(copy.from().get_allocator().resource(), &storage);
+        EXPECT_EQ(copy.path().get_allocator().resource(), &storage);
+        EXPECT_EQ(arena.allocations, arena_allocations);
+        EXPECT_TRUE(copy.packet_string(packet_type::position, &arena) == packet);
+    }
+
+    // an assignment keeps the resource of the tracker assigned to
+    tracker other(&other_storage);
+    size_t storage_allocations = storage.allocations;
+    other = t;
+    EXPECT_EQ(other.from().get_allocator().resource(), &other_storage);
+    EXPECT_EQ(other.path().get_allocator().resource(), &other_storage);
+    EXPECT_EQ(storage.allocations, storage_allocations);
+    EXPECT_TRUE(other.packet_string(packet_type::position, &arena) == packet);
+
+    other = tracker(&storage);
+    EXPECT_EQ(other.from().get_allocator().resource(), &other_storage);
+
+    // a move keeps the resource of the tracker moved from
+    tracker moved(std::move(t));
+    EXPECT_EQ(moved.from().get_allocator().resource(), &storage);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
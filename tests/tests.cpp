@@ -44,6 +44,8 @@
 #include <fstream>
 #include <sstream>
 #include <locale>
+#include <thread>
+#include <set>
 
 #include <fmt/format.h>
 #include <fmt/color.h>
@@ -86,6 +88,10 @@ TEST(packet, encode_header)
     EXPECT_TRUE(encode_header("N0CALL", "APRS", "") == "N0CALL>APRS:");
     EXPECT_TRUE(encode_header("N0CALL", "", "") == "N0CALL>:");
     EXPECT_TRUE(encode_header("", "", "") == ">:");
+
+    // views which are not null terminated
+    std::string_view header = "N0CALL>APRS,WIDE1-1:";
+    EXPECT_TRUE(encode_header(header.substr(0, 6), header.substr(7, 4), header.substr(12, 7)) == header);
 }
 
 TEST(position, dd_to_dms)
@@ -1615,343 +1621,2716 @@ TEST(position, encode_position_data_compressed_no_timestamp)
     }
 }
 
-TEST(tracker, various_anonymous_structs)
+TEST(position, encode_position_data_compressed_with_timestamp)
 {
-    {
-        tracker t;
-        t.from("N0CALL");
-        t.to("APRS");
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('_');
-
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-            double speed = 0.0;
-            double track = 0.0;
-            int day = -1;
-            int hour = -1;
-            int minute = -1;
-            int second = -1;
-        };
+    char buffer[64];
 
-        s data{ 39.751166666667, -75.085333333333, 4.0, 335.0, 18, 16, 13, 0 };
+    {
+        size_t size = encode_position_data_compressed_with_timestamp('@', 'z', 9, 23, 45, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+        EXPECT_TRUE(std::string(buffer, size) == "@092345z/54agSVoou?SH");
+    }
 
-        t.position(data);
+    {
+        size_t size = encode_position_data_compressed_with_timestamp('/', 'h', 23, 45, 12, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+        EXPECT_TRUE(std::string(buffer, size) == "/234512h/54agSVoou?SH");
+    }
 
-        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+    {
+        size_t size = encode_position_data_compressed_with_timestamp('/', '/', 1, 2, 3, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+        EXPECT_TRUE(std::string(buffer, size) == "/010203//54agSVoou?SH");
+    }
 
-        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/181613z3945.07N/07505.12W_335/008");
+    {
+        // the compressed position is the same as in the packets without a timestamp
+        size_t size = encode_position_data_compressed_with_timestamp('!', 'z', 9, 23, 45, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+        std::string data(buffer, size);
+        EXPECT_TRUE(data.substr(8) == encode_position_data_compressed_no_timestamp('!', 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000).substr(1));
     }
 
     {
-        tracker t;
-        t.from("N0CALL");
-        t.to("APRS");
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('_');
+        // the buffer is too small
+        size_t size = encode_position_data_compressed_with_timestamp('@', 'z', 9, 23, 45, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, 20);
+        EXPECT_TRUE(size == 0);
+    }
+}
 
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-            int day = -1;
-            int hour = -1;
-            int minute = -1;
-            int second = -1;
-        };
+TEST(position, encode_position_packet_compressed_with_timestamp_no_message)
+{
+    char buffer[64];
 
-        s data{ 39.751166666667, -75.085333333333, 18, 16, 13, 0 };
+    size_t size = encode_position_packet_compressed_with_timestamp_no_message("N0CALL", "APRS", "WIDE1-1", false, 'h', 23, 45, 12, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+    EXPECT_TRUE(std::string(buffer, size) == "N0CALL>APRS,WIDE1-1:/234512h/54agSVoou?SH");
 
-        t.position(data);
+    size = encode_position_packet_compressed_with_timestamp_no_message("N0CALL", "APRS", "", true, 'z', 9, 23, 45, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, sizeof(buffer));
+    EXPECT_TRUE(std::string(buffer, size) == "N0CALL>APRS:@092345z/54agSVoou?SH");
 
-        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+    // the header fits but the data does not
+    size = encode_position_packet_compressed_with_timestamp_no_message("N0CALL", "APRS", "", true, 'z', 9, 23, 45, 50.006266308942, 20.168111391714, '/', 'u', 120, 45.90, 0b01001000, buffer, 32);
+    EXPECT_TRUE(size == 0);
+}
 
-        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/181613z3945.07N/07505.12W_");
-    }
+TEST(position, compressed_with_timestamp_round_trip)
+{
+    // Decode the compressed fields back, and compare with the input
+    // within the resolution of the compressed format
+
+    auto decode_base91 = [](const char* s, size_t n) {
+        long v = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            v = v * 91 + (s[i] - 33);
+        }
+        return v;
+    };
 
+    struct test_vector
     {
-        tracker t;
-        t.from("N0CALL");
-        t.to("APRS");
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('_');
+        double lat;
+        double lon;
+        double course;
+        double speed;
+    };
 
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-            int day = -1;
-            int hour = -1;
-            int minute = -1;
-            // int second = -1; - required even if not used
-        };
+    test_vector vectors[] = {
+        { 47.6080436707, -122.3130035400, 0.0, 0.0 },
+        { -33.8688, 151.2093, 180.0, 12.0 },
+        { 51.6145, -0.0485, 297.0, 7.0 },
+        { 89.9, 179.9, 356.0, 99.0 },
+        { -89.9, -179.9, 4.0, 1.0 },
+    };
 
-        s data{ 39.751166666667, -75.085333333333, 18, 16, 13 };
+    char buffer[64];
 
-        t.position(data);
+    for (const test_vector& v : vectors)
+    {
+        size_t size = encode_position_data_compressed_with_timestamp('@', 'z', 31, 23, 59, v.lat, v.lon, '/', '>', v.course, v.speed, 0b00111000 + 33, buffer, sizeof(buffer));
+        ASSERT_TRUE(size == 21);
 
-        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+        EXPECT_TRUE(std::string(buffer + 1, 7) == "312359z");
 
-        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/000000z3945.07N/07505.12W_");
+        double lat = 90.0 - decode_base91(buffer + 9, 4) / 380926.0;
+        double lon = -180.0 + decode_base91(buffer + 13, 4) / 190463.0;
+        double course = (buffer[18] - 33) * 4.0;
+        double speed = std::pow(1.08, buffer[19] - 33) - 1.0;
+
+        EXPECT_NEAR(lat, v.lat, 1.0 / 380926.0);
+        EXPECT_NEAR(lon, v.lon, 1.0 / 190463.0);
+        EXPECT_NEAR(course, v.course, 4.0);
+        EXPECT_NEAR(speed, v.speed, v.speed * 0.08 + 0.001);
     }
+}
 
-    {
-        tracker t;
-        t.from("N0CALL");
-        t.to("APRS");
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('_');
+TEST(fixed_point, encoders)
+{
+    char buffer[16];
+
+    EXPECT_TRUE(std::string(buffer, write_n_digits(7, 3, buffer)) == "007");
+    EXPECT_TRUE(std::string(buffer, write_n_digits(-7, 3, buffer)) == "-07");
+    EXPECT_TRUE(std::string(buffer, write_n_digits(1234, 3, buffer)) == "1234");
+    EXPECT_TRUE(std::string(buffer, write_n_digits(0, 0, buffer)) == "0");
+
+    EXPECT_TRUE(round_div(15, 10) == 2);
+    EXPECT_TRUE(round_div(-15, 10) == -2);
+    EXPECT_TRUE(round_div(14, 10) == 1);
+
+    EXPECT_TRUE(std::string(buffer, encode_compressed_lat_fixed(49500000, buffer)) == encode_compressed_lat(49.5));
+    EXPECT_TRUE(std::string(buffer, encode_compressed_lon_fixed(-72750000, buffer)) == encode_compressed_lon(-72.75));
+    EXPECT_TRUE(std::string(buffer, encode_compressed_course_speed_fixed(88, 3600, buffer)) == encode_compressed_course_speed(88, 36.0));
+    EXPECT_TRUE(std::string(buffer, encode_ddm_lat_fixed(49058333, 0, buffer)) == "4903.50N");
+    EXPECT_TRUE(std::string(buffer, encode_ddm_lat_fixed(49058333, 2, buffer)) == "4903.  N");
+    EXPECT_TRUE(std::string(buffer, encode_ddm_lon_fixed(-72029167, buffer)) == "07201.75W");
+    EXPECT_TRUE(std::string(buffer, encode_course_speed_fixed(88, 3600, buffer)) == "088/036");
+    EXPECT_TRUE(std::string(buffer, encode_altitude_fixed(1234, buffer)) == "/A=001234");
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_lat_fixed(51614500, -48500, mic_e_status::en_route, 0, buffer)) == "UQ3VXW");
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_lat_fixed(-33427300, 151210000, mic_e_status::custom0, 2, buffer)) == encode_mic_e_lat(-33.4273, 151.21, mic_e_status::custom0, 2));
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_lat_fixed(49176667, -123949167, mic_e_status::emergency, 4, buffer)) == encode_mic_e_lat(49.176667, -123.949167, mic_e_status::emergency, 4));
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_lon_fixed(-48500, buffer)) == encode_mic_e_lon(-0.0485));
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_course_speed_fixed(297, 700, buffer)) == encode_mic_e_course_speed(297, 7.0));
+    EXPECT_TRUE(std::string(buffer, encode_mic_e_alt_fixed(108, buffer)) == encode_mic_e_alt_feet(108));
+}
 
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-        };
+TEST(fixed_point, conformance)
+{
+    // The fixed point packets must be identical to the double packets
+    // for the same inputs, except where the double encoders are ill-conditioned
 
-        s data{ 39.751166666667, -75.085333333333 };
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    t.path("WIDE1-1,WIDE2-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
 
-        t.position(data);
+    uint64_t state = 88172645463325252ull;
+    auto next = [&]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
 
-        std::string packet = t.packet_string_no_message(packet_type::position);
+    auto minutes_remainder = [](int32_t udeg) {
+        // minutes * 100000, modulo one minute
+        return (static_cast<int64_t>(std::abs(static_cast<int64_t>(udeg)) % 1000000) * 6) % 100000;
+    };
 
-        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!3945.07N/07505.12W_");
-    }
+    size_t compared = 0;
+    size_t skipped = 0;
 
+    for (int i = 0; i < 50000; i++)
     {
-        tracker t;
-        t.from("N0CALL");
-        t.mic_e_status(mic_e_status::en_route);
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('>');
+        fixed_data f;
+        f.lat_udeg = static_cast<int32_t>(static_cast<int64_t>(next() % 179999999) - 89999999);
+        f.lon_udeg = static_cast<int32_t>(static_cast<int64_t>(next() % 359999999) - 179999999);
+        f.track_degrees = static_cast<int32_t>(next() % 360);
+        f.speed_cknots = static_cast<int32_t>(next() % 50000);
+        f.alt_feet = static_cast<int32_t>(next() % 40000) - 1000;
+        f.has_course_speed = (i % 3) != 0;
+        f.has_alt = (i % 4) != 0;
 
-        struct s
+        if (i % 2 == 0)
         {
-            double lat = 0.0;
-            double lon = 0.0;
-            double speed = 0.0;
-            double track = 0.0;
-            double alt = 0.0;
-        };
+            // stay close to a real route, where ties and boundaries are more likely
+            f.lat_udeg = 47608043 + static_cast<int32_t>(next() % 20000);
+            f.lon_udeg = -122313003 + static_cast<int32_t>(next() % 20000);
+        }
 
-        s data{ 51.6145, -0.0485, 3.601, 297.0, 33.00 };
+        int64_t lat_rem = minutes_remainder(f.lat_udeg);
+        int64_t lon_rem = minutes_remainder(f.lon_udeg);
 
-        t.position(data);
+        bool compressed_tie = (380926LL * (90000000LL - f.lat_udeg)) % 1000000 == 500000 || (190463LL * (180000000LL + f.lon_udeg)) % 1000000 == 500000;
+        bool ddm_tie = lat_rem % 1000 == 500 || lon_rem % 1000 == 500;
+        bool mic_e_ill = lat_rem % 1000 == 500 || lat_rem == 0 || lon_rem % 100 == 50 || lon_rem == 0 || f.speed_cknots % 10 == 5 || (static_cast<int64_t>(f.alt_feet) * 3048) % 10000 == 5000;
 
-        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+        data d;
+        d.lat = f.lat_udeg / 1000000.0;
+        d.lon = f.lon_udeg / 1000000.0;
+        if (f.has_course_speed)
+        {
+            d.track_degrees = f.track_degrees;
+            d.speed_knots = f.speed_cknots / 100.0;
+        }
+        if (f.has_alt)
+        {
+            d.alt_feet = f.alt_feet;
+        }
 
-        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
-    }
+        char buffer[256];
 
-    {
-        tracker t;
-        t.from("N0CALL");
-        t.mic_e_status(mic_e_status::en_route);
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('>');
+        if (!ddm_tie)
+        {
+            size_t size = encode_position_packet_no_timestamp_fixed("N0CALL", "APRS", "WIDE1-1,WIDE2-1", false, f, '/', '>', 0, buffer, sizeof(buffer));
+            ASSERT_TRUE(std::string(buffer, size) == encode_position_packet_no_timestamp_no_message(t, d)) << i;
+            compared++;
+        }
+        else
+        {
+            skipped++;
+        }
 
-        struct s
+        if (!compressed_tie)
         {
-            double lat = 0.0;
-            double lon = 0.0;
-            double speed = 0.0;
-            double track = 0.0;
-        };
+            size_t size = encode_position_packet_compressed_no_timestamp_fixed("N0CALL", "APRS", "WIDE1-1,WIDE2-1", false, f, '/', '>', buffer, sizeof(buffer));
+            ASSERT_TRUE(std::string(buffer, size) == encode_position_packet_compressed_no_timestamp_no_message(t, d)) << i;
+            compared++;
+        }
+        else
+        {
+            skipped++;
+        }
 
-        s data{ 51.6145, -0.0485, 3.601, 297.0 };
+        if (!mic_e_ill)
+        {
+            size_t size = encode_mic_e_packet_fixed("N0CALL", "WIDE1-1,WIDE2-1", f, mic_e_status::en_route, '/', '>', 0, buffer, sizeof(buffer));
+            ASSERT_TRUE(std::string(buffer, size) == encode_mic_e_packet_no_message(t, d)) << i;
+            compared++;
+        }
+        else
+        {
+            skipped++;
+        }
+    }
 
-        t.position(data);
+    EXPECT_TRUE(compared > 140000) << compared;
+    EXPECT_TRUE(skipped < 10000) << skipped;
+}
 
-        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+TEST(ax25, compute_fcs)
+{
+    std::string data = "123456789";
+    EXPECT_TRUE(compute_fcs(reinterpret_cast<const unsigned char*>(data.data()), data.size()) == 0x906E);
+}
 
-        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/");
+TEST(ax25, encode_ax25_frame)
+{
+    {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", frame, sizeof(frame));
+
+        std::vector<unsigned char> expected = {
+            0x82, 0xA0, 0xA4, 0xA6, 0x40, 0x40, 0xE0, // APRS
+            0x9C, 0x60, 0x86, 0x82, 0x98, 0x98, 0x60, // N0CALL
+            0xAE, 0x92, 0x88, 0x8A, 0x62, 0x40, 0x63, // WIDE1-1, last address
+            0x03, 0xF0,
+            '!', '4', '9', '0', '3', '.', '5', '0', 'N', '/', '0', '7', '2', '0', '1', '.', '7', '5', 'W', '-',
+            0xD7, 0x86 };
+
+        EXPECT_TRUE(std::vector<unsigned char>(frame, frame + size) == expected);
     }
 
     {
-        tracker t;
-        t.from("N0CALL");
-        t.mic_e_status(mic_e_status::en_route);
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('>');
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame("N0CALL-9>APRS,WIDE1*,WIDE2-1:>", frame, sizeof(frame));
+        EXPECT_TRUE(size == 4 * 7 + 2 + 1 + 2);
+        EXPECT_TRUE(frame[13] == 0x72); // N0CALL-9
+        EXPECT_TRUE(frame[20] == 0xE0); // WIDE1*, has been repeated
+        EXPECT_TRUE(frame[27] == 0x63); // WIDE2-1, last address
+    }
 
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-        };
+    {
+        unsigned char frame[330];
+        EXPECT_TRUE(encode_ax25_frame("N0CALL>APRS,WIDE1-1", frame, sizeof(frame)) == 0);
+        EXPECT_TRUE(encode_ax25_frame("TOOLONGCALL>APRS:>", frame, sizeof(frame)) == 0);
+        EXPECT_TRUE(encode_ax25_frame("N0CALL-16>APRS:>", frame, sizeof(frame)) == 0);
+        EXPECT_TRUE(encode_ax25_frame("N0CALL>APRS:>", frame, 10) == 0);
+    }
+}
 
-        s data{ 51.6145, -0.0485 };
+TEST(ax25, hdlc_bit_count)
+{
+    unsigned char zeros[] = { 0x00, 0x00 };
+    unsigned char ones[] = { 0xFF };
+    unsigned char ones_2[] = { 0xFF, 0xFF };
+    unsigned char mixed[] = { 0x1F, 0xF8 };
+
+    EXPECT_TRUE(hdlc_bit_count(zeros, 0) == 16);
+    EXPECT_TRUE(hdlc_bit_count(zeros, sizeof(zeros)) == 16 + 16);
+    EXPECT_TRUE(hdlc_bit_count(ones, sizeof(ones)) == 16 + 8 + 1);
+    EXPECT_TRUE(hdlc_bit_count(ones_2, sizeof(ones_2)) == 16 + 16 + 3);
+    EXPECT_TRUE(hdlc_bit_count(mixed, sizeof(mixed)) == 16 + 16 + 2);
+}
 
-        t.position(data);
+TEST(ax25, estimate_airtime)
+{
+    packet_airtime a = estimate_airtime("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 1200);
+    EXPECT_TRUE(a.packet_bytes == 40);
+    EXPECT_TRUE(a.frame_bytes == 45);
+    EXPECT_TRUE(a.frame_bits >= 45 * 8 + 16);
+    EXPECT_NEAR(a.seconds, a.frame_bits / 1200.0, 0.000001);
+
+    packet_airtime b = estimate_airtime("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 9600);
+    EXPECT_TRUE(b.frame_bits == a.frame_bits);
+    EXPECT_NEAR(b.seconds * 8, a.seconds, 0.000001);
+}
 
-        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+TEST(digipeater, digipeat)
+{
+    digipeater d;
+    d.callsign("DIGI");
+    d.aliases("WIDE1-1,RELAY");
 
-        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwl \x1c>/");
-    }
+    struct test_case
+    {
+        std::string packet;
+        std::string expected; // empty if not repeated
+    };
 
+    test_case cases[] = {
+        { "N0CALL>APRS,WIDE1-1,WIDE2-2:>Hello", "N0CALL>APRS,DIGI*,WIDE2-2:>Hello" },
+        { "N0CALL>APRS,RELAY:>Hello", "N0CALL>APRS,DIGI*:>Hello" },
+        { "N0CALL>APRS,DIGI:>Hello", "N0CALL>APRS,DIGI*:>Hello" },
+        { "N0CALL>APRS,DIGI1*,WIDE2-2:>Hello", "N0CALL>APRS,DIGI1*,DIGI*,WIDE2-1:>Hello" },
+        { "N0CALL>APRS,DIGI1*,WIDE2-1:>Hello", "N0CALL>APRS,DIGI1*,DIGI*,WIDE2*:>Hello" },
+        { "N0CALL-9>T2SP0W,WIDE2-2:`c.l+@&'/'\"G:}KJ6TMS|!:&0'p|!w#R!|3", "N0CALL-9>T2SP0W,DIGI*,WIDE2-1:`c.l+@&'/'\"G:}KJ6TMS|!:&0'p|!w#R!|3" },
+        { "N0CALL>APRS,WIDE3-3:>Hello", "" }, // more hops than allowed
+        { "N0CALL>APRS,WIDE2-3:>Hello", "" },
+        { "N0CALL>APRS,WIDE2*:>Hello", "" },
+        { "N0CALL>APRS,DIGI1*:>Hello", "" },
+        { "N0CALL>APRS:>Hello", "" },
+        { "N0CALL>APRS,FAR,DIGI,WIDE2-1:>Hello", "" },
+        { "N0CALL>APRS,DIGI-1:>Hello", "" },
+    };
+
+    for (const test_case& c : cases)
     {
-        tracker t;
-        t.from("N0CALL");
-        t.to("APRS");
-        t.path("WIDE1-1");
-        t.symbol_table('/');
-        t.symbol_code('[');
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(c.packet, frame, sizeof(frame));
+        EXPECT_TRUE(size > 0);
 
-        struct s
-        {
-            double lat = 0.0;
-            double lon = 0.0;
-            double speed = 0.0;
-            double track = 0.0;
-        };
+        size_t repeated_size = d.digipeat(frame, size, sizeof(frame));
 
-        s data{ 50.656773231546 , 6.4228800344424, 0.0856036, 360 };
+        if (c.expected.empty())
+        {
+            EXPECT_TRUE(repeated_size == 0);
+            continue;
+        }
 
-        t.position(data);
+        unsigned char expected[330];
+        size_t expected_size = encode_ax25_frame(c.expected, expected, sizeof(expected));
 
-        // Y - compression type
-        std::string packet = t.packet_string(packet_type::position_compressed);
-        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!/4qheP+c)[!#Y");
+        EXPECT_TRUE(std::vector<unsigned char>(frame, frame + repeated_size) == std::vector<unsigned char>(expected, expected + expected_size));
     }
+
+    EXPECT_TRUE(d.repeated() == 6);
 }
 
-TEST(tracker, position)
+TEST(digipeater, preemptive_and_full_paths)
 {
-    tracker t;
-    t.from("N0CALL");
-    t.mic_e_status(mic_e_status::en_route);
-    t.path("WIDE1-1");
-    t.symbol_table('/');
-    t.symbol_code('>');
-
-    struct s
-    {
-        double lat = 0.0;
-        double lon = 0.0;
-        double speed = 0.0;
-        double track = 0.0;
-        double alt = 0.0;
+    digipeater d;
+    d.callsign("DIGI");
+    d.preemptive(true);
+
+    auto digipeat = [&](std::string_view packet, size_t capacity) {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(packet, frame, sizeof(frame));
+        size = d.digipeat(frame, size, std::min(capacity, sizeof(frame)));
+        return std::vector<unsigned char>(frame, frame + size);
     };
 
-    s data;
-
-    data.lat = 51.6145;
-    data.lon = -0.0485;
-    data.speed = 3.601;
-    data.track = 297.0;
-    data.alt = 33.00;
+    auto encode = [](std::string_view packet) {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(packet, frame, sizeof(frame));
+        return std::vector<unsigned char>(frame, frame + size);
+    };
 
-    t.position(data);
+    // the unused addresses before the callsign are marked used
+    EXPECT_TRUE(digipeat("N0CALL>APRS,FAR,DIGI,WIDE2-1:>Hello", 330) == encode("N0CALL>APRS,FAR,DIGI*,WIDE2-1:>Hello"));
 
-    std::string packet = t.packet_string_no_message(packet_type::mic_e);
+    // the callsign is not inserted if the frame cannot grow
+    std::string packet = "N0CALL>APRS,DIGI1*,WIDE2-2:>Hello";
+    EXPECT_TRUE(digipeat(packet, encode(packet).size()) == encode("N0CALL>APRS,DIGI1*,WIDE2-1:>Hello"));
+    EXPECT_TRUE(digipeat("N0CALL>APRS,A*,B*,C*,D*,E*,F*,G*,WIDE2-1:>Hello", 330) == encode("N0CALL>APRS,A*,B*,C*,D*,E*,F*,G*,WIDE2*:>Hello"));
 
-    EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+    // fill-in digipeaters only repeat WIDE1-1
+    digipeater fill_in;
+    fill_in.callsign("DIGI-2");
+    fill_in.aliases("WIDE1-1");
+    fill_in.max_hops(0);
 
-    data.lat = 49.176666666667;
-    data.lon = -123.94916666667;
+    unsigned char frame[330];
+    size_t size = encode_ax25_frame("N0CALL>APRS,WIDE2-2:>Hello", frame, sizeof(frame));
+    EXPECT_TRUE(fill_in.digipeat(frame, size, sizeof(frame)) == 0);
 
-    t.mic_e_status(mic_e_status::in_service);
+    // no callsign, nothing is repeated
+    digipeater none;
+    size = encode_ax25_frame("N0CALL>APRS,WIDE1-1:>Hello", frame, sizeof(frame));
+    EXPECT_TRUE(none.digipeat(frame, size, sizeof(frame)) == 0);
+}
 
-    t.position(data);
+TEST(digipeater, fcs_shift)
+{
+    // shifting the register through zero bytes one step at a time or at once
 
-    packet = t.packet_string_no_message(packet_type::mic_e);
+    for (size_t size : { 0, 1, 2, 3, 7, 8, 100, 255, 256, 1000 })
+    {
+        std::vector<unsigned char> zeros(size, 0);
+        for (uint16_t crc : { 0x0001, 0x8000, 0x1234, 0xFFFF })
+        {
+            EXPECT_TRUE(fcs_shift(crc, size) == fcs_register(crc, zeros.data(), zeros.size()));
+        }
+    }
+}
+
+TEST(callsign_key, make_callsign_key)
+{
+    EXPECT_TRUE(make_callsign_key("N0CALL-9").value == 0x4E3043414C4C0009ull);
+    EXPECT_TRUE(make_callsign_key("N0CALL").value == 0x4E3043414C4C0000ull);
+    EXPECT_TRUE(make_callsign_key("N0CALL-0") == make_callsign_key("N0CALL"));
+    EXPECT_TRUE(make_callsign_key("n0call-9") == make_callsign_key("N0CALL-9"));
+    EXPECT_TRUE(make_callsign_key("W1AW").value == 0x5731415720200000ull);
+    EXPECT_TRUE(make_callsign_key("N0CALL-15").ssid() == 15);
+
+    EXPECT_FALSE(make_callsign_key("").valid());
+    EXPECT_FALSE(make_callsign_key("-9").valid());
+    EXPECT_FALSE(make_callsign_key("TOOLONG").valid());
+    EXPECT_FALSE(make_callsign_key("N0CALL-16").valid());
+    EXPECT_FALSE(make_callsign_key("N0CALL-").valid());
+    EXPECT_FALSE(make_callsign_key("N0CALL*").valid());
+    EXPECT_FALSE(make_callsign_key("N0 CAL").valid());
+
+    // keys sort like the callsigns
+    EXPECT_TRUE(make_callsign_key("W1AW") < make_callsign_key("W1AWA"));
+    EXPECT_TRUE(make_callsign_key("N0CALL-9") < make_callsign_key("N0CALL-10"));
+    EXPECT_TRUE(make_callsign_key("K1ABC") < make_callsign_key("N0CALL"));
+
+    for (std::string_view callsign : { "N0CALL-9", "W1AW", "A-15", "VA7XL-10" })
+    {
+        EXPECT_TRUE(to_string(make_callsign_key(callsign)) == callsign);
+
+        // the same key from the AX.25 address
+        unsigned char address[7];
+        encode_ax25_address(callsign, false, true, address);
+        EXPECT_TRUE(make_callsign_key(address) == make_callsign_key(callsign));
+    }
+
+    tracker t;
+    t.from("N0CALL-7");
+    EXPECT_TRUE(to_string(make_callsign_key(t.from())) == "N0CALL-7");
+
+    unsigned char frame[330];
+    size_t size = encode_ax25_frame("N0CALL-9>APRS,WIDE1-1:>", frame, sizeof(frame));
+    EXPECT_TRUE(size > 0);
+    EXPECT_TRUE(to_string(make_callsign_key(frame + 7)) == "N0CALL-9");
+    EXPECT_TRUE(to_string(make_callsign_key(frame)) == "APRS");
+    frame[2] = ' ' << 1;
+    EXPECT_FALSE(make_callsign_key(frame).valid()); // AP RS
+}
+
+TEST(station_table, update_find_erase)
+{
+    station_table s;
+
+    data d;
+    d.lat = 49.176666666667;
+    d.lon = -123.94916666667;
+    d.speed_knots = 10.0;
+
+    EXPECT_TRUE(s.update("N0CALL-9", d));
+    EXPECT_FALSE(s.update("N0CALL-16", d));
+    EXPECT_TRUE(s.size() == 1);
+
+    std::optional<data> found = s.find("N0CALL-9");
+    EXPECT_TRUE(found.has_value());
+    EXPECT_NEAR(found->lat, d.lat, 1e-7);
+    EXPECT_NEAR(*found->speed_knots, 10.0, 0.01);
+    EXPECT_FALSE(s.find("N0CALL").has_value());
+
+    d.lat = 47.6;
+    EXPECT_TRUE(s.update(make_callsign_key("N0CALL-9"), d));
+    EXPECT_TRUE(s.size() == 1);
+    EXPECT_NEAR(s.find("N0CALL-9")->lat, 47.6, 1e-7);
+
+    // growing and erasing, the other stations are still found
+
+    for (int i = 0; i < 1000; i++)
+    {
+        d.lat = i * 0.01;
+        EXPECT_TRUE(s.update("N" + std::to_string(i) + "AB", d));
+    }
+
+    EXPECT_TRUE(s.size() == 1001);
+    EXPECT_TRUE(s.capacity() >= 1001);
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        EXPECT_TRUE(s.erase(make_callsign_key("N" + std::to_string(i) + "AB")));
+    }
+
+    EXPECT_FALSE(s.erase(make_callsign_key("N0AB")));
+    EXPECT_TRUE(s.size() == 501);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        std::optional<data> station = s.find("N" + std::to_string(i) + "AB");
+        EXPECT_TRUE(station.has_value() == (i % 2 == 1));
+        if (station)
+        {
+            EXPECT_NEAR(station->lat, i * 0.01, 1e-7);
+        }
+    }
+
+    size_t count = 0;
+    s.for_each([&](callsign_key key, const data&) {
+        EXPECT_TRUE(s.contains(key));
+        count++;
+    });
+    EXPECT_TRUE(count == 501);
+
+    s.clear();
+    EXPECT_TRUE(s.size() == 0);
+    EXPECT_FALSE(s.find("N0CALL-9").has_value());
+}
+
+TEST(station_grid, query_radius)
+{
+    // the grid queries return the same stations as testing every station
+
+    station_grid g(0.5);
+
+    struct station
+    {
+        callsign_key key;
+        double lat = 0.0;
+        double lon = 0.0;
+    };
+
+    std::vector<station> stations;
+    uint32_t random = 1;
+
+    auto next = [&](double range) {
+        random = random * 1664525 + 1013904223;
+        return (random >> 8) / 16777216.0 * range;
+    };
+
+    for (int i = 0; i < 2000; i++)
+    {
+        station s;
+        s.key = make_callsign_key("N" + std::to_string(i) + "A");
+        // clustered around Seattle, and around the world, near the poles and the antimeridian
+        s.lat = i % 2 ? 47.0 + next(2.0) : next(180.0) - 90.0;
+        s.lon = i % 2 ? -123.0 + next(2.0) : next(360.0) - 180.0;
+        g.update(s.key, 0.0, 0.0);
+        g.update(s.key, s.lat, s.lon); // moved
+        stations.push_back(s);
+    }
+
+    EXPECT_TRUE(g.size() == 2000);
+
+    struct query
+    {
+        double lat;
+        double lon;
+        double radius_meters;
+    };
+
+    query queries[] = {
+        { 47.6, -122.3, 1000.0 },
+        { 47.6, -122.3, 50000.0 },
+        { 47.6, -122.3, 500000.0 },
+        { 0.0, 179.9, 1000000.0 },
+        { 89.5, 0.0, 1000000.0 },
+        { -60.0, 10.0, 15000000.0 },
+    };
+
+    for (const query& q : queries)
+    {
+        std::vector<uint64_t> expected;
+        for (const station& s : stations)
+        {
+            if (distance_meters(q.lat, q.lon, s.lat, s.lon) <= q.radius_meters)
+            {
+                expected.push_back(s.key.value);
+            }
+        }
+
+        std::vector<uint64_t> found;
+        size_t count = g.query_radius(q.lat, q.lon, q.radius_meters, [&](callsign_key key, double, double) {
+            found.push_back(key.value);
+        });
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+
+        EXPECT_TRUE(count == found.size());
+        EXPECT_TRUE(found == expected);
+    }
+
+    for (size_t i = 0; i < stations.size(); i += 2)
+    {
+        EXPECT_TRUE(g.erase(stations[i].key));
+    }
+
+    EXPECT_FALSE(g.erase(stations[0].key));
+    EXPECT_TRUE(g.size() == 1000);
+    EXPECT_FALSE(g.contains(stations[0].key));
+    EXPECT_TRUE(g.contains(stations[1].key));
+    EXPECT_TRUE(g.query_radius(0.0, 0.0, 20100000.0, [](callsign_key, double, double) {}) == 1000);
+}
+
+TEST(station_grid, query_box)
+{
+    station_grid g;
+
+    g.update(make_callsign_key("N0CALL-1"), 47.6, -122.3);
+    g.update(make_callsign_key("N0CALL-2"), 45.5, -122.7);
+    g.update(make_callsign_key("N0CALL-3"), -17.7, 178.0);
+    g.update(make_callsign_key("N0CALL-4"), -18.1, -178.5);
+    g.update(make_callsign_key("N0CALL-5"), 90.0, 180.0);
+
+    auto box = [&](double north, double west, double south, double east) {
+        std::vector<std::string> found;
+        g.query_box(north, west, south, east, [&](callsign_key key, double, double) {
+            found.push_back(std::string(to_string(key)));
+        });
+        std::sort(found.begin(), found.end());
+        return found;
+    };
+
+    EXPECT_TRUE(box(48.0, -123.0, 47.0, -122.0) == std::vector<std::string>({ "N0CALL-1" }));
+    EXPECT_TRUE(box(48.0, -123.0, 45.0, -122.0) == std::vector<std::string>({ "N0CALL-1", "N0CALL-2" }));
+    EXPECT_TRUE(box(-17.0, 177.0, -19.0, -178.0) == std::vector<std::string>({ "N0CALL-3", "N0CALL-4" }));
+    EXPECT_TRUE(box(-17.0, 177.0, -19.0, 179.0) == std::vector<std::string>({ "N0CALL-3" }));
+    EXPECT_TRUE(box(90.0, -180.0, -90.0, 180.0).size() == 5);
+    EXPECT_TRUE(box(47.0, -123.0, 48.0, -122.0).empty());
+
+    // moved out of the box
+    g.update(make_callsign_key("N0CALL-1"), 40.0, -122.3);
+    EXPECT_TRUE(box(48.0, -123.0, 47.0, -122.0).empty());
+
+    g.clear();
+    EXPECT_TRUE(g.size() == 0);
+    EXPECT_TRUE(box(90.0, -180.0, -90.0, 180.0).empty());
+}
+
+#if defined(__cpp_lib_shared_mutex)
+
+TEST(station_grid, concurrent_readers)
+{
+    // readers query while a writer moves the stations, every query sees
+    // each station once, in the box or not
+
+    station_grid g(0.1);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        g.update(make_callsign_key("N" + std::to_string(i) + "A"), 47.0 + i * 0.001, -122.0);
+    }
+
+    std::atomic<bool> done = false;
+    std::atomic<size_t> bad_queries = 0;
+
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < 2; r++)
+    {
+        readers.emplace_back([&]() {
+            while (!done)
+            {
+                size_t count = g.query_box(49.0, -124.0, 46.0, -120.0, [](callsign_key, double, double) {});
+                if (count != 1000)
+                {
+                    bad_queries++;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    for (int step = 0; step < 20; step++)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            g.update(make_callsign_key("N" + std::to_string(i) + "A"), 47.0 + ((i + step) % 1000) * 0.001, -122.0 - step * 0.01);
+        }
+    }
+
+    done = true;
+
+    for (std::thread& t : readers)
+    {
+        t.join();
+    }
+
+    EXPECT_TRUE(bad_queries == 0);
+}
+
+#endif
+
+TEST(decode_packet, tracker_packets)
+{
+    // every packet the tracker encodes decodes back to its position
+
+    packet_type types[] = {
+        packet_type::mic_e,
+        packet_type::position,
+        packet_type::position_compressed,
+        packet_type::position_with_timestamp,
+        packet_type::position_with_timestamp_utc,
+        packet_type::position_with_timestamp_utc_hms,
+        packet_type::position_compressed_with_timestamp,
+        packet_type::position_compressed_with_timestamp_utc,
+        packet_type::position_compressed_with_timestamp_utc_hms,
+        packet_type::smallest,
+    };
+
+    tracker t;
+    t.from("N0CALL-10");
+    t.to("APRS");
+    t.path("WIDE1-1,WIDE2-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.message("Hello World!");
+
+    for (double lat : { 49.176666666667, -33.8688 })
+    {
+        for (double lon : { -123.94916666667, 151.2093 })
+        {
+            t.position(lat, lon, 8.2, 93, 47, 1, 2, 3, 4);
+
+            for (packet_type type : types)
+            {
+                std::string packet = t.packet_string(type);
+
+                decoded_packet p;
+                EXPECT_TRUE(decode_packet(packet, p)) << packet;
+                EXPECT_TRUE(p.from == "N0CALL-10");
+                EXPECT_TRUE(p.path == "WIDE1-1,WIDE2-1");
+                EXPECT_TRUE(p.kinds == position_packet) << packet;
+                EXPECT_TRUE(p.has_position) << packet;
+                EXPECT_NEAR(p.fix.lat, lat, 0.0002) << packet;
+                EXPECT_NEAR(p.fix.lon, lon, 0.0002) << packet;
+                EXPECT_TRUE(p.symbol_table == '/' && p.symbol_code == '>') << packet;
+                if (type != packet_type::smallest)
+                {
+                    EXPECT_NEAR(p.fix.track_degrees.value_or(0), 93, 4) << packet;
+                    EXPECT_NEAR(p.fix.speed_knots.value_or(0), 8.2 * 1.943844, 1.5) << packet;
+                }
+            }
+        }
+    }
+}
+
+TEST(decode_packet, data_types)
+{
+    decoded_packet p;
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-090/036/A=001234", p));
+    EXPECT_TRUE(p.to == "APRS");
+    EXPECT_TRUE(p.info == "!4903.50N/07201.75W-090/036/A=001234");
+    EXPECT_NEAR(p.fix.lat, 49.058333, 0.000001);
+    EXPECT_NEAR(p.fix.lon, -72.029167, 0.000001);
+    EXPECT_TRUE(p.fix.track_degrees == 90 && p.fix.speed_knots == 36 && p.fix.alt_feet == 1234);
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:=/5L!!<*e7>7P[", p));
+    EXPECT_NEAR(p.fix.lat, 49.5, 0.0001);
+    EXPECT_NEAR(p.fix.lon, -72.75, 0.0001);
+    EXPECT_NEAR(*p.fix.track_degrees, 88, 0.1);
+    EXPECT_NEAR(*p.fix.speed_knots, 36.2, 0.1);
+
+    // position ambiguity
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:!49  .  N/072  .  W-", p));
+    EXPECT_NEAR(p.fix.lat, 49.0, 0.000001);
+    EXPECT_NEAR(p.fix.lon, -72.0, 0.000001);
+
+    EXPECT_TRUE(decode_packet("VA7MAS>T8RWYS,VE7SLC-7*,WIDE1,WIDE2-1,qAR,N7NIX-4:`33Cl\"A>/'\"4@}|(:%a'M|!w#'!|3", p));
+    EXPECT_TRUE(p.kinds == position_packet && p.has_position);
+    EXPECT_NEAR(p.fix.lat, 48.4655, 0.0001);
+    EXPECT_NEAR(p.fix.lon, -123.3898, 0.0001);
+    EXPECT_TRUE(p.symbol_table == '/' && p.symbol_code == '>');
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:;LEADER   *092345z4903.50N/07201.75W>088/036", p));
+    EXPECT_TRUE(p.kinds == object_packet && p.has_position);
+    EXPECT_NEAR(p.fix.lat, 49.058333, 0.000001);
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:)AID #2!4903.50N/07201.75WA", p));
+    EXPECT_TRUE(p.kinds == item_packet && p.has_position);
+    EXPECT_NEAR(p.fix.lon, -72.029167, 0.000001);
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:@092345z4903.50N/07201.75W_220/004g005t077", p));
+    EXPECT_TRUE(p.kinds == (position_packet | weather_packet));
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS::WU2Z     :Testing{003", p) && p.kinds == message_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS::NWS-WARN :092010z,THUNDER_STORM", p) && p.kinds == (message_packet | nws_packet));
+    EXPECT_TRUE(decode_packet("N0CALL>APRS::N0CALL   :PARM.Battery,Temp", p) && p.kinds == (message_packet | telemetry_packet));
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:?APRS?", p) && p.kinds == query_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:>Net Control Center", p) && p.kinds == status_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:T#005,199,000,255,073,123,01101001", p) && p.kinds == telemetry_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:{Q1qwerty", p) && p.kinds == user_defined_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:_10090556c220s004g005t077", p) && p.kinds == weather_packet);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:$GPRMC,063909,A,3349.4302,N,11700.3721,W,43.022,89.3,291099,13.6,E*52", p));
+    EXPECT_TRUE(p.kinds == position_packet && !p.has_position);
+
+    // third party, the packet carried
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:}K1ABC>APRS,TCPIP,N0CALL*:!4903.50N/07201.75W-", p));
+    EXPECT_TRUE(p.from == "K1ABC" && p.kinds == position_packet && p.has_position);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:}K1ABC>APRS,TCPIP,N0CALL*:}K2ABC>APRS:!4903.50N/07201.75W-", p));
+    EXPECT_TRUE(p.from == "K2ABC" && p.kinds == position_packet && p.has_position);
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:}K1ABC", p) && p.from == "N0CALL" && p.kinds == 0);
+
+    // nested deeper than two levels, left undecoded
+    std::string nested = "N0CALL>APRS:";
+    for (int i = 0; i < 400000; i++)
+    {
+        nested += "}A>B:";
+    }
+    nested += "!4903.50N/07201.75W-";
+    EXPECT_TRUE(decode_packet(nested, p));
+    EXPECT_TRUE(p.from == "A" && p.kinds == 0 && !p.has_position);
+
+    EXPECT_TRUE(decode_packet("N0CALL>APRS:", p) && p.kinds == 0);
+    EXPECT_FALSE(decode_packet("N0CALL APRS", p));
+    EXPECT_FALSE(decode_packet(">APRS:!", p));
+}
+
+TEST(filter_engine, match)
+{
+    filter_engine e;
+
+    uint32_t range = e.add_client();
+    uint32_t area = e.add_client();
+    uint32_t prefix = e.add_client();
+    uint32_t buddy = e.add_client();
+    uint32_t types = e.add_client();
+    uint32_t exclude = e.add_client();
+    uint32_t none = e.add_client();
+
+    EXPECT_TRUE(e.filter(range, "r/49.05/-72.03/5"));
+    EXPECT_TRUE(e.filter(area, "a/50/-73/49/-72"));
+    EXPECT_TRUE(e.filter(prefix, "p/N0/k1"));
+    EXPECT_TRUE(e.filter(buddy, "b/N0CALL-9/W1*"));
+    EXPECT_TRUE(e.filter(types, "t/mw"));
+    EXPECT_TRUE(e.filter(exclude, "t/p -p/K1"));
+    EXPECT_TRUE(e.client_count() == 7);
+
+    auto match = [&](std::string_view packet) {
+        std::vector<uint32_t> clients;
+        size_t count = e.match(packet, [&](uint32_t client) { clients.push_back(client); });
+        EXPECT_TRUE(count == clients.size());
+        std::sort(clients.begin(), clients.end());
+        return clients;
+    };
+
+    EXPECT_TRUE(match("N0CALL-9>APRS:!4903.50N/07201.75W-") == std::vector<uint32_t>({ range, area, prefix, buddy, exclude }));
+    EXPECT_TRUE(match("n0call-9>APRS:!4803.50N/07201.75W-") == std::vector<uint32_t>({ prefix, buddy, exclude }));
+    EXPECT_TRUE(match("K1ABC>APRS:!4930.00N/07230.00W-") == std::vector<uint32_t>({ area, prefix }));
+    EXPECT_TRUE(match("W1AW>APRS::N0CALL   :hello") == std::vector<uint32_t>({ buddy, types }));
+    EXPECT_TRUE(match("N0CALL-1>APRS:_10090556c220s004g005t077") == std::vector<uint32_t>({ prefix, types }));
+    EXPECT_TRUE(match("VE7ABC>APRS:>status").empty());
+    EXPECT_TRUE(match("not a packet").empty());
+
+    // filters are replaced, unsupported terms are reported, the others apply
+    EXPECT_FALSE(e.filter(range, "r/49.05/-72.03 x/1 t/s"));
+    EXPECT_TRUE(match("N0CALL-9>APRS:!4903.50N/07201.75W-") == std::vector<uint32_t>({ area, prefix, buddy, exclude }));
+    EXPECT_TRUE(match("VE7ABC>APRS:>status") == std::vector<uint32_t>({ range }));
+
+    // a box across the antimeridian
+    EXPECT_TRUE(e.filter(none, "a/-17/177/-19/-178"));
+    EXPECT_TRUE(match("ZL1ABC>APRS:!1800.00S/17930.00W-") == std::vector<uint32_t>({ exclude, none }));
+    EXPECT_TRUE(match("ZL1ABC>APRS:!1800.00S/17930.00E-") == std::vector<uint32_t>({ exclude, none }));
+    EXPECT_TRUE(match("ZL1ABC>APRS:!1800.00S/17630.00E-") == std::vector<uint32_t>({ exclude }));
+
+    // removed clients match nothing, their ids are reused
+    e.remove_client(prefix);
+    e.remove_client(none);
+    EXPECT_TRUE(e.client_count() == 5);
+    EXPECT_TRUE(match("K1ABC>APRS:!4930.00N/07230.00W-") == std::vector<uint32_t>({ area }));
+    EXPECT_TRUE(match("ZL1ABC>APRS:!1800.00S/17930.00W-") == std::vector<uint32_t>({ exclude }));
+    EXPECT_TRUE(e.add_client() == none);
+    EXPECT_TRUE(e.filter(none, "b/*"));
+    EXPECT_TRUE(match("VE7ABC>APRS:>status") == std::vector<uint32_t>({ range, none }));
+}
+
+TEST(filter_engine, trie_size)
+{
+    // the trie nodes of replaced filters are freed and reused
+
+    filter_engine e;
+
+    uint32_t a = e.add_client();
+    uint32_t b = e.add_client();
+
+    EXPECT_TRUE(e.filter(a, "p/N0CALL"));
+
+    for (int i = 0; i < 1000; i++)
+    {
+        char filter[64];
+        std::snprintf(filter, sizeof(filter), "p/W%dX/K%d -p/VE%d", i, i * 7, i);
+        EXPECT_TRUE(e.filter(b, filter));
+        // two roots, N0CALL and at most three 5 character prefixes, thousands if never freed
+        EXPECT_TRUE(e.trie_size() <= 23);
+    }
+
+    std::vector<uint32_t> clients;
+    e.match("K6993>APRS:>status", [&](uint32_t client) { clients.push_back(client); });
+    EXPECT_TRUE(clients == std::vector<uint32_t>({ b }));
+
+    e.remove_client(b);
+    clients.clear();
+    e.match("N0CALL>APRS:>status", [&](uint32_t client) { clients.push_back(client); });
+    EXPECT_TRUE(clients == std::vector<uint32_t>({ a }));
+    EXPECT_TRUE(e.trie_size() <= 23);
+}
+
+#ifdef APRS_TRACK_HAS_THREADS
+
+TEST(feed_decoder, station_order)
+{
+    // the records of each station come out in the order its lines went in,
+    // and decode the same as decode_packet
+
+    feed_decoder decoder(4, 16);
+
+    std::vector<std::string> lines;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        char line[128];
+        std::snprintf(line, sizeof(line), "N%dA>APRS:!%02d%02d.%02dN/12218.00W>%d", i % 37, 40 + i % 9, i % 60, i % 100, i);
+        lines.push_back(line);
+    }
+
+    lines.push_back("not a packet");
+
+    std::unordered_map<uint64_t, uint64_t> last;
+    std::vector<feed_record> records;
+    bool ordered = true;
+
+    auto f = [&](const feed_record& r) {
+        auto it = last.find(r.station.value);
+        if (it != last.end() && it->second >= r.sequence)
+        {
+            ordered = false;
+        }
+        last[r.station.value] = r.sequence;
+        records.push_back(r);
+    };
+
+    for (const std::string& line : lines)
+    {
+        decoder.push(line, f);
+    }
+
+    decoder.finish(f);
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(records.size() == lines.size());
+    EXPECT_TRUE(last.size() == 38);
+
+    std::sort(records.begin(), records.end(), [](const feed_record& a, const feed_record& b) { return a.sequence < b.sequence; });
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        decoded_packet p;
+        bool decoded = decode_packet(lines[i], p);
+        EXPECT_TRUE(records[i].sequence == i);
+        EXPECT_TRUE(records[i].station == make_callsign_key(p.from));
+        EXPECT_TRUE(records[i].has_position == (decoded && p.has_position));
+        EXPECT_TRUE(records[i].fix.lat == p.fix.lat && records[i].fix.lon == p.fix.lon);
+    }
+
+    size_t decoded = 0;
+    for (const feed_stage_stats& s : decoder.stats())
+    {
+        decoded += s.lines;
+        EXPECT_TRUE(s.queue_depth == 0 && s.output_depth == 0);
+        EXPECT_TRUE(s.max_queue_depth <= 16);
+    }
+    EXPECT_TRUE(decoded == lines.size());
+}
+
+#endif
+
+TEST(duplicate_filter, check)
+{
+    using namespace std::chrono_literals;
+
+    duplicate_filter f(64, 30s);
+    EXPECT_TRUE(f.capacity() == 64);
+
+    EXPECT_FALSE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 1000ms));
+    EXPECT_TRUE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 2000ms));
+
+    // the path is ignored, trailing spaces and line endings too
+    EXPECT_TRUE(f.check("N0CALL>APRS,DIGI1*,WIDE2-1:!4903.50N/07201.75W-", 3000ms));
+    EXPECT_TRUE(f.check("N0CALL>APRS:!4903.50N/07201.75W- \r\n", 4000ms));
+
+    // different source, destination or information field
+    EXPECT_FALSE(f.check("N0CALL-1>APRS,WIDE1-1:!4903.50N/07201.75W-", 5000ms));
+    EXPECT_FALSE(f.check("N0CALL>APZ001,WIDE1-1:!4903.50N/07201.75W-", 5000ms));
+    EXPECT_FALSE(f.check("N0CALL>APRS,WIDE1-1:!4903.51N/07201.75W-", 5000ms));
+
+    // the window starts when the packet is first seen
+    EXPECT_TRUE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 30999ms));
+    EXPECT_FALSE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 31000ms));
+    EXPECT_TRUE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 31001ms));
+
+    EXPECT_TRUE(f.duplicates() == 5);
+
+    f.clear();
+    EXPECT_FALSE(f.check("N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-", 32000ms));
+
+    // more packets than the table holds, the oldest are evicted
+    duplicate_filter small(8, 30s);
+    for (int i = 0; i < 9; i++)
+    {
+        EXPECT_FALSE(small.check("N0CALL>APRS:>" + std::to_string(i), std::chrono::milliseconds(i)));
+    }
+    EXPECT_TRUE(small.evictions() == 1);
+    EXPECT_FALSE(small.check("N0CALL>APRS:>0", 10ms));
+    EXPECT_TRUE(small.check("N0CALL>APRS:>8", 10ms));
+}
+
+TEST(duplicate_filter, frames)
+{
+    using namespace std::chrono_literals;
+
+    // AX.25 frames have the same fingerprint as their TNC2 packets
+
+    std::string packets[] = {
+        "N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W-",
+        "N0CALL-9>APRS,WIDE1*,WIDE2-1:>",
+        "N0CALL-15>T2SP0W:`c.l+@&'/'\"G:}KJ6TMS|!:&0'p|!w#R!|3",
+    };
+
+    for (const std::string& packet : packets)
+    {
+        unsigned char frame[330];
+        size_t size = encode_ax25_frame(packet, frame, sizeof(frame));
+        EXPECT_TRUE(size > 0);
+        EXPECT_TRUE(frame_fingerprint(frame, size) == packet_fingerprint(packet));
+
+        duplicate_filter f;
+        EXPECT_FALSE(f.check(frame, size, 0ms));
+        EXPECT_TRUE(f.check(packet, 1ms));
+    }
+
+    unsigned char a[330];
+    unsigned char b[330];
+    size_t a_size = encode_ax25_frame("N0CALL>APRS,WIDE1-1,WIDE2-2:>Hello", a, sizeof(a));
+    size_t b_size = encode_ax25_frame("N0CALL>APRS,DIGI1*,WIDE1*,WIDE2-1:>Hello", b, sizeof(b));
+    EXPECT_TRUE(frame_fingerprint(a, a_size) == frame_fingerprint(b, b_size));
+}
+
+TEST(tracker, various_anonymous_structs)
+{
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('_');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            double speed = 0.0;
+            double track = 0.0;
+            int day = -1;
+            int hour = -1;
+            int minute = -1;
+            int second = -1;
+        };
+
+        s data{ 39.751166666667, -75.085333333333, 4.0, 335.0, 18, 16, 13, 0 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+
+        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/181613z3945.07N/07505.12W_335/008");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('_');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            int day = -1;
+            int hour = -1;
+            int minute = -1;
+            int second = -1;
+        };
+
+        s data{ 39.751166666667, -75.085333333333, 18, 16, 13, 0 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+
+        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/181613z3945.07N/07505.12W_");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('_');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            int day = -1;
+            int hour = -1;
+            int minute = -1;
+            // int second = -1; - required even if not used
+        };
+
+        s data{ 39.751166666667, -75.085333333333, 18, 16, 13 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::position_with_timestamp_utc);
+
+        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:/000000z3945.07N/07505.12W_");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('_');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+        };
+
+        s data{ 39.751166666667, -75.085333333333 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::position);
+
+        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!3945.07N/07505.12W_");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.mic_e_status(mic_e_status::en_route);
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('>');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            double speed = 0.0;
+            double track = 0.0;
+            double alt = 0.0;
+        };
+
+        s data{ 51.6145, -0.0485, 3.601, 297.0, 33.00 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+
+        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.mic_e_status(mic_e_status::en_route);
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('>');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            double speed = 0.0;
+            double track = 0.0;
+        };
+
+        s data{ 51.6145, -0.0485, 3.601, 297.0 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+
+        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.mic_e_status(mic_e_status::en_route);
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('>');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+        };
+
+        s data{ 51.6145, -0.0485 };
+
+        t.position(data);
+
+        std::string packet = t.packet_string_no_message(packet_type::mic_e);
+
+        EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwl \x1c>/");
+    }
+
+    {
+        tracker t;
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('[');
+
+        struct s
+        {
+            double lat = 0.0;
+            double lon = 0.0;
+            double speed = 0.0;
+            double track = 0.0;
+        };
+
+        s data{ 50.656773231546 , 6.4228800344424, 0.0856036, 360 };
+
+        t.position(data);
+
+        // Y - compression type
+        std::string packet = t.packet_string(packet_type::position_compressed);
+        EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!/4qheP+c)[!#Y");
+    }
+}
+
+TEST(tracker, position)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.mic_e_status(mic_e_status::en_route);
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+
+    struct s
+    {
+        double lat = 0.0;
+        double lon = 0.0;
+        double speed = 0.0;
+        double track = 0.0;
+        double alt = 0.0;
+    };
+
+    s data;
+
+    data.lat = 51.6145;
+    data.lon = -0.0485;
+    data.speed = 3.601;
+    data.track = 297.0;
+    data.alt = 33.00;
+
+    t.position(data);
+
+    std::string packet = t.packet_string_no_message(packet_type::mic_e);
+
+    EXPECT_TRUE(packet == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+
+    data.lat = 49.176666666667;
+    data.lon = -123.94916666667;
+
+    t.mic_e_status(mic_e_status::in_service);
+
+    t.position(data);
+
+    packet = t.packet_string_no_message(packet_type::mic_e);
+
+    EXPECT_TRUE(packet == "N0CALL>T9QPVP,WIDE1-1:`3T{lh}>/\"48}");
+}
+
+TEST(tracker, message_and_packet_bytes)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('_');
+
+    struct s
+    {
+        double lat = 0.0;
+        double lon = 0.0;
+    };
+
+    s data{ 39.751166666667, -75.085333333333 };
+
+    t.position(data);
+
+    // set message using a vector of bytes, by passing in the range
+
+    std::string message = "Hello World";
+    std::vector<unsigned char> message_bytes = { 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x57, 0x6f, 0x72, 0x6c, 0x64 };
+    t.message(message_bytes);
+
+    std::string packet = t.packet_string_no_message(packet_type::position);
+
+    EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!3945.07N/07505.12W_");
+
+    // get packet bytes, by passing in an output iterator
+
+    std::vector<unsigned char> packet_bytes;
+    t.packet(packet_type::position, std::back_inserter(packet_bytes));
+
+    std::string packet_from_bytes(packet_bytes.begin(), packet_bytes.end());
+
+    EXPECT_TRUE(packet_from_bytes == packet + message);
+
+    // set message using a vector of bytes, by passing in the input/output iterators
+
+    t.message(message_bytes.begin(), message_bytes.end());
+
+    // get packet bytes, by passing in a range
+
+    std::vector<unsigned char> packet_bytes_copy;
+    packet_bytes_copy.resize(packet_bytes.size());
+    t.packet(packet_type::position, packet_bytes_copy);
+
+    std::string packet_from_bytes_copy(packet_bytes_copy.begin(), packet_bytes_copy.end());
+
+    EXPECT_TRUE(packet_from_bytes_copy == packet + message);
+}
+
+TEST(tracker, shared_message)
+{
+    message_pool pool;
+
+    message_handle m1 = pool.intern("147.100MHz T110 +060");
+    message_handle m2 = pool.intern("147.100MHz T110 +060");
+    message_handle m3 = pool.intern("Hello World!");
+
+    EXPECT_EQ(m1, m2);
+    EXPECT_NE(m1, m3);
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.bytes(), 32);
+
+    tracker t1;
+    t1.from("N0CALL");
+    t1.to("APRS");
+    t1.path("WIDE1-1");
+    t1.position(49.176666666667, -123.94916666667);
+    t1.message(m1);
+
+    tracker t2 = t1;
+    t2.from("N1CALL");
+
+    EXPECT_TRUE(t1.message() == "147.100MHz T110 +060");
+    EXPECT_TRUE(t1.message_view() == "147.100MHz T110 +060");
+    EXPECT_TRUE(t1.packet_string(packet_type::position) == "N0CALL>APRS,WIDE1-1:!4910.60N/12356.95W>147.100MHz T110 +060");
+    EXPECT_TRUE(t2.packet_string(packet_type::position) == "N1CALL>APRS,WIDE1-1:!4910.60N/12356.95W>147.100MHz T110 +060");
+    data d;
+    d.lat = 49.176666666667;
+    d.lon = -123.94916666667;
+    EXPECT_TRUE(encode_position_packet_no_timestamp(t2, d) == "N1CALL>APRS,WIDE1-1:!4910.60N/12356.95W>147.100MHz T110 +060");
+
+    std::vector<unsigned char> bytes;
+    t1.packet(packet_type::position, std::back_inserter(bytes));
+    EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "N0CALL>APRS,WIDE1-1:!4910.60N/12356.95W>147.100MHz T110 +060");
+
+    // a message of its own replaces the shared message
+    t2.message("Hello");
+    EXPECT_TRUE(t2.message() == "Hello");
+    EXPECT_TRUE(t1.message() == "147.100MHz T110 +060");
+
+    m3.reset();
+    EXPECT_EQ(pool.collect(), 1);
+    EXPECT_EQ(pool.size(), 1);
+
+    m1.reset();
+    m2.reset();
+    EXPECT_EQ(pool.collect(), 0); // still used by t1
+
+    t1.message("");
+    EXPECT_EQ(pool.collect(), 1);
+    EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(tracker, profile)
+{
+    tracker_profile p;
+    p.to = "APRS";
+    p.path = "WIDE1-1";
+    p.symbol_table = '/';
+    p.symbol_code = '>';
+    p.algorithm = algorithm::periodic;
+    p.interval_seconds = 60;
+
+    auto shared = std::make_shared<shared_profile>(p);
+    EXPECT_EQ(shared->version(), 1);
+
+    tracker t1;
+    t1.path("WIDE2-2"); // replaced by the profile
+    t1.profile(shared);
+    t1.from("N0CALL");
+    t1.position(49.176666666667, -123.94916666667);
+
+    tracker t2;
+    t2.profile(shared);
+    t2.from("N1CALL");
+    t2.symbol_code('k'); // kept when the profile changes
+    t2.position(49.176666666667, -123.94916666667);
+
+    EXPECT_EQ(t1.profile(), shared);
+    EXPECT_EQ(t1.algorithm(), algorithm::periodic);
+    EXPECT_TRUE(t1.packet_string(packet_type::position) == "N0CALL>APRS,WIDE1-1:!4910.60N/12356.95W>");
+    EXPECT_TRUE(t2.packet_string(packet_type::position) == "N1CALL>APRS,WIDE1-1:!4910.60N/12356.95Wk");
+
+    p.path = "WIDE2-1";
+    p.symbol_code = '[';
+    p.messaging = true;
+    shared->store(p);
+    EXPECT_EQ(shared->version(), 2);
+    EXPECT_TRUE(shared->load()->path == "WIDE2-1");
+
+    // applied on the next update
+    EXPECT_TRUE(t1.packet_string(packet_type::position) == "N0CALL>APRS,WIDE1-1:!4910.60N/12356.95W>");
+
+    t1.update();
+    t2.update();
+
+    EXPECT_TRUE(t1.packet_string(packet_type::position) == "N0CALL>APRS,WIDE2-1:=4910.60N/12356.95W[");
+    EXPECT_TRUE(t2.packet_string(packet_type::position) == "N1CALL>APRS,WIDE2-1:=4910.60N/12356.95Wk");
+
+    // the settings not set on the tracker are read from the profile
+    EXPECT_EQ(&t1.path(), &shared->load()->path);
+    EXPECT_NE(&t2.path(), &shared->load()->path);
+
+    // copies of a tracker change their own settings
+    tracker t3 = t2;
+    t3.symbol_code('j');
+    EXPECT_EQ(t2.symbol_code(), 'k');
+    EXPECT_EQ(t3.symbol_code(), 'j');
+
+    // detached trackers keep the settings they have
+    t1.profile(nullptr);
+    shared->store(tracker_profile{});
+    t1.update();
+    EXPECT_TRUE(t1.path() == "WIDE2-1");
+}
+
+TEST(tracker, snapshot)
+{
+    tracker t;
+    t.from("N0CALL-10");
+    t.to("APZ001");
+    t.path("WIDE1-1,WIDE2-1");
+    t.symbol_table('\\');
+    t.symbol_code('k');
+    t.message("Hello World!");
+    t.messaging(true);
+    t.algorithm(algorithm::periodic);
+    t.interval_seconds(600);
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47, 10, 12, 30, 45);
+    t.update();
+    EXPECT_TRUE(t.updated());
+
+    std::vector<unsigned char> bytes;
+    t.snapshot(bytes);
+    tracker other;
+    other.from("N0CALL-9");
+    other.snapshot(bytes);
+
+    tracker restored;
+    restored.history_capacity(4);
+    restored.position(1.0, 2.0);
+
+    size_t size = restored.restore(bytes);
+    EXPECT_GT(size, 0);
+    EXPECT_LT(size, bytes.size());
+
+    EXPECT_EQ(restored.history_size(), 0);
+    for (packet_type p : { packet_type::position, packet_type::mic_e, packet_type::position_compressed_with_timestamp_utc })
+    {
+        EXPECT_TRUE(restored.packet_string(p) == t.packet_string(p));
+    }
+    EXPECT_TRUE(restored.algorithm() == algorithm::periodic);
+
+    // the restored tracker beaconed just now, a new one beacons right away
+    restored.update();
+    EXPECT_FALSE(restored.updated());
+    tracker fresh;
+    fresh.algorithm(algorithm::periodic);
+    fresh.update();
+    EXPECT_TRUE(fresh.updated());
+
+    // the records follow each other
+    tracker next;
+    EXPECT_EQ(next.restore(std::span<const unsigned char>(bytes).subspan(size)), bytes.size() - size);
+    EXPECT_TRUE(next.from() == "N0CALL-9");
+
+    // truncated records are rejected
+    tracker truncated;
+    truncated.from("N0CALL");
+    EXPECT_EQ(truncated.restore(std::span<const unsigned char>(bytes.data(), size - 1)), 0);
+    bytes[size - 1] ^= 0xFF;
+    EXPECT_EQ(truncated.restore(std::span<const unsigned char>(bytes.data(), 10)), 0);
+    EXPECT_TRUE(truncated.from() == "N0CALL");
+
+    // version 1 records have the fix in fixed point, 16 bit rates and speed, and no phase
+    std::vector<unsigned char> v1 = { 0, 0, 0, 0, 1 };
+    auto le = [&](uint64_t value, size_t n) { for (size_t i = 0; i < n; i++) v1.push_back(static_cast<unsigned char>(value >> (8 * i))); };
+    auto str = [&](std::string_view s) { le(s.size(), 2); v1.insert(v1.end(), s.begin(), s.end()); };
+    auto f64 = [&](double value) { uint64_t bits; std::memcpy(&bits, &value, 8); le(bits, 8); };
+    str("N0CALL-10");
+    str("APZ001");
+    str("WIDE1-1,WIDE2-1");
+    str("Hello World!");
+    le(static_cast<uint32_t>(491766667), 4);
+    le(static_cast<uint32_t>(-1239491667), 4);
+    le(15420, 4); // 154.2 feet
+    le(1594, 2); // 15.94 knots
+    le(300, 2); // 3 degrees
+    v1.insert(v1.end(), { 10, 12, 30, 45, 15 });
+    le(600, 4);
+    f64(4.0);
+    f64(52.0);
+    for (int value : { 60, 30, 15, 15, 255 }) le(static_cast<uint16_t>(value), 2);
+    le(1200, 4);
+    size_t mic_e_status_offset = v1.size() + 4;
+    v1.insert(v1.end(), { 'k', '\\', 0, static_cast<unsigned char>(algorithm::periodic), 0, 1, 0 });
+    le(0, 4);
+    le(0, 8);
+    le(0, 2);
+    le(0, 8);
+    le(0, 8);
+    f64(0.0);
+    v1[0] = static_cast<unsigned char>(v1.size());
+
+    t.phase(std::chrono::seconds(15));
+    tracker restored_v1;
+    EXPECT_EQ(restored_v1.restore(v1), v1.size());
+    EXPECT_EQ(restored_v1.phase().count(), -1);
+    EXPECT_TRUE(restored_v1.packet_string(packet_type::position) == t.packet_string(packet_type::position));
+
+    v1[4] = tracker_snapshot_version + 1;
+    EXPECT_EQ(restored_v1.restore(v1), 0);
+
+    // the fix and the rates are restored as they were set
+    t.position(49.176666666667, -123.94916666667, knots_to_mps(67.4999), 293.4996);
+    t.slow_rate(40000);
+    std::vector<unsigned char> v3;
+    t.snapshot(v3);
+    tracker restored_v3;
+    EXPECT_EQ(restored_v3.restore(v3), v3.size());
+    EXPECT_EQ(restored_v3.slow_rate(), 40000);
+    for (packet_type p : { packet_type::position, packet_type::mic_e, packet_type::position_compressed })
+    {
+        EXPECT_TRUE(restored_v3.packet_string(p) == t.packet_string(p));
+    }
+    EXPECT_TRUE(restored_v3.packet_string(packet_type::position).find("293/067") != std::string::npos);
+
+    // messages set from wider characters keep their bytes and length
+    for (int i = 0; i < 2; i++)
+    {
+        if (i == 0)
+        {
+            t.message(u"Hello");
+        }
+        else
+        {
+            t.message(L"Hello World");
+        }
+        std::vector<unsigned char> wide;
+        t.snapshot(wide);
+        tracker restored_wide;
+        EXPECT_EQ(restored_wide.restore(wide), wide.size());
+        std::vector<unsigned char> expected;
+        std::vector<unsigned char> actual;
+        t.message(std::back_inserter(expected));
+        restored_wide.message(std::back_inserter(actual));
+        EXPECT_TRUE(actual == expected);
+        EXPECT_TRUE(restored_wide.message_view() == t.message_view());
+        EXPECT_TRUE(restored_wide.packet_string(packet_type::position) == t.packet_string(packet_type::position));
+    }
+
+    // an out of range mic-e status is rejected, like an out of range algorithm
+    std::vector<unsigned char> status = v1;
+    status[4] = 1;
+    status[mic_e_status_offset] = static_cast<unsigned char>(mic_e_status::unknown);
+    EXPECT_EQ(restored_v1.restore(status), status.size());
+    status[mic_e_status_offset] = static_cast<unsigned char>(mic_e_status::unknown) + 1;
+    EXPECT_EQ(restored_v1.restore(status), 0);
+}
+
+TEST(tracker, phase)
+{
+    using namespace std::chrono;
+
+    milliseconds start = seconds(1735689600); // 2025-01-01 00:00:00 UTC
+
+    tracker a;
+    a.algorithm(algorithm::periodic);
+    a.interval_seconds(60);
+    a.phase(seconds(15));
+
+    tracker b;
+    b.algorithm(algorithm::periodic);
+    b.interval_seconds(60);
+
+    std::vector<int> beacons_a;
+    std::vector<int> beacons_b;
+
+    for (int second = 0; second < 200; second++)
+    {
+        a.update(start + seconds(second));
+        b.update(start + seconds(second));
+        if (a.updated()) beacons_a.push_back(second);
+        if (b.updated()) beacons_b.push_back(second);
+    }
+
+    // the first beacon waits for the slot, then one beacon per slot
+    EXPECT_EQ(beacons_a, (std::vector<int>{ 15, 75, 135, 195 }));
+
+    // without a phase the first update beacons
+    EXPECT_EQ(beacons_b, (std::vector<int>{ 0, 60, 120, 180 }));
+
+    // a clock stepped back restarts the interval, the beacons do not stop
+    b.update(start + seconds(1000));
+    EXPECT_TRUE(b.updated());
+    b.update(start + seconds(500));
+    EXPECT_FALSE(b.updated());
+    b.update(start + seconds(560));
+    EXPECT_TRUE(b.updated());
+
+    // the slots stay aligned when the updates are late
+    a.update(start + seconds(257));
+    EXPECT_TRUE(a.updated());
+    a.update(start + seconds(300));
+    EXPECT_FALSE(a.updated());
+    a.update(start + seconds(315));
+    EXPECT_TRUE(a.updated());
+
+    tracker c;
+    c.from("N0CALL-10");
+    c.phase_from_callsign();
+    tracker d;
+    d.from("N0CALL-11");
+    d.phase_from_callsign();
+    EXPECT_EQ(c.phase(), callsign_phase("N0CALL-10"));
+    EXPECT_NE(c.phase(), d.phase());
+    EXPECT_GE(c.phase().count(), 0);
+    EXPECT_LT(c.phase().count(), 3600000);
+
+    EXPECT_EQ(beacon_slot(milliseconds(59999), milliseconds(0), seconds(60)), 0);
+    EXPECT_EQ(beacon_slot(milliseconds(60000), milliseconds(0), seconds(60)), 1);
+    EXPECT_EQ(beacon_slot(milliseconds(0), milliseconds(1), seconds(60)), -1);
+}
+
+TEST(tracker, u8packet_string)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
+
+    t.message(u8"Hello 世界");
+
+    t.position(51.6145, -0.0485);
+    t.speed(3.601);
+    t.track(297.0);
+    t.alt(33.00);
+
+    std::u8string u8packet = t.u8packet_string(packet_type::mic_e);
+
+    EXPECT_TRUE(u8packet == u8"N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}Hello 世界");
+}
+
+TEST(tracker, position_compressed_with_timestamp)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.messaging(true);
+
+    t.position(51.6145, -0.0485, 3.601, 297.0, 33.00);
+    t.time(18, 16, 13, 42);
+
+    EXPECT_TRUE(t.packet_string(packet_type::position_compressed) == "N0CALL>APRS,WIDE1-1:=/4EcaNLqN>k<Y/A=000108");
+    EXPECT_TRUE(t.packet_string(packet_type::position_compressed_with_timestamp) == "N0CALL>APRS,WIDE1-1:@181613//4EcaNLqN>k<Y/A=000108");
+    EXPECT_TRUE(t.packet_string(packet_type::position_compressed_with_timestamp_utc) == "N0CALL>APRS,WIDE1-1:@181613z/4EcaNLqN>k<Y/A=000108");
+    EXPECT_TRUE(t.packet_string(packet_type::position_compressed_with_timestamp_utc_hms) == "N0CALL>APRS,WIDE1-1:@161342h/4EcaNLqN>k<Y/A=000108");
+
+    t.message("Hello");
+    t.messaging(false);
+
+    EXPECT_TRUE(t.packet_string(packet_type::position_compressed_with_timestamp_utc) == "N0CALL>APRS,WIDE1-1:/181613z/4EcaNLqN>k<Y/A=000108Hello");
+    EXPECT_TRUE(t.packet_string_no_message(packet_type::position_compressed_with_timestamp_utc) == "N0CALL>APRS,WIDE1-1:/181613z/4EcaNLqN>k<Y/A=000108");
+
+    std::vector<unsigned char> bytes;
+    t.packet(packet_type::position_compressed_with_timestamp_utc_hms, std::back_inserter(bytes));
+    EXPECT_TRUE(std::string(bytes.begin(), bytes.end()) == "N0CALL>APRS,WIDE1-1:/161342h/4EcaNLqN>k<Y/A=000108Hello");
+}
+
+TEST(tracker, packet_cache)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
+
+    EXPECT_FALSE(t.packet_cache());
+    t.packet_cache(true);
+
+    t.position(51.6145, -0.0485, 3.601, 297.0, 33.00);
+
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+
+    // a fix within the same quantization step encodes to the same bytes
+    t.position(51.61450001, -0.04850001, 3.601, 297.0001, 33.00);
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
+
+    // setters which affect the packet invalidate the cached packets
+    t.symbol_code('[');
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}[/\"48}");
+    t.from("N1CALL");
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N1CALL>UQ3VXW,WIDE1-1:`vZwlh}[/\"48}");
+    t.mic_e_status(mic_e_status::emergency);
+    EXPECT_TRUE(t.packet_string(packet_type::mic_e) == "N1CALL>513VXW,WIDE1-1:`vZwlh}[/\"48}");
+
+    // the message is not part of the cached packet
+    t.message("Hi");
+    EXPECT_TRUE(t.packet_string(packet_type::position).ends_with("Hi"));
+    t.message("Bye");
+    EXPECT_TRUE(t.packet_string(packet_type::position).ends_with("Bye"));
+
+    // a key only has the fields the packet type encodes
+    data d;
+    d.lat = 51.6145;
+    d.lon = -0.0485;
+    d.speed_knots = 7.0;
+    d.second = 10;
+
+    packet_cache_key first;
+    packet_cache_key second;
+    EXPECT_TRUE(make_packet_cache_key(packet_type::position, d, first));
+    d.second = 11;
+    EXPECT_TRUE(make_packet_cache_key(packet_type::position, d, second));
+    EXPECT_TRUE(first == second); // no timestamp, and no course, so no course and speed either
+    EXPECT_TRUE(make_packet_cache_key(packet_type::position_with_timestamp_utc_hms, d, second));
+    EXPECT_FALSE(first == second);
+}
+
+TEST(tracker, packet_cache_conformance)
+{
+    // Cached and incrementally rendered packets must be the same bytes as
+    // a full encode, for fixes nudged around the quantization steps of every encoder
+
+    packet_type types[] = {
+        packet_type::mic_e,
+        packet_type::position,
+        packet_type::position_compressed,
+        packet_type::position_with_timestamp,
+        packet_type::position_with_timestamp_utc,
+        packet_type::position_with_timestamp_utc_hms,
+        packet_type::position_compressed_with_timestamp,
+        packet_type::position_compressed_with_timestamp_utc,
+        packet_type::position_compressed_with_timestamp_utc_hms,
+        packet_type::smallest,
+    };
+
+    auto configure = [](tracker& t) {
+        t.from("N0CALL");
+        t.to("APRS");
+        t.path("WIDE1-1");
+        t.symbol_table('/');
+        t.symbol_code('>');
+    };
+
+    tracker cached;
+    configure(cached);
+    cached.packet_cache(true);
+
+    tracker reference;
+    configure(reference);
+
+    EXPECT_TRUE(cached.packet_cache());
+    EXPECT_FALSE(reference.packet_cache());
+
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return state / 4294967296.0;
+    };
+
+    double lat = 47.6080436707;
+    double lon = -122.3130035400;
+
+    for (int i = 0; i < 3000; i++)
+    {
+        // small steps, mostly below the resolution of the formats
+        lat += (next() - 0.5) * 0.00002;
+        lon += (next() - 0.5) * 0.00002;
+        double speed = 10.0 + (next() - 0.5) * 0.2;
+        double course = 90.0 + (next() - 0.5) * 2.0;
+        double alt = 100.0 + (next() - 0.5) * 0.5;
+        int second = (i / 7) % 60;
+
+        for (tracker* t : { &cached, &reference })
+        {
+            // exercise the individual setters as well
+            switch (i % 5)
+            {
+                case 0: t->position(lat, lon, speed, course, alt, 1, 2, 3, second); break;
+                case 1: t->position(lat, lon); break;
+                case 2: t->speed(speed); t->track(course); break;
+                case 3: t->alt(alt); t->time(4, (i / 60) % 60, second); break;
+                case 4: t->position(lat, lon, speed, course); break;
+            }
+        }
+
+        if (i == 1500)
+        {
+            // configuration changes are fully re-encoded
+            cached.ambiguity(1);
+            reference.ambiguity(1);
+            cached.mic_e_status(mic_e_status::en_route);
+            reference.mic_e_status(mic_e_status::en_route);
+        }
+
+        for (packet_type type : types)
+        {
+            ASSERT_TRUE(cached.packet_string(type) == reference.packet_string(type)) << i << " " << to_string(type);
+        }
+    }
+}
+
+TEST(tracker, packed_data)
+{
+    static_assert(sizeof(packed_data) <= 32);
+    static_assert(sizeof(tracker) <= 512); // the fleet footprint of the tracker memory benchmark
+
+    data d;
+    d.lat = 49.176666666667;
+    d.lon = -123.94916666667;
+    d.track_degrees = 3;
+    d.speed_knots = 15.999;
+
+    packed_data p = pack_data(d);
+    EXPECT_EQ(p.lat, 491766667);
+    EXPECT_EQ(p.lon, -1239491667);
+    EXPECT_EQ(p.speed, 1600);
+    EXPECT_EQ(p.track, 300);
+    EXPECT_TRUE(p.has_speed && p.has_track);
+    EXPECT_FALSE(p.has_alt || p.has_time);
+
+    data u = unpack_data(p);
+    EXPECT_NEAR(u.lat, d.lat, 1e-7);
+    EXPECT_NEAR(u.lon, d.lon, 1e-7);
+    EXPECT_DOUBLE_EQ(u.speed_knots.value(), 16.0);
+    EXPECT_DOUBLE_EQ(u.track_degrees.value(), 3.0);
+    EXPECT_FALSE(u.alt_feet.has_value());
+    EXPECT_FALSE(u.has_time);
+
+    // packing is idempotent, what the tracker stores encodes the same way every time
+    packed_data p2 = pack_data(u);
+    EXPECT_EQ(p2.lat, p.lat);
+    EXPECT_EQ(p2.lon, p.lon);
+    EXPECT_EQ(p2.speed, p.speed);
+
+    // speeds above 655.35 knots are kept, the uncompressed format goes up to 999 knots
+    d.speed_knots = 1000.0;
+    d.track_degrees = -1.0;
+    d.alt_feet = -100.5;
+    p = pack_data(d);
+    EXPECT_EQ(p.speed, 100000u);
+    EXPECT_DOUBLE_EQ(unpack_data(p).speed_knots.value(), 1000.0);
+    EXPECT_EQ(p.track, 35900u); // normalized to 0 to 360 degrees
+    d.track_degrees = 725.0;
+    EXPECT_EQ(pack_data(d).track, 500u);
+    d.track_degrees = 360.0;
+    EXPECT_EQ(pack_data(d).track, 36000u);
+    EXPECT_EQ(p.alt, -10050);
+
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    t.path("WIDE1-1");
+    t.position(49.176666666667, -123.94916666667);
+    EXPECT_TRUE(t.packet_string(packet_type::position) == "N0CALL>APRS,WIDE1-1:!4910.60N/12356.95W>");
+
+    t.position(49.0583, -72.0292, 400.0, 90.0); // 777.5 knots
+    EXPECT_TRUE(t.packet_string(packet_type::position).ends_with("090/778"));
+}
+
+TEST(tracker, encoded_bytes)
+{
+    // The tracker encodes the fix as it was set, the packets are the same
+    // as before the fix was stored in fixed point
 
-    EXPECT_TRUE(packet == "N0CALL>T9QPVP,WIDE1-1:`3T{lh}>/\"48}");
+    tracker t;
+    t.from("N0CALL-10");
+    t.to("APRS");
+    t.path("WIDE1-1");
+
+    // rounding the fix before the encoders rounds it would give 294/068
+    t.position(17.8941, -101.7217, knots_to_mps(67.4999), 293.4996);
+    EXPECT_TRUE(t.packet_string(packet_type::position).ends_with("293/067"));
+
+    // the FNV-1a hash of the packets of 20000 pseudo random fixes, in every
+    // encoding, before the fix was stored in fixed point
+    uint64_t state = 88172645463325252ull;
+    auto random = [&]()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<double>(state >> 11) * (1.0 / 9007199254740992.0);
+    };
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (int i = 0; i < 20000; i++)
+    {
+        double lat = random() * 180.0 - 90.0;
+        double lon = random() * 360.0 - 180.0;
+        double speed = random() * 60.0;
+        double track = random() * 360.0;
+        double alt = random() * 12000.0 - 100.0;
+        int day = 1 + static_cast<int>(random() * 28);
+        int hour = static_cast<int>(random() * 24);
+        int minute = static_cast<int>(random() * 60);
+        int second = static_cast<int>(random() * 60);
+
+        if (i % 3 == 0)
+        {
+            t.position(lat, lon, speed, track, alt, day, hour, minute, second);
+        }
+        else if (i % 3 == 1)
+        {
+            t.position(lat, lon, speed, track, alt);
+        }
+        else
+        {
+            t.position(lat, lon, speed, track);
+        }
+
+        for (int p = 0; p < static_cast<int>(packet_type::smallest); p++)
+        {
+            std::string packet = t.packet_string(static_cast<packet_type>(p)) + "\n";
+            for (char c : packet)
+            {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+            }
+        }
+    }
+
+    EXPECT_EQ(hash, 0xd22c51edf92c2346ull);
 }
 
-TEST(tracker, message_and_packet_bytes)
+TEST(tracker, history)
+{
+    tracker t;
+    EXPECT_EQ(t.history_capacity(), 0);
+
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47);
+    EXPECT_EQ(t.history_size(), 0);
+
+    t.history_capacity(4);
+    EXPECT_EQ(t.history_capacity(), 4);
+
+    double tracks[] = { 10.0, 350.0, 20.0, 200.0, 90.0, 95.0, 100.0 };
+    double speeds[] = { 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0 };
+
+    for (size_t i = 0; i < std::size(tracks); i++)
+    {
+        t.position(49.176666666667 + i * 0.001, -123.94916666667 + i * 0.002, speeds[i], tracks[i], 47);
+
+        // the aggregates are maintained incrementally, compare with a full recomputation
+        double distance = 0.0;
+        double heading_change = 0.0;
+        double speed = 0.0;
+
+        for (size_t j = 0; j < t.history_size(); j++)
+        {
+            data d = t.history(j);
+            speed += knots_to_mps(d.speed_knots.value());
+            if (j > 0)
+            {
+                data previous = t.history(j - 1);
+                distance += distance_meters(previous.lat, previous.lon, d.lat, d.lon);
+                double change = std::abs(d.track_degrees.value() - previous.track_degrees.value());
+                heading_change += std::min(change, 360.0 - change);
+            }
+        }
+
+        EXPECT_EQ(t.history_size(), std::min<size_t>(i + 1, 4));
+        EXPECT_NEAR(t.history_distance(), distance, 0.05);
+        EXPECT_NEAR(t.history_heading_change(), heading_change, 0.01);
+        EXPECT_NEAR(t.history_average_speed(), speed / t.history_size(), 0.01);
+    }
+
+    // oldest first
+    std::vector<data> fixes;
+    t.history(std::back_inserter(fixes));
+    ASSERT_EQ(fixes.size(), 4);
+    EXPECT_DOUBLE_EQ(fixes[0].track_degrees.value(), 200.0);
+    EXPECT_DOUBLE_EQ(fixes[3].track_degrees.value(), 100.0);
+    EXPECT_NEAR(fixes[3].lat, 49.182666666667, 1e-7);
+
+    EXPECT_NEAR(t.history_heading_change(), 110.0 + 5.0 + 5.0, 0.01);
+
+    // 0.001 degrees of latitude is about 111 meters
+    EXPECT_NEAR(distance_meters(49.0, -123.0, 49.001, -123.0), 111.2, 0.1);
+
+    t.history_capacity(4);
+    EXPECT_EQ(t.history_size(), 0);
+    EXPECT_DOUBLE_EQ(t.history_distance(), 0.0);
+    EXPECT_DOUBLE_EQ(t.history_average_speed(), 0.0);
+}
+
+TEST(tracker, history_capacity_one)
+{
+    tracker t;
+    t.history_capacity(1);
+
+    double tracks[] = { 10.0, 190.0, 10.0, 190.0 };
+
+    for (size_t i = 0; i < std::size(tracks); i++)
+    {
+        t.position(49.176666666667 + i * 0.01, -123.94916666667, 5.0 + i, tracks[i], 47);
+
+        EXPECT_EQ(t.history_size(), 1);
+        EXPECT_DOUBLE_EQ(t.history_distance(), 0.0);
+        EXPECT_DOUBLE_EQ(t.history_heading_change(), 0.0);
+        EXPECT_NEAR(t.history_average_speed(), 5.0 + i, 0.01);
+    }
+
+    EXPECT_DOUBLE_EQ(t.history(0).track_degrees.value(), 190.0);
+
+    // past the size, the fix is empty
+    EXPECT_FALSE(t.history(1).track_degrees.has_value());
+    EXPECT_DOUBLE_EQ(t.history(1).lat, 0.0);
+}
+
+TEST(tracker, history_out_of_range)
+{
+    tracker t;
+
+    // no history, a capacity of 0
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47);
+    EXPECT_EQ(t.history_size(), 0);
+    EXPECT_FALSE(t.history(0).speed_knots.has_value());
+    EXPECT_DOUBLE_EQ(t.history(0).lat, 0.0);
+
+    // slots which are allocated but not filled yet
+    t.history_capacity(4);
+    t.position(49.176666666667, -123.94916666667, 8.2, 3, 47);
+    t.position(49.186666666667, -123.94916666667, 8.2, 3, 47);
+    EXPECT_EQ(t.history_size(), 2);
+    EXPECT_NEAR(t.history(1).lat, 49.186666666667, 1e-7);
+    EXPECT_FALSE(t.history(2).speed_knots.has_value());
+    EXPECT_FALSE(t.history(3).speed_knots.has_value());
+    EXPECT_FALSE(t.history(SIZE_MAX).speed_knots.has_value());
+}
+
+TEST(tracker, smallest_packet_type)
 {
     tracker t;
     t.from("N0CALL");
     t.to("APRS");
     t.path("WIDE1-1");
     t.symbol_table('/');
-    t.symbol_code('_');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
 
-    struct s
-    {
-        double lat = 0.0;
-        double lon = 0.0;
-    };
+    t.position(51.6145, -0.0485, 3.601, 297.0, 33.00);
 
-    s data{ 39.751166666667, -75.085333333333 };
+    EXPECT_TRUE(t.smallest_packet_type() == packet_type::mic_e);
+    EXPECT_TRUE(t.packet_string(packet_type::smallest) == "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}");
 
-    t.position(data);
+    // Mic-E has no messaging flag
+    t.messaging(true);
+    EXPECT_TRUE(t.smallest_packet_type() == packet_type::position_compressed);
+    EXPECT_TRUE(t.packet_string(packet_type::smallest) == "N0CALL>APRS,WIDE1-1:=/4EcaNLqN>k<Y/A=000108");
 
-    // set message using a vector of bytes, by passing in the range
+    // compressed positions cannot be ambiguous
+    t.ambiguity(1);
+    EXPECT_TRUE(t.smallest_packet_type() == packet_type::position);
 
-    std::string message = "Hello World";
-    std::vector<unsigned char> message_bytes = { 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x57, 0x6f, 0x72, 0x6c, 0x64 };
-    t.message(message_bytes);
+    // only the timestamped formats carry the time
+    t.ambiguity(0);
+    t.time(18, 16, 13, 0);
+    EXPECT_TRUE(t.smallest_packet_type() == packet_type::position_compressed_with_timestamp_utc);
+    EXPECT_TRUE(t.packet_string_no_message(packet_type::smallest) == "N0CALL>APRS,WIDE1-1:@181613z/4EcaNLqN>k<Y/A=000108");
 
-    std::string packet = t.packet_string_no_message(packet_type::position);
+    t.ambiguity(1);
+    EXPECT_TRUE(t.smallest_packet_type() == packet_type::position_with_timestamp_utc);
+    EXPECT_TRUE(t.packet_string_no_message(packet_type::smallest) == "N0CALL>APRS,WIDE1-1:@181613z5136.8 N/00002.91W>297/007/A=000108");
+}
 
-    EXPECT_TRUE(packet == "N0CALL>APRS,WIDE1-1:!3945.07N/07505.12W_");
+TEST(tracker, airtime)
+{
+    tracker t;
+    t.from("N0CALL");
+    t.path("WIDE1-1");
+    t.symbol_table('/');
+    t.symbol_code('>');
+    t.mic_e_status(mic_e_status::en_route);
 
-    // get packet bytes, by passing in an output iterator
+    t.position(51.6145, -0.0485, 3.601, 297.0, 33.00);
 
-    std::vector<unsigned char> packet_bytes;
-    t.packet(packet_type::position, std::back_inserter(packet_bytes));
+    EXPECT_TRUE(t.baud_rate() == 1200);
 
-    std::string packet_from_bytes(packet_bytes.begin(), packet_bytes.end());
+    packet_airtime a = t.airtime(packet_type::mic_e);
 
-    EXPECT_TRUE(packet_from_bytes == packet + message);
+    EXPECT_TRUE(a.packet_bytes == 35);
+    EXPECT_TRUE(a.frame_bytes == 38);
+    EXPECT_TRUE(a.frame_bits == 323);
+    EXPECT_NEAR(a.seconds, 323 / 1200.0, 0.000001);
 
-    // set message using a vector of bytes, by passing in the input/output iterators
+    EXPECT_TRUE(t.airtime(packet_type::smallest).frame_bits == a.frame_bits);
 
-    t.message(message_bytes.begin(), message_bytes.end());
+    EXPECT_TRUE(t.total_packets() == 0);
+    EXPECT_TRUE(t.total_bytes() == 0);
 
-    // get packet bytes, by passing in a range
+    t.account(a);
+    t.account(t.airtime(packet_type::position));
 
-    std::vector<unsigned char> packet_bytes_copy;
-    packet_bytes_copy.resize(packet_bytes.size());
-    t.packet(packet_type::position, packet_bytes_copy);
+    EXPECT_TRUE(t.total_packets() == 2);
+    EXPECT_TRUE(t.total_bytes() == a.packet_bytes + t.airtime(packet_type::position).packet_bytes);
+    EXPECT_NEAR(t.total_airtime_seconds(), a.seconds + t.airtime(packet_type::position).seconds, 0.000001);
 
-    std::string packet_from_bytes_copy(packet_bytes_copy.begin(), packet_bytes_copy.end());
+    t.baud_rate(300);
+    EXPECT_NEAR(t.airtime(packet_type::mic_e).seconds, 323 / 300.0, 0.000001);
+}
 
-    EXPECT_TRUE(packet_from_bytes_copy == packet + message);
+TEST(transmit_arbiter, airtime)
+{
+    transmit_arbiter a;
+    a.baud_rate(1200);
+    a.txdelay(std::chrono::milliseconds(300));
+
+    // 323 bits at 1200 baud, plus TXDELAY
+    EXPECT_TRUE(a.airtime("N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}").count() == 300000 + 269167);
 }
 
-TEST(tracker, u8packet_string)
+TEST(transmit_arbiter, budget_and_spacing)
+{
+    using namespace std::chrono;
+
+    std::string packet = "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}";
+
+    transmit_arbiter a;
+    a.txdelay(milliseconds(300));
+    a.budget(0.1);
+    a.burst(milliseconds(1200));
+    a.jitter(milliseconds(0));
+
+    EXPECT_TRUE(a.request(packet, false, milliseconds(0)));
+    EXPECT_TRUE(a.next_time() == milliseconds(570));
+
+    // The channel is held while the previous frame is on the air
+    EXPECT_FALSE(a.request(packet, false, milliseconds(100)));
+
+    // Enough tokens are left for a second frame
+    EXPECT_TRUE(a.request(packet, false, milliseconds(600)));
+
+    // The bucket is now empty, the next frame is deferred until refilled
+    EXPECT_FALSE(a.request(packet, false, milliseconds(1200)));
+    EXPECT_TRUE(a.next_time() > milliseconds(1200));
+    EXPECT_FALSE(a.request(packet, false, a.next_time() - milliseconds(1)));
+    EXPECT_TRUE(a.request(packet, false, a.next_time()));
+
+    EXPECT_TRUE(a.granted() == 3);
+    EXPECT_TRUE(a.deferred() == 3);
+    EXPECT_TRUE(a.total_airtime() == microseconds(3 * 569167));
+}
+
+TEST(transmit_arbiter, burst_smaller_than_frame)
+{
+    using namespace std::chrono;
+
+    std::string packet = "N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}";
+
+    transmit_arbiter a;
+    a.txdelay(milliseconds(300));
+    a.budget(0.1);
+    a.burst(milliseconds(200)); // less than the 569 ms of airtime of the frame
+    a.jitter(milliseconds(0));
+
+    // A full bucket grants the frame, and goes negative
+    EXPECT_TRUE(a.request(packet, false, milliseconds(0)));
+    EXPECT_FALSE(a.request(packet, false, milliseconds(1000)));
+
+    // The debt and the burst are refilled at 10% of the channel time
+    EXPECT_TRUE(a.next_time() == milliseconds(5692));
+    EXPECT_FALSE(a.request(packet, false, a.next_time() - milliseconds(1)));
+    EXPECT_TRUE(a.request(packet, false, a.next_time()));
+
+    EXPECT_TRUE(a.granted() == 2);
+}
+
+TEST(transmit_arbiter, emergency_priority)
 {
+    using namespace std::chrono;
+
     tracker t;
     t.from("N0CALL");
     t.path("WIDE1-1");
     t.symbol_table('/');
     t.symbol_code('>');
     t.mic_e_status(mic_e_status::en_route);
+    t.position(51.6145, -0.0485, 3.601, 297.0, 33.00);
 
-    t.message(u8"Hello 世界");
+    transmit_arbiter a;
+    a.budget(0.01);
+    a.burst(milliseconds(600));
+    a.jitter(milliseconds(0));
 
-    t.position(51.6145, -0.0485);
-    t.speed(3.601);
-    t.track(297.0);
-    t.alt(33.00);
+    EXPECT_TRUE(a.request(t, packet_type::mic_e, milliseconds(0)));
+    EXPECT_FALSE(a.request(t, packet_type::mic_e, milliseconds(1000)));
 
-    std::u8string u8packet = t.u8packet_string(packet_type::mic_e);
+    t.mic_e_status(mic_e_status::emergency);
 
-    EXPECT_TRUE(u8packet == u8"N0CALL>UQ3VXW,WIDE1-1:`vZwlh}>/\"48}Hello 世界");
+    // Emergencies are not held back by spacing or by the budget
+    EXPECT_TRUE(a.request(t, packet_type::mic_e, milliseconds(1000)));
+    EXPECT_TRUE(a.request(t, packet_type::mic_e, milliseconds(1001)));
 }
 
-TEST(tracker, auto_tests)
+TEST(transmit_arbiter, deterministic)
 {
-    std::string file_path = INPUT_TEST_FILE;
+    using namespace std::chrono;
 
-    std::vector<packet_data> packets = parse_json_basic(file_path);
+    std::string packet = "N0CALL>APRS,WIDE1-1:!4903.50N/07201.75W>";
 
-    EXPECT_TRUE(!packets.empty());
+    auto run = [&](uint32_t seed) {
+        transmit_arbiter a;
+        a.seed(seed);
+        a.jitter(milliseconds(2000));
+        std::vector<milliseconds> times;
+        for (int i = 0; i < 200; i++)
+        {
+            milliseconds now = milliseconds(i * 250);
+            if (a.request(packet, false, now))
+            {
+                times.push_back(now);
+            }
+        }
+        return times;
+    };
 
-    for (const auto& packet : packets)
+    EXPECT_TRUE(run(42) == run(42));
+    EXPECT_FALSE(run(42) == run(7));
+}
+
+TEST(track_log, round_trip)
+{
+    // A vehicle on a steady course, with a stop, a turn and a gap in the fixes
+
+    std::vector<track_log_entry> entries;
+
+    int64_t time = 1735689600; // 2025-01-01 00:00:00 UTC
+    double lat = 47.6080436707;
+    double lon = -122.3130035400;
+
+    for (int i = 0; i < 3000; i++)
+    {
+        data d;
+        d.lat = lat;
+        d.lon = lon;
+        d.speed_knots = (i >= 1000 && i < 1100) ? 0.0 : 30.0;
+        d.track_degrees = i < 2000 ? 90.0 : 180.0;
+        d.alt_feet = 150.0 + (i % 7);
+        d.has_time = i >= 100;
+
+        track_log_entry entry;
+        entry.time = time;
+        entry.fix = pack_data(d);
+        entries.push_back(entry);
+
+        time += (i == 2500) ? 600 : 1;
+        if (d.speed_knots.value() > 0)
+        {
+            if (i < 2000) lon += 0.0002; else lat -= 0.00014;
+        }
+    }
+
+    track_log_writer writer(1024);
+    for (const track_log_entry& entry : entries)
+    {
+        writer.append(entry);
+    }
+
+    std::vector<unsigned char> bytes = writer.finish();
+
+    EXPECT_EQ(writer.size(), entries.size());
+    EXPECT_LT(bytes.size(), entries.size() * 4);
+
+    track_log_reader reader(bytes);
+    ASSERT_TRUE(reader.valid());
+    EXPECT_EQ(reader.size(), entries.size());
+    EXPECT_EQ(reader.block_count(), 3);
+    EXPECT_EQ(reader.block(1).first_time, entries[1024].time);
+
+    size_t i = 0;
+    for (const track_log_entry& entry : reader)
+    {
+        ASSERT_LT(i, entries.size());
+        EXPECT_EQ(entry.time, entries[i].time);
+        EXPECT_EQ(entry.fix.lat, entries[i].fix.lat);
+        EXPECT_EQ(entry.fix.lon, entries[i].fix.lon);
+        EXPECT_EQ(entry.fix.alt, entries[i].fix.alt);
+        EXPECT_EQ(entry.fix.speed, entries[i].fix.speed);
+        EXPECT_EQ(entry.fix.track, entries[i].fix.track);
+        EXPECT_EQ(entry.fix.has_time, entries[i].fix.has_time);
+        i++;
+    }
+    EXPECT_EQ(i, entries.size());
+
+    // the time of day is derived from the time
+    const track_log_entry& last = *std::next(reader.begin(), 2999);
+    EXPECT_EQ(last.fix.day, 1);
+    EXPECT_EQ(last.fix.hour, 0);
+    EXPECT_EQ(last.fix.minute, 59);
+    EXPECT_EQ(last.fix.second, 58);
+
+    size_t count = 0;
+    reader.for_each([&](const track_log_entry& entry) {
+        EXPECT_EQ(entry.fix.lat, entries[count].fix.lat);
+        count++;
+    });
+    EXPECT_EQ(count, entries.size());
+
+    // truncated logs are rejected
+    EXPECT_FALSE(track_log_reader(std::span<const unsigned char>(bytes.data(), bytes.size() - 1)).valid());
+    EXPECT_TRUE(track_log_reader().begin() == track_log_reader().end());
+
+#ifdef APRS_TRACK_HAS_MMAP
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "aprstrack_track_log_test.aptl";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    mapped_file mapped(path.string().c_str());
+    ASSERT_TRUE(mapped.is_open());
+    track_log_reader mapped_reader(mapped.bytes());
+    EXPECT_EQ(std::distance(mapped_reader.begin(), mapped_reader.end()), static_cast<std::ptrdiff_t>(entries.size()));
+    mapped.close();
+    std::filesystem::remove(path);
+#endif
+}
+
+TEST(track_log, seek)
+{
+    track_log_writer writer(100);
+
+    for (int64_t i = 0; i < 1000; i++)
+    {
+        data d;
+        d.lat = 47.6 + i * 1e-4;
+        d.lon = -122.3;
+        writer.append(i * 10, d);
+    }
+
+    std::vector<unsigned char> bytes = writer.finish();
+    track_log_reader reader(bytes);
+    EXPECT_EQ(reader.block_count(), 10);
+
+    auto it = reader.seek(5555);
+    ASSERT_TRUE(it != reader.end());
+    EXPECT_EQ(it->time, 5560);
+    EXPECT_EQ(it->fix.lat, pack_degrees(47.6 + 556 * 1e-4));
+    EXPECT_EQ(std::distance(it, reader.end()), 444);
+
+    EXPECT_EQ(reader.seek(-1)->time, 0);
+    EXPECT_EQ(reader.seek(990)->time, 990);
+    EXPECT_TRUE(reader.seek(9991) == reader.end());
+}
+
+TEST(track_log, corrupt_footer)
+{
+    // footer values which would wrap the size checks are rejected
+
+    track_log_writer writer(100);
+
+    for (int64_t i = 0; i < 300; i++)
+    {
+        data d;
+        d.lat = 47.6 + i * 1e-4;
+        d.lon = -122.3;
+        writer.append(i * 10, d);
+    }
+
+    const std::vector<unsigned char> bytes = writer.finish();
+    ASSERT_TRUE(track_log_reader(bytes).valid());
+
+    auto corrupt = [&](uint64_t index_offset, uint32_t block_count) {
+        std::vector<unsigned char> copy = bytes;
+        unsigned char* footer = copy.data() + copy.size() - 24;
+        for (int i = 0; i < 8; i++)
+        {
+            footer[i] = static_cast<unsigned char>(index_offset >> (i * 8));
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            footer[16 + i] = static_cast<unsigned char>(block_count >> (i * 8));
+        }
+        return track_log_reader(copy).valid();
+    };
+
+    uint64_t end = bytes.size() - 24;
+    track_log_reader reader(bytes);
+    uint64_t index_offset = end - reader.block_count() * 32;
+
+    EXPECT_TRUE(reader.block_count() == 3);
+    EXPECT_TRUE(corrupt(index_offset, 3));
+    EXPECT_FALSE(corrupt(index_offset, 4));
+    EXPECT_FALSE(corrupt(end + 1, 0));
+    EXPECT_FALSE(corrupt(UINT64_MAX, 0));
+    EXPECT_FALSE(corrupt(end - 0xFFFFFFFFull * 32, 0xFFFFFFFFu));
+}
+
+TEST(position_store, round_trip)
+{
+    // Two vehicles on steady courses with stops, turns and gaps, and a
+    // station which barely moves, across several chunks
+
+    position_store store(256);
+
+    std::vector<track_log_entry> entries[3];
+    callsign_key keys[3] = { make_callsign_key("N0CALL-9"), make_callsign_key("N0CALL-7"), make_callsign_key("N0CALL") };
+
+    int64_t time = 1735689600; // 2025-01-01 00:00:00 UTC
+
+    for (int i = 0; i < 1000; i++)
+    {
+        for (int v = 0; v < 3; v++)
+        {
+            data d;
+            d.lat = v == 2 ? 47.5 : 47.6080436707 - (i >= 600 ? (i - 600) * 0.00014 : 0.0) * (v + 1);
+            d.lon = v == 2 ? -122.5 : -122.3130035400 + (i < 600 ? i * 0.0002 : 0.12) * (v + 1);
+            d.speed_knots = (i >= 300 && i < 350) || v == 2 ? 0.0 : 30.0 + v;
+            d.track_degrees = i < 600 ? 90.0 : 180.0;
+            if (v != 1)
+            {
+                d.alt_feet = 150.0 + (i % 7);
+            }
+            d.has_time = i >= 100;
+
+            track_log_entry entry;
+            entry.time = time + i + (i >= 800 ? 600 : 0) + v;
+            entry.fix = pack_data(d);
+            entries[v].push_back(entry);
+
+            EXPECT_TRUE(store.append(keys[v], entry));
+        }
+    }
+
+    EXPECT_EQ(store.size(), 3000);
+    EXPECT_EQ(store.station_count(), 3);
+    EXPECT_LT(store.memory_bytes(), 3000 * 8);
+
+    for (int v = 0; v < 3; v++)
+    {
+        size_t i = 0;
+        size_t count = store.history(keys[v], INT64_MIN, INT64_MAX, [&](callsign_key key, const track_log_entry& entry) {
+            ASSERT_LT(i, entries[v].size());
+            EXPECT_TRUE(key == keys[v]);
+            EXPECT_EQ(entry.time, entries[v][i].time);
+            EXPECT_EQ(entry.fix.lat, entries[v][i].fix.lat);
+            EXPECT_EQ(entry.fix.lon, entries[v][i].fix.lon);
+            EXPECT_EQ(entry.fix.alt, entries[v][i].fix.alt);
+            EXPECT_EQ(entry.fix.speed, entries[v][i].fix.speed);
+            EXPECT_EQ(entry.fix.track, entries[v][i].fix.track);
+            EXPECT_EQ(entry.fix.has_alt, entries[v][i].fix.has_alt);
+            EXPECT_EQ(entry.fix.has_time, entries[v][i].fix.has_time);
+            i++;
+        });
+        EXPECT_EQ(count, entries[v].size());
+    }
+
+    // fixes are appended in time order
+    EXPECT_FALSE(store.append(keys[0], entries[0][10]));
+    EXPECT_FALSE(store.append(callsign_key{}, entries[0].back()));
+    EXPECT_EQ(store.size(), 3000);
+
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_EQ(store.history(keys[0], INT64_MIN, INT64_MAX, [](callsign_key, const track_log_entry&) {}), 0);
+}
+
+TEST(position_store, queries)
+{
+    position_store store(100);
+
+    for (int64_t i = 0; i < 1000; i++)
     {
-        std::string expected_packet_string = packet.packet;
+        for (int s = 0; s < 10; s++)
+        {
+            data d;
+            d.lat = 40.0 + s;
+            d.lon = s < 5 ? -179.0 + i * 1e-3 : 179.0 + i * 1e-3;
+            store.append(make_callsign_key("N" + std::to_string(s) + "A"), i * 10, d);
+        }
+    }
+
+    auto none = [](callsign_key, const track_log_entry&) {};
+
+    EXPECT_EQ(store.query_time(0, 9990, none), 10000);
+    EXPECT_EQ(store.query_time(5000, 5999, none), 1000);
+    EXPECT_EQ(store.query_time(5555, 5555, none), 0);
+    EXPECT_EQ(store.query_time(10000, 20000, none), 0);
+
+    std::set<std::string> stations;
+    size_t count = store.query_box(1000, 1990, 42.5, -180.0, 41.5, -178.0, [&](callsign_key key, const track_log_entry& entry) {
+        stations.insert(std::string(to_string(key)));
+        EXPECT_TRUE(entry.time >= 1000 && entry.time <= 1990);
+    });
+    EXPECT_EQ(count, 100);
+    EXPECT_TRUE(stations == std::set<std::string>({ "N2A" }));
+
+    // across the antimeridian
+    EXPECT_EQ(store.query_box(0, 9990, 90.0, 179.5, -90.0, -178.5, none), 5 * 501 + 5 * 500);
+    EXPECT_EQ(store.query_box(0, 9990, 45.5, 170.0, 44.5, 179.5, none), 501);
+}
+
+TEST(geojson_reader, line_string)
+{
+    // the layout of scripts/generate_route.py, with the speed labels
+    std::string_view document = R"({
+  "features": [
+    {
+      "geometry": {
+        "coordinates": [
+          [ -122.34622955322266, 47.628700256347656 ],
+          [ -122.3462, 4.76284e1, 12.5 ],
+          [-122.3463,47.628]
+        ],
+        "type": "LineString"
+      },
+      "properties": { "name": "coordinates", "stroke-width": 3, "co\"ordinates": [ [ 1, 2 ] ], "visible": true }
+    },
+    {
+      "type": "Feature",
+      "geometry": { "type": "Point", "coordinates": [ 47.6287, -122.3462 ] },
+      "properties": { "name": "Speed: 25 mph", "marker-color": "#FF0000" }
+    },
+    {
+      "type": "Feature",
+      "geometry": { "type": "LineString", "coordinates": [ [ -122.0, 47.0 ] ] }
+    }
+  ],
+  "type": "FeatureCollection"
+})";
+
+    // any chunking gives the same positions
+    for (size_t chunk_size = 1; chunk_size <= document.size(); chunk_size += (chunk_size < 16 ? 1 : 37))
+    {
+        std::vector<geojson_position> positions;
+        geojson_reader reader;
+
+        for (size_t i = 0; i < document.size(); i += chunk_size)
+        {
+            EXPECT_TRUE(reader.feed(document.substr(i, chunk_size), [&](const geojson_position& p) { positions.push_back(p); }));
+        }
+
+        EXPECT_TRUE(reader.finish());
+        ASSERT_EQ(positions.size(), 4);
+        EXPECT_EQ(reader.size(), 4);
+        EXPECT_EQ(positions[0].lat, 47.628700256347656);
+        EXPECT_EQ(positions[0].lon, -122.34622955322266);
+        EXPECT_FALSE(positions[0].alt_meters.has_value());
+        EXPECT_EQ(positions[1].lat, 47.6284);
+        EXPECT_EQ(positions[1].alt_meters.value_or(0.0), 12.5);
+        EXPECT_EQ(positions[2].lon, -122.3463);
+        EXPECT_EQ(positions[3].lat, 47.0);
+    }
+
+    // the positions can be replayed through a tracker
+    tracker t;
+    t.from("N0CALL");
+    t.to("APRS");
+    geojson_reader reader;
+    reader.feed(document, [&](const geojson_position& p) { t.position(p); });
+    EXPECT_TRUE(t.packet_string(packet_type::position) == "N0CALL>APRS:!4700.00N/12200.00W>");
+
+    // malformed documents
+    auto parse = [](std::string_view text) {
+        geojson_reader r;
+        return r.feed(text, [](const geojson_position&) {}) && r.finish();
+    };
+    EXPECT_FALSE(parse(R"({ "coordinates": [ [ 1, 2 ] })"));
+    EXPECT_FALSE(parse(R"({ "coordinates": [ [ 1, 2 ] ])"));
+    EXPECT_FALSE(parse(R"({ "coordinates": [ [ 1, x ] ] })"));
+    EXPECT_FALSE(parse(""));
+    EXPECT_TRUE(parse(R"({ "coordinates": [ [ 1, 2 ] ] })"));
+}
+
+TEST(corpus, round_trip)
+{
+    std::vector<packet_data> packets(2);
+    ASSERT_TRUE(parse_tnc2_packet("VA7XL-9>T9PVVW,WIDE1-1,WIDE2-1,qAR,VA7SHG-1:`1TDlJ\x1Ej/]\"4(}147.100MHz", packets[0]));
+    ASSERT_TRUE(parse_tnc2_packet("N0CALL>APRS,WIDE1-1:=4903.50N/07201.75W-090/036/A=001234", packets[1]));
+    packets.push_back(packets[1]); // repeated strings are stored once
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "aprstrack_corpus_test.bin";
+    ASSERT_TRUE(write_corpus(path.string(), packets));
+
+    {
+        corpus_file corpus;
+        ASSERT_TRUE(corpus.open(path.string()));
+        ASSERT_EQ(corpus.size(), 3);
+
+        size_t i = 0;
+        corpus.for_each([&](const corpus_packet& packet) {
+            EXPECT_EQ(packet.packet, packets[i].packet);
+            EXPECT_EQ(packet.from, packets[i].from);
+            EXPECT_EQ(packet.to, packets[i].to);
+            EXPECT_EQ(packet.path, packets[i].path);
+            EXPECT_EQ(packet.symbol_table, packets[i].symbol_table);
+            EXPECT_EQ(packet.symbol_code, packets[i].symbol_code);
+            EXPECT_EQ(packet.messaging_str, packets[i].messaging_str);
+            EXPECT_EQ(packet.lat, packets[i].lat);
+            EXPECT_EQ(packet.lon, packets[i].lon);
+            EXPECT_EQ(packet.alt, packets[i].alt);
+            EXPECT_EQ(packet.speed, packets[i].speed);
+            EXPECT_EQ(packet.course, packets[i].course);
+            EXPECT_EQ(packet.from_ssid, packets[i].from_ssid);
+            EXPECT_TRUE(packet.mic_e_status == packets[i].mic_e_status);
+            EXPECT_TRUE(packet.packet_type == packets[i].packet_type);
+            EXPECT_EQ(packet.has_altitude, packets[i].has_altitude);
+            i++;
+        });
+        EXPECT_EQ(i, 3);
+
+        EXPECT_TRUE(corpus[0].mic_e_status == mic_e_status::in_service);
+        EXPECT_EQ(corpus[0].from_ssid, 9);
+        EXPECT_TRUE(corpus[1].messaging);
+        EXPECT_EQ(corpus[1].path.data(), corpus[2].path.data());
+    }
+
+    // a count which wraps the size of the records is rejected
+    {
+        std::vector<char> bytes(std::filesystem::file_size(path));
+        std::ifstream(path, std::ios::binary).read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        uint64_t count = 3 + (uint64_t(1) << (64 - std::countr_zero(sizeof(corpus_record))));
+        std::memcpy(bytes.data() + offsetof(corpus_header, count), &count, sizeof(count));
+        std::filesystem::path wrapped_path = std::filesystem::temp_directory_path() / "aprstrack_corpus_wrapped_test.bin";
+        std::ofstream(wrapped_path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        corpus_file wrapped;
+        EXPECT_FALSE(wrapped.open(wrapped_path.string()));
+        std::filesystem::remove(wrapped_path);
+    }
+
+    // truncated corpora are rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    corpus_file truncated;
+    EXPECT_FALSE(truncated.open(path.string()));
+    std::filesystem::remove(path);
+
+    EXPECT_FALSE(corpus_file().open(path.string()));
+
+    // the mic-e status of the destination, standard and custom bits do not mix
+    EXPECT_TRUE(parse_mic_e_destination_status("T9PVVW") == mic_e_status::in_service);
+    EXPECT_TRUE(parse_mic_e_destination_status("ABC123") == mic_e_status::custom0);
+    EXPECT_TRUE(parse_mic_e_destination_status("0L1234") == mic_e_status::emergency);
+    EXPECT_TRUE(parse_mic_e_destination_status("PA0123") == mic_e_status::unknown);
+    EXPECT_TRUE(parse_mic_e_destination_status("K0Z123") == mic_e_status::unknown);
+    EXPECT_TRUE(parse_mic_e_destination_status("PP") == mic_e_status::unknown);
+}
+
+TEST(tracker, auto_tests)
+{
+    std::string file_path = INPUT_TEST_FILE;
+
+    auto test_packet = [](const auto& packet) {
+        std::string expected_packet_string(packet.packet);
         std::string actual_packet_string;
 
         if (packet.packet_type == packet_type::mic_e)
@@ -2063,6 +4442,26 @@ TEST(tracker, auto_tests)
         }
 
         EXPECT_TRUE(result);
+    };
+
+    // The binary corpus is read in place when it is current, the JSON corpus otherwise
+
+    corpus_file corpus;
+
+    if (corpus_is_current(file_path) && corpus.open(corpus_path(file_path)))
+    {
+        EXPECT_TRUE(corpus.size() > 0);
+        corpus.for_each(test_packet);
+        return;
+    }
+
+    std::vector<packet_data> packets = parse_json_basic(file_path);
+
+    EXPECT_TRUE(!packets.empty());
+
+    for (const auto& packet : packets)
+    {
+        test_packet(packet);
     }
 }
 
@@ -36,6 +36,16 @@
 #include <string>
 #include <fstream>
 #include <cctype>
+#include <string_view>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <cstring>
+#include <span>
+#include <type_traits>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -118,6 +128,37 @@ inline void nop()
 #endif
 }
 
+inline size_t parallel_chunk_count(size_t count)
+{
+    // One chunk per hardware thread, small inputs are kept on a single thread
+
+    size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, count / 1024));
+}
+
+template<typename F>
+inline void parallel_for_chunks(size_t count, size_t chunks, F&& f)
+{
+    // Splits [0, count) into contiguous chunks, and calls f(chunk, begin, end)
+    // for each chunk on its own thread
+
+    size_t chunk_size = (count + chunks - 1) / chunks;
+
+    std::vector<std::thread> threads;
+
+    for (size_t chunk = 0; chunk < chunks; chunk++)
+    {
+        size_t begin = std::min(count, chunk * chunk_size);
+        size_t end = std::min(count, begin + chunk_size);
+        threads.emplace_back([&f, chunk, begin, end]() { f(chunk, begin, end); });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
 inline std::string base64_encode(const std::string& input)
 {
     std::string encoded;
@@ -336,6 +377,267 @@ inline std::vector<packet_data> parse_json(const std::string& file_path)
     return packets;
 }
 
+inline std::string format_number(double value)
+{
+    // Same text as std::to_string, without the cost of snprintf
+
+    char buffer[64];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 6);
+    return ec == std::errc() ? std::string(buffer, end) : std::to_string(value);
+}
+
+inline std::string format_number_round_trip(double value)
+{
+    // The shortest text which parses back to the same value
+
+    char buffer[64];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return ec == std::errc() ? std::string(buffer, end) : std::to_string(value);
+}
+
+inline int parse_ssid(std::string_view callsign)
+{
+    size_t dash = callsign.find('-');
+
+    if (dash == std::string_view::npos)
+    {
+        return 0;
+    }
+
+    int ssid = 0;
+    std::from_chars(callsign.data() + dash + 1, callsign.data() + callsign.size(), ssid);
+    return ssid;
+}
+
+inline mic_e_status parse_mic_e_destination_status(std::string_view to)
+{
+    // The a, b and c message bits are in the first three characters of the destination
+    //
+    // 0-9 and L are 0, P-Z are a standard 1, and A-K are a custom 1
+    // A destination mixing standard and custom 1 bits has no status
+
+    if (to.size() < 3)
+    {
+        return mic_e_status::unknown;
+    }
+
+    bool standard = false;
+    bool custom = false;
+    int bits = 0;
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        char c = to[i];
+        bits <<= 1;
+        if (c >= 'P' && c <= 'Z')
+        {
+            bits |= 1;
+            standard = true;
+        }
+        else if (c >= 'A' && c <= 'K')
+        {
+            bits |= 1;
+            custom = true;
+        }
+        else if (!(c >= '0' && c <= '9') && c != 'L')
+        {
+            return mic_e_status::unknown;
+        }
+    }
+
+    if (standard && custom)
+    {
+        return mic_e_status::unknown;
+    }
+
+    // off_duty (1 1 1) through emergency (0 0 0), then custom0 (1 1 1) through custom6 (0 0 1)
+    return static_cast<mic_e_status>((custom ? 8 : 0) + (7 - bits));
+}
+
+inline bool parse_tnc2_packet(std::string_view line, packet_data& packet)
+{
+    // Parses a TNC2 packet with a position into the fields parse_json
+    // reads from the output of scripts/parse_packets.pl
+    //
+    // Speeds are in km/h and altitudes in meters, as reported by FAP
+    // Returns false for packets without a mic-e or a position report
+
+    decoded_packet p;
+
+    if (!decode_packet(line, p) || !p.has_position || p.info.empty())
+    {
+        return false;
+    }
+
+    char dti = p.info[0];
+
+    packet = packet_data();
+
+    if (dti == '`' || dti == '\'' || dti == 0x1C || dti == 0x1D)
+    {
+        if (p.to.size() < 6)
+        {
+            return false;
+        }
+
+        packet.packet_type = packet_type::mic_e;
+        packet.mic_e_status = parse_mic_e_destination_status(p.to);
+
+        for (size_t i = 5; i >= 2; i--)
+        {
+            if (p.to[i] != 'K' && p.to[i] != 'L' && p.to[i] != 'Z')
+            {
+                break;
+            }
+            packet.ambiguity++;
+        }
+    }
+    else if (dti == '!' || dti == '=' || dti == '/' || dti == '@')
+    {
+        std::string_view position = p.info.substr(dti == '/' || dti == '@' ? 8 : 1);
+
+        bool compressed = !((position[0] >= '0' && position[0] <= '9') || position[0] == ' ');
+
+        packet.packet_type = compressed ? packet_type::position_compressed : packet_type::position;
+        packet.messaging = dti == '=' || dti == '@';
+
+        if (p.info.size() > 7 && std::all_of(p.info.begin() + 1, p.info.begin() + 7, [](char c) { return c >= '0' && c <= '9'; }))
+        {
+            switch (p.info[7])
+            {
+                case 'z':
+                    packet.packet_type = compressed ? packet_type::position_compressed_with_timestamp_utc : packet_type::position_with_timestamp_utc;
+                    break;
+                case '/':
+                    packet.packet_type = compressed ? packet_type::position_compressed_with_timestamp : packet_type::position_with_timestamp;
+                    break;
+                case 'h':
+                    packet.packet_type = compressed ? packet_type::position_compressed_with_timestamp_utc_hms : packet_type::position_with_timestamp_utc_hms;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (!compressed)
+        {
+            for (size_t i : { 6, 5, 3, 2 })
+            {
+                if (position[i] != ' ')
+                {
+                    break;
+                }
+                packet.ambiguity++;
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    packet.packet = std::string(line);
+    packet.data = std::string(p.info);
+    packet.from = std::string(p.from);
+    packet.from_ssid = parse_ssid(p.from);
+    packet.to = std::string(p.to);
+    packet.to_ssid = parse_ssid(p.to);
+    packet.path = std::string(p.path);
+    packet.lat = p.fix.lat;
+    packet.lon = p.fix.lon;
+    packet.lat_str = format_number(packet.lat);
+    packet.lon_str = format_number(packet.lon);
+    packet.messaging_str = packet.messaging ? "true" : "false";
+    packet.symbol_table = std::string(1, p.symbol_table);
+    packet.symbol_code = std::string(1, p.symbol_code);
+
+    if (p.fix.speed_knots)
+    {
+        packet.speed = *p.fix.speed_knots * 1.852;
+        packet.course = p.fix.track_degrees.value_or(0.0);
+        packet.speed_str = format_number(packet.speed);
+        packet.course_str = format_number(packet.course);
+        packet.has_course_speed = true;
+    }
+
+    if (p.fix.alt_feet)
+    {
+        packet.alt = *p.fix.alt_feet * 0.3048;
+        packet.alt_str = format_number(packet.alt);
+        packet.has_altitude = true;
+    }
+
+    return true;
+}
+
+inline std::vector<packet_data> parse_tnc2(const std::string& file_path)
+{
+    // Parses a capture of TNC2 packets, one per line, in parallel
+    // The packets are returned in the order of the file
+
+    std::vector<packet_data> packets;
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open file: " << file_path << std::endl;
+        return packets;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<std::string_view> lines;
+
+    for (size_t begin = 0; begin < text.size();)
+    {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos)
+        {
+            end = text.size();
+        }
+        std::string_view line(text.data() + begin, end - begin);
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        {
+            line.remove_suffix(1);
+        }
+        if (!line.empty())
+        {
+            lines.push_back(line);
+        }
+        begin = end + 1;
+    }
+
+    size_t chunks = parallel_chunk_count(lines.size());
+    std::vector<std::vector<packet_data>> parsed(chunks);
+
+    parallel_for_chunks(lines.size(), chunks, [&](size_t chunk, size_t begin, size_t end) {
+        parsed[chunk].reserve(end - begin);
+        packet_data packet;
+        for (size_t i = begin; i < end; i++)
+        {
+            if (parse_tnc2_packet(lines[i], packet))
+            {
+                parsed[chunk].push_back(std::move(packet));
+            }
+        }
+    });
+
+    size_t count = 0;
+
+    for (const auto& chunk : parsed)
+    {
+        count += chunk.size();
+    }
+
+    packets.reserve(count);
+
+    for (auto& chunk : parsed)
+    {
+        packets.insert(packets.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+    }
+
+    return packets;
+}
+
 inline std::vector<packet_data> parse_json_basic(const std::string& file_path)
 {
     std::vector<packet_data> packets;
@@ -435,41 +737,50 @@ inline void write_json(const std::string& file_path, const std::vector<packet_da
     file << json_data.dump(4);
 }
 
-inline void write_json_basic(const std::string& file_path, const std::vector<packet_data>& packets)
+inline void append_json_string(std::string& output, std::string_view value)
 {
-    nlohmann::ordered_json json_data;
+    // Escapes a string as nlohmann::json does when dumping
 
-    int i = 0;
+    output.push_back('"');
 
-    for (const auto& packet : packets)
+    for (unsigned char c : value)
     {
-        nlohmann::ordered_json item;
-        item["index"] = std::to_string(i);
-        item["packet"] = escape_string(packet.packet);
-        item["packet_base64"] = base64_encode(packet.packet);
-        item["from"] = packet.from;
-        item["from_ssid"] = std::to_string(packet.from_ssid);
-        item["to"] = packet.to;
-        item["to_ssid"] = std::to_string(packet.to_ssid);
-        item["path"] = packet.path;
-        item["lat"] = std::to_string(packet.lat);
-        item["lon"] = std::to_string(packet.lon);
-        item["messaging"] = packet.messaging_str;
-        item["symbol_code"] = packet.symbol_code;
-        item["symbol_table"] = packet.symbol_table;
-        item["course"] = std::to_string(packet.course);
-        item["speed"] = std::to_string(packet.speed);
-        item["alt"] = std::to_string(packet.alt);
-        item["mic_e_status"] = to_string(packet.mic_e_status);
-        item["packet_type"] = to_string(packet.packet_type);
-        item["ambiguity"] = std::to_string(packet.ambiguity);
-        item["has_course_speed"] = packet.has_course_speed ? "true" : "false";
-        item["has_altitude"] = packet.has_altitude ? "true" : "false";
-        json_data.push_back(item);
-        i++;
+        switch (c)
+        {
+            case '"': output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\b': output += "\\b"; break;
+            case '\f': output += "\\f"; break;
+            case '\n': output += "\\n"; break;
+            case '\r': output += "\\r"; break;
+            case '\t': output += "\\t"; break;
+            default:
+                if (c < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    output.append(buffer);
+                }
+                else
+                {
+                    output.push_back(static_cast<char>(c));
+                }
+                break;
+        }
     }
 
-    std::ofstream file(file_path);
+    output.push_back('"');
+}
+
+inline void write_json_basic(const std::string& file_path, const std::vector<packet_data>& packets)
+{
+    // The packets are written directly, in the layout of nlohmann::ordered_json::dump(4),
+    // building a json document for a large corpus takes longer than encoding it
+    //
+    // The coordinates are written with all of their digits, the packets were
+    // verified with the exact values, and six decimals round some of them differently
+
+    std::ofstream file(file_path, std::ios::binary);
 
     if (!file.is_open())
     {
@@ -477,7 +788,345 @@ inline void write_json_basic(const std::string& file_path, const std::vector<pac
         return;
     }
 
-    file << json_data.dump(4);
+    std::string output;
+
+    auto field = [&](const char* name, std::string_view value, bool last = false) {
+        output += "        ";
+        append_json_string(output, name);
+        output += ": ";
+        append_json_string(output, value);
+        output += last ? "\n" : ",\n";
+    };
+
+    output += "[";
+
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        const packet_data& packet = packets[i];
+
+        output += i == 0 ? "\n    {\n" : ",\n    {\n";
+        field("index", std::to_string(i));
+        field("packet", escape_string(packet.packet));
+        field("packet_base64", base64_encode(packet.packet));
+        field("from", packet.from);
+        field("from_ssid", std::to_string(packet.from_ssid));
+        field("to", packet.to);
+        field("to_ssid", std::to_string(packet.to_ssid));
+        field("path", packet.path);
+        field("lat", format_number_round_trip(packet.lat));
+        field("lon", format_number_round_trip(packet.lon));
+        field("messaging", packet.messaging_str);
+        field("symbol_code", packet.symbol_code);
+        field("symbol_table", packet.symbol_table);
+        field("course", format_number(packet.course));
+        field("speed", format_number(packet.speed));
+        field("alt", format_number(packet.alt));
+        field("mic_e_status", to_string(packet.mic_e_status));
+        field("packet_type", to_string(packet.packet_type));
+        field("ambiguity", std::to_string(packet.ambiguity));
+        field("has_course_speed", packet.has_course_speed ? "true" : "false");
+        field("has_altitude", packet.has_altitude ? "true" : "false", true);
+        output += "    }";
+
+        if (output.size() > (1 << 20))
+        {
+            file.write(output.data(), output.size());
+            output.clear();
+        }
+    }
+
+    output += packets.empty() ? "]" : "\n]";
+
+    file.write(output.data(), output.size());
+}
+
+// A binary test corpus, written next to the JSON corpus and read in place
+//
+//   header   APTC, version, the record size and count, and where the strings are
+//   records  one fixed size corpus_record for every packet
+//   strings  the text of the packets, repeated strings are stored once
+//
+// The JSON corpus stays the source of truth, the binary corpus is only used
+// while it is at least as new as the JSON corpus it was written from
+
+struct corpus_string
+{
+    uint32_t offset = 0;
+    uint32_t size = 0;
+};
+
+struct corpus_header
+{
+    char magic[4] = { 'A', 'P', 'T', 'C' };
+    uint8_t version = 1;
+    uint8_t reserved[3] = {};
+    uint32_t record_size = 0;
+    uint32_t reserved2 = 0;
+    uint64_t count = 0;
+    uint64_t strings_offset = 0;
+    uint64_t strings_size = 0;
+};
+
+struct corpus_record
+{
+    corpus_string packet;
+    corpus_string data;
+    corpus_string from;
+    corpus_string to;
+    corpus_string path;
+    corpus_string comment;
+    corpus_string symbol_code;
+    corpus_string symbol_table;
+    double lat = 0.0;
+    double lon = 0.0;
+    double alt = 0.0;
+    double course = 0.0;
+    double speed = 0.0;
+    int32_t from_ssid = 0;
+    int32_t to_ssid = 0;
+    int32_t ambiguity = 0;
+    uint8_t mic_e_status = 0;
+    uint8_t packet_type = 0;
+    uint8_t messaging = 0;
+    uint8_t has_course_speed = 0;
+    uint8_t has_altitude = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<corpus_header> && sizeof(corpus_header) == 40);
+static_assert(std::is_trivially_copyable_v<corpus_record>);
+
+struct corpus_packet
+{
+    // A packet of the binary corpus, with the fields of packet_data as
+    // read by parse_json_basic, the strings point into the corpus
+
+    std::string_view packet;
+    std::string_view data;
+    std::string_view from;
+    int from_ssid = 0;
+    std::string_view to;
+    int to_ssid = 0;
+    std::string_view path;
+    double lat = 0.0;
+    double lon = 0.0;
+    std::string_view messaging_str;
+    bool messaging = false;
+    std::string_view symbol_code;
+    std::string_view symbol_table;
+    double alt = 0.0;
+    std::string_view alt_str;
+    double course = 0.0;
+    double speed = 0.0;
+    std::string_view course_str;
+    std::string_view speed_str;
+    enum mic_e_status mic_e_status = mic_e_status::unknown;
+    enum packet_type packet_type = packet_type::mic_e;
+    std::string_view comment;
+    bool has_course_speed = false;
+    bool has_altitude = false;
+    int ambiguity = 0;
+};
+
+inline std::string corpus_path(const std::string& json_file_path)
+{
+    return std::filesystem::path(json_file_path).replace_extension(".bin").string();
+}
+
+inline bool write_corpus(const std::string& file_path, const std::vector<packet_data>& packets)
+{
+    std::string strings;
+    std::unordered_map<std::string, corpus_string> interned;
+
+    auto intern = [&](const std::string& value) {
+        auto [it, inserted] = interned.try_emplace(value);
+        if (inserted)
+        {
+            it->second.offset = static_cast<uint32_t>(strings.size());
+            it->second.size = static_cast<uint32_t>(value.size());
+            strings += value;
+        }
+        return it->second;
+    };
+
+    std::vector<corpus_record> records(packets.size());
+
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        const packet_data& packet = packets[i];
+        corpus_record& record = records[i];
+        record.packet = intern(packet.packet);
+        record.data = intern(packet.data);
+        record.from = intern(packet.from);
+        record.to = intern(packet.to);
+        record.path = intern(packet.path);
+        record.comment = intern(packet.comment);
+        record.symbol_code = intern(packet.symbol_code);
+        record.symbol_table = intern(packet.symbol_table);
+        record.lat = packet.lat;
+        record.lon = packet.lon;
+        record.alt = packet.alt;
+        record.course = packet.course;
+        record.speed = packet.speed;
+        record.from_ssid = packet.from_ssid;
+        record.to_ssid = packet.to_ssid;
+        record.ambiguity = packet.ambiguity;
+        record.mic_e_status = static_cast<uint8_t>(packet.mic_e_status);
+        record.packet_type = static_cast<uint8_t>(packet.packet_type);
+        record.messaging = packet.messaging_str == "true" ? 1 : 0;
+        record.has_course_speed = packet.has_course_speed ? 1 : 0;
+        record.has_altitude = packet.has_altitude ? 1 : 0;
+    }
+
+    if (strings.size() > UINT32_MAX)
+    {
+        std::cerr << "Corpus strings exceed 4 GiB: " << file_path << std::endl;
+        return false;
+    }
+
+    corpus_header header;
+    header.record_size = sizeof(corpus_record);
+    header.count = records.size();
+    header.strings_offset = sizeof(corpus_header) + records.size() * sizeof(corpus_record);
+    header.strings_size = strings.size();
+
+    std::ofstream file(file_path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open file: " << file_path << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(corpus_record)));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    return file.good();
+}
+
+class corpus_file
+{
+public:
+    bool open(const std::string& file_path)
+    {
+        // Maps the corpus, or reads it where files can not be mapped
+        // Returns false for a missing, truncated or foreign file
+
+        bytes_ = {};
+
+#ifdef APRS_TRACK_HAS_MMAP
+        if (!file_.open(file_path.c_str()))
+        {
+            return false;
+        }
+        std::span<const unsigned char> bytes = file_.bytes();
+#else
+        std::ifstream file(file_path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        std::span<const unsigned char> bytes(reinterpret_cast<const unsigned char*>(buffer_.data()), buffer_.size());
+#endif
+
+        if (bytes.size() < sizeof(corpus_header))
+        {
+            return false;
+        }
+
+        corpus_header header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+
+        // The count and sizes are checked without overflow, the header is not trusted
+
+        if (std::memcmp(header.magic, "APTC", 4) != 0 || header.version != 1 || header.record_size != sizeof(corpus_record) ||
+            header.count > (bytes.size() - sizeof(corpus_header)) / sizeof(corpus_record) ||
+            header.strings_offset != sizeof(corpus_header) + header.count * sizeof(corpus_record) ||
+            header.strings_size != bytes.size() - header.strings_offset)
+        {
+            return false;
+        }
+
+        bytes_ = bytes;
+        size_ = static_cast<size_t>(header.count);
+        strings_ = std::string_view(reinterpret_cast<const char*>(bytes.data() + header.strings_offset), static_cast<size_t>(header.strings_size));
+
+        return true;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    corpus_packet operator[](size_t i) const
+    {
+        corpus_record record;
+        std::memcpy(&record, bytes_.data() + sizeof(corpus_header) + i * sizeof(corpus_record), sizeof(record));
+
+        auto text = [&](corpus_string s) {
+            return strings_.substr(std::min<size_t>(s.offset, strings_.size()), s.size);
+        };
+
+        corpus_packet packet;
+        packet.packet = text(record.packet);
+        packet.data = text(record.data);
+        packet.from = text(record.from);
+        packet.from_ssid = record.from_ssid;
+        packet.to = text(record.to);
+        packet.to_ssid = record.to_ssid;
+        packet.path = text(record.path);
+        packet.lat = record.lat;
+        packet.lon = record.lon;
+        packet.messaging = record.messaging != 0;
+        packet.messaging_str = packet.messaging ? "true" : "false";
+        packet.symbol_code = text(record.symbol_code);
+        packet.symbol_table = text(record.symbol_table);
+        packet.alt = record.alt;
+        packet.course = record.course;
+        packet.speed = record.speed;
+        packet.mic_e_status = static_cast<enum mic_e_status>(record.mic_e_status);
+        packet.packet_type = static_cast<enum packet_type>(record.packet_type);
+        packet.comment = text(record.comment);
+        packet.has_course_speed = record.has_course_speed != 0;
+        packet.has_altitude = record.has_altitude != 0;
+        packet.ambiguity = record.ambiguity;
+        return packet;
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            f((*this)[i]);
+        }
+    }
+
+private:
+#ifdef APRS_TRACK_HAS_MMAP
+    mapped_file file_;
+#else
+    std::vector<char> buffer_;
+#endif
+    std::span<const unsigned char> bytes_;
+    std::string_view strings_;
+    size_t size_ = 0;
+};
+
+inline bool corpus_is_current(const std::string& json_file_path)
+{
+    // The binary corpus is current while it is at least as new as the JSON corpus
+
+    std::error_code ec;
+    auto binary_time = std::filesystem::last_write_time(corpus_path(json_file_path), ec);
+    if (ec)
+    {
+        return false;
+    }
+    auto json_time = std::filesystem::last_write_time(json_file_path, ec);
+    return ec || binary_time >= json_time;
 }
 
 inline void append_to_json(const std::string& input_file_path, const std::string& output_file_path, const std::vector<packet_data_generated>& generated_packets)
@@ -554,284 +1203,333 @@ inline void write_json(const std::string& file_path, const std::vector<expected_
     file << json_data.dump(4);
 }
 
-std::vector<packet_data> process_packets(const std::vector<packet_data>& packets)
+enum class process_result
 {
-    int failure_count = 0;
-    int success_count = 0;
-    int skipped_count = 0;
-    int total_count = (int)packets.size();
-    std::vector<packet_data> success_packets;
+    success,
+    failure,
+    skipped
+};
 
-    for (const auto& packet : packets)
+inline process_result process_packet(const packet_data& packet, packet_data& generated_packet)
+{
+    if (packet.ambiguity > 0)
     {
-        if (packet.ambiguity > 0)
-        {
-            skipped_count++;
-            continue;
-        }
+        return process_result::skipped;
+    }
 
-        std::string expected_packet_string = packet.packet;
-        std::string packet_string;
-        std::string actual_packet_string;
+    std::string expected_packet_string = packet.packet;
+    std::string packet_string;
+    std::string actual_packet_string;
 
-        if (packet.packet_type == packet_type::mic_e)
+    if (packet.packet_type == packet_type::mic_e)
+    {
+        if (!packet.alt_str.empty())
         {
-            if (!packet.alt_str.empty())
-            {
-                packet_string = encode_mic_e_packet_no_message(
-                    packet.from,
-                    packet.path,
-                    packet.lat,
-                    packet.lon,
-                    packet.mic_e_status,
-                    packet.course,
-                    kmh_to_knots(packet.speed),
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0,
-                    meters_to_feet(packet.alt));
-            }
-            else
-            {
-                packet_string = encode_mic_e_packet_no_message(
-                    packet.from,
-                    packet.path,
-                    packet.lat,
-                    packet.lon,
-                    packet.mic_e_status,
-                    packet.course,
-                    kmh_to_knots(packet.speed),
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0);
-            }
+            packet_string = encode_mic_e_packet_no_message(
+                packet.from,
+                packet.path,
+                packet.lat,
+                packet.lon,
+                packet.mic_e_status,
+                packet.course,
+                kmh_to_knots(packet.speed),
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0,
+                meters_to_feet(packet.alt));
+        }
+        else
+        {
+            packet_string = encode_mic_e_packet_no_message(
+                packet.from,
+                packet.path,
+                packet.lat,
+                packet.lon,
+                packet.mic_e_status,
+                packet.course,
+                kmh_to_knots(packet.speed),
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0);
+        }
 
-            actual_packet_string = packet_string;
+        actual_packet_string = packet_string;
 
-            std::string course_speed_alt = encode_mic_e_course_speed_alternate(packet.course, kmh_to_knots(packet.speed));
-            size_t course_speed_alt_index = packet.from.size() + 1 + packet.to.size() + 1 + packet.path.size() + 1 + 3 + 1;
-            std::string expected_course_speed = expected_packet_string.substr(course_speed_alt_index, 3);
-            std::string actual_course_speed = packet_string.substr(course_speed_alt_index, 3);
+        std::string course_speed_alt = encode_mic_e_course_speed_alternate(packet.course, kmh_to_knots(packet.speed));
+        size_t course_speed_alt_index = packet.from.size() + 1 + packet.to.size() + 1 + packet.path.size() + 1 + 3 + 1;
+        std::string expected_course_speed = expected_packet_string.substr(course_speed_alt_index, 3);
+        std::string actual_course_speed = packet_string.substr(course_speed_alt_index, 3);
 
-            if (expected_course_speed != actual_course_speed && expected_course_speed == course_speed_alt)
-            {
-                packet_string.replace(course_speed_alt_index, 3, course_speed_alt);
-            }
+        if (expected_course_speed != actual_course_speed && expected_course_speed == course_speed_alt)
+        {
+            packet_string.replace(course_speed_alt_index, 3, course_speed_alt);
+        }
 
-            if (!packet.alt_str.empty() && packet.data[9] != '"')
-            {
-                size_t vendor_index = packet.from.size() + 1 + packet.to.size() + 1 + packet.path.size() + 1 + 9;
-                packet_string.insert(vendor_index, 1, packet.data[9]);
-            }
+        if (!packet.alt_str.empty() && packet.data[9] != '"')
+        {
+            size_t vendor_index = packet.from.size() + 1 + packet.to.size() + 1 + packet.path.size() + 1 + 9;
+            packet_string.insert(vendor_index, 1, packet.data[9]);
+        }
 
-            if (packet.to_ssid > 0)
-            {
-                size_t to_end_index = packet.from.size() + 1 + packet.to.size();
-                std::string ssid_string = "-" + std::to_string(packet.to_ssid);
-                to_end_index -= ssid_string.size();
-                packet_string.insert(to_end_index, ssid_string);
-            }
+        if (packet.to_ssid > 0)
+        {
+            size_t to_end_index = packet.from.size() + 1 + packet.to.size();
+            std::string ssid_string = "-" + std::to_string(packet.to_ssid);
+            to_end_index -= ssid_string.size();
+            packet_string.insert(to_end_index, ssid_string);
         }
-        else if (packet.packet_type == packet_type::position)
+    }
+    else if (packet.packet_type == packet_type::position)
+    {
+        if (packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
         {
-            if (packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
-            {
-                packet_string = encode_position_packet_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0);
-            }
-            else if (packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
-            {
-                packet_string = encode_position_packet_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0,
-                    kmh_to_knots(packet.speed),
-                    packet.course);
-            }
-            else if (!packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
-            {
-                packet_string = encode_position_packet_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0,
-                    meters_to_feet(packet.alt));
-            }
-            else if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
-            {
-                packet_string = encode_position_packet_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    0,
-                    kmh_to_knots(packet.speed),
-                    packet.course,
-                    meters_to_feet(packet.alt));
-            }
+            packet_string = encode_position_packet_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0);
+        }
+        else if (packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
+        {
+            packet_string = encode_position_packet_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0,
+                kmh_to_knots(packet.speed),
+                packet.course);
+        }
+        else if (!packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
+        {
+            packet_string = encode_position_packet_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0,
+                meters_to_feet(packet.alt));
+        }
+        else if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
+        {
+            packet_string = encode_position_packet_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                0,
+                kmh_to_knots(packet.speed),
+                packet.course,
+                meters_to_feet(packet.alt));
+        }
+
+        actual_packet_string = packet_string;
+    }
+    else if (packet.packet_type == packet_type::position_compressed)
+    {
+        size_t compression_type_index = 0;
 
-            actual_packet_string = packet_string;
+        if (packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
+        {
+            packet_string = encode_position_packet_compressed_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                packet.course,
+                kmh_to_knots(packet.speed),
+                1);
         }
-        else if (packet.packet_type == packet_type::position_compressed)
+        else if (!packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
         {
-            size_t compression_type_index = 0;
+            packet_string = encode_position_packet_compressed_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                meters_to_feet(packet.alt),
+                1);
+        }
+        else if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
+        {
+            packet_string = encode_position_packet_compressed_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                packet.course,
+                kmh_to_knots(packet.speed),
+                1,
+                meters_to_feet(packet.alt));
+        }
+        else if (packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
+        {
+            packet_string = encode_position_packet_compressed_no_timestamp_no_message(
+                packet.from,
+                packet.to,
+                packet.path,
+                packet.messaging_str == "true",
+                packet.lat,
+                packet.lon,
+                packet.symbol_table[0],
+                packet.symbol_code[0],
+                1);
+        }
 
-            if (packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
-            {
-                packet_string = encode_position_packet_compressed_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    packet.course,
-                    kmh_to_knots(packet.speed),
-                    1);
-            }
-            else if (!packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
-            {
-                packet_string = encode_position_packet_compressed_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    meters_to_feet(packet.alt),
-                    1);
-            }
-            else if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
-            {
-                packet_string = encode_position_packet_compressed_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    packet.course,
-                    kmh_to_knots(packet.speed),
-                    1,
-                    meters_to_feet(packet.alt));
-            }
-            else if (packet.alt_str.empty() && packet.course_str.empty() && packet.speed_str.empty())
-            {
-                packet_string = encode_position_packet_compressed_no_timestamp_no_message(
-                    packet.from,
-                    packet.to,
-                    packet.path,
-                    packet.messaging_str == "true",
-                    packet.lat,
-                    packet.lon,
-                    packet.symbol_table[0],
-                    packet.symbol_code[0],
-                    1);
-            }
+        actual_packet_string = packet_string;
+
+        compression_type_index = packet_string.size() - 1;
 
-            actual_packet_string = packet_string;
+        if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
+        {
+            compression_type_index -= 9;
+        }
 
-            compression_type_index = packet_string.size() - 1;
+        char compression_type = packet_string[compression_type_index];
 
-            if (!packet.alt_str.empty() && (!packet.course_str.empty() || !packet.speed_str.empty()))
-            {
-                compression_type_index -= 9;
-            }
+        (void)compression_type; // Suppress unused variable warning
 
-            char compression_type = packet_string[compression_type_index];
+        assert(compression_type == '\x1');
 
-            (void)compression_type; // Suppress unused variable warning
+        packet_string[compression_type_index] = expected_packet_string[compression_type_index];
+    }
+    else
+    {
+        return process_result::skipped;
+    }
 
-            assert(compression_type == '\x1');
+    bool result = expected_packet_string.starts_with(packet_string);
 
-            packet_string[compression_type_index] = expected_packet_string[compression_type_index];
+    if (result)
+    {
+        generated_packet = packet_data();
+        generated_packet.packet = actual_packet_string;
+        generated_packet.packet_type = packet.packet_type;
+        generated_packet.from = packet.from;
+        generated_packet.from_ssid = packet.from_ssid;
+        generated_packet.to = packet.to;
+        generated_packet.to_ssid = packet.to_ssid;
+        generated_packet.path = packet.path;
+        generated_packet.messaging_str = packet.messaging_str;
+        generated_packet.lat = packet.lat;
+        generated_packet.lon = packet.lon;
+        generated_packet.mic_e_status = packet.mic_e_status;
+        generated_packet.course = packet.course;
+        generated_packet.speed = packet.speed;
+        generated_packet.symbol_table = packet.symbol_table;
+        generated_packet.symbol_code = packet.symbol_code;
+        generated_packet.alt = packet.alt;
+        generated_packet.messaging = (packet.messaging_str == "true");
+        generated_packet.has_altitude = !packet.alt_str.empty();
+        generated_packet.has_course_speed = !packet.course_str.empty() || !packet.speed_str.empty();
+        return process_result::success;
+    }
+    else
+    {
+#ifdef LIBAPRSTRACK_PRINT_FAILED_PACKETS
+        static std::mutex print_mutex;
+        std::lock_guard<std::mutex> lock(print_mutex);
+        printf("expected: %d %s\n", (int)expected_packet_string.size(), expected_packet_string.c_str());
+        printf("  actual: %d %s\n", (int)actual_packet_string.size(), actual_packet_string.c_str());
+        printf("expected hex: ");
+        for (char c : expected_packet_string)
+        {
+            printf("%02x ", static_cast<unsigned char>(c));
         }
-        else
+        printf("\n");
+        printf("  actual hex: ");
+        for (char c : actual_packet_string)
         {
-            skipped_count++;
-            continue;
-        }
-
-        bool result = expected_packet_string.starts_with(packet_string);
-
-        if (result)
-        {
-            packet_data generated_packet;
-            generated_packet.packet = actual_packet_string;
-            generated_packet.packet_type = packet.packet_type;
-            generated_packet.from = packet.from;
-            generated_packet.from_ssid = packet.from_ssid;
-            generated_packet.to = packet.to;
-            generated_packet.to_ssid = packet.to_ssid;
-            generated_packet.path = packet.path;
-            generated_packet.messaging_str = packet.messaging_str;
-            generated_packet.lat = packet.lat;
-            generated_packet.lon = packet.lon;
-            generated_packet.mic_e_status = packet.mic_e_status;
-            generated_packet.course = packet.course;
-            generated_packet.speed = packet.speed;
-            generated_packet.symbol_table = packet.symbol_table;
-            generated_packet.symbol_code = packet.symbol_code;
-            generated_packet.alt = packet.alt;
-            generated_packet.messaging = (packet.messaging_str == "true");
-            generated_packet.has_altitude = !packet.alt_str.empty();
-            generated_packet.has_course_speed = !packet.course_str.empty() || !packet.speed_str.empty();
-            success_packets.push_back(generated_packet);
-            success_count++;
+            printf("%02x ", static_cast<unsigned char>(c));
         }
-        else
+        printf("\n");
+        printf("-----------------------------------------------\n");
+#endif
+        return process_result::failure;
+    }
+}
+
+std::vector<packet_data> process_packets(const std::vector<packet_data>& packets)
+{
+    // Re-encodes the packets in parallel, the packets which encode back to
+    // their original text are returned in the order of the input
+
+    struct chunk_result
+    {
+        std::vector<packet_data> success_packets;
+        int failure_count = 0;
+        int success_count = 0;
+        int skipped_count = 0;
+    };
+
+    size_t chunks = parallel_chunk_count(packets.size());
+    std::vector<chunk_result> results(chunks);
+
+    parallel_for_chunks(packets.size(), chunks, [&](size_t chunk, size_t begin, size_t end) {
+        chunk_result& result = results[chunk];
+        packet_data generated_packet;
+        for (size_t i = begin; i < end; i++)
         {
-#ifdef LIBAPRSTRACK_PRINT_FAILED_PACKETS
-            printf("expected: %d %s\n", (int)expected_packet_string.size(), expected_packet_string.c_str());
-            printf("  actual: %d %s\n", (int)actual_packet_string.size(), actual_packet_string.c_str());
-            printf("expected hex: ");
-            for (char c : expected_packet_string)
+            switch (process_packet(packets[i], generated_packet))
             {
-                printf("%02x ", static_cast<unsigned char>(c));
+                case process_result::success:
+                    result.success_packets.push_back(std::move(generated_packet));
+                    result.success_count++;
+                    break;
+                case process_result::failure:
+                    result.failure_count++;
+                    break;
+                case process_result::skipped:
+                    result.skipped_count++;
+                    break;
             }
-            printf("\n");
-            printf("  actual hex: ");
-            for (char c : actual_packet_string)
-            {
-                printf("%02x ", static_cast<unsigned char>(c));
-            }
-            printf("\n");
-            printf("-----------------------------------------------\n");
-#endif
-            failure_count++;
         }
+    });
+
+    int failure_count = 0;
+    int success_count = 0;
+    int skipped_count = 0;
+    int total_count = (int)packets.size();
+    std::vector<packet_data> success_packets;
+
+    for (auto& result : results)
+    {
+        failure_count += result.failure_count;
+        success_count += result.success_count;
+        skipped_count += result.skipped_count;
+        success_packets.insert(success_packets.end(), std::make_move_iterator(result.success_packets.begin()), std::make_move_iterator(result.success_packets.end()));
     }
 
     printf("total count %d, success count %d, failure count %d, skipped count %d\n", total_count, success_count, failure_count, skipped_count);
 
     return success_packets;
-}
\ No newline at end of file
+}